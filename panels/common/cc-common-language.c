@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <locale.h>
 
 #include <glib.h>
@@ -84,60 +85,107 @@ cc_common_language_get_iter_for_language (GtkTreeModel *model,
   return iter_for_language (model, lang, iter, FALSE);
 }
 
-gboolean
-cc_common_language_has_font (const gchar *locale)
+/* How long a font coverage snapshot is trusted before asking
+ * fontconfig whether the installed fonts changed. */
+#define FONT_COVERAGE_CHECK_INTERVAL G_USEC_PER_SEC
+
+static FcConfig   *font_coverage_config = NULL;
+static gint64      font_coverage_checked = 0;
+static GHashTable *font_coverage = NULL;
+
+static void
+add_font_set_coverage (GHashTable *languages,
+                       FcFontSet  *font_set)
 {
-        const FcCharSet  *charset;
-        FcPattern        *pattern;
-        FcObjectSet      *object_set;
-        FcFontSet        *font_set;
-        g_autofree gchar *language_code = NULL;
-        gboolean          is_displayable;
-
-        is_displayable = FALSE;
-        pattern = NULL;
-        object_set = NULL;
-        font_set = NULL;
-
-        if (!gnome_parse_locale (locale, &language_code, NULL, NULL, NULL))
-                return FALSE;
-
-        charset = FcLangGetCharSet ((FcChar8 *) language_code);
-        if (!charset) {
-                /* fontconfig does not know about this language */
-                is_displayable = TRUE;
+        if (font_set == NULL)
+                return;
+
+        for (int i = 0; i < font_set->nfont; i++) {
+                FcLangSet *lang_set;
+                FcStrSet *langs;
+                FcStrList *list;
+                FcChar8 *lang;
+
+                if (FcPatternGetLangSet (font_set->fonts[i], FC_LANG, 0, &lang_set) != FcResultMatch)
+                        continue;
+
+                langs = FcLangSetGetLangs (lang_set);
+                list = FcStrListCreate (langs);
+
+                /* fontconfig matches a bare language against any of its
+                 * territory variants, so only the language part matters */
+                while ((lang = FcStrListNext (list)) != NULL) {
+                        g_autofree gchar *language = g_ascii_strdown ((const gchar *) lang, -1);
+                        gchar *dash = strchr (language, '-');
+
+                        if (dash != NULL)
+                                *dash = '\0';
+
+                        if (!g_hash_table_contains (languages, language))
+                                g_hash_table_add (languages, g_steal_pointer (&language));
+                }
+
+                FcStrListDone (list);
+                FcStrSetDestroy (langs);
         }
-        else {
-                /* see if any fonts support rendering it */
-                pattern = FcPatternBuild (NULL, FC_LANG, FcTypeString, language_code, NULL);
+}
 
-                if (pattern == NULL)
-                        goto done;
+/*
+ * Collects, in a single pass over the installed fonts, the languages
+ * for which at least one font exists. The result is cached until
+ * fontconfig reports a configuration change.
+ */
+static GHashTable *
+get_font_coverage (void)
+{
+        FcConfig *config;
+        gint64 now;
 
-                object_set = FcObjectSetCreate ();
+        config = FcConfigGetCurrent ();
+        now = g_get_monotonic_time ();
 
-                if (object_set == NULL)
-                        goto done;
+        if (font_coverage != NULL && config == font_coverage_config) {
+                if (now - font_coverage_checked < FONT_COVERAGE_CHECK_INTERVAL)
+                        return font_coverage;
 
-                font_set = FcFontList (NULL, pattern, object_set);
+                font_coverage_checked = now;
+                if (FcConfigUptoDate (config))
+                        return font_coverage;
 
-                if (font_set == NULL)
-                        goto done;
+                /* A stale configuration stays stale, so load the new one
+                 * before rebuilding; keep the old table if that fails */
+                if (!FcInitBringUptoDate ())
+                        return font_coverage;
 
-                is_displayable = (font_set->nfont > 0);
+                config = FcConfigGetCurrent ();
         }
 
- done:
-        if (font_set != NULL)
-                FcFontSetDestroy (font_set);
+        g_clear_pointer (&font_coverage, g_hash_table_unref);
+        font_coverage = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        font_coverage_config = config;
+        font_coverage_checked = now;
+
+        add_font_set_coverage (font_coverage, FcConfigGetFonts (config, FcSetSystem));
+        add_font_set_coverage (font_coverage, FcConfigGetFonts (config, FcSetApplication));
+
+        return font_coverage;
+}
+
+gboolean
+cc_common_language_has_font_for_language (const gchar *language_code)
+{
+        g_autofree gchar *language = NULL;
+
+        g_return_val_if_fail (language_code != NULL, FALSE);
 
-        if (object_set != NULL)
-                FcObjectSetDestroy (object_set);
+        /* fontconfig does not know about this language */
+        if (!FcLangGetCharSet ((FcChar8 *) language_code))
+                return TRUE;
 
-        if (pattern != NULL)
-                FcPatternDestroy (pattern);
+        /* see if any fonts support rendering it */
+        language = g_ascii_strdown (language_code, -1);
 
-        return is_displayable;
+        return g_hash_table_contains (get_font_coverage (), language);
 }
 
 gchar *
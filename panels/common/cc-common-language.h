@@ -41,7 +41,7 @@ gboolean cc_common_language_get_iter_for_region     (GtkTreeModel     *model,
 guint    cc_common_language_add_available_languages (GtkListStore     *store,
                                                      gboolean          regions,
                                                      GHashTable       *user_langs);
-gboolean cc_common_language_has_font                (const gchar  *locale);
+gboolean cc_common_language_has_font_for_language   (const gchar  *language_code);
 gchar   *cc_common_language_get_current_language    (void);
 
 GHashTable *cc_common_language_get_initial_languages   (void);
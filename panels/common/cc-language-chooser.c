@@ -31,48 +31,79 @@
 #include <gtk/gtk.h>
 
 #include "cc-common-language.h"
+#include "cc-locale-catalogue.h"
 #include "cc-util.h"
 
-#define GNOME_DESKTOP_USE_UNSTABLE_API
-#include <libgnome-desktop/gnome-languages.h>
-
 struct _CcLanguageChooser {
         GtkDialog parent_instance;
 
         GtkSearchEntry *language_filter_entry;
-        GtkListBox     *language_listbox;
-        GtkListBoxRow  *more_row;
+        GtkListView    *language_listview;
+        GtkStack       *language_stack;
+        GtkWidget      *language_scrolled_window;
+        GtkWidget      *empty_label;
+        GtkButton      *more_button;
         GtkSearchBar   *search_bar;
         GtkButton      *select_button;
 
+        GtkFilterListModel *filter_model;
+        GtkFilter          *filter;
+        GHashTable         *initial;
+        GHashTable         *bound_rows;
+
         gboolean showing_extra;
         gchar *language;
+        gchar *filter_contents;
         gchar **filter_words;
 };
 
 G_DEFINE_TYPE (CcLanguageChooser, cc_language_chooser, GTK_TYPE_DIALOG)
 
-static void
-add_all_languages (CcLanguageChooser *self)
+static gint
+sort_languages (gconstpointer a,
+                gconstpointer b)
+{
+        const CcLocaleInfo *la = *(const CcLocaleInfo **) a;
+        const CcLocaleInfo *lb = *(const CcLocaleInfo **) b;
+        int d;
+
+        d = g_strcmp0 (la->language, lb->language);
+        if (d != 0)
+                return d;
+
+        return g_strcmp0 (la->country, lb->country);
+}
+
+static GListModel *
+create_language_model (void)
 {
-        g_auto(GStrv) locale_ids = NULL;
-        g_autoptr(GHashTable) initial = NULL;
+        g_autoptr(GPtrArray) sorted = NULL;
+        GtkStringList *model;
+        GPtrArray *locales;
 
-        locale_ids = gnome_get_all_locales ();
-        initial = cc_common_language_get_initial_languages ();
-        for (int i = 0; locale_ids[i] != NULL; i++) {
-                CcLanguageRow *row;
-                gboolean is_initial;
+        locales = cc_locale_catalogue_get_locales ();
+        sorted = g_ptr_array_sized_new (locales->len);
 
-                if (!cc_common_language_has_font (locale_ids[i]))
+        for (guint i = 0; i < locales->len; i++) {
+                const CcLocaleInfo *info = g_ptr_array_index (locales, i);
+
+                if (!cc_common_language_has_font_for_language (info->language_code))
                         continue;
 
-                row = cc_language_row_new (locale_ids[i]);
-                gtk_widget_show (GTK_WIDGET (row));
-                is_initial = (g_hash_table_lookup (initial, locale_ids[i]) != NULL);
-                cc_language_row_set_is_extra (row, !is_initial);
-                gtk_list_box_prepend (self->language_listbox, GTK_WIDGET (row));
+                g_ptr_array_add (sorted, (gpointer) info);
         }
+
+        g_ptr_array_sort (sorted, sort_languages);
+
+        /* Items only carry the locale id, everything else, including the
+         * normalised filter keys, comes from the catalogue */
+        model = gtk_string_list_new (NULL);
+        for (guint i = 0; i < sorted->len; i++) {
+                const CcLocaleInfo *info = g_ptr_array_index (sorted, i);
+                gtk_string_list_append (model, info->id);
+        }
+
+        return G_LIST_MODEL (model);
 }
 
 static gboolean
@@ -92,85 +123,120 @@ match_all (gchar       **words,
 }
 
 static gboolean
-language_visible (GtkListBoxRow *row,
-                  gpointer   user_data)
+language_visible (gpointer item,
+                  gpointer user_data)
 {
         CcLanguageChooser *self = user_data;
-        g_autofree gchar *language = NULL;
-        g_autofree gchar *country = NULL;
-        g_autofree gchar *language_local = NULL;
-        g_autofree gchar *country_local = NULL;
-        gboolean visible;
+        const CcLocaleInfo *info;
+        const gchar *locale_id;
 
-        if (row == self->more_row)
-                return !self->showing_extra;
+        locale_id = gtk_string_object_get_string (GTK_STRING_OBJECT (item));
 
-        if (!CC_IS_LANGUAGE_ROW (row))
-                return TRUE;
-
-        if (!self->showing_extra && cc_language_row_get_is_extra (CC_LANGUAGE_ROW (row)))
+        if (!self->showing_extra &&
+            !g_hash_table_contains (self->initial, locale_id) &&
+            g_strcmp0 (locale_id, self->language) != 0)
                 return FALSE;
 
         if (!self->filter_words)
                 return TRUE;
 
-        language =
-                cc_util_normalize_casefold_and_unaccent (cc_language_row_get_language (CC_LANGUAGE_ROW (row)));
-        visible = match_all (self->filter_words, language);
-        if (visible)
-                return TRUE;
+        info = cc_locale_catalogue_lookup_locale (locale_id);
 
-        country =
-                cc_util_normalize_casefold_and_unaccent (cc_language_row_get_country (CC_LANGUAGE_ROW (row)));
-        visible = match_all (self->filter_words, country);
-        if (visible)
-                return TRUE;
+        return match_all (self->filter_words, info->language_key) ||
+               match_all (self->filter_words, info->country_key) ||
+               match_all (self->filter_words, info->language_local_key) ||
+               match_all (self->filter_words, info->country_local_key);
+}
 
-        language_local =
-                cc_util_normalize_casefold_and_unaccent (cc_language_row_get_language_local (CC_LANGUAGE_ROW (row)));
-        visible = match_all (self->filter_words, language_local);
-        if (visible)
-                return TRUE;
+static void
+update_empty_state (CcLanguageChooser *self)
+{
+        gboolean empty;
+
+        /* Wait for an incremental filter run to finish before deciding */
+        if (gtk_filter_list_model_get_pending (self->filter_model) > 0 &&
+            g_list_model_get_n_items (G_LIST_MODEL (self->filter_model)) == 0)
+                return;
 
-        country_local =
-                cc_util_normalize_casefold_and_unaccent (cc_language_row_get_country_local (CC_LANGUAGE_ROW (row)));
-        return match_all (self->filter_words, country_local);
+        empty = g_list_model_get_n_items (G_LIST_MODEL (self->filter_model)) == 0;
+        gtk_stack_set_visible_child (self->language_stack,
+                                     empty ? self->empty_label : self->language_scrolled_window);
 }
 
-static gint
-sort_languages (GtkListBoxRow *a,
-                GtkListBoxRow *b,
-                gpointer   data)
+static void
+setup_row_cb (CcLanguageChooser        *self,
+              GtkListItem              *list_item,
+              GtkSignalListItemFactory *factory)
 {
-        int d;
+        gtk_list_item_set_child (list_item, GTK_WIDGET (cc_language_row_new ()));
+}
 
-        if (!CC_IS_LANGUAGE_ROW (a))
-                return 1;
-        if (!CC_IS_LANGUAGE_ROW (b))
-                return -1;
+static void
+bind_row_cb (CcLanguageChooser        *self,
+             GtkListItem              *list_item,
+             GtkSignalListItemFactory *factory)
+{
+        CcLanguageRow *row;
+        const gchar *locale_id;
 
-        d = g_strcmp0 (cc_language_row_get_language (CC_LANGUAGE_ROW (a)), cc_language_row_get_language (CC_LANGUAGE_ROW (b)));
-        if (d != 0)
-                return d;
+        row = CC_LANGUAGE_ROW (gtk_list_item_get_child (list_item));
+        locale_id = gtk_string_object_get_string (gtk_list_item_get_item (list_item));
 
-        return g_strcmp0 (cc_language_row_get_country (CC_LANGUAGE_ROW (a)), cc_language_row_get_country (CC_LANGUAGE_ROW (b)));
+        cc_language_row_set_locale_info (row, cc_locale_catalogue_lookup_locale (locale_id));
+        cc_language_row_set_checked (row, g_strcmp0 (locale_id, self->language) == 0);
+
+        g_hash_table_add (self->bound_rows, row);
+}
+
+static void
+unbind_row_cb (CcLanguageChooser        *self,
+               GtkListItem              *list_item,
+               GtkSignalListItemFactory *factory)
+{
+        CcLanguageRow *row;
+
+        row = CC_LANGUAGE_ROW (gtk_list_item_get_child (list_item));
+        g_hash_table_remove (self->bound_rows, row);
+        cc_language_row_set_locale_info (row, NULL);
 }
 
 static void
 language_filter_entry_search_changed_cb (CcLanguageChooser *self)
 {
         g_autofree gchar *filter_contents = NULL;
-
-        g_clear_pointer (&self->filter_words, g_strfreev);
+        GtkFilterChange change;
 
         filter_contents =
                 cc_util_normalize_casefold_and_unaccent (gtk_editable_get_text (GTK_EDITABLE (self->language_filter_entry)));
-        if (!filter_contents) {
-                gtk_list_box_invalidate_filter (self->language_listbox);
+        if (filter_contents)
+                g_strstrip (filter_contents);
+        if (filter_contents && *filter_contents == '\0')
+                g_clear_pointer (&filter_contents, g_free);
+
+        if (g_strcmp0 (filter_contents, self->filter_contents) == 0)
                 return;
-        }
-        self->filter_words = g_strsplit_set (g_strstrip (filter_contents), " ", 0);
-        gtk_list_box_invalidate_filter (self->language_listbox);
+
+        /* Typing more characters can only hide rows and deleting them can
+         * only reveal rows, which lets the filter model skip work */
+        if (!self->filter_contents)
+                change = GTK_FILTER_CHANGE_MORE_STRICT;
+        else if (!filter_contents)
+                change = GTK_FILTER_CHANGE_LESS_STRICT;
+        else if (g_str_has_prefix (filter_contents, self->filter_contents))
+                change = GTK_FILTER_CHANGE_MORE_STRICT;
+        else if (g_str_has_prefix (self->filter_contents, filter_contents))
+                change = GTK_FILTER_CHANGE_LESS_STRICT;
+        else
+                change = GTK_FILTER_CHANGE_DIFFERENT;
+
+        g_clear_pointer (&self->filter_words, g_strfreev);
+        g_free (self->filter_contents);
+        self->filter_contents = g_steal_pointer (&filter_contents);
+
+        if (self->filter_contents)
+                self->filter_words = g_strsplit_set (self->filter_contents, " ", 0);
+
+        gtk_filter_changed (self->filter, change);
 }
 
 static void
@@ -182,62 +248,65 @@ show_more (CcLanguageChooser *self, gboolean visible)
         gtk_widget_set_size_request (GTK_WIDGET (self), width, height);
 
         gtk_search_bar_set_search_mode (self->search_bar, visible);
-        gtk_widget_grab_focus (visible ? GTK_WIDGET (self->language_filter_entry) : GTK_WIDGET (self->language_listbox));
+        gtk_widget_grab_focus (visible ? GTK_WIDGET (self->language_filter_entry) : GTK_WIDGET (self->language_listview));
+
+        if (self->showing_extra == visible)
+                return;
 
         self->showing_extra = visible;
+        gtk_widget_set_visible (GTK_WIDGET (self->more_button), !visible);
 
-        gtk_list_box_invalidate_filter (self->language_listbox);
+        gtk_filter_changed (self->filter,
+                            visible ? GTK_FILTER_CHANGE_LESS_STRICT : GTK_FILTER_CHANGE_MORE_STRICT);
+}
+
+static void
+more_button_clicked_cb (CcLanguageChooser *self)
+{
+        show_more (self, TRUE);
 }
 
 static void
 set_locale_id (CcLanguageChooser *self,
                const gchar       *locale_id)
 {
-        GtkWidget *child;
+        GHashTableIter iter;
+        gpointer row;
+        gboolean old_is_extra, new_is_extra;
 
-        gtk_widget_set_sensitive (GTK_WIDGET (self->select_button), FALSE);
+        /* Only the rows currently bound to an item need updating, the
+         * others pick up the check mark when they get bound */
+        g_hash_table_iter_init (&iter, self->bound_rows);
+        while (g_hash_table_iter_next (&iter, &row, NULL))
+                cc_language_row_set_checked (row, g_strcmp0 (locale_id, cc_language_row_get_locale_id (row)) == 0);
 
-        for (child = gtk_widget_get_first_child (GTK_WIDGET (self->language_listbox));
-             child;
-             child = gtk_widget_get_next_sibling (child)) {
-                CcLanguageRow *row;
+        gtk_widget_set_sensitive (GTK_WIDGET (self->select_button),
+                                  cc_locale_catalogue_lookup_locale (locale_id) != NULL);
 
-                if (!CC_IS_LANGUAGE_ROW (child))
-                        continue;
-
-                row = CC_LANGUAGE_ROW (child);
-                if (g_strcmp0 (locale_id, cc_language_row_get_locale_id (row)) == 0) {
-                        cc_language_row_set_checked (row, TRUE);
-                        gtk_widget_set_sensitive (GTK_WIDGET (self->select_button), TRUE);
-
-                        /* make sure the selected language is shown */
-                        if (!self->showing_extra && cc_language_row_get_is_extra (row)) {
-                                cc_language_row_set_is_extra (row, FALSE);
-                                gtk_list_box_invalidate_filter (self->language_listbox);
-                        }
-                } else {
-                        cc_language_row_set_checked (row, FALSE);
-                }
-        }
+        old_is_extra = self->language != NULL && !g_hash_table_contains (self->initial, self->language);
+        new_is_extra = locale_id != NULL && !g_hash_table_contains (self->initial, locale_id);
 
         g_free (self->language);
         self->language = g_strdup (locale_id);
+
+        /* make sure the selected language is shown */
+        if (!self->showing_extra && (old_is_extra || new_is_extra))
+                gtk_filter_changed (self->filter,
+                                    old_is_extra ? GTK_FILTER_CHANGE_DIFFERENT : GTK_FILTER_CHANGE_LESS_STRICT);
 }
 
 static void
-language_listbox_row_activated_cb (CcLanguageChooser *self, GtkListBoxRow *row)
+language_listview_activate_cb (CcLanguageChooser *self,
+                               guint              position)
 {
+        g_autoptr(GtkStringObject) item = NULL;
         const gchar *new_locale_id;
 
-        if (row == self->more_row) {
-                show_more (self, TRUE);
+        item = g_list_model_get_item (G_LIST_MODEL (self->filter_model), position);
+        if (!item)
                 return;
-        }
 
-        if (!CC_IS_LANGUAGE_ROW (row))
-                return;
-
-        new_locale_id = cc_language_row_get_locale_id (CC_LANGUAGE_ROW (row));
+        new_locale_id = gtk_string_object_get_string (item);
         if (g_strcmp0 (new_locale_id, self->language) == 0) {
                 gtk_dialog_response (GTK_DIALOG (self),
                                      gtk_dialog_get_response_for_widget (GTK_DIALOG (self),
@@ -251,32 +320,55 @@ static void
 activate_default_cb (CcLanguageChooser *self)
 {
         GtkWidget *focus;
+        GtkWidget *row;
 
+        /* The focus lands on the list item widget holding our row */
         focus = gtk_window_get_focus (GTK_WINDOW (self));
-        if (!focus || !CC_IS_LANGUAGE_ROW (focus))
+        if (!focus || !gtk_widget_is_ancestor (focus, GTK_WIDGET (self->language_listview)))
+                return;
+
+        row = gtk_widget_get_first_child (focus);
+        if (!row || !CC_IS_LANGUAGE_ROW (row))
                 return;
 
-        if (g_strcmp0 (cc_language_row_get_locale_id (CC_LANGUAGE_ROW (focus)), self->language) == 0)
+        if (g_strcmp0 (cc_language_row_get_locale_id (CC_LANGUAGE_ROW (row)), self->language) == 0)
                 return;
 
         g_signal_stop_emission_by_name (GTK_WINDOW (self), "activate-default");
-        gtk_widget_activate (focus);
+        set_locale_id (self, cc_language_row_get_locale_id (CC_LANGUAGE_ROW (row)));
 }
 
 void
 cc_language_chooser_init (CcLanguageChooser *self)
 {
+        g_autoptr(GtkListItemFactory) factory = NULL;
+        g_autoptr(GtkNoSelection) selection = NULL;
+
         g_resources_register (cc_common_get_resource ());
 
         gtk_widget_init_template (GTK_WIDGET (self));
 
-        gtk_list_box_set_sort_func (self->language_listbox,
-                                    sort_languages, self, NULL);
-        gtk_list_box_set_filter_func (self->language_listbox,
-                                      language_visible, self, NULL);
-        add_all_languages (self);
+        self->initial = cc_common_language_get_initial_languages ();
+        self->bound_rows = g_hash_table_new (NULL, NULL);
+
+        self->filter = GTK_FILTER (gtk_custom_filter_new (language_visible, self, NULL));
+        self->filter_model = gtk_filter_list_model_new (create_language_model (), g_object_ref (self->filter));
+        gtk_filter_list_model_set_incremental (self->filter_model, TRUE);
+        g_signal_connect_object (self->filter_model, "items-changed",
+                                 G_CALLBACK (update_empty_state), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (self->filter_model, "notify::pending",
+                                 G_CALLBACK (update_empty_state), self, G_CONNECT_SWAPPED);
+
+        factory = gtk_signal_list_item_factory_new ();
+        g_signal_connect_object (factory, "setup", G_CALLBACK (setup_row_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (factory, "bind", G_CALLBACK (bind_row_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (factory, "unbind", G_CALLBACK (unbind_row_cb), self, G_CONNECT_SWAPPED);
+
+        selection = gtk_no_selection_new (g_object_ref (G_LIST_MODEL (self->filter_model)));
+        gtk_list_view_set_model (self->language_listview, GTK_SELECTION_MODEL (selection));
+        gtk_list_view_set_factory (self->language_listview, factory);
 
-        gtk_list_box_invalidate_filter (self->language_listbox);
+        update_empty_state (self);
 }
 
 static void
@@ -284,7 +376,12 @@ cc_language_chooser_dispose (GObject *object)
 {
         CcLanguageChooser *self = CC_LANGUAGE_CHOOSER (object);
 
+        g_clear_object (&self->filter_model);
+        g_clear_object (&self->filter);
+        g_clear_pointer (&self->initial, g_hash_table_unref);
+        g_clear_pointer (&self->bound_rows, g_hash_table_unref);
         g_clear_pointer (&self->filter_words, g_strfreev);
+        g_clear_pointer (&self->filter_contents, g_free);
         g_clear_pointer (&self->language, g_free);
 
         G_OBJECT_CLASS (cc_language_chooser_parent_class)->dispose (object);
@@ -301,14 +398,18 @@ cc_language_chooser_class_init (CcLanguageChooserClass *klass)
         gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/control-center/common/cc-language-chooser.ui");
 
         gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, language_filter_entry);
-        gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, language_listbox);
-        gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, more_row);
+        gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, language_listview);
+        gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, language_stack);
+        gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, language_scrolled_window);
+        gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, empty_label);
+        gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, more_button);
         gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, search_bar);
         gtk_widget_class_bind_template_child (widget_class, CcLanguageChooser, select_button);
 
         gtk_widget_class_bind_template_callback (widget_class, activate_default_cb);
         gtk_widget_class_bind_template_callback (widget_class, language_filter_entry_search_changed_cb);
-        gtk_widget_class_bind_template_callback (widget_class, language_listbox_row_activated_cb);
+        gtk_widget_class_bind_template_callback (widget_class, language_listview_activate_cb);
+        gtk_widget_class_bind_template_callback (widget_class, more_button_clicked_cb);
 }
 
 CcLanguageChooser *
@@ -19,67 +19,23 @@
 #include "cc-language-row.h"
 #include "cc-common-resources.h"
 
-#define GNOME_DESKTOP_USE_UNSTABLE_API
-#include <libgnome-desktop/gnome-languages.h>
-
 struct _CcLanguageRow {
-  GtkListBoxRow parent_instance;
+  GtkBox parent_instance;
 
   GtkImage *check_image;
   GtkLabel *country_label;
   GtkLabel *language_label;
 
-  gchar *locale_id;
-  gchar *language;
-  gchar *language_local;
-  gchar *country;
-  gchar *country_local;
-
-  gboolean is_extra;
+  const CcLocaleInfo *info;
 };
 
-G_DEFINE_TYPE (CcLanguageRow, cc_language_row, GTK_TYPE_LIST_BOX_ROW)
-
-static gchar *
-get_language_label (const gchar *language_code,
-                    const gchar *modifier,
-                    const gchar *locale_id)
-{
-  g_autofree gchar *language = NULL;
-
-  language = gnome_get_language_from_code (language_code, locale_id);
-
-  if (modifier == NULL)
-    return g_steal_pointer (&language);
-  else
-    {
-      g_autofree gchar *t_mod = gnome_get_translated_modifier (modifier, locale_id);
-      return g_strdup_printf ("%s — %s", language, t_mod);
-    }
-}
-
-static void
-cc_language_row_dispose (GObject *object)
-{
-  CcLanguageRow *self = CC_LANGUAGE_ROW (object);
-
-  g_clear_pointer (&self->locale_id, g_free);
-  g_clear_pointer (&self->country, g_free);
-  g_clear_pointer (&self->country_local, g_free);
-  g_clear_pointer (&self->language, g_free);
-  g_clear_pointer (&self->language_local, g_free);
-
-  G_OBJECT_CLASS (cc_language_row_parent_class)->dispose (object);
-}
+G_DEFINE_TYPE (CcLanguageRow, cc_language_row, GTK_TYPE_BOX)
 
 void
 cc_language_row_class_init (CcLanguageRowClass *klass)
 {
-  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
-  object_class->dispose = cc_language_row_dispose;
-
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/control-center/common/cc-language-row.ui");
 
   gtk_widget_class_bind_template_child (widget_class, CcLanguageRow, check_image);
@@ -96,70 +52,63 @@ cc_language_row_init (CcLanguageRow *self)
 }
 
 CcLanguageRow *
-cc_language_row_new (const gchar *locale_id)
+cc_language_row_new (void)
+{
+  return CC_LANGUAGE_ROW (g_object_new (CC_TYPE_LANGUAGE_ROW, NULL));
+}
+
+void
+cc_language_row_set_locale_info (CcLanguageRow      *self,
+                                 const CcLocaleInfo *info)
+{
+  g_return_if_fail (CC_IS_LANGUAGE_ROW (self));
+
+  self->info = info;
+
+  gtk_label_set_label (self->language_label, info ? info->language : NULL);
+  gtk_label_set_label (self->country_label, info ? info->country : NULL);
+}
+
+const CcLocaleInfo *
+cc_language_row_get_locale_info (CcLanguageRow *self)
 {
-  CcLanguageRow *self;
-  g_autofree gchar *language_code = NULL;
-  g_autofree gchar *country_code = NULL;
-  g_autofree gchar *modifier = NULL;
-
-  self = CC_LANGUAGE_ROW (g_object_new (CC_TYPE_LANGUAGE_ROW, NULL));
-  self->locale_id = g_strdup (locale_id);
-
-  gnome_parse_locale (locale_id, &language_code, &country_code, NULL, &modifier);
-
-  self->language = get_language_label (language_code, modifier, locale_id);
-  self->language_local = get_language_label (language_code, modifier, NULL);
-  gtk_label_set_label (self->language_label, self->language);
-
-  if (country_code == NULL)
-    {
-      self->country = NULL;
-      self->country_local = NULL;
-    }
-  else
-    {
-      self->country = gnome_get_country_from_code (country_code, locale_id);
-      self->country_local = gnome_get_country_from_code (country_code, NULL);
-      gtk_label_set_label (self->country_label, self->country);
-    }
-
-  return self;
+  g_return_val_if_fail (CC_IS_LANGUAGE_ROW (self), NULL);
+  return self->info;
 }
 
 const gchar *
 cc_language_row_get_locale_id (CcLanguageRow *self)
 {
   g_return_val_if_fail (CC_IS_LANGUAGE_ROW (self), NULL);
-  return self->locale_id;
+  return self->info ? self->info->id : NULL;
 }
 
 const gchar *
 cc_language_row_get_language (CcLanguageRow *self)
 {
   g_return_val_if_fail (CC_IS_LANGUAGE_ROW (self), NULL);
-  return self->language;
+  return self->info->language;
 }
 
 const gchar *
 cc_language_row_get_language_local (CcLanguageRow *self)
 {
   g_return_val_if_fail (CC_IS_LANGUAGE_ROW (self), NULL);
-  return self->language_local;
+  return self->info->language_local;
 }
 
 const gchar *
 cc_language_row_get_country (CcLanguageRow *self)
 {
   g_return_val_if_fail (CC_IS_LANGUAGE_ROW (self), NULL);
-  return self->country;
+  return self->info->country;
 }
 
 const gchar *
 cc_language_row_get_country_local (CcLanguageRow *self)
 {
   g_return_val_if_fail (CC_IS_LANGUAGE_ROW (self), NULL);
-  return self->country_local;
+  return self->info->country_local;
 }
 
 void
@@ -168,17 +117,3 @@ cc_language_row_set_checked (CcLanguageRow *self, gboolean checked)
   g_return_if_fail (CC_IS_LANGUAGE_ROW (self));
   gtk_widget_set_visible (GTK_WIDGET (self->check_image), checked);
 }
-
-void
-cc_language_row_set_is_extra (CcLanguageRow *self, gboolean is_extra)
-{
-  g_return_if_fail (CC_IS_LANGUAGE_ROW (self));
-  self->is_extra = is_extra;
-}
-
-gboolean
-cc_language_row_get_is_extra (CcLanguageRow *self)
-{
-  g_return_val_if_fail (CC_IS_LANGUAGE_ROW (self), FALSE);
-  return self->is_extra;
-}
@@ -20,12 +20,19 @@
 
 #include <gtk/gtk.h>
 
+#include "cc-locale-catalogue.h"
+
 G_BEGIN_DECLS
 
 #define CC_TYPE_LANGUAGE_ROW (cc_language_row_get_type ())
-G_DECLARE_FINAL_TYPE (CcLanguageRow, cc_language_row, CC, LANGUAGE_ROW, GtkListBoxRow)
+G_DECLARE_FINAL_TYPE (CcLanguageRow, cc_language_row, CC, LANGUAGE_ROW, GtkBox)
+
+CcLanguageRow *cc_language_row_new                (void);
+
+void           cc_language_row_set_locale_info    (CcLanguageRow      *row,
+                                                   const CcLocaleInfo *info);
 
-CcLanguageRow *cc_language_row_new                (const gchar *locale_id);
+const CcLocaleInfo *cc_language_row_get_locale_info (CcLanguageRow *row);
 
 const gchar   *cc_language_row_get_locale_id      (CcLanguageRow *row);
 
@@ -39,8 +46,4 @@ const gchar   *cc_language_row_get_country_local  (CcLanguageRow *row);
 
 void           cc_language_row_set_checked        (CcLanguageRow *row, gboolean checked);
 
-void           cc_language_row_set_is_extra       (CcLanguageRow *row, gboolean is_extra);
-
-gboolean       cc_language_row_get_is_extra       (CcLanguageRow *row);
-
 G_END_DECLS
@@ -0,0 +1,426 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "cc-locale-catalogue"
+
+#include <config.h>
+
+#include <gio/gio.h>
+
+#define GNOME_DESKTOP_USE_UNSTABLE_API
+#include <libgnome-desktop/gnome-languages.h>
+
+#include "cc-locale-catalogue.h"
+#include "cc-util.h"
+
+#define INPUT_SOURCE_TYPE_XKB "xkb"
+
+/*
+ * Resolving the display names of every installed locale through
+ * gnome-desktop is slow (hundreds of milliseconds), and the language,
+ * format and input source choosers used to do it every time they were
+ * opened. The catalogue is built once per process, either lazily by the
+ * first caller or ahead of time in a worker thread, and is immutable
+ * afterwards.
+ */
+typedef struct
+{
+  GPtrArray    *locales;
+  GHashTable   *locales_by_id;
+  GPtrArray    *input_locales;
+  GPtrArray    *other_layouts;
+} CcLocaleCatalogue;
+
+static GMutex catalogue_lock;
+static CcLocaleCatalogue *catalogue = NULL;
+
+/* Only ever created on the main thread, see cc_locale_catalogue_preload() */
+static GnomeXkbInfo *shared_xkb_info = NULL;
+
+static void
+locale_info_free (CcLocaleInfo *info)
+{
+  g_free (info->id);
+  g_free (info->language_code);
+  g_free (info->country_code);
+  g_free (info->modifier);
+  g_free (info->language);
+  g_free (info->language_local);
+  g_free (info->country);
+  g_free (info->country_local);
+  g_free (info->region);
+  g_free (info->region_local);
+  g_free (info->region_untranslated);
+  g_free (info->language_key);
+  g_free (info->language_local_key);
+  g_free (info->country_key);
+  g_free (info->country_local_key);
+  g_free (info->region_key);
+  g_free (info->region_local_key);
+  g_free (info->region_untranslated_key);
+  g_free (info);
+}
+
+static void
+input_locale_info_free (CcInputLocaleInfo *info)
+{
+  g_free (info->id);
+  g_free (info->language_code);
+  g_free (info->country_code);
+  g_free (info->language);
+  g_free (info->name);
+  g_free (info->name_key);
+  g_free (info->untranslated_name_key);
+  g_free (info->layouts);
+  g_free (info);
+}
+
+static gchar *
+get_language_label (const gchar *language_code,
+                    const gchar *modifier,
+                    const gchar *locale_id)
+{
+  g_autofree gchar *language = NULL;
+
+  language = gnome_get_language_from_code (language_code, locale_id);
+
+  if (modifier == NULL)
+    return g_steal_pointer (&language);
+  else
+    {
+      g_autofree gchar *t_mod = gnome_get_translated_modifier (modifier, locale_id);
+      return g_strdup_printf ("%s — %s", language, t_mod);
+    }
+}
+
+static CcLocaleInfo *
+locale_info_new (const gchar *locale_id)
+{
+  CcLocaleInfo *info;
+
+  info = g_new0 (CcLocaleInfo, 1);
+  info->id = g_strdup (locale_id);
+
+  if (!gnome_parse_locale (locale_id, &info->language_code, &info->country_code, NULL, &info->modifier))
+    {
+      locale_info_free (info);
+      return NULL;
+    }
+
+  info->language = get_language_label (info->language_code, info->modifier, locale_id);
+  info->language_local = get_language_label (info->language_code, info->modifier, NULL);
+
+  if (info->country_code != NULL)
+    {
+      info->country = gnome_get_country_from_code (info->country_code, locale_id);
+      info->country_local = gnome_get_country_from_code (info->country_code, NULL);
+    }
+
+  info->region = gnome_get_country_from_locale (locale_id, locale_id);
+  if (info->region != NULL)
+    {
+      info->region_local = gnome_get_country_from_locale (locale_id, NULL);
+      info->region_untranslated = gnome_get_country_from_locale (locale_id, "C");
+    }
+
+  info->language_key = cc_util_normalize_casefold_and_unaccent (info->language);
+  info->language_local_key = cc_util_normalize_casefold_and_unaccent (info->language_local);
+  info->country_key = cc_util_normalize_casefold_and_unaccent (info->country);
+  info->country_local_key = cc_util_normalize_casefold_and_unaccent (info->country_local);
+  info->region_key = cc_util_normalize_casefold_and_unaccent (info->region);
+  info->region_local_key = cc_util_normalize_casefold_and_unaccent (info->region_local);
+  info->region_untranslated_key = cc_util_normalize_casefold_and_unaccent (info->region_untranslated);
+
+  return info;
+}
+
+static void
+add_layouts (GPtrArray  *layouts,
+             GHashTable *seen,
+             GList      *list)
+{
+  for (; list != NULL; list = list->next)
+    {
+      if (g_hash_table_add (seen, list->data))
+        g_ptr_array_add (layouts, list->data);
+    }
+}
+
+static CcInputLocaleInfo *
+input_locale_info_new (GnomeXkbInfo *xkb_info,
+                       const gchar  *simple_locale,
+                       const gchar  *language_code,
+                       const gchar  *country_code,
+                       GHashTable   *layouts_with_locale)
+{
+  CcInputLocaleInfo *info;
+  g_autoptr(GPtrArray) layouts = NULL;
+  g_autoptr(GHashTable) seen = NULL;
+  g_autoptr(GList) language_layouts = NULL;
+  g_autofree gchar *untranslated_name = NULL;
+
+  info = g_new0 (CcInputLocaleInfo, 1);
+  info->id = g_strdup (simple_locale);
+  info->language_code = g_strdup (language_code);
+  info->country_code = g_strdup (country_code);
+  info->language = gnome_get_language_from_code (language_code, NULL);
+  info->name = gnome_get_language_from_locale (simple_locale, NULL);
+  info->name_key = cc_util_normalize_casefold_and_unaccent (info->name);
+  untranslated_name = gnome_get_language_from_locale (simple_locale, "C");
+  info->untranslated_name_key = cc_util_normalize_casefold_and_unaccent (untranslated_name);
+
+  if (!gnome_get_input_source_from_locale (simple_locale, &info->input_source_type, &info->input_source_id))
+    {
+      info->input_source_type = NULL;
+      info->input_source_id = NULL;
+    }
+  else if (g_str_equal (info->input_source_type, INPUT_SOURCE_TYPE_XKB))
+    {
+      g_hash_table_add (layouts_with_locale, (gpointer) info->input_source_id);
+    }
+
+  layouts = g_ptr_array_new ();
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  language_layouts = gnome_xkb_info_get_layouts_for_language (xkb_info, language_code);
+  add_layouts (layouts, seen, language_layouts);
+
+  if (country_code != NULL)
+    {
+      g_autoptr(GList) country_layouts = gnome_xkb_info_get_layouts_for_country (xkb_info, country_code);
+      add_layouts (layouts, seen, country_layouts);
+    }
+
+  for (guint i = 0; i < layouts->len; i++)
+    g_hash_table_add (layouts_with_locale, g_ptr_array_index (layouts, i));
+
+  g_ptr_array_add (layouts, NULL);
+  info->layouts = (const gchar **) g_ptr_array_free (g_steal_pointer (&layouts), FALSE);
+
+  return info;
+}
+
+static CcLocaleCatalogue *
+catalogue_build (GnomeXkbInfo *xkb_info)
+{
+  CcLocaleCatalogue *self;
+  g_autoptr(GHashTable) layouts_with_locale = NULL;
+  g_autoptr(GHashTable) input_locale_ids = NULL;
+  g_autoptr(GList) all_layouts = NULL;
+  g_auto(GStrv) locale_ids = NULL;
+  gint64 start_time;
+
+  start_time = g_get_monotonic_time ();
+
+  self = g_new0 (CcLocaleCatalogue, 1);
+  self->locales = g_ptr_array_new_with_free_func ((GDestroyNotify) locale_info_free);
+  self->locales_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+  self->input_locales = g_ptr_array_new_with_free_func ((GDestroyNotify) input_locale_info_free);
+  self->other_layouts = g_ptr_array_new ();
+
+  layouts_with_locale = g_hash_table_new (g_str_hash, g_str_equal);
+  input_locale_ids = g_hash_table_new (g_str_hash, g_str_equal);
+
+  locale_ids = gnome_get_all_locales ();
+  for (gchar **locale = locale_ids; *locale; locale++)
+    {
+      CcLocaleInfo *info;
+      CcInputLocaleInfo *input_info;
+      g_autofree gchar *simple_locale = NULL;
+
+      info = locale_info_new (*locale);
+      if (info == NULL)
+        continue;
+
+      g_ptr_array_add (self->locales, info);
+      g_hash_table_insert (self->locales_by_id, info->id, info);
+
+      if (info->country_code != NULL)
+        simple_locale = g_strdup_printf ("%s_%s.UTF-8", info->language_code, info->country_code);
+      else
+        simple_locale = g_strdup_printf ("%s.UTF-8", info->language_code);
+
+      if (g_hash_table_contains (input_locale_ids, simple_locale))
+        continue;
+
+      input_info = input_locale_info_new (xkb_info,
+                                          simple_locale,
+                                          info->language_code,
+                                          info->country_code,
+                                          layouts_with_locale);
+      g_ptr_array_add (self->input_locales, input_info);
+      g_hash_table_add (input_locale_ids, input_info->id);
+    }
+
+  /* Layouts that are not relevant for any locale */
+  all_layouts = gnome_xkb_info_get_all_layouts (xkb_info);
+  for (GList *l = all_layouts; l; l = l->next)
+    if (!g_hash_table_contains (layouts_with_locale, l->data))
+      g_ptr_array_add (self->other_layouts, l->data);
+  g_ptr_array_add (self->other_layouts, NULL);
+
+  g_debug ("Built catalogue of %u locales (%u input locales) in %" G_GINT64_FORMAT " ms",
+           self->locales->len,
+           self->input_locales->len,
+           (g_get_monotonic_time () - start_time) / 1000);
+
+  return self;
+}
+
+static GnomeXkbInfo *
+ensure_xkb_info (void)
+{
+  if (shared_xkb_info == NULL)
+    {
+      /* The XKB rules are parsed on first use, get that out of the way
+       * so that later queries only read them */
+      shared_xkb_info = gnome_xkb_info_new ();
+      g_list_free (gnome_xkb_info_get_all_layouts (shared_xkb_info));
+    }
+
+  return shared_xkb_info;
+}
+
+static void
+preload_thread_func (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancellable)
+{
+  g_mutex_lock (&catalogue_lock);
+  if (catalogue == NULL)
+    catalogue = catalogue_build (task_data);
+  g_mutex_unlock (&catalogue_lock);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static CcLocaleCatalogue *
+ensure_catalogue (void)
+{
+  CcLocaleCatalogue *self;
+
+  g_mutex_lock (&catalogue_lock);
+  if (catalogue == NULL)
+    catalogue = catalogue_build (ensure_xkb_info ());
+  self = catalogue;
+  g_mutex_unlock (&catalogue_lock);
+
+  return self;
+}
+
+/**
+ * cc_locale_catalogue_preload:
+ *
+ * Starts building the catalogue in a worker thread, so that it is
+ * ready by the time a chooser is opened. Calling this more than once,
+ * or after the catalogue has been built, is harmless.
+ */
+void
+cc_locale_catalogue_preload (void)
+{
+  static gboolean preloading = FALSE;
+  g_autoptr(GTask) task = NULL;
+  const gchar *type, *id;
+
+  if (preloading)
+    return;
+  preloading = TRUE;
+
+  /* Neither gnome-desktop nor GnomeXkbInfo is thread-safe; both fill
+   * their tables lazily and without locking. Make every table the
+   * worker uses get filled here, on the main thread, so that the worker
+   * only ever reads them. */
+  g_strfreev (gnome_get_all_locales ());
+  g_free (gnome_get_language_from_code ("en", NULL));
+  g_free (gnome_get_language_from_locale ("en_US.UTF-8", NULL));
+  g_free (gnome_get_country_from_code ("US", NULL));
+  g_free (gnome_get_country_from_locale ("en_US.UTF-8", NULL));
+  g_free (gnome_get_translated_modifier ("euro", NULL));
+  gnome_get_input_source_from_locale ("en_US.UTF-8", &type, &id);
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_source_tag (task, cc_locale_catalogue_preload);
+  g_task_set_task_data (task, ensure_xkb_info (), NULL);
+  g_task_run_in_thread (task, preload_thread_func);
+}
+
+/**
+ * cc_locale_catalogue_get_locales:
+ *
+ * Returns: (transfer none) (element-type CcLocaleInfo): every
+ *   available locale, in the order returned by gnome_get_all_locales()
+ */
+GPtrArray *
+cc_locale_catalogue_get_locales (void)
+{
+  return ensure_catalogue ()->locales;
+}
+
+/**
+ * cc_locale_catalogue_lookup_locale:
+ * @locale_id: a locale, as returned by gnome_get_all_locales()
+ *
+ * Returns: (transfer none) (nullable): the entry for @locale_id
+ */
+const CcLocaleInfo *
+cc_locale_catalogue_lookup_locale (const gchar *locale_id)
+{
+  if (locale_id == NULL)
+    return NULL;
+
+  return g_hash_table_lookup (ensure_catalogue ()->locales_by_id, locale_id);
+}
+
+/**
+ * cc_locale_catalogue_get_input_locales:
+ *
+ * Returns: (transfer none) (element-type CcInputLocaleInfo): one entry
+ *   per distinct language and country combination
+ */
+GPtrArray *
+cc_locale_catalogue_get_input_locales (void)
+{
+  return ensure_catalogue ()->input_locales;
+}
+
+/**
+ * cc_locale_catalogue_get_other_layouts:
+ *
+ * Returns: (transfer none): the XKB layouts which are not associated
+ *   with any available locale
+ */
+const gchar * const *
+cc_locale_catalogue_get_other_layouts (void)
+{
+  return (const gchar * const *) ensure_catalogue ()->other_layouts->pdata;
+}
+
+/**
+ * cc_locale_catalogue_get_xkb_info:
+ *
+ * Returns the #GnomeXkbInfo owning the layout ids referenced by the
+ * catalogue. It is shared by the whole process and must only be used
+ * from the main thread; getting it does not build the catalogue.
+ *
+ * Returns: (transfer none): the shared #GnomeXkbInfo
+ */
+GnomeXkbInfo *
+cc_locale_catalogue_get_xkb_info (void)
+{
+  return ensure_xkb_info ();
+}
@@ -0,0 +1,91 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#define GNOME_DESKTOP_USE_UNSTABLE_API
+#include <libgnome-desktop/gnome-xkb-info.h>
+
+G_BEGIN_DECLS
+
+/*
+ * One entry per locale returned by gnome_get_all_locales(). The
+ * "local" strings are translated into the current UI language, the
+ * other ones into the locale itself. Every *_key field holds the
+ * output of cc_util_normalize_casefold_and_unaccent() for the field
+ * of the same name, ready to be matched against a search query.
+ */
+typedef struct
+{
+  gchar *id;
+  gchar *language_code;
+  gchar *country_code;
+  gchar *modifier;
+
+  gchar *language;
+  gchar *language_local;
+  gchar *country;
+  gchar *country_local;
+
+  gchar *region;
+  gchar *region_local;
+  gchar *region_untranslated;
+
+  gchar *language_key;
+  gchar *language_local_key;
+  gchar *country_key;
+  gchar *country_local_key;
+
+  gchar *region_key;
+  gchar *region_local_key;
+  gchar *region_untranslated_key;
+} CcLocaleInfo;
+
+/*
+ * One entry per simplified "language_COUNTRY.UTF-8" locale, with the
+ * input sources that are relevant for it. Layout ids are owned by the
+ * GnomeXkbInfo returned by cc_locale_catalogue_get_xkb_info().
+ */
+typedef struct
+{
+  gchar        *id;
+  gchar        *language_code;
+  gchar        *country_code;
+
+  gchar        *language;
+  gchar        *name;
+  gchar        *name_key;
+  gchar        *untranslated_name_key;
+
+  const gchar  *input_source_type;
+  const gchar  *input_source_id;
+
+  const gchar **layouts;
+} CcInputLocaleInfo;
+
+void                 cc_locale_catalogue_preload               (void);
+
+GPtrArray           *cc_locale_catalogue_get_locales           (void);
+const CcLocaleInfo  *cc_locale_catalogue_lookup_locale         (const gchar *locale_id);
+
+GPtrArray           *cc_locale_catalogue_get_input_locales     (void);
+const gchar * const *cc_locale_catalogue_get_other_layouts     (void);
+
+GnomeXkbInfo        *cc_locale_catalogue_get_xkb_info          (void);
+
+G_END_DECLS
@@ -43,16 +43,13 @@
  *
  * Originally written by Aleksander Morgado <aleksander@gnu.org>
  */
-char *
-cc_util_normalize_casefold_and_unaccent (const char *str)
+static char *
+normalize_casefold_and_unaccent_slow (const char *str)
 {
   g_autofree gchar *normalized = NULL;
   gchar *tmp;
   int i = 0, j = 0, ilen;
 
-  if (str == NULL)
-    return NULL;
-
   normalized = g_utf8_normalize (str, -1, G_NORMALIZE_NFKD);
   tmp = g_utf8_casefold (normalized, -1);
 
@@ -107,6 +104,181 @@ cc_util_normalize_casefold_and_unaccent (const char *str)
   return tmp;
 }
 
+/* Every code point in this range decomposes (NFKD) into a starter
+ * followed by combining marks only, so the result for a string made of
+ * ASCII and these characters is the concatenation of the per-character
+ * results. The table is filled from the slow path on first use so that
+ * it always matches the Unicode data of the running GLib.
+ */
+#define LATIN_TABLE_FIRST 0x00A0
+#define LATIN_TABLE_LAST  0x024F
+
+static const char * const *
+get_latin_table (void)
+{
+  static const char **table = NULL;
+
+  if (g_once_init_enter (&table))
+    {
+      const char **entries;
+      gunichar c;
+
+      entries = g_new0 (const char *, LATIN_TABLE_LAST - LATIN_TABLE_FIRST + 1);
+      for (c = LATIN_TABLE_FIRST; c <= LATIN_TABLE_LAST; c++)
+        {
+          gchar utf8[8];
+
+          utf8[g_unichar_to_utf8 (c, utf8)] = '\0';
+          entries[c - LATIN_TABLE_FIRST] = normalize_casefold_and_unaccent_slow (utf8);
+        }
+
+      g_once_init_leave (&table, entries);
+    }
+
+  return table;
+}
+
+/* Checks a word at a time whether any byte has its high bit set */
+static gboolean
+is_ascii (const char *str,
+          gsize       len)
+{
+  gsize i = 0;
+
+  for (; i + sizeof (guint64) <= len; i += sizeof (guint64))
+    {
+      guint64 word;
+
+      memcpy (&word, str + i, sizeof (word));
+      if (word & G_GUINT64_CONSTANT (0x8080808080808080))
+        return FALSE;
+    }
+
+  for (; i < len; i++)
+    if (str[i] & 0x80)
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+ascii_lower (const char *str,
+             gsize       len,
+             char       *out)
+{
+  gsize i;
+
+  for (i = 0; i < len; i++)
+    out[i] = g_ascii_tolower (str[i]);
+  out[len] = '\0';
+}
+
+/* Appends the result for @str to @out, using the Latin table for
+ * non-ASCII characters. Returns %FALSE as soon as a character outside
+ * of the table is found, in which case the whole string has to go
+ * through the slow path.
+ */
+static gboolean
+normalize_latin (const char *str,
+                 gsize       len,
+                 GString    *out)
+{
+  const char * const *table = get_latin_table ();
+  const char *p = str;
+  const char *end = str + len;
+
+  while (p < end)
+    {
+      gunichar c;
+
+      if (!(*p & 0x80))
+        {
+          g_string_append_c (out, g_ascii_tolower (*p));
+          p++;
+          continue;
+        }
+
+      c = g_utf8_get_char_validated (p, end - p);
+      if (c < LATIN_TABLE_FIRST || c > LATIN_TABLE_LAST)
+        return FALSE;
+
+      g_string_append (out, table[c - LATIN_TABLE_FIRST]);
+      p = g_utf8_next_char (p);
+    }
+
+  return TRUE;
+}
+
+char *
+cc_util_normalize_casefold_and_unaccent (const char *str)
+{
+  GString *out;
+  gsize len;
+
+  if (str == NULL)
+    return NULL;
+
+  len = strlen (str);
+
+  if (is_ascii (str, len))
+    {
+      char *result = g_malloc (len + 1);
+
+      ascii_lower (str, len, result);
+      return result;
+    }
+
+  out = g_string_sized_new (len + 1);
+  if (normalize_latin (str, len, out))
+    return g_string_free (out, FALSE);
+
+  g_string_free (out, TRUE);
+  return normalize_casefold_and_unaccent_slow (str);
+}
+
+/**
+ * cc_util_normalize_casefold_and_unaccent_into:
+ * @str: (nullable): the string to normalize
+ * @buffer: the buffer to write the result into
+ *
+ * Same as cc_util_normalize_casefold_and_unaccent(), but the result
+ * replaces the contents of @buffer, so that the same buffer can be
+ * reused for many strings without allocating.
+ *
+ * Returns: the contents of @buffer, or %NULL if @str is %NULL
+ */
+const char *
+cc_util_normalize_casefold_and_unaccent_into (const char *str,
+                                              GString    *buffer)
+{
+  g_autofree gchar *slow = NULL;
+  gsize len;
+
+  g_return_val_if_fail (buffer != NULL, NULL);
+
+  g_string_truncate (buffer, 0);
+
+  if (str == NULL)
+    return NULL;
+
+  len = strlen (str);
+
+  if (is_ascii (str, len))
+    {
+      g_string_set_size (buffer, len);
+      ascii_lower (str, len, buffer->str);
+      return buffer->str;
+    }
+
+  if (normalize_latin (str, len, buffer))
+    return buffer->str;
+
+  slow = normalize_casefold_and_unaccent_slow (str);
+  g_string_assign (buffer, slow);
+
+  return buffer->str;
+}
+
 char *
 cc_util_get_smart_date (GDateTime *date)
 {
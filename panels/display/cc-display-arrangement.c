@@ -39,11 +39,45 @@ struct _CcDisplayArrangement
   gdouble           drag_anchor_x;
   gdouble           drag_anchor_y;
 
+  /* Taken when the drag starts, motion is handled once per frame */
+  SnapGeometry     *drag_geometry;
+  guint             drag_tick_id;
+  gboolean          drag_pending;
+  gdouble           drag_x;
+  gdouble           drag_y;
+
   guint             major_snap_distance;
 };
 
 typedef struct _CcDisplayArrangement CcDisplayArrangement;
 
+typedef struct {
+  CcDisplayMonitor *output;
+  gint              x1, y1, x2, y2;
+} OutputRect;
+
+typedef struct {
+  gint              pos;
+  guint             index;
+} Edge;
+
+typedef enum {
+  EDGE_LEFT,
+  EDGE_RIGHT,
+  EDGE_TOP,
+  EDGE_BOTTOM,
+  N_EDGES
+} EdgeType;
+
+/* Scaled geometry of all outputs that another one can snap to, with their
+ * edges sorted by position so that only nearby outputs need checking. */
+typedef struct {
+  CcDisplayMonitor *snap_output;
+  gint              w, h;
+  GArray           *rects;
+  GArray           *edges[N_EDGES];
+} SnapGeometry;
+
 enum {
   PROP_0,
   PROP_CONFIG,
@@ -124,6 +158,131 @@ get_scaled_geometry (CcDisplayConfig  *config,
   apply_rotation_to_geometry (output, w, h);
 }
 
+static gint
+compare_edges (gconstpointer a,
+               gconstpointer b)
+{
+  const Edge *edge_a = a;
+  const Edge *edge_b = b;
+
+  return (edge_a->pos > edge_b->pos) - (edge_a->pos < edge_b->pos);
+}
+
+static SnapGeometry *
+snap_geometry_new (CcDisplayConfig  *config,
+                   CcDisplayMonitor *snap_output)
+{
+  SnapGeometry *geometry = g_new0 (SnapGeometry, 1);
+  GList *outputs, *l;
+  gint x, y;
+  guint i;
+
+  geometry->snap_output = snap_output;
+  geometry->rects = g_array_new (FALSE, FALSE, sizeof (OutputRect));
+  for (i = 0; i < N_EDGES; i++)
+    geometry->edges[i] = g_array_new (FALSE, FALSE, sizeof (Edge));
+
+  get_scaled_geometry (config, snap_output, &x, &y, &geometry->w, &geometry->h);
+
+  outputs = cc_display_config_get_monitors (config);
+  for (l = outputs; l; l = l->next)
+    {
+      CcDisplayMonitor *output = l->data;
+      OutputRect rect;
+      Edge edge;
+      gint w, h;
+
+      if (output == snap_output)
+        continue;
+
+      if (!cc_display_monitor_is_useful (output))
+        continue;
+
+      get_scaled_geometry (config, output, &rect.x1, &rect.y1, &w, &h);
+      rect.output = output;
+      rect.x2 = rect.x1 + w;
+      rect.y2 = rect.y1 + h;
+
+      edge.index = geometry->rects->len;
+      g_array_append_val (geometry->rects, rect);
+
+      edge.pos = rect.x1;
+      g_array_append_val (geometry->edges[EDGE_LEFT], edge);
+      edge.pos = rect.x2;
+      g_array_append_val (geometry->edges[EDGE_RIGHT], edge);
+      edge.pos = rect.y1;
+      g_array_append_val (geometry->edges[EDGE_TOP], edge);
+      edge.pos = rect.y2;
+      g_array_append_val (geometry->edges[EDGE_BOTTOM], edge);
+    }
+
+  for (i = 0; i < N_EDGES; i++)
+    g_array_sort (geometry->edges[i], compare_edges);
+
+  return geometry;
+}
+
+static void
+snap_geometry_free (SnapGeometry *geometry)
+{
+  guint i;
+
+  g_array_unref (geometry->rects);
+  for (i = 0; i < N_EDGES; i++)
+    g_array_unref (geometry->edges[i]);
+
+  g_free (geometry);
+}
+
+static const OutputRect *
+snap_geometry_lookup (SnapGeometry     *geometry,
+                      CcDisplayMonitor *output)
+{
+  guint i;
+
+  for (i = 0; i < geometry->rects->len; i++)
+    {
+      const OutputRect *rect = &g_array_index (geometry->rects, OutputRect, i);
+
+      if (rect->output == output)
+        return rect;
+    }
+
+  return NULL;
+}
+
+/* Flags every output with an edge of the given type in [lo, hi] */
+static void
+snap_geometry_mark_edges (SnapGeometry *geometry,
+                          EdgeType      type,
+                          gint64        lo,
+                          gint64        hi,
+                          gboolean     *candidates)
+{
+  GArray *edges = geometry->edges[type];
+  guint start = 0, end = edges->len;
+
+  while (start < end)
+    {
+      guint mid = start + (end - start) / 2;
+
+      if (g_array_index (edges, Edge, mid).pos < lo)
+        start = mid + 1;
+      else
+        end = mid;
+    }
+
+  for (; start < edges->len; start++)
+    {
+      const Edge *edge = &g_array_index (edges, Edge, start);
+
+      if (edge->pos > hi)
+        break;
+
+      candidates[edge->index] = TRUE;
+    }
+}
+
 static void
 get_bounding_box (CcDisplayConfig *config,
                   gint            *x1,
@@ -162,6 +321,41 @@ get_bounding_box (CcDisplayConfig *config,
     }
 }
 
+/* Like get_scaled_geometry(), but uses the snapshot while dragging */
+static void
+get_output_geometry (CcDisplayArrangement *self,
+                     CcDisplayMonitor     *output,
+                     int                  *x,
+                     int                  *y,
+                     int                  *w,
+                     int                  *h)
+{
+  if (self->drag_geometry)
+    {
+      const OutputRect *rect;
+
+      if (output == self->drag_geometry->snap_output)
+        {
+          cc_display_monitor_get_geometry (output, x, y, NULL, NULL);
+          *w = self->drag_geometry->w;
+          *h = self->drag_geometry->h;
+          return;
+        }
+
+      rect = snap_geometry_lookup (self->drag_geometry, output);
+      if (rect)
+        {
+          *x = rect->x1;
+          *y = rect->y1;
+          *w = rect->x2 - rect->x1;
+          *h = rect->y2 - rect->y1;
+          return;
+        }
+    }
+
+  get_scaled_geometry (self->config, output, x, y, w, h);
+}
+
 static void
 monitor_get_drawing_rect (CcDisplayArrangement *self,
                           CcDisplayMonitor     *output,
@@ -172,7 +366,7 @@ monitor_get_drawing_rect (CcDisplayArrangement *self,
 {
   gdouble x, y;
 
-  get_scaled_geometry (self->config, output, x1, y1, x2, y2);
+  get_output_geometry (self, output, x1, y1, x2, y2);
 
   /* get_scaled_geometry returns the width and height */
   *x2 = *x1 + *x2;
@@ -318,27 +512,57 @@ maybe_update_snap (SnapData       *snap_data,
 }
 
 static void
-find_best_snapping (CcDisplayConfig   *config,
-                    CcDisplayMonitor  *snap_output,
+find_best_snapping (SnapGeometry      *geometry,
+                    gint               x1,
+                    gint               y1,
                     SnapData          *snap_data)
 {
-  GList *outputs, *l;
-  gint x1, y1, x2, y2;
+  g_autofree gboolean *candidates = NULL;
+  gint x2, y2;
   gint w, h;
+  guint i;
 
   g_assert (snap_data != NULL);
 
-  get_scaled_geometry (config, snap_output, &x1, &y1, &w, &h);
+  w = geometry->w;
+  h = geometry->h;
   x2 = x1 + w;
   y2 = y1 + h;
 
+  candidates = g_new0 (gboolean, geometry->rects->len);
+
+  if (snap_data->major_snap_distance == G_MAXUINT)
+    {
+      for (i = 0; i < geometry->rects->len; i++)
+        candidates[i] = TRUE;
+    }
+  else
+    {
+      gdouble range_x = 1, range_y = 1;
+
+      /* Snapping along the major axis only happens within the snap
+       * distance, so only outputs with an edge that close can matter. */
+      cairo_matrix_transform_distance (&snap_data->to_widget, &range_x, &range_y);
+      range_x = MIN (ceil (snap_data->major_snap_distance / fabs (range_x)) + 1, G_MAXINT);
+      range_y = MIN (ceil (snap_data->major_snap_distance / fabs (range_y)) + 1, G_MAXINT);
+
+      snap_geometry_mark_edges (geometry, EDGE_TOP,
+                                (gint64) y2 - range_y, (gint64) y2 + range_y, candidates);
+      snap_geometry_mark_edges (geometry, EDGE_BOTTOM,
+                                (gint64) y1 - range_y, (gint64) y1 + range_y, candidates);
+      snap_geometry_mark_edges (geometry, EDGE_LEFT,
+                                (gint64) x2 - range_x, (gint64) x2 + range_x, candidates);
+      snap_geometry_mark_edges (geometry, EDGE_RIGHT,
+                                (gint64) x1 - range_x, (gint64) x1 + range_x, candidates);
+    }
+
 #define OVERLAP(_s1, _s2, _t1, _t2) ((_s1) <= (_t2) && (_t1) <= (_s2))
 
-  outputs = cc_display_config_get_monitors (config);
-  for (l = outputs; l; l = l->next)
+  /* Keep the config order, the result depends on it for equal distances */
+  for (i = 0; i < geometry->rects->len; i++)
     {
-      CcDisplayMonitor *output = l->data;
-      gint _x1, _y1, _x2, _y2, _h, _w;
+      const OutputRect *rect = &g_array_index (geometry->rects, OutputRect, i);
+      gint _x1, _y1, _x2, _y2;
       gint bottom_snap_pos;
       gint top_snap_pos;
       gint left_snap_pos;
@@ -346,15 +570,13 @@ find_best_snapping (CcDisplayConfig   *config,
       gdouble dist_x, dist_y;
       gdouble tmp;
 
-      if (output == snap_output)
+      if (!candidates[i])
         continue;
 
-      if (!cc_display_monitor_is_useful (output))
-        continue;
-
-      get_scaled_geometry (config, output, &_x1, &_y1, &_w, &_h);
-      _x2 = _x1 + _w;
-      _y2 = _y1 + _h;
+      _x1 = rect->x1;
+      _y1 = rect->y1;
+      _x2 = rect->x2;
+      _y2 = rect->y2;
 
       top_snap_pos = _y1 - h;
       bottom_snap_pos = _y2;
@@ -503,6 +725,15 @@ on_output_changed_cb (CcDisplayArrangement *self,
   else
     self->major_snap_distance = G_MAXUINT;
 
+  /* Something other than the drag itself changed the layout */
+  if (self->drag_geometry && output != self->drag_geometry->snap_output)
+    {
+      CcDisplayMonitor *snap_output = self->drag_geometry->snap_output;
+
+      g_clear_pointer (&self->drag_geometry, snap_geometry_free);
+      self->drag_geometry = snap_geometry_new (self->config, snap_output);
+    }
+
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
@@ -638,6 +869,65 @@ cc_display_arrangement_draw (GtkDrawingArea *drawing_area,
     }
 }
 
+static void
+update_drag (CcDisplayArrangement *self)
+{
+  gdouble event_x, event_y;
+  gint mon_x, mon_y;
+  SnapData snap_data;
+
+  if (!self->drag_pending)
+    return;
+
+  self->drag_pending = FALSE;
+
+  event_x = self->drag_x;
+  event_y = self->drag_y;
+
+  cairo_matrix_transform_point (&self->to_actual, &event_x, &event_y);
+
+  mon_x = round (event_x - self->drag_anchor_x);
+  mon_y = round (event_y - self->drag_anchor_y);
+
+  /* The monitor is now at the location as if there was no snapping whatsoever. */
+  snap_data.snapped = SNAP_DIR_NONE;
+  snap_data.mon_x = mon_x;
+  snap_data.mon_y = mon_y;
+  snap_data.dist_x = 0;
+  snap_data.dist_y = 0;
+  snap_data.to_widget = self->to_widget;
+  snap_data.major_snap_distance = self->major_snap_distance;
+
+  find_best_snapping (self->drag_geometry, mon_x, mon_y, &snap_data);
+
+  cc_display_monitor_set_position (self->selected_output, snap_data.mon_x, snap_data.mon_y);
+}
+
+static gboolean
+drag_tick_cb (GtkWidget     *widget,
+              GdkFrameClock *frame_clock,
+              gpointer       user_data)
+{
+  CcDisplayArrangement *self = CC_DISPLAY_ARRANGEMENT (widget);
+
+  self->drag_tick_id = 0;
+  update_drag (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+stop_drag (CcDisplayArrangement *self)
+{
+  if (self->drag_tick_id)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->drag_tick_id);
+  self->drag_tick_id = 0;
+  self->drag_pending = FALSE;
+  self->drag_active = FALSE;
+
+  g_clear_pointer (&self->drag_geometry, snap_geometry_free);
+}
+
 static gboolean
 on_click_gesture_pressed_cb (GtkGestureClick      *click_gesture,
                              gint                  n_press,
@@ -671,6 +961,7 @@ on_click_gesture_pressed_cb (GtkGestureClick      *click_gesture,
       self->drag_active = TRUE;
       self->drag_anchor_x = event_x - mon_x;
       self->drag_anchor_y = event_y - mon_y;
+      self->drag_geometry = snap_geometry_new (self->config, output);
     }
 
   return TRUE;
@@ -691,7 +982,9 @@ on_click_gesture_released_cb (GtkGestureClick      *click_gesture,
   if (!self->drag_active)
     return FALSE;
 
-  self->drag_active = FALSE;
+  /* Apply the last motion that hasn't been handled yet */
+  update_drag (self);
+  stop_drag (self);
 
   output = cc_display_arrangement_find_monitor_at (self, x, y);
   gtk_widget_set_cursor_from_name (GTK_WIDGET (self),
@@ -711,9 +1004,6 @@ on_motion_controller_motion_cb (GtkEventControllerMotion *motion_controller,
                                 gdouble                   y,
                                 CcDisplayArrangement     *self)
 {
-  gdouble event_x, event_y;
-  gint mon_x, mon_y;
-  SnapData snap_data;
 
   if (!self->config)
     return FALSE;
@@ -738,28 +1028,13 @@ on_motion_controller_motion_cb (GtkEventControllerMotion *motion_controller,
 
   g_assert (self->selected_output);
 
-  event_x = x;
-  event_y = y;
-
-  cairo_matrix_transform_point (&self->to_actual, &event_x, &event_y);
-
-  mon_x = round (event_x - self->drag_anchor_x);
-  mon_y = round (event_y - self->drag_anchor_y);
-
-  /* The monitor is now at the location as if there was no snapping whatsoever. */
-  snap_data.snapped = SNAP_DIR_NONE;
-  snap_data.mon_x = mon_x;
-  snap_data.mon_y = mon_y;
-  snap_data.dist_x = 0;
-  snap_data.dist_y = 0;
-  snap_data.to_widget = self->to_widget;
-  snap_data.major_snap_distance = self->major_snap_distance;
-
-  cc_display_monitor_set_position (self->selected_output, mon_x, mon_y);
+  /* Only the latest position matters, snap once per frame */
+  self->drag_x = x;
+  self->drag_y = y;
+  self->drag_pending = TRUE;
 
-  find_best_snapping (self->config, self->selected_output, &snap_data);
-
-  cc_display_monitor_set_position (self->selected_output, snap_data.mon_x, snap_data.mon_y);
+  if (!self->drag_tick_id)
+    self->drag_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), drag_tick_cb, NULL, NULL);
 
   return TRUE;
 }
@@ -816,6 +1091,7 @@ cc_display_arrangement_finalize (GObject *object)
   CcDisplayArrangement *self = CC_DISPLAY_ARRANGEMENT (object);
 
   g_clear_object (&self->config);
+  g_clear_pointer (&self->drag_geometry, snap_geometry_free);
 
   G_OBJECT_CLASS (cc_display_arrangement_parent_class)->finalize (object);
 }
@@ -907,7 +1183,7 @@ cc_display_arrangement_set_config (CcDisplayArrangement *self,
     }
   g_clear_object (&self->config);
 
-  self->drag_active = FALSE;
+  stop_drag (self);
 
   /* Listen to all the signals */
   if (config)
@@ -953,6 +1229,7 @@ void
 cc_display_config_snap_output (CcDisplayConfig  *config,
                                CcDisplayMonitor *output)
 {
+  SnapGeometry *geometry;
   SnapData snap_data;
   gint x, y, w, h;
 
@@ -963,6 +1240,7 @@ cc_display_config_snap_output (CcDisplayConfig  *config,
     return;
 
   get_scaled_geometry (config, output, &x, &y, &w, &h);
+  geometry = snap_geometry_new (config, output);
 
   snap_data.snapped = SNAP_DIR_NONE;
   snap_data.mon_x = x;
@@ -972,7 +1250,8 @@ cc_display_config_snap_output (CcDisplayConfig  *config,
   cairo_matrix_init_identity (&snap_data.to_widget);
   snap_data.major_snap_distance = G_MAXUINT;
 
-  find_best_snapping (config, output, &snap_data);
+  find_best_snapping (geometry, x, y, &snap_data);
+  snap_geometry_free (geometry);
 
   cc_display_monitor_set_position (output, snap_data.mon_x, snap_data.mon_y);
 }
@@ -55,12 +55,23 @@ struct _CcDisplayModeDBus
   double preferred_scale;
   GArray *supported_scales;
   guint32 flags;
+
+  /* Width, height and interlacing packed together, see mode_resolution_key() */
+  gint64 resolution_key;
 };
 
 G_DEFINE_TYPE (CcDisplayModeDBus,
                cc_display_mode_dbus,
                CC_TYPE_DISPLAY_MODE)
 
+static gint64
+mode_resolution_key (int      width,
+                     int      height,
+                     gboolean interlaced)
+{
+  return ((gint64) width << 32) | ((gint64) height << 1) | !!interlaced;
+}
+
 static gboolean
 cc_display_mode_dbus_equal (const CcDisplayModeDBus *m1,
                             const CcDisplayModeDBus *m2)
@@ -205,6 +216,9 @@ cc_display_mode_dbus_new_virtual (int     width,
   self->width = width;
   self->height = height;
   self->preferred_scale = preferred_scale;
+  self->resolution_key = mode_resolution_key (width, height, FALSE);
+
+  g_array_unref (self->supported_scales);
   self->supported_scales = g_array_ref (supported_scales);
 
   return self;
@@ -250,6 +264,8 @@ cc_display_mode_dbus_new (CcDisplayMonitorDBus *monitor,
   if (is_interlaced)
     self->flags |= MODE_INTERLACED;
 
+  self->resolution_key = mode_resolution_key (self->width, self->height, is_interlaced);
+
   return self;
 }
 
@@ -345,6 +361,8 @@ struct _CcDisplayMonitorDBus
   int max_height;
 
   GList *modes;
+  /* resolution key -> first mode of that resolution, not owned */
+  GHashTable *modes_by_resolution;
   CcDisplayMode *current_mode;
   CcDisplayMode *preferred_mode;
 
@@ -801,6 +819,7 @@ cc_display_monitor_dbus_init (CcDisplayMonitorDBus *self)
   self->underscanning = UNDERSCANNING_UNSUPPORTED;
   self->max_width = G_MAXINT;
   self->max_height = G_MAXINT;
+  self->modes_by_resolution = g_hash_table_new (g_int64_hash, g_int64_equal);
 }
 
 static void
@@ -814,6 +833,7 @@ cc_display_monitor_dbus_finalize (GObject *object)
   g_free (self->product_serial);
   g_free (self->display_name);
 
+  g_hash_table_destroy (self->modes_by_resolution);
   g_list_free_full (self->modes, g_object_unref);
 
   if (self->logical_monitor)
@@ -860,6 +880,22 @@ cc_display_monitor_dbus_class_init (CcDisplayMonitorDBusClass *klass)
   parent_class->set_scale = cc_display_monitor_dbus_set_scale;
 }
 
+static void
+index_modes (CcDisplayMonitorDBus *self)
+{
+  GList *l;
+
+  g_hash_table_remove_all (self->modes_by_resolution);
+
+  for (l = self->modes; l; l = l->next)
+    {
+      CcDisplayModeDBus *mode = l->data;
+
+      if (!g_hash_table_contains (self->modes_by_resolution, &mode->resolution_key))
+        g_hash_table_insert (self->modes_by_resolution, &mode->resolution_key, mode);
+    }
+}
+
 static void
 construct_modes (CcDisplayMonitorDBus *self,
                  GVariantIter *modes)
@@ -883,6 +919,8 @@ construct_modes (CcDisplayMonitorDBus *self,
     }
 
   self->modes = g_list_reverse (self->modes);
+
+  index_modes (self);
 }
 
 static CcDisplayMonitorDBus *
@@ -1101,6 +1139,13 @@ config_apply (CcDisplayConfigDBus *self,
 
   cc_display_config_dbus_ensure_non_offset_coords (self);
 
+  if (!self->proxy)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED,
+                           "No connection to the display configuration service");
+      return FALSE;
+    }
+
   retval = g_dbus_proxy_call_sync (self->proxy,
                                    "ApplyMonitorsConfig",
                                    build_apply_parameters (self, method),
@@ -1282,95 +1327,50 @@ cc_display_config_dbus_set_cloning (CcDisplayConfig *pself,
     }
 }
 
-static gboolean
-mode_supports_scale (CcDisplayMode *mode,
-                     double         scale)
-{
-  g_autoptr(GArray) scales = NULL;
-  int i;
-
-  scales = cc_display_mode_get_supported_scales (mode);
-  for (i = 0; i < scales->len; i++)
-    {
-      if (G_APPROX_VALUE (scale, g_array_index (scales, double, i),
-                          DBL_EPSILON))
-        return TRUE;
-    }
-
-  return FALSE;
-}
-
-static void
-remove_unsupported_scales (CcDisplayMode *mode,
-                           GArray        *supported_scales)
-{
-  g_autoptr(GArray) mode_scales = NULL;
-  int i;
-
-  mode_scales = cc_display_mode_get_supported_scales (mode);
-  i = 0;
-  while (i < supported_scales->len)
-    {
-      double scale;
-
-      if (i == supported_scales->len)
-        break;
-
-      scale = g_array_index (supported_scales, double, i);
-
-      if (mode_supports_scale (mode, scale))
-        {
-          i++;
-          continue;
-        }
-
-      g_array_remove_range (supported_scales, i, 1);
-    }
-}
-
-static gboolean
-monitor_has_compatible_clone_mode (CcDisplayMonitorDBus *monitor,
-                                   CcDisplayModeDBus    *mode,
-                                   GArray               *supported_scales)
+/*
+ * Returns the scales that can be used with the resolution of @mode when
+ * all monitors mirror it, or %NULL if some monitor lacks that resolution.
+ * Like the monitors themselves, it only considers the first mode of each
+ * resolution.
+ */
+static GArray *
+get_clone_scales (CcDisplayConfigDBus *self,
+                  CcDisplayModeDBus   *mode)
 {
+  g_autoptr(GArray) scales = g_array_copy (mode->supported_scales);
   GList *l;
 
-  for (l = monitor->modes; l; l = l->next)
+  for (l = self->monitors; l; l = l->next)
     {
-      CcDisplayModeDBus *other_mode = l->data;
+      CcDisplayMonitorDBus *monitor = l->data;
+      CcDisplayModeDBus *other_mode;
+      int i;
 
-      if (other_mode->width != mode->width ||
-          other_mode->height != mode->height)
-        continue;
+      other_mode = g_hash_table_lookup (monitor->modes_by_resolution, &mode->resolution_key);
+      if (!other_mode)
+        return NULL;
 
-      if ((other_mode->flags & MODE_INTERLACED) !=
-          (mode->flags & MODE_INTERLACED))
+      if (other_mode == mode)
         continue;
 
-      remove_unsupported_scales (CC_DISPLAY_MODE (other_mode), supported_scales);
+      for (i = scales->len - 1; i >= 0; i--)
+        {
+          double scale = g_array_index (scales, double, i);
 
-      return TRUE;
+          if (!cc_display_mode_dbus_is_supported_scale (CC_DISPLAY_MODE (other_mode), scale))
+            g_array_remove_index (scales, i);
+        }
     }
 
-  return FALSE;
+  return g_steal_pointer (&scales);
 }
 
-static gboolean
-monitors_has_compatible_clone_mode (CcDisplayConfigDBus *self,
-                                    CcDisplayModeDBus   *mode,
-                                    GArray              *supported_scales)
+static void
+clone_scales_free (gpointer data)
 {
-  GList *l;
-
-  for (l = self->monitors; l; l = l->next)
-    {
-      CcDisplayMonitorDBus *monitor = l->data;
-
-      if (!monitor_has_compatible_clone_mode (monitor, mode, supported_scales))
-        return FALSE;
-    }
-
-  return TRUE;
+  /* NULL marks resolutions that can't be mirrored */
+  if (data)
+    g_array_unref (data);
 }
 
 static gboolean
@@ -1394,6 +1394,7 @@ cc_display_config_dbus_generate_cloning_modes (CcDisplayConfig *pself)
 {
   CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
   CcDisplayMonitorDBus *base_monitor = NULL;
+  g_autoptr(GHashTable) clone_scales = NULL;
   GList *l;
   GList *clone_modes = NULL;
   CcDisplayModeDBus *best_mode = NULL;
@@ -1412,31 +1413,43 @@ cc_display_config_dbus_generate_cloning_modes (CcDisplayConfig *pself)
   if (!base_monitor)
     return NULL;
 
+  /* The base monitor usually has several refresh rates per resolution,
+   * only work out the common scales once for each of them. */
+  clone_scales = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                        NULL, clone_scales_free);
+
   for (l = base_monitor->modes; l; l = l->next)
     {
       CcDisplayModeDBus *mode = l->data;
       CcDisplayModeDBus *virtual_mode;
       g_autoptr (GArray) supported_scales = NULL;
+      GArray *scales;
 
-      supported_scales =
-        cc_display_mode_get_supported_scales (CC_DISPLAY_MODE (mode));
+      if (!g_hash_table_lookup_extended (clone_scales, &mode->resolution_key,
+                                         NULL, (gpointer *) &scales))
+        {
+          scales = get_clone_scales (self, mode);
+          g_hash_table_insert (clone_scales, &mode->resolution_key, scales);
+        }
 
-      if (!monitors_has_compatible_clone_mode (self, mode, supported_scales))
+      if (!scales)
         continue;
 
+      supported_scales = g_array_copy (scales);
       virtual_mode = cc_display_mode_dbus_new_virtual (mode->width,
                                                        mode->height,
                                                        mode->preferred_scale,
                                                        supported_scales);
-      clone_modes = g_list_append (clone_modes, virtual_mode);
+      clone_modes = g_list_prepend (clone_modes, virtual_mode);
 
       if (!best_mode || is_mode_better (virtual_mode, best_mode))
         best_mode = virtual_mode;
     }
 
-  best_mode->flags |= MODE_PREFERRED;
+  if (best_mode)
+    best_mode->flags |= MODE_PREFERRED;
 
-  return clone_modes;
+  return g_list_reverse (clone_modes);
 }
 
 static gboolean
@@ -1507,9 +1520,9 @@ static GArray *
 cc_display_mode_dbus_get_supported_scales (CcDisplayMode *pself)
 {
   CcDisplayModeDBus *self = CC_DISPLAY_MODE_DBUS (pself);
-  CcDisplayConfig *config = CC_DISPLAY_CONFIG (self->monitor->config);
 
-  if (cc_display_config_is_cloning (config))
+  /* Virtual clone modes already only carry the scales all monitors share */
+  if (self->monitor && cc_display_config_is_cloning (CC_DISPLAY_CONFIG (self->monitor->config)))
     {
       GArray *scales = g_array_copy (self->supported_scales);
       int i;
@@ -1572,6 +1585,8 @@ filter_out_invalid_scaled_modes (CcDisplayConfigDBus *self)
                 }
             }
         }
+
+      index_modes (monitor);
     }
 }
 
@@ -1820,19 +1835,24 @@ cc_display_config_dbus_constructed (GObject *object)
   construct_monitors (self, monitors, logical_monitors);
   filter_out_invalid_scaled_modes (self);
 
-  self->proxy = g_dbus_proxy_new_sync (self->connection,
-                                       G_DBUS_PROXY_FLAGS_NONE,
-                                       NULL,
-                                       "org.gnome.Mutter.DisplayConfig",
-                                       "/org/gnome/Mutter/DisplayConfig",
-                                       "org.gnome.Mutter.DisplayConfig",
-                                       NULL,
-                                       &error);
-  if (error)
-    g_warning ("Could not create DisplayConfig proxy: %s", error->message);
-
-  g_signal_connect (self->proxy, "g-properties-changed",
-                    G_CALLBACK (proxy_properties_changed_cb), self);
+  /* Without a connection the state can still be inspected, e.g. by tests */
+  if (self->connection)
+    {
+      self->proxy = g_dbus_proxy_new_sync (self->connection,
+                                           G_DBUS_PROXY_FLAGS_NONE,
+                                           NULL,
+                                           "org.gnome.Mutter.DisplayConfig",
+                                           "/org/gnome/Mutter/DisplayConfig",
+                                           "org.gnome.Mutter.DisplayConfig",
+                                           NULL,
+                                           &error);
+      if (error)
+        g_warning ("Could not create DisplayConfig proxy: %s", error->message);
+      else
+        g_signal_connect (self->proxy, "g-properties-changed",
+                          G_CALLBACK (proxy_properties_changed_cb), self);
+    }
+
   update_panel_orientation_managed (self);
 
   G_OBJECT_CLASS (cc_display_config_dbus_parent_class)->constructed (object);
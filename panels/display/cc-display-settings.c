@@ -23,6 +23,7 @@
 #include <glib/gi18n.h>
 #include <float.h>
 #include <math.h>
+#include <string.h>
 #include "cc-display-settings.h"
 #include "cc-display-config.h"
 
@@ -46,6 +47,15 @@ struct _CcDisplaySettings
   GListStore       *resolution_list;
   GListModel       *scale_list;
 
+  /* The lists above are derived from the modes of the selected output
+   * and only rebuilt when those change, see rebuild_mode_lists(). */
+  gboolean          mode_lists_valid;
+  gboolean          mode_lists_cloning;
+  GHashTable       *refresh_rates;
+  guint             refresh_rate_key;
+  CcDisplayMode    *extra_resolution;
+  GArray           *scales;
+
   GtkWidget        *enabled_listbox;
   AdwActionRow     *enabled_row;
   GtkSwitch        *enabled_switch;
@@ -231,187 +241,263 @@ sort_modes_by_freq_desc (CcDisplayMode *a, CcDisplayMode *b)
   return delta;
 }
 
-static gboolean
-cc_display_settings_rebuild_ui (CcDisplaySettings *self)
+static gint
+compare_modes_by_area_desc (gconstpointer a,
+                            gconstpointer b)
 {
-  GtkWidget *child;
-  g_autolist(CcDisplayMode) clone_modes = NULL;
-  GList *modes;
-  GList *item;
-  gint width, height;
-  CcDisplayMode *current_mode;
-  GtkToggleButton *group = NULL;
-  g_autoptr(GArray) scales = NULL;
-  gint i;
+  return sort_modes_by_area_desc (*(CcDisplayMode **) a, *(CcDisplayMode **) b);
+}
 
-  self->idle_udpate_id = 0;
+static gint
+compare_modes_by_freq_desc (gconstpointer a,
+                            gconstpointer b)
+{
+  return sort_modes_by_freq_desc (*(CcDisplayMode **) a, *(CcDisplayMode **) b);
+}
 
-  if (!self->config || !self->selected_output)
-    {
-      gtk_widget_set_visible (self->enabled_listbox, FALSE);
-      gtk_widget_set_visible (self->orientation_row, FALSE);
-      gtk_widget_set_visible (self->refresh_rate_row, FALSE);
-      gtk_widget_set_visible (self->resolution_row, FALSE);
-      gtk_widget_set_visible (self->scale_combo_row, FALSE);
-      gtk_widget_set_visible (self->scale_buttons_row, FALSE);
-      gtk_widget_set_visible (self->underscanning_row, FALSE);
+static guint
+resolution_key (CcDisplayMode *mode)
+{
+  int width, height;
 
-      return G_SOURCE_REMOVE;
-    }
+  /* Mutter limits monitor sizes well below 65536 pixels */
+  cc_display_mode_get_resolution (mode, &width, &height);
+  return ((guint) width << 16) | ((guint) height & 0xffff);
+}
 
-  g_object_freeze_notify ((GObject*) self->enabled_switch);
-  g_object_freeze_notify ((GObject*) self->orientation_row);
-  g_object_freeze_notify ((GObject*) self->refresh_rate_row);
-  g_object_freeze_notify ((GObject*) self->resolution_row);
-  g_object_freeze_notify ((GObject*) self->scale_combo_row);
-  g_object_freeze_notify ((GObject*) self->underscanning_switch);
+static gboolean
+scales_equal (GArray *a,
+              GArray *b)
+{
+  if (!a || !b || a->len != b->len)
+    return FALSE;
 
-  cc_display_monitor_get_geometry (self->selected_output, NULL, NULL, &width, &height);
+  return memcmp (a->data, b->data, a->len * sizeof (double)) == 0;
+}
 
-  /* Selecte the first mode we can find if the monitor is disabled. */
-  current_mode = cc_display_monitor_get_mode (self->selected_output);
-  if (current_mode == NULL)
-    current_mode = cc_display_monitor_get_preferred_mode (self->selected_output);
-  if (current_mode == NULL) {
-    modes = cc_display_monitor_get_modes (self->selected_output);
-    /* Lets assume that a monitor always has at least one mode. */
-    g_assert (modes);
-    current_mode = CC_DISPLAY_MODE (modes->data);
-  }
+static void
+invalidate_mode_lists (CcDisplaySettings *self)
+{
+  self->mode_lists_valid = FALSE;
+}
 
-  /* Enabled Switch */
-  adw_preferences_row_set_title (ADW_PREFERENCES_ROW (self->enabled_row),
-                                 cc_display_monitor_get_ui_name (self->selected_output));
-  gtk_switch_set_active (GTK_SWITCH (self->enabled_switch),
-                         cc_display_monitor_is_active (self->selected_output));
+/* Builds everything that only depends on the set of modes of the
+ * selected output: the orientations, the sorted resolutions and the
+ * refresh rates available for each of them. */
+static void
+rebuild_mode_lists (CcDisplaySettings *self)
+{
+  g_autolist(CcDisplayMode) clone_modes = NULL;
+  g_autoptr(GPtrArray) resolutions = NULL;
+  CcDisplayRotation rotations[] = { CC_DISPLAY_ROTATION_NONE,
+                                    CC_DISPLAY_ROTATION_90,
+                                    CC_DISPLAY_ROTATION_270,
+                                    CC_DISPLAY_ROTATION_180 };
+  GHashTableIter iter;
+  GPtrArray *rates;
+  GList *modes, *l;
+  guint i;
+
+  self->mode_lists_valid = TRUE;
+  self->mode_lists_cloning = cc_display_config_is_cloning (self->config);
+  self->refresh_rate_key = G_MAXUINT;
+  self->extra_resolution = NULL;
+  g_clear_pointer (&self->scales, g_array_unref);
+  g_hash_table_remove_all (self->refresh_rates);
 
-  if (should_show_rotation (self))
+  gtk_string_list_splice (GTK_STRING_LIST (self->orientation_list),
+                          0,
+                          g_list_model_get_n_items (self->orientation_list),
+                          NULL);
+  for (i = 0; i < G_N_ELEMENTS (rotations); i++)
     {
-      guint i;
-      CcDisplayRotation rotations[] = { CC_DISPLAY_ROTATION_NONE,
-                                        CC_DISPLAY_ROTATION_90,
-                                        CC_DISPLAY_ROTATION_270,
-                                        CC_DISPLAY_ROTATION_180 };
-
-      gtk_widget_set_visible (self->orientation_row, TRUE);
-
-      gtk_string_list_splice (GTK_STRING_LIST (self->orientation_list),
-                              0,
-                              g_list_model_get_n_items (self->orientation_list),
-                              NULL);
-      for (i = 0; i < G_N_ELEMENTS (rotations); i++)
-        {
-          g_autoptr(GObject) obj = NULL;
+      g_autoptr(GObject) obj = NULL;
 
-          if (!cc_display_monitor_supports_rotation (self->selected_output, rotations[i]))
-            continue;
+      if (!cc_display_monitor_supports_rotation (self->selected_output, rotations[i]))
+        continue;
 
-          gtk_string_list_append (GTK_STRING_LIST (self->orientation_list),
-                                  string_for_rotation (rotations[i]));
-          obj = g_list_model_get_item (self->orientation_list, i);
-          g_object_set_data (G_OBJECT (obj), "rotation-value", GINT_TO_POINTER (rotations[i]));
+      gtk_string_list_append (GTK_STRING_LIST (self->orientation_list),
+                              string_for_rotation (rotations[i]));
+      obj = g_list_model_get_item (self->orientation_list,
+                                   g_list_model_get_n_items (self->orientation_list) - 1);
+      g_object_set_data (G_OBJECT (obj), "rotation-value", GINT_TO_POINTER (rotations[i]));
+    }
 
-          if (cc_display_monitor_get_rotation (self->selected_output) == rotations[i])
-            adw_combo_row_set_selected (ADW_COMBO_ROW (self->orientation_row),
-                                        g_list_model_get_n_items (G_LIST_MODEL (self->orientation_list)) - 1);
-        }
+  if (self->mode_lists_cloning)
+    {
+      clone_modes = cc_display_config_generate_cloning_modes (self->config);
+      modes = clone_modes;
     }
   else
     {
-      gtk_widget_set_visible (self->orientation_row, FALSE);
+      modes = cc_display_monitor_get_modes (self->selected_output);
     }
 
-  /* Only show refresh rate if we are not in cloning mode. */
-  if (!cc_display_config_is_cloning (self->config))
+  /* The first mode of each resolution represents it in the resolution list */
+  resolutions = g_ptr_array_new ();
+  for (l = modes; l != NULL; l = l->next)
     {
-      GList *item;
-      gdouble freq;
+      CcDisplayMode *mode = CC_DISPLAY_MODE (l->data);
+      guint key = resolution_key (mode);
 
-      freq = cc_display_mode_get_freq_f (current_mode);
+      rates = g_hash_table_lookup (self->refresh_rates, GUINT_TO_POINTER (key));
+      if (!rates)
+        {
+          rates = g_ptr_array_new_with_free_func (g_object_unref);
+          g_hash_table_insert (self->refresh_rates, GUINT_TO_POINTER (key), rates);
+          g_ptr_array_add (resolutions, mode);
+        }
 
-      modes = cc_display_monitor_get_modes (self->selected_output);
+      /* At some point we used to filter very close resolutions,
+       * but we don't anymore these days.
+       */
+      g_ptr_array_add (rates, g_object_ref (mode));
+    }
 
-      g_list_store_remove_all (self->refresh_rate_list);
+  g_ptr_array_sort (resolutions, compare_modes_by_area_desc);
 
-      for (item = modes; item != NULL; item = item->next)
-        {
-          gint w, h;
-          guint new;
-          CcDisplayMode *mode = CC_DISPLAY_MODE (item->data);
-
-          cc_display_mode_get_resolution (mode, &w, &h);
-          if (w != width || h != height)
-            continue;
-
-          /* At some point we used to filter very close resolutions,
-           * but we don't anymore these days.
-           */
-          new = g_list_store_insert_sorted (self->refresh_rate_list,
-                                            mode,
-                                            (GCompareDataFunc) sort_modes_by_freq_desc,
-                                            NULL);
-          if (freq == cc_display_mode_get_freq_f (mode))
-            adw_combo_row_set_selected (ADW_COMBO_ROW (self->refresh_rate_row), new);
-        }
+  g_hash_table_iter_init (&iter, self->refresh_rates);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &rates))
+    g_ptr_array_sort (rates, compare_modes_by_freq_desc);
 
-      gtk_widget_set_visible (self->refresh_rate_row, TRUE);
+  g_list_store_splice (self->resolution_list,
+                       0,
+                       g_list_model_get_n_items (G_LIST_MODEL (self->resolution_list)),
+                       resolutions->pdata,
+                       resolutions->len);
+}
+
+static void
+update_orientation (CcDisplaySettings *self)
+{
+  CcDisplayRotation rotation;
+  guint i, n_items;
+
+  if (!should_show_rotation (self))
+    {
+      gtk_widget_set_visible (self->orientation_row, FALSE);
+      return;
     }
-  else
+
+  gtk_widget_set_visible (self->orientation_row, TRUE);
+
+  rotation = cc_display_monitor_get_rotation (self->selected_output);
+  n_items = g_list_model_get_n_items (self->orientation_list);
+  for (i = 0; i < n_items; i++)
     {
-      gtk_widget_set_visible (self->refresh_rate_row, FALSE);
+      g_autoptr(GObject) obj = g_list_model_get_item (self->orientation_list, i);
+
+      if (GPOINTER_TO_INT (g_object_get_data (obj, "rotation-value")) == rotation)
+        {
+          adw_combo_row_set_selected (ADW_COMBO_ROW (self->orientation_row), i);
+          break;
+        }
     }
+}
 
+static void
+update_resolution (CcDisplaySettings *self,
+                   CcDisplayMode     *current_mode)
+{
+  guint key = resolution_key (current_mode);
+  guint i, n_items;
 
   /* Resolutions are always shown. */
   gtk_widget_set_visible (self->resolution_row, TRUE);
-  if (cc_display_config_is_cloning (self->config))
+
+  if (self->extra_resolution)
     {
-      clone_modes = cc_display_config_generate_cloning_modes (self->config);
-      modes = clone_modes;
+      if (g_list_store_find (self->resolution_list, self->extra_resolution, &i))
+        g_list_store_remove (self->resolution_list, i);
+      self->extra_resolution = NULL;
     }
-  else
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (self->resolution_list));
+  for (i = 0; i < n_items; i++)
     {
-      modes = cc_display_monitor_get_modes (self->selected_output);
+      g_autoptr(CcDisplayMode) mode = NULL;
+
+      mode = g_list_model_get_item (G_LIST_MODEL (self->resolution_list), i);
+      if (resolution_key (mode) == key)
+        {
+          adw_combo_row_set_selected (ADW_COMBO_ROW (self->resolution_row), i);
+          return;
+        }
+    }
+
+  /* The current resolution may not be one all outputs can mirror, still
+   * show it until another one is picked. */
+  for (i = 0; i < n_items; i++)
+    {
+      g_autoptr(CcDisplayMode) mode = NULL;
+
+      mode = g_list_model_get_item (G_LIST_MODEL (self->resolution_list), i);
+      if (sort_modes_by_area_desc (current_mode, mode) < 0)
+        break;
+    }
+
+  g_list_store_insert (self->resolution_list, i, current_mode);
+  adw_combo_row_set_selected (ADW_COMBO_ROW (self->resolution_row), i);
+  self->extra_resolution = current_mode;
+}
+
+static void
+update_refresh_rate (CcDisplaySettings *self,
+                     CcDisplayMode     *current_mode)
+{
+  guint key;
+  gdouble freq;
+  guint i, n_items;
+
+  /* Only show refresh rate if we are not in cloning mode. */
+  if (self->mode_lists_cloning)
+    {
+      gtk_widget_set_visible (self->refresh_rate_row, FALSE);
+      return;
     }
 
-  g_list_store_remove_all (self->resolution_list);
-  g_list_store_append (self->resolution_list, current_mode);
-  adw_combo_row_set_selected (ADW_COMBO_ROW (self->resolution_row), 0);
-  for (item = modes; item != NULL; item = item->next)
+  gtk_widget_set_visible (self->refresh_rate_row, TRUE);
+
+  /* The list only needs to change along with the resolution */
+  key = resolution_key (current_mode);
+  if (key != self->refresh_rate_key)
     {
-      gint ins;
-      gint w, h;
-      CcDisplayMode *mode = CC_DISPLAY_MODE (item->data);
+      GPtrArray *rates = g_hash_table_lookup (self->refresh_rates, GUINT_TO_POINTER (key));
+
+      self->refresh_rate_key = key;
+      g_list_store_splice (self->refresh_rate_list,
+                           0,
+                           g_list_model_get_n_items (G_LIST_MODEL (self->refresh_rate_list)),
+                           rates ? rates->pdata : NULL,
+                           rates ? rates->len : 0);
+    }
 
-      cc_display_mode_get_resolution (mode, &w, &h);
+  freq = cc_display_mode_get_freq_f (current_mode);
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (self->refresh_rate_list));
+  for (i = 0; i < n_items; i++)
+    {
+      g_autoptr(CcDisplayMode) mode = NULL;
 
-      /* Find the appropriate insertion point. */
-      for (ins = 0; ins < g_list_model_get_n_items (G_LIST_MODEL (self->resolution_list)); ins++)
+      mode = g_list_model_get_item (G_LIST_MODEL (self->refresh_rate_list), i);
+      if (freq == cc_display_mode_get_freq_f (mode))
         {
-          g_autoptr(CcDisplayMode) m = NULL;
-          gint cmp;
-
-          m = g_list_model_get_item (G_LIST_MODEL (self->resolution_list), ins);
-
-          cmp = sort_modes_by_area_desc (mode, m);
-          /* Next item is smaller, insert at this point. */
-          if (cmp < 0)
-            break;
-
-          /* Don't insert if it is already in the list */
-          if (cmp == 0)
-            {
-              ins = -1;
-              break;
-            }
+          adw_combo_row_set_selected (ADW_COMBO_ROW (self->refresh_rate_row), i);
+          break;
         }
-
-        if (ins >= 0)
-          g_list_store_insert (self->resolution_list, ins, mode);
     }
+}
 
+static void
+rebuild_scales (CcDisplaySettings *self,
+                GArray            *scales)
+{
+  GtkWidget *child;
+  GtkToggleButton *group = NULL;
+  guint i;
+
+  g_clear_pointer (&self->scales, g_array_unref);
+  self->scales = g_array_ref (scales);
 
-  /* Scale row is usually shown. */
   while ((child = gtk_widget_get_first_child (self->scale_bbox)) != NULL)
     gtk_box_remove (GTK_BOX (self->scale_bbox), child);
 
@@ -419,7 +505,7 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
                           0,
                           g_list_model_get_n_items (self->scale_list),
                           NULL);
-  scales = cc_display_mode_get_supported_scales (current_mode);
+
   self->num_scales = scales->len;
   for (i = 0; i < scales->len; i++)
     {
@@ -427,20 +513,14 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
       g_autoptr(GObject) value_object = NULL;
       double scale = g_array_index (scales, double, i);
       GtkWidget *scale_btn;
-      gboolean is_selected;
 
       /* ComboRow */
       scale_str = make_scale_string (scale);
-      is_selected = G_APPROX_VALUE (cc_display_monitor_get_scale (self->selected_output),
-                                    scale, DBL_EPSILON);
 
       gtk_string_list_append (GTK_STRING_LIST (self->scale_list), scale_str);
       value_object = g_list_model_get_item (self->scale_list, i);
       g_object_set_data_full (G_OBJECT (value_object), "scale",
                               g_memdup2 (&scale, sizeof (double)), g_free);
-      if (is_selected)
-        adw_combo_row_set_selected (ADW_COMBO_ROW (self->scale_combo_row),
-                                    g_list_model_get_n_items (G_LIST_MODEL (self->scale_list)) - 1);
 
       /* ButtonBox */
       scale_btn = gtk_toggle_button_new_with_label (scale_str);
@@ -451,31 +531,133 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
       if (!group)
         group = GTK_TOGGLE_BUTTON (scale_btn);
       gtk_box_append (GTK_BOX (self->scale_bbox), scale_btn);
-      /* Set active before connecting the signal */
-      if (is_selected)
-        gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (scale_btn), TRUE);
 
       g_signal_connect_object (scale_btn,
                                "notify::active",
                                G_CALLBACK (on_scale_btn_active_changed_cb),
                                self, 0);
     }
+
   cc_display_settings_refresh_layout (self, self->folded);
+}
+
+static void
+update_scale (CcDisplaySettings *self,
+              CcDisplayMode     *current_mode)
+{
+  g_autoptr(GArray) scales = NULL;
+  GtkWidget *child;
+  double current_scale;
+  guint i;
+
+  /* Scale row is usually shown. */
+  scales = cc_display_mode_get_supported_scales (current_mode);
+  if (!scales_equal (scales, self->scales))
+    rebuild_scales (self, scales);
+
+  current_scale = cc_display_monitor_get_scale (self->selected_output);
+
+  for (i = 0; i < scales->len; i++)
+    {
+      if (G_APPROX_VALUE (current_scale, g_array_index (scales, double, i), DBL_EPSILON))
+        {
+          adw_combo_row_set_selected (ADW_COMBO_ROW (self->scale_combo_row), i);
+          break;
+        }
+    }
+
+  for (child = gtk_widget_get_first_child (self->scale_bbox);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      double scale = *(gdouble*) g_object_get_data (G_OBJECT (child), "scale");
+
+      if (G_APPROX_VALUE (current_scale, scale, DBL_EPSILON))
+        {
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (child), TRUE);
+          break;
+        }
+    }
+}
+
+static void
+cc_display_settings_update_ui (CcDisplaySettings *self)
+{
+  GList *modes;
+  CcDisplayMode *current_mode;
+
+  g_clear_handle_id (&self->idle_udpate_id, g_source_remove);
+
+  if (!self->config || !self->selected_output)
+    {
+      gtk_widget_set_visible (self->enabled_listbox, FALSE);
+      gtk_widget_set_visible (self->orientation_row, FALSE);
+      gtk_widget_set_visible (self->refresh_rate_row, FALSE);
+      gtk_widget_set_visible (self->resolution_row, FALSE);
+      gtk_widget_set_visible (self->scale_combo_row, FALSE);
+      gtk_widget_set_visible (self->scale_buttons_row, FALSE);
+      gtk_widget_set_visible (self->underscanning_row, FALSE);
+
+      return;
+    }
+
+  /* Selection changes below must not be taken for user input */
+  self->updating = TRUE;
+
+  g_object_freeze_notify ((GObject*) self->enabled_switch);
+  g_object_freeze_notify ((GObject*) self->orientation_row);
+  g_object_freeze_notify ((GObject*) self->refresh_rate_row);
+  g_object_freeze_notify ((GObject*) self->resolution_row);
+  g_object_freeze_notify ((GObject*) self->scale_combo_row);
+  g_object_freeze_notify ((GObject*) self->underscanning_switch);
+
+  /* Selecte the first mode we can find if the monitor is disabled. */
+  current_mode = cc_display_monitor_get_mode (self->selected_output);
+  if (current_mode == NULL)
+    current_mode = cc_display_monitor_get_preferred_mode (self->selected_output);
+  if (current_mode == NULL) {
+    modes = cc_display_monitor_get_modes (self->selected_output);
+    /* Lets assume that a monitor always has at least one mode. */
+    g_assert (modes);
+    current_mode = CC_DISPLAY_MODE (modes->data);
+  }
+
+  if (!self->mode_lists_valid ||
+      self->mode_lists_cloning != cc_display_config_is_cloning (self->config))
+    rebuild_mode_lists (self);
+
+  /* Enabled Switch */
+  adw_preferences_row_set_title (ADW_PREFERENCES_ROW (self->enabled_row),
+                                 cc_display_monitor_get_ui_name (self->selected_output));
+  gtk_switch_set_active (GTK_SWITCH (self->enabled_switch),
+                         cc_display_monitor_is_active (self->selected_output));
+
+  update_orientation (self);
+  update_refresh_rate (self, current_mode);
+  update_resolution (self, current_mode);
+  update_scale (self, current_mode);
 
   gtk_widget_set_visible (self->underscanning_row,
                           cc_display_monitor_supports_underscanning (self->selected_output) &&
-                          !cc_display_config_is_cloning (self->config));
+                          !self->mode_lists_cloning);
   gtk_switch_set_active (GTK_SWITCH (self->underscanning_switch),
                          cc_display_monitor_get_underscanning (self->selected_output));
 
-  self->updating = TRUE;
   g_object_thaw_notify ((GObject*) self->enabled_switch);
   g_object_thaw_notify ((GObject*) self->orientation_row);
   g_object_thaw_notify ((GObject*) self->refresh_rate_row);
   g_object_thaw_notify ((GObject*) self->resolution_row);
   g_object_thaw_notify ((GObject*) self->scale_combo_row);
   g_object_thaw_notify ((GObject*) self->underscanning_switch);
+
   self->updating = FALSE;
+}
+
+static gboolean
+update_ui_idle_cb (CcDisplaySettings *self)
+{
+  self->idle_udpate_id = 0;
+  cc_display_settings_update_ui (self);
 
   return G_SOURCE_REMOVE;
 }
@@ -491,7 +673,17 @@ on_output_changed_cb (CcDisplaySettings *self,
   if (self->idle_udpate_id)
     return;
 
-  self->idle_udpate_id = g_idle_add ((GSourceFunc) cc_display_settings_rebuild_ui, self);
+  self->idle_udpate_id = g_idle_add ((GSourceFunc) update_ui_idle_cb, self);
+}
+
+static void
+on_output_modes_changed_cb (CcDisplaySettings *self,
+                            GParamSpec        *pspec,
+                            CcDisplayMonitor  *output)
+{
+  /* Enabling or disabling outputs changes what can be mirrored */
+  invalidate_mode_lists (self);
+  on_output_changed_cb (self, pspec, output);
 }
 
 static void
@@ -701,9 +893,10 @@ cc_display_settings_finalize (GObject *object)
   g_clear_object (&self->resolution_list);
   g_clear_object (&self->scale_list);
 
-  if (self->idle_udpate_id)
-    g_source_remove (self->idle_udpate_id);
-  self->idle_udpate_id = 0;
+  g_clear_pointer (&self->refresh_rates, g_hash_table_unref);
+  g_clear_pointer (&self->scales, g_array_unref);
+
+  g_clear_handle_id (&self->idle_udpate_id, g_source_remove);
 
   G_OBJECT_CLASS (cc_display_settings_parent_class)->finalize (object);
 }
@@ -779,6 +972,8 @@ cc_display_settings_init (CcDisplaySettings *self)
   self->refresh_rate_list = g_list_store_new (CC_TYPE_DISPLAY_MODE);
   self->resolution_list = g_list_store_new (CC_TYPE_DISPLAY_MODE);
   self->scale_list = G_LIST_MODEL (gtk_string_list_new (NULL));
+  self->refresh_rates = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                               NULL, (GDestroyNotify) g_ptr_array_unref);
 
   self->updating = TRUE;
 
@@ -825,7 +1020,7 @@ cc_display_settings_set_has_accelerometer (CcDisplaySettings    *self,
 {
   self->has_accelerometer = has_accelerometer;
 
-  cc_display_settings_rebuild_ui (self);
+  cc_display_settings_update_ui (self);
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_CONFIG]);
 }
 
@@ -839,7 +1034,8 @@ void
 cc_display_settings_set_config (CcDisplaySettings *self,
                                 CcDisplayConfig   *config)
 {
-  const gchar *signals[] = { "rotation", "mode", "scale", "is-usable", "active" };
+  const gchar *signals[] = { "rotation", "mode", "scale" };
+  const gchar *modes_signals[] = { "is-usable", "active" };
   GList *outputs, *l;
   guint i;
 
@@ -867,9 +1063,13 @@ cc_display_settings_set_config (CcDisplaySettings *self,
 
           for (i = 0; i < G_N_ELEMENTS (signals); ++i)
             g_signal_connect_object (output, signals[i], G_CALLBACK (on_output_changed_cb), self, G_CONNECT_SWAPPED);
+          for (i = 0; i < G_N_ELEMENTS (modes_signals); ++i)
+            g_signal_connect_object (output, modes_signals[i], G_CALLBACK (on_output_modes_changed_cb), self, G_CONNECT_SWAPPED);
         }
     }
 
+  invalidate_mode_lists (self);
+
   cc_display_settings_set_selected_output (self, NULL);
 
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_CONFIG]);
@@ -885,9 +1085,12 @@ void
 cc_display_settings_set_selected_output (CcDisplaySettings *self,
                                          CcDisplayMonitor  *output)
 {
+  if (self->selected_output != output)
+    invalidate_mode_lists (self);
+
   self->selected_output = output;
 
-  cc_display_settings_rebuild_ui (self);
+  cc_display_settings_update_ui (self);
 
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_SELECTED_OUTPUT]);
 }
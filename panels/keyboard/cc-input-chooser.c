@@ -17,12 +17,14 @@
 
 #include <config.h>
 #include <locale.h>
+#include <string.h>
 #include <glib/gi18n.h>
 
 #define GNOME_DESKTOP_USE_UNSTABLE_API
 #include <libgnome-desktop/gnome-languages.h>
 
 #include "cc-common-language.h"
+#include "cc-locale-catalogue.h"
 #include "cc-util.h"
 #include "cc-input-chooser.h"
 #include "cc-input-source-ibus.h"
@@ -40,17 +42,73 @@
 
 typedef enum
 {
-  ROW_TRAVEL_DIRECTION_NONE,
-  ROW_TRAVEL_DIRECTION_FORWARD,
-  ROW_TRAVEL_DIRECTION_BACKWARD
-} RowTravelDirection;
+  INPUT_ITEM_LOCALE,
+  INPUT_ITEM_SOURCE,
+  INPUT_ITEM_BACK,
+  INPUT_ITEM_MORE
+} InputItemKind;
 
-typedef enum
+typedef struct _LocaleInfo LocaleInfo;
+
+/* Items of both levels of the chooser: the locales, and the input
+ * sources of the locale being browsed. Filter keys are computed once,
+ * when the item is created. */
+#define CC_TYPE_INPUT_ITEM (cc_input_item_get_type ())
+G_DECLARE_FINAL_TYPE (CcInputItem, cc_input_item, CC, INPUT_ITEM, GObject)
+
+struct _CcInputItem
 {
-  ROW_LABEL_POSITION_START,
-  ROW_LABEL_POSITION_CENTER,
-  ROW_LABEL_POSITION_END
-} RowLabelPosition;
+  GObject        parent_instance;
+
+  InputItemKind  kind;
+  LocaleInfo    *locale;
+
+  const gchar   *type;
+  const gchar   *id;
+  gchar         *name;
+  gchar         *unaccented_name;
+
+  gboolean       is_default;
+  gboolean       is_extra;
+};
+
+G_DEFINE_TYPE (CcInputItem, cc_input_item, G_TYPE_OBJECT)
+
+static void
+cc_input_item_finalize (GObject *object)
+{
+  CcInputItem *self = CC_INPUT_ITEM (object);
+
+  g_free (self->name);
+  g_free (self->unaccented_name);
+
+  G_OBJECT_CLASS (cc_input_item_parent_class)->finalize (object);
+}
+
+static void
+cc_input_item_class_init (CcInputItemClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = cc_input_item_finalize;
+}
+
+static void
+cc_input_item_init (CcInputItem *self)
+{
+}
+
+static CcInputItem *
+cc_input_item_new (InputItemKind  kind,
+                   LocaleInfo    *locale)
+{
+  CcInputItem *self = g_object_new (CC_TYPE_INPUT_ITEM, NULL);
+
+  self->kind = kind;
+  self->locale = locale;
+
+  return self;
+}
 
 struct _CcInputChooser
 {
@@ -58,12 +116,23 @@ struct _CcInputChooser
 
   GtkButton         *add_button;
   GtkSearchEntry    *filter_entry;
-  GtkListBox        *input_sources_listbox;
+  GtkListView       *input_sources_listview;
+  GtkStack          *list_stack;
+  GtkWidget         *list_scrolled_window;
   GtkLabel          *login_label;
-  GtkListBoxRow     *more_row;
   GtkWidget         *no_results;
   GtkAdjustment     *scroll_adjustment;
 
+  GListStore        *locale_store;
+  GListStore        *source_store;
+  GtkFilter         *filter;
+  GtkFilterListModel *locale_filter_model;
+  GtkFilterListModel *source_filter_model;
+  GtkNoSelection    *locale_selection;
+  GtkSingleSelection *source_selection;
+  CcInputItem       *more_item;
+  LocaleInfo        *current_locale;
+
   GnomeXkbInfo      *xkb_info;
   GHashTable        *ibus_engines;
   GHashTable        *locales;
@@ -77,18 +146,18 @@ struct _CcInputChooser
 
 G_DEFINE_TYPE (CcInputChooser, cc_input_chooser, GTK_TYPE_DIALOG)
 
-typedef struct
+struct _LocaleInfo
 {
   gchar *id;
   gchar *name;
   gchar *unaccented_name;
   gchar *untranslated_name;
-  GtkListBoxRow *default_input_source_row;
-  GtkListBoxRow *locale_row;
-  GtkListBoxRow *back_row;
-  GHashTable *layout_rows_by_id;
-  GHashTable *engine_rows_by_id;
-} LocaleInfo;
+  CcInputItem *default_input_source;
+  CcInputItem *locale_item;
+  CcInputItem *back_item;
+  GHashTable *layouts_by_id;
+  GHashTable *engines_by_id;
+};
 
 static void
 locale_info_free (gpointer data)
@@ -99,14 +168,45 @@ locale_info_free (gpointer data)
   g_free (info->name);
   g_free (info->unaccented_name);
   g_free (info->untranslated_name);
-  g_clear_object (&info->default_input_source_row);
-  g_clear_object (&info->locale_row);
-  g_clear_object (&info->back_row);
-  g_hash_table_destroy (info->layout_rows_by_id);
-  g_hash_table_destroy (info->engine_rows_by_id);
+  g_clear_object (&info->default_input_source);
+  g_clear_object (&info->locale_item);
+  g_clear_object (&info->back_item);
+  g_hash_table_destroy (info->layouts_by_id);
+  g_hash_table_destroy (info->engines_by_id);
   g_free (info);
 }
 
+static LocaleInfo *
+locale_info_new (const gchar *id,
+                 const gchar *name,
+                 const gchar *unaccented_name,
+                 const gchar *untranslated_name)
+{
+  LocaleInfo *info;
+
+  info = g_new0 (LocaleInfo, 1);
+  info->id = g_strdup (id);
+  info->name = g_strdup (name);
+  info->unaccented_name = g_strdup (unaccented_name);
+  info->untranslated_name = g_strdup (untranslated_name);
+
+  /* We don't own these ids */
+  info->layouts_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               NULL, g_object_unref);
+  info->engines_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               NULL, g_object_unref);
+
+  return info;
+}
+
+static gboolean
+locale_info_has_sources (LocaleInfo *info)
+{
+  return info->default_input_source ||
+         g_hash_table_size (info->layouts_by_id) ||
+         g_hash_table_size (info->engines_by_id);
+}
+
 static void
 set_row_widget_margins (GtkWidget *widget)
 {
@@ -117,219 +217,208 @@ set_row_widget_margins (GtkWidget *widget)
 }
 
 static GtkWidget *
-padded_label_new (const gchar        *text,
-                  RowLabelPosition    position,
-                  RowTravelDirection  direction,
-                  gboolean            dim_label)
+no_results_widget_new (void)
 {
-  GtkWidget *widget;
   GtkWidget *label;
-  GtkWidget *arrow;
-  GtkAlign alignment;
 
-  if (position == ROW_LABEL_POSITION_START)
-    alignment = GTK_ALIGN_START;
-  else if (position == ROW_LABEL_POSITION_CENTER)
-    alignment = GTK_ALIGN_CENTER;
-  else
-    alignment = GTK_ALIGN_END;
+  label = gtk_label_new (_("No input sources found"));
+  gtk_widget_set_valign (label, GTK_ALIGN_CENTER);
+  set_row_widget_margins (label);
+  gtk_style_context_add_class (gtk_widget_get_style_context (label), "dim-label");
 
-  widget = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  return label;
+}
 
-  if (direction == ROW_TRAVEL_DIRECTION_BACKWARD)
-    {
-      arrow = gtk_image_new_from_icon_name ("go-previous-symbolic");
-      gtk_box_append (GTK_BOX (widget), arrow);
-    }
+static CcInputItem *
+input_source_item_new (CcInputChooser *self,
+                       LocaleInfo     *info,
+                       const gchar    *type,
+                       const gchar    *id)
+{
+  CcInputItem *item;
+  gchar *display_name = NULL;
 
-  label = gtk_label_new (text);
-  gtk_label_set_ellipsize (GTK_LABEL (label), PANGO_ELLIPSIZE_MIDDLE);
-  gtk_widget_set_hexpand (label, TRUE);
-  gtk_widget_set_halign (label, alignment);
-  set_row_widget_margins (label);
-  gtk_box_append (GTK_BOX (widget), label);
-  if (dim_label)
-    gtk_style_context_add_class (gtk_widget_get_style_context (label), "dim-label");
+  if (g_str_equal (type, INPUT_SOURCE_TYPE_XKB))
+    {
+      const gchar *name;
 
-  if (direction == ROW_TRAVEL_DIRECTION_FORWARD)
+      gnome_xkb_info_get_layout_info (self->xkb_info, id, &name, NULL, NULL, NULL);
+      display_name = g_strdup (name);
+    }
+  else if (g_str_equal (type, INPUT_SOURCE_TYPE_IBUS))
     {
-      arrow = gtk_image_new_from_icon_name ("go-next-symbolic");
-      gtk_box_append (GTK_BOX (widget), arrow);
+#ifdef HAVE_IBUS
+      display_name = engine_get_display_name (g_hash_table_lookup (self->ibus_engines, id));
+#endif  /* HAVE_IBUS */
     }
 
-  return widget;
+  if (!display_name)
+    return NULL;
+
+  item = cc_input_item_new (INPUT_ITEM_SOURCE, info);
+  item->type = type;
+  item->id = id;
+  item->name = display_name;
+  item->unaccented_name = cc_util_normalize_casefold_and_unaccent (display_name);
+
+  return item;
 }
 
-static GtkListBoxRow *
-more_row_new (void)
+static void
+setup_row_cb (CcInputChooser           *self,
+              GtkListItem              *list_item,
+              GtkSignalListItemFactory *factory)
 {
-  GtkWidget *row;
   GtkWidget *box;
-  GtkWidget *arrow;
+  GtkWidget *back_arrow;
+  GtkWidget *label;
+  GtkWidget *engine_image;
+  GtkWidget *more_image;
 
-  row = gtk_list_box_row_new ();
   box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-  gtk_list_box_row_set_child (GTK_LIST_BOX_ROW (row), box);
-  gtk_widget_set_tooltip_text (row, _("More…"));
 
-  arrow = gtk_image_new_from_icon_name ("view-more-symbolic");
-  gtk_widget_set_hexpand (arrow, TRUE);
-  set_row_widget_margins (arrow);
-  gtk_box_append (GTK_BOX (box), arrow);
+  back_arrow = gtk_image_new_from_icon_name ("go-previous-symbolic");
+  gtk_box_append (GTK_BOX (box), back_arrow);
 
-  return GTK_LIST_BOX_ROW (row);
-}
+  label = gtk_label_new (NULL);
+  gtk_label_set_ellipsize (GTK_LABEL (label), PANGO_ELLIPSIZE_MIDDLE);
+  gtk_widget_set_hexpand (label, TRUE);
+  set_row_widget_margins (label);
+  gtk_box_append (GTK_BOX (box), label);
 
-static GtkWidget *
-no_results_widget_new (void)
-{
-  return padded_label_new (_("No input sources found"), ROW_LABEL_POSITION_CENTER, ROW_TRAVEL_DIRECTION_NONE, TRUE);
-}
+  engine_image = gtk_image_new_from_icon_name ("system-run-symbolic");
+  set_row_widget_margins (engine_image);
+  gtk_box_append (GTK_BOX (box), engine_image);
 
-static GtkListBoxRow *
-back_row_new (const gchar *text)
-{
-  GtkWidget *row;
-  GtkWidget *widget;
+  more_image = gtk_image_new_from_icon_name ("view-more-symbolic");
+  gtk_widget_set_hexpand (more_image, TRUE);
+  set_row_widget_margins (more_image);
+  gtk_box_append (GTK_BOX (box), more_image);
 
-  row = gtk_list_box_row_new ();
-  widget = padded_label_new (text, ROW_LABEL_POSITION_CENTER, ROW_TRAVEL_DIRECTION_BACKWARD, TRUE);
-  gtk_list_box_row_set_child (GTK_LIST_BOX_ROW (row), widget);
+  g_object_set_data (G_OBJECT (box), "back-arrow", back_arrow);
+  g_object_set_data (G_OBJECT (box), "label", label);
+  g_object_set_data (G_OBJECT (box), "engine-image", engine_image);
+  g_object_set_data (G_OBJECT (box), "more-image", more_image);
 
-  return GTK_LIST_BOX_ROW (row);
+  gtk_list_item_set_child (list_item, box);
 }
 
-static GtkListBoxRow *
-locale_row_new (const gchar *text)
+static void
+bind_row_cb (CcInputChooser           *self,
+             GtkListItem              *list_item,
+             GtkSignalListItemFactory *factory)
 {
-  GtkWidget *row;
-  GtkWidget *widget;
-
-  row = gtk_list_box_row_new ();
-  widget = padded_label_new (text, ROW_LABEL_POSITION_CENTER, ROW_TRAVEL_DIRECTION_NONE, FALSE);
-  gtk_list_box_row_set_child (GTK_LIST_BOX_ROW (row), widget);
+  CcInputItem *item;
+  GtkWidget *box;
+  GtkWidget *label;
 
-  return GTK_LIST_BOX_ROW (row);
-}
+  item = gtk_list_item_get_item (list_item);
+  box = gtk_list_item_get_child (list_item);
+  label = g_object_get_data (G_OBJECT (box), "label");
 
-static GtkListBoxRow *
-input_source_row_new (CcInputChooser *self,
-                      const gchar    *type,
-                      const gchar    *id)
-{
-  GtkWidget *row = NULL;
-  GtkWidget *widget;
+  gtk_widget_set_visible (g_object_get_data (G_OBJECT (box), "back-arrow"),
+                          item->kind == INPUT_ITEM_BACK);
+  gtk_widget_set_visible (g_object_get_data (G_OBJECT (box), "engine-image"),
+                          item->kind == INPUT_ITEM_SOURCE && g_str_equal (item->type, INPUT_SOURCE_TYPE_IBUS));
+  gtk_widget_set_visible (g_object_get_data (G_OBJECT (box), "more-image"),
+                          item->kind == INPUT_ITEM_MORE);
+  gtk_widget_set_visible (label, item->kind != INPUT_ITEM_MORE);
+  gtk_widget_set_tooltip_text (box, item->kind == INPUT_ITEM_MORE ? _("More…") : NULL);
 
-  if (g_str_equal (type, INPUT_SOURCE_TYPE_XKB))
+  switch (item->kind)
     {
-      const gchar *display_name;
-
-      gnome_xkb_info_get_layout_info (self->xkb_info, id, &display_name, NULL, NULL, NULL);
-
-      row = gtk_list_box_row_new ();
-      widget = padded_label_new (display_name,
-                                 ROW_LABEL_POSITION_START,
-                                 ROW_TRAVEL_DIRECTION_NONE,
-                                 FALSE);
-      gtk_list_box_row_set_child (GTK_LIST_BOX_ROW (row), widget);
-      g_object_set_data (G_OBJECT (row), "name", (gpointer) display_name);
-      g_object_set_data_full (G_OBJECT (row), "unaccented-name",
-                              cc_util_normalize_casefold_and_unaccent (display_name), g_free);
+    case INPUT_ITEM_LOCALE:
+      gtk_label_set_label (GTK_LABEL (label), item->locale->name);
+      gtk_widget_set_halign (label, GTK_ALIGN_CENTER);
+      gtk_style_context_remove_class (gtk_widget_get_style_context (label), "dim-label");
+      break;
+
+    case INPUT_ITEM_BACK:
+      gtk_label_set_label (GTK_LABEL (label), item->locale->name);
+      gtk_widget_set_halign (label, GTK_ALIGN_CENTER);
+      gtk_style_context_add_class (gtk_widget_get_style_context (label), "dim-label");
+      break;
+
+    case INPUT_ITEM_SOURCE:
+      gtk_label_set_label (GTK_LABEL (label), item->name);
+      gtk_widget_set_halign (label, GTK_ALIGN_START);
+      gtk_style_context_remove_class (gtk_widget_get_style_context (label), "dim-label");
+      break;
+
+    case INPUT_ITEM_MORE:
+    default:
+      break;
     }
-  else if (g_str_equal (type, INPUT_SOURCE_TYPE_IBUS))
-    {
-#ifdef HAVE_IBUS
-      gchar *display_name;
-      GtkWidget *image;
-
-      display_name = engine_get_display_name (g_hash_table_lookup (self->ibus_engines, id));
-
-      row = gtk_list_box_row_new ();
-      widget = padded_label_new (display_name,
-                                 ROW_LABEL_POSITION_START,
-                                 ROW_TRAVEL_DIRECTION_NONE,
-                                 FALSE);
-      gtk_list_box_row_set_child (GTK_LIST_BOX_ROW (row), widget);
-
-      image = gtk_image_new_from_icon_name ("system-run-symbolic");
-      set_row_widget_margins (image);
-      gtk_box_append (GTK_BOX (widget), image);
-
-      g_object_set_data_full (G_OBJECT (row), "name", display_name, g_free);
-      g_object_set_data_full (G_OBJECT (row), "unaccented-name",
-                              cc_util_normalize_casefold_and_unaccent (display_name), g_free);
-#else
-      widget = NULL;
-#endif  /* HAVE_IBUS */
-    }
-
-  if (row)
-    {
-      g_object_set_data (G_OBJECT (row), "type", (gpointer) type);
-      g_object_set_data (G_OBJECT (row), "id", (gpointer) id);
+}
 
-      return GTK_LIST_BOX_ROW (row);
-    }
+static void
+reset_view (CcInputChooser *self)
+{
+  gtk_adjustment_set_value (self->scroll_adjustment,
+                            gtk_adjustment_get_lower (self->scroll_adjustment));
 
-  return NULL;
+  if (gtk_widget_is_visible (GTK_WIDGET (self->filter_entry)) &&
+      !gtk_widget_is_focus (GTK_WIDGET (self->filter_entry)))
+    gtk_widget_grab_focus (GTK_WIDGET (self->filter_entry));
 }
 
-static void
-remove_all_rows (GtkListBox *listbox)
+static gint
+source_sort (gconstpointer a,
+             gconstpointer b,
+             gpointer      user_data)
 {
-  GtkWidget *child;
+  CcInputItem *ia = CC_INPUT_ITEM ((gpointer) a);
+  CcInputItem *ib = CC_INPUT_ITEM ((gpointer) b);
 
-  while ((child = gtk_widget_get_first_child (GTK_WIDGET (listbox))) != NULL)
-    gtk_list_box_remove (listbox, child);
+  /* The default input source always goes first in its group */
+  if (ia->is_default)
+    return -1;
+  if (ib->is_default)
+    return 1;
+
+  return g_strcmp0 (ia->name, ib->name);
 }
 
 static void
-add_input_source_rows_for_locale (CcInputChooser *self,
-                                  LocaleInfo     *info)
+append_items (GPtrArray  *items,
+              GHashTable *table)
 {
-  GtkWidget *row;
   GHashTableIter iter;
-  const gchar *id;
-
-  if (info->default_input_source_row)
-    gtk_list_box_append (self->input_sources_listbox, GTK_WIDGET (info->default_input_source_row));
+  gpointer item;
 
-  g_hash_table_iter_init (&iter, info->layout_rows_by_id);
-  while (g_hash_table_iter_next (&iter, (gpointer *) &id, (gpointer *) &row))
-    gtk_list_box_append (self->input_sources_listbox, row);
-
-  g_hash_table_iter_init (&iter, info->engine_rows_by_id);
-  while (g_hash_table_iter_next (&iter, (gpointer *) &id, (gpointer *) &row))
-    gtk_list_box_append (self->input_sources_listbox, row);
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, NULL, &item))
+    g_ptr_array_add (items, item);
 }
 
 static void
 show_input_sources_for_locale (CcInputChooser *self,
                                LocaleInfo     *info)
 {
-  remove_all_rows (self->input_sources_listbox);
+  g_autoptr(GPtrArray) items = NULL;
 
-  if (!info->back_row)
-    {
-      info->back_row = g_object_ref_sink (back_row_new (info->name));
-      gtk_widget_show (GTK_WIDGET (info->back_row));
-      g_object_set_data (G_OBJECT (info->back_row), "back", GINT_TO_POINTER (TRUE));
-      g_object_set_data (G_OBJECT (info->back_row), "locale-info", info);
-    }
-  gtk_list_box_append (self->input_sources_listbox, GTK_WIDGET (info->back_row));
+  self->current_locale = info;
 
-  add_input_source_rows_for_locale (self, info);
+  if (!info->back_item)
+    info->back_item = cc_input_item_new (INPUT_ITEM_BACK, info);
 
-  gtk_adjustment_set_value (self->scroll_adjustment,
-                            gtk_adjustment_get_lower (self->scroll_adjustment));
-  gtk_list_box_invalidate_filter (self->input_sources_listbox);
-  gtk_list_box_set_selection_mode (self->input_sources_listbox, GTK_SELECTION_SINGLE);
-  gtk_list_box_set_activate_on_single_click (self->input_sources_listbox, FALSE);
-  gtk_list_box_unselect_all (self->input_sources_listbox);
+  items = g_ptr_array_new ();
+  if (info->default_input_source)
+    g_ptr_array_add (items, info->default_input_source);
+  append_items (items, info->layouts_by_id);
+  append_items (items, info->engines_by_id);
+  g_ptr_array_sort_with_data (items, (GCompareDataFunc) source_sort, NULL);
+  g_ptr_array_insert (items, 0, info->back_item);
 
-  if (gtk_widget_is_visible (GTK_WIDGET (self->filter_entry)) &&
-      !gtk_widget_is_focus (GTK_WIDGET (self->filter_entry)))
-    gtk_widget_grab_focus (GTK_WIDGET (self->filter_entry));
+  g_list_store_splice (self->source_store,
+                       0, g_list_model_get_n_items (G_LIST_MODEL (self->source_store)),
+                       items->pdata, items->len);
+
+  gtk_single_selection_set_selected (self->source_selection, GTK_INVALID_LIST_POSITION);
+  gtk_list_view_set_model (self->input_sources_listview, GTK_SELECTION_MODEL (self->source_selection));
+  gtk_list_view_set_single_click_activate (self->input_sources_listview, FALSE);
+
+  reset_view (self);
 }
 
 static gboolean
@@ -338,103 +427,67 @@ is_current_locale (const gchar *locale)
   return g_strcmp0 (setlocale (LC_CTYPE, NULL), locale) == 0;
 }
 
+static gint
+locale_sort (gconstpointer a,
+             gconstpointer b)
+{
+  CcInputItem *ia = *(CcInputItem **) a;
+  CcInputItem *ib = *(CcInputItem **) b;
+
+  /* The "Other" locale always goes at the end */
+  if (!ia->locale->id[0] && ib->locale->id[0])
+    return 1;
+  else if (ia->locale->id[0] && !ib->locale->id[0])
+    return -1;
+
+  return g_strcmp0 (ia->locale->name, ib->locale->name);
+}
+
 static void
 show_locale_rows (CcInputChooser *self)
 {
   g_autoptr(GHashTable) initial = NULL;
+  g_autoptr(GPtrArray) items = NULL;
   LocaleInfo *info;
   GHashTableIter iter;
 
-  remove_all_rows (self->input_sources_listbox);
+  self->current_locale = NULL;
 
   if (!self->showing_extra)
     initial = cc_common_language_get_initial_languages ();
 
+  items = g_ptr_array_new ();
+
   g_hash_table_iter_init (&iter, self->locales);
   while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
     {
-      if (!info->default_input_source_row &&
-          !g_hash_table_size (info->layout_rows_by_id) &&
-          !g_hash_table_size (info->engine_rows_by_id))
+      if (!locale_info_has_sources (info))
         continue;
 
-      if (!info->locale_row)
+      if (!info->locale_item)
         {
-          info->locale_row = g_object_ref_sink (locale_row_new (info->name));
-          gtk_widget_show (GTK_WIDGET (info->locale_row));
-          g_object_set_data (G_OBJECT (info->locale_row), "locale-info", info);
-
-          if (!self->showing_extra &&
-              !g_hash_table_contains (initial, info->id) &&
-              !is_current_locale (info->id))
-            g_object_set_data (G_OBJECT (info->locale_row), "is-extra", GINT_TO_POINTER (TRUE));
+          info->locale_item = cc_input_item_new (INPUT_ITEM_LOCALE, info);
+          info->locale_item->is_extra = !self->showing_extra &&
+                                        !g_hash_table_contains (initial, info->id) &&
+                                        !is_current_locale (info->id);
         }
-      gtk_list_box_append (self->input_sources_listbox, GTK_WIDGET (info->locale_row));
+      g_ptr_array_add (items, info->locale_item);
     }
 
-  gtk_list_box_append (self->input_sources_listbox, GTK_WIDGET (self->more_row));
-
-  gtk_adjustment_set_value (self->scroll_adjustment,
-                            gtk_adjustment_get_lower (self->scroll_adjustment));
-  gtk_list_box_invalidate_filter (self->input_sources_listbox);
-  gtk_list_box_set_selection_mode (self->input_sources_listbox, GTK_SELECTION_NONE);
-  gtk_list_box_set_activate_on_single_click (self->input_sources_listbox, TRUE);
-
-  if (gtk_widget_is_visible (GTK_WIDGET (self->filter_entry)) &&
-      !gtk_widget_is_focus (GTK_WIDGET (self->filter_entry)))
-    gtk_widget_grab_focus (GTK_WIDGET (self->filter_entry));
-}
-
-static gint
-list_sort (GtkListBoxRow *a,
-           GtkListBoxRow *b,
-           gpointer       data)
-{
-  CcInputChooser *self = data;
-  LocaleInfo *ia;
-  LocaleInfo *ib;
-  const gchar *la;
-  const gchar *lb;
-  gint retval;
+  g_ptr_array_sort (items, locale_sort);
 
   /* Always goes at the end */
-  if (a == self->more_row)
-    return 1;
-  if (b == self->more_row)
-    return -1;
+  g_ptr_array_add (items, self->more_item);
 
-  ia = g_object_get_data (G_OBJECT (a), "locale-info");
-  ib = g_object_get_data (G_OBJECT (b), "locale-info");
+  g_list_store_splice (self->locale_store,
+                       0, g_list_model_get_n_items (G_LIST_MODEL (self->locale_store)),
+                       items->pdata, items->len);
 
-  /* The "Other" locale always goes at the end */
-  if (!ia->id[0] && ib->id[0])
-    return 1;
-  else if (ia->id[0] && !ib->id[0])
-    return -1;
-
-  retval = g_strcmp0 (ia->name, ib->name);
-  if (retval)
-    return retval;
-
-  la = g_object_get_data (G_OBJECT (a), "name");
-  lb = g_object_get_data (G_OBJECT (b), "name");
-
-  /* Only input sources have a "name" property and they should always
-     go after their respective heading */
-  if (la && !lb)
-    return 1;
-  else if (!la && lb)
-    return -1;
-  else if (!la && !lb)
-    return 0; /* Shouldn't happen */
-
-  /* The default input source always goes first in its group */
-  if (g_object_get_data (G_OBJECT (a), "default"))
-    return -1;
-  if (g_object_get_data (G_OBJECT (b), "default"))
-    return 1;
+  gtk_list_view_set_model (self->input_sources_listview, GTK_SELECTION_MODEL (self->locale_selection));
+  gtk_list_view_set_single_click_activate (self->input_sources_listview, TRUE);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->add_button), FALSE);
 
-  return g_strcmp0 (la, lb);
+  reset_view (self);
 }
 
 static gboolean
@@ -450,88 +503,82 @@ match_all (gchar       **words,
   return TRUE;
 }
 
-static gboolean
-match_default_source_in_table (gchar         **words,
-                               GtkListBoxRow  *row)
-{
-  const gchar *source_name;
-  source_name = g_object_get_data (G_OBJECT (row), "unaccented-name");
-  if (source_name && match_all (words, source_name))
-    return TRUE;
-  return FALSE;
-}
-
 static gboolean
 match_source_in_table (gchar      **words,
                        GHashTable  *table)
 {
   GHashTableIter iter;
-  gpointer row;
-  const gchar *source_name;
+  CcInputItem *item;
 
   g_hash_table_iter_init (&iter, table);
-  while (g_hash_table_iter_next (&iter, NULL, &row))
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &item))
     {
-      source_name = g_object_get_data (G_OBJECT (row), "unaccented-name");
-      if (source_name && match_all (words, source_name))
+      if (match_all (words, item->unaccented_name))
         return TRUE;
     }
   return FALSE;
 }
 
 static gboolean
-list_filter (GtkListBoxRow *row,
-             gpointer       user_data)
+list_filter (gpointer object,
+             gpointer user_data)
 {
   CcInputChooser *self = user_data;
+  CcInputItem *item = object;
   LocaleInfo *info;
-  gboolean is_extra;
-  const gchar *source_name;
 
-  if (row == self->more_row)
+  if (item->kind == INPUT_ITEM_MORE)
     return !self->showing_extra;
 
-  is_extra = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "is-extra"));
-
-  if (!self->showing_extra && is_extra)
+  if (!self->showing_extra && item->is_extra)
     return FALSE;
 
   if (!self->filter_words)
     return TRUE;
 
-  info = g_object_get_data (G_OBJECT (row), "locale-info");
-
-  if (row == info->back_row)
+  if (item->kind == INPUT_ITEM_BACK)
     return TRUE;
 
+  info = item->locale;
+
   if (match_all (self->filter_words, info->unaccented_name))
     return TRUE;
 
   if (match_all (self->filter_words, info->untranslated_name))
     return TRUE;
 
-  source_name = g_object_get_data (G_OBJECT (row), "unaccented-name");
-  if (source_name)
-    {
-      if (match_all (self->filter_words, source_name))
-        return TRUE;
-    }
-  else
-    {
-      if (info->default_input_source_row &&
-          match_default_source_in_table (self->filter_words, info->default_input_source_row))
-        {
-          return TRUE;
-        }
-      if (match_source_in_table (self->filter_words, info->layout_rows_by_id))
-        return TRUE;
-      if (match_source_in_table (self->filter_words, info->engine_rows_by_id))
-        return TRUE;
-    }
+  if (item->kind == INPUT_ITEM_SOURCE)
+    return match_all (self->filter_words, item->unaccented_name);
+
+  if (info->default_input_source &&
+      match_all (self->filter_words, info->default_input_source->unaccented_name))
+    return TRUE;
+  if (match_source_in_table (self->filter_words, info->layouts_by_id))
+    return TRUE;
+  if (match_source_in_table (self->filter_words, info->engines_by_id))
+    return TRUE;
 
   return FALSE;
 }
 
+static void
+update_empty_state (CcInputChooser *self)
+{
+  GtkFilterListModel *model;
+  gboolean empty;
+
+  model = self->current_locale ? self->source_filter_model : self->locale_filter_model;
+
+  /* Wait for an incremental filter run to finish before deciding */
+  if (gtk_filter_list_model_get_pending (model) > 0)
+    return;
+
+  empty = self->filter_words && self->filter_words[0] &&
+          g_list_model_get_n_items (G_LIST_MODEL (model)) == 0;
+  gtk_stack_set_visible_child (self->list_stack,
+                               empty ? self->no_results : self->list_scrolled_window);
+}
+
 static gboolean
 strvs_differ (gchar **av,
               gchar **bv)
@@ -564,15 +611,17 @@ do_filter (CcInputChooser *self)
 
   if (!self->filter_words[0])
     {
-      gtk_list_box_invalidate_filter (self->input_sources_listbox);
-      gtk_list_box_set_placeholder (self->input_sources_listbox, NULL);
+      g_clear_pointer (&self->filter_words, g_strfreev);
+      if (previous_words != NULL && previous_words[0] != NULL)
+        gtk_filter_changed (self->filter, GTK_FILTER_CHANGE_LESS_STRICT);
     }
   else if (previous_words == NULL || strvs_differ (self->filter_words, previous_words))
     {
-      gtk_list_box_invalidate_filter (self->input_sources_listbox);
-      gtk_list_box_set_placeholder (self->input_sources_listbox, self->no_results);
+      gtk_filter_changed (self->filter, GTK_FILTER_CHANGE_DIFFERENT);
     }
 
+  update_empty_state (self);
+
   return G_SOURCE_REMOVE;
 }
 
@@ -591,57 +640,56 @@ show_more (CcInputChooser *self)
 
   self->showing_extra = TRUE;
 
-  gtk_list_box_invalidate_filter (self->input_sources_listbox);
+  gtk_filter_changed (self->filter, GTK_FILTER_CHANGE_LESS_STRICT);
 }
 
 static void
-on_input_sources_listbox_row_activated_cb (CcInputChooser *self, GtkListBoxRow  *row)
+on_input_sources_listview_activate_cb (CcInputChooser *self,
+                                       guint           position)
 {
-  gpointer data;
+  g_autoptr(CcInputItem) item = NULL;
+  GListModel *model;
 
-  if (!row)
+  model = G_LIST_MODEL (gtk_list_view_get_model (self->input_sources_listview));
+  item = g_list_model_get_item (model, position);
+  if (!item)
     return;
 
-  if (row == self->more_row)
+  switch (item->kind)
     {
+    case INPUT_ITEM_MORE:
       show_more (self);
-      return;
-    }
+      break;
 
-  data = g_object_get_data (G_OBJECT (row), "back");
-  if (data)
-    {
+    case INPUT_ITEM_BACK:
       show_locale_rows (self);
-      return;
-    }
+      break;
 
-  data = g_object_get_data (G_OBJECT (row), "name");
-  if (data)
-    {
+    case INPUT_ITEM_SOURCE:
       if (gtk_widget_is_sensitive (GTK_WIDGET (self->add_button)))
         gtk_dialog_response (GTK_DIALOG (self),
                              gtk_dialog_get_response_for_widget (GTK_DIALOG (self),
                                                                  GTK_WIDGET (self->add_button)));
-      return;
-    }
+      break;
 
-  data = g_object_get_data (G_OBJECT (row), "locale-info");
-  if (data)
-    {
-      show_input_sources_for_locale (self, (LocaleInfo *) data);
-      return;
+    case INPUT_ITEM_LOCALE:
+      show_input_sources_for_locale (self, item->locale);
+      break;
+
+    default:
+      break;
     }
 }
 
 static void
-on_input_sources_listbox_selected_rows_changed_cb (CcInputChooser *self)
+on_source_selection_changed_cb (CcInputChooser *self)
 {
-  gboolean sensitive = TRUE;
-  GtkListBoxRow *row;
+  CcInputItem *item;
+  gboolean sensitive = FALSE;
 
-  row = gtk_list_box_get_selected_row (self->input_sources_listbox);
-  if (!row || g_object_get_data (G_OBJECT (row), "back"))
-    sensitive = FALSE;
+  item = gtk_single_selection_get_selected_item (self->source_selection);
+  if (item && item->kind == INPUT_ITEM_SOURCE)
+    sensitive = TRUE;
 
   gtk_widget_set_sensitive (GTK_WIDGET (self->add_button), sensitive);
 }
@@ -652,14 +700,10 @@ add_default_row (CcInputChooser *self,
                  const gchar    *type,
                  const gchar    *id)
 {
-  info->default_input_source_row = input_source_row_new (self, type, id);
-  if (info->default_input_source_row)
-    {
-      gtk_widget_show (GTK_WIDGET (info->default_input_source_row));
-      g_object_ref_sink (GTK_WIDGET (info->default_input_source_row));
-      g_object_set_data (G_OBJECT (info->default_input_source_row), "default", GINT_TO_POINTER (TRUE));
-      g_object_set_data (G_OBJECT (info->default_input_source_row), "locale-info", info);
-    }
+  g_clear_object (&info->default_input_source);
+  info->default_input_source = input_source_item_new (self, info, type, id);
+  if (info->default_input_source)
+    info->default_input_source->is_default = TRUE;
 }
 
 static void
@@ -670,13 +714,13 @@ add_rows_to_table (CcInputChooser *self,
                    const gchar    *default_id)
 {
   GHashTable *table;
-  GtkListBoxRow *row;
+  CcInputItem *item;
   const gchar *id;
 
   if (g_str_equal (type, INPUT_SOURCE_TYPE_XKB))
-    table = info->layout_rows_by_id;
+    table = info->layouts_by_id;
   else if (g_str_equal (type, INPUT_SOURCE_TYPE_IBUS))
-    table = info->engine_rows_by_id;
+    table = info->engines_by_id;
   else
     return;
 
@@ -684,16 +728,12 @@ add_rows_to_table (CcInputChooser *self,
     {
       id = (const gchar *) list->data;
 
-      /* The widget for the default input source lives elsewhere */
+      /* The item for the default input source lives elsewhere */
       if (g_strcmp0 (id, default_id))
         {
-          row = input_source_row_new (self, type, id);
-          gtk_widget_show (GTK_WIDGET (row));
-          if (row)
-            {
-              g_object_set_data (G_OBJECT (row), "locale-info", info);
-              g_hash_table_replace (table, (gpointer) id, g_object_ref_sink (row));
-            }
+          item = input_source_item_new (self, info, type, id);
+          if (item)
+            g_hash_table_replace (table, (gpointer) id, item);
         }
       list = list->next;
     }
@@ -732,7 +772,7 @@ maybe_set_as_default (CcInputChooser *self,
 
   if (g_str_equal (type, INPUT_SOURCE_TYPE_IBUS) &&
       g_str_equal (id, engine_id) &&
-      info->default_input_source_row == NULL)
+      info->default_input_source == NULL)
     {
       add_default_row (self, info, type, id);
       return TRUE;
@@ -823,13 +863,10 @@ get_ibus_locale_infos (CcInputChooser *self)
 
 static void
 add_locale_to_table (GHashTable  *table,
-                     const gchar *lang_code,
+                     const gchar *language,
                      LocaleInfo  *info)
 {
   GHashTable *set;
-  g_autofree gchar *language = NULL;
-
-  language = gnome_get_language_from_code (lang_code, NULL);
 
   set = g_hash_table_lookup (table, language);
   if (!set)
@@ -840,108 +877,49 @@ add_locale_to_table (GHashTable  *table,
   g_hash_table_add (set, info);
 }
 
-static void
-add_ids_to_set (GHashTable *set,
-                GList      *list)
-{
-  while (list)
-    {
-      g_hash_table_add (set, list->data);
-      list = list->next;
-    }
-}
-
 static void
 get_locale_infos (CcInputChooser *self)
 {
-  g_autoptr(GHashTable) layouts_with_locale = NULL;
   LocaleInfo *info;
-  g_auto(GStrv) locale_ids = NULL;
-  gchar **locale;
-  g_autoptr(GList) all_layouts = NULL;
-  GList *l;
+  GPtrArray *input_locales;
+  const gchar * const *other_layouts;
 
   self->locales = g_hash_table_new_full (g_str_hash, g_str_equal,
                                          g_free, locale_info_free);
   self->locales_by_language = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                      g_free, (GDestroyNotify) g_hash_table_unref);
 
-  layouts_with_locale = g_hash_table_new (g_str_hash, g_str_equal);
-
-  locale_ids = gnome_get_all_locales ();
-  for (locale = locale_ids; *locale; ++locale)
+  input_locales = cc_locale_catalogue_get_input_locales ();
+  for (guint i = 0; i < input_locales->len; i++)
     {
-      g_autofree gchar *lang_code = NULL;
-      g_autofree gchar *country_code = NULL;
-      g_autofree gchar *simple_locale = NULL;
-      g_autofree gchar *tmp = NULL;
-      const gchar *type = NULL;
+      const CcInputLocaleInfo *locale = g_ptr_array_index (input_locales, i);
       const gchar *id = NULL;
-      g_autoptr(GList) language_layouts = NULL;
-
-      if (!gnome_parse_locale (*locale, &lang_code, &country_code, NULL, NULL))
-        continue;
-
-      if (country_code != NULL)
-	simple_locale = g_strdup_printf ("%s_%s.UTF-8", lang_code, country_code);
-      else
-	simple_locale = g_strdup_printf ("%s.UTF-8", lang_code);
-
-      if (g_hash_table_contains (self->locales, simple_locale))
-          continue;
+      GList *layouts = NULL;
 
-      info = g_new0 (LocaleInfo, 1);
-      info->id = g_strdup (simple_locale);
-      info->name = gnome_get_language_from_locale (simple_locale, NULL);
-      info->unaccented_name = cc_util_normalize_casefold_and_unaccent (info->name);
-      tmp = gnome_get_language_from_locale (simple_locale, "C");
-      info->untranslated_name = cc_util_normalize_casefold_and_unaccent (tmp);
+      info = locale_info_new (locale->id, locale->name, locale->name_key, locale->untranslated_name_key);
+      g_hash_table_replace (self->locales, g_strdup (locale->id), info);
+      add_locale_to_table (self->locales_by_language, locale->language, info);
 
-      g_hash_table_replace (self->locales, g_strdup (simple_locale), info);
-      add_locale_to_table (self->locales_by_language, lang_code, info);
-
-      if (gnome_get_input_source_from_locale (simple_locale, &type, &id) &&
-          g_str_equal (type, INPUT_SOURCE_TYPE_XKB))
+      if (locale->input_source_type != NULL &&
+          g_str_equal (locale->input_source_type, INPUT_SOURCE_TYPE_XKB))
         {
-          add_default_row (self, info, type, id);
-          g_hash_table_add (layouts_with_locale, (gpointer) id);
+          id = locale->input_source_id;
+          add_default_row (self, info, locale->input_source_type, id);
         }
 
-      /* We don't own these ids */
-      info->layout_rows_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                       NULL, g_object_unref);
-      info->engine_rows_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                       NULL, g_object_unref);
-
-      language_layouts = gnome_xkb_info_get_layouts_for_language (self->xkb_info, lang_code);
-      add_rows_to_table (self, info, language_layouts, INPUT_SOURCE_TYPE_XKB, id);
-      add_ids_to_set (layouts_with_locale, language_layouts);
-
-      if (country_code != NULL)
-        {
-          g_autoptr(GList) country_layouts = gnome_xkb_info_get_layouts_for_country (self->xkb_info, country_code);
-          add_rows_to_table (self, info, country_layouts, INPUT_SOURCE_TYPE_XKB, id);
-          add_ids_to_set (layouts_with_locale, country_layouts);
-        }
+      for (const gchar **l = locale->layouts; *l; l++)
+        layouts = g_list_prepend (layouts, (gpointer) *l);
+      add_rows_to_table (self, info, layouts, INPUT_SOURCE_TYPE_XKB, id);
+      g_list_free (layouts);
     }
 
   /* Add a "Other" locale to hold the remaining input sources */
-  info = g_new0 (LocaleInfo, 1);
-  info->id = g_strdup ("");
-  info->name = g_strdup (C_("Input Source", "Other"));
-  info->unaccented_name = g_strdup ("");
-  info->untranslated_name = g_strdup ("");
+  info = locale_info_new ("", C_("Input Source", "Other"), "", "");
   g_hash_table_replace (self->locales, g_strdup (info->id), info);
 
-  info->layout_rows_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                   NULL, g_object_unref);
-  info->engine_rows_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                   NULL, g_object_unref);
-
-  all_layouts = gnome_xkb_info_get_all_layouts (self->xkb_info);
-  for (l = all_layouts; l; l = l->next)
-    if (!g_hash_table_contains (layouts_with_locale, l->data))
-      add_row_other (self, INPUT_SOURCE_TYPE_XKB, l->data);
+  other_layouts = cc_locale_catalogue_get_other_layouts ();
+  for (; *other_layouts; other_layouts++)
+    add_row_other (self, INPUT_SOURCE_TYPE_XKB, *other_layouts);
 }
 
 /*
@@ -965,8 +943,14 @@ cc_input_chooser_dispose (GObject *object)
 {
   CcInputChooser *self = CC_INPUT_CHOOSER (object);
 
-  g_clear_object (&self->more_row);
-  g_clear_object (&self->no_results);
+  g_clear_object (&self->more_item);
+  g_clear_object (&self->locale_selection);
+  g_clear_object (&self->source_selection);
+  g_clear_object (&self->locale_filter_model);
+  g_clear_object (&self->source_filter_model);
+  g_clear_object (&self->locale_store);
+  g_clear_object (&self->source_store);
+  g_clear_object (&self->filter);
   g_clear_object (&self->xkb_info);
   g_clear_pointer (&self->ibus_engines, g_hash_table_unref);
   g_clear_pointer (&self->locales, g_hash_table_unref);
@@ -989,12 +973,13 @@ cc_input_chooser_class_init (CcInputChooserClass *klass)
 
   gtk_widget_class_bind_template_child (widget_class, CcInputChooser, add_button);
   gtk_widget_class_bind_template_child (widget_class, CcInputChooser, filter_entry);
-  gtk_widget_class_bind_template_child (widget_class, CcInputChooser, input_sources_listbox);
+  gtk_widget_class_bind_template_child (widget_class, CcInputChooser, input_sources_listview);
+  gtk_widget_class_bind_template_child (widget_class, CcInputChooser, list_stack);
+  gtk_widget_class_bind_template_child (widget_class, CcInputChooser, list_scrolled_window);
   gtk_widget_class_bind_template_child (widget_class, CcInputChooser, login_label);
   gtk_widget_class_bind_template_child (widget_class, CcInputChooser, scroll_adjustment);
 
-  gtk_widget_class_bind_template_callback (widget_class, on_input_sources_listbox_row_activated_cb);
-  gtk_widget_class_bind_template_callback (widget_class, on_input_sources_listbox_selected_rows_changed_cb);
+  gtk_widget_class_bind_template_callback (widget_class, on_input_sources_listview_activate_cb);
   gtk_widget_class_bind_template_callback (widget_class, on_filter_entry_search_changed_cb);
   //gtk_widget_class_bind_template_callback (widget_class, on_filter_entry_key_release_event_cb);
 }
@@ -1002,9 +987,46 @@ cc_input_chooser_class_init (CcInputChooserClass *klass)
 void
 cc_input_chooser_init (CcInputChooser *self)
 {
+  g_autoptr(GtkListItemFactory) factory = NULL;
+
   gtk_widget_init_template (GTK_WIDGET (self));
 
   gtk_search_entry_set_key_capture_widget (self->filter_entry, GTK_WIDGET (self));
+
+  self->no_results = no_results_widget_new ();
+  gtk_stack_add_child (self->list_stack, self->no_results);
+
+  self->more_item = cc_input_item_new (INPUT_ITEM_MORE, NULL);
+
+  /* Both levels share the filter, each with its own recycled rows */
+  self->filter = GTK_FILTER (gtk_custom_filter_new (list_filter, self, NULL));
+
+  self->locale_store = g_list_store_new (CC_TYPE_INPUT_ITEM);
+  self->locale_filter_model = gtk_filter_list_model_new (g_object_ref (G_LIST_MODEL (self->locale_store)),
+                                                         g_object_ref (self->filter));
+  gtk_filter_list_model_set_incremental (self->locale_filter_model, TRUE);
+  self->locale_selection = gtk_no_selection_new (g_object_ref (G_LIST_MODEL (self->locale_filter_model)));
+
+  self->source_store = g_list_store_new (CC_TYPE_INPUT_ITEM);
+  self->source_filter_model = gtk_filter_list_model_new (g_object_ref (G_LIST_MODEL (self->source_store)),
+                                                         g_object_ref (self->filter));
+  self->source_selection = gtk_single_selection_new (g_object_ref (G_LIST_MODEL (self->source_filter_model)));
+  gtk_single_selection_set_autoselect (self->source_selection, FALSE);
+  gtk_single_selection_set_can_unselect (self->source_selection, TRUE);
+  g_signal_connect_object (self->source_selection, "notify::selected",
+                           G_CALLBACK (on_source_selection_changed_cb), self, G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->locale_filter_model, "items-changed",
+                           G_CALLBACK (update_empty_state), self, G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->locale_filter_model, "notify::pending",
+                           G_CALLBACK (update_empty_state), self, G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->source_filter_model, "items-changed",
+                           G_CALLBACK (update_empty_state), self, G_CONNECT_SWAPPED);
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect_object (factory, "setup", G_CALLBACK (setup_row_cb), self, G_CONNECT_SWAPPED);
+  g_signal_connect_object (factory, "bind", G_CALLBACK (bind_row_cb), self, G_CONNECT_SWAPPED);
+  gtk_list_view_set_factory (self->input_sources_listview, factory);
 }
 
 CcInputChooser *
@@ -1023,14 +1045,6 @@ cc_input_chooser_new (gboolean      is_login,
   if (ibus_engines)
     self->ibus_engines = g_hash_table_ref (ibus_engines);
 
-  self->more_row = g_object_ref_sink (more_row_new ());
-  gtk_widget_show (GTK_WIDGET (self->more_row));
-  self->no_results = g_object_ref_sink (no_results_widget_new ());
-  gtk_widget_show (self->no_results);
-
-  gtk_list_box_set_filter_func (self->input_sources_listbox, list_filter, self, NULL);
-  gtk_list_box_set_sort_func (self->input_sources_listbox, list_sort, self, NULL);
-
   if (self->is_login)
     gtk_widget_show (GTK_WIDGET (self->login_label));
 
@@ -1063,25 +1077,21 @@ cc_input_chooser_set_ibus_engines (CcInputChooser *self,
 CcInputSource *
 cc_input_chooser_get_source (CcInputChooser *self)
 {
-  GtkListBoxRow *selected;
-  const gchar *t, *i;
+  CcInputItem *selected;
 
   g_return_val_if_fail (CC_IS_INPUT_CHOOSER (self), FALSE);
 
-  selected = gtk_list_box_get_selected_row (self->input_sources_listbox);
-  if (!selected)
+  if (!self->current_locale)
     return NULL;
 
-  t = g_object_get_data (G_OBJECT (selected), "type");
-  i = g_object_get_data (G_OBJECT (selected), "id");
-
-  if (!t || !i)
-    return FALSE;
+  selected = gtk_single_selection_get_selected_item (self->source_selection);
+  if (!selected || selected->kind != INPUT_ITEM_SOURCE)
+    return NULL;
 
-  if (g_strcmp0 (t, "xkb") == 0)
-    return CC_INPUT_SOURCE (cc_input_source_xkb_new_from_id (self->xkb_info, i));
-  else if (g_strcmp0 (t, "ibus") == 0)
-    return CC_INPUT_SOURCE (cc_input_source_ibus_new (i));
+  if (g_strcmp0 (selected->type, "xkb") == 0)
+    return CC_INPUT_SOURCE (cc_input_source_xkb_new_from_id (self->xkb_info, selected->id));
+  else if (g_strcmp0 (selected->type, "ibus") == 0)
+    return CC_INPUT_SOURCE (cc_input_source_ibus_new (selected->id));
   else
     return NULL;
 }
@@ -30,6 +30,7 @@
 #include "cc-input-row.h"
 #include "cc-input-source-ibus.h"
 #include "cc-input-source-xkb.h"
+#include "cc-locale-catalogue.h"
 
 #ifdef HAVE_IBUS
 #include <ibus.h>
@@ -769,7 +770,8 @@ cc_input_list_box_init (CcInputListBox *self)
 
   self->input_settings = g_settings_new (GNOME_DESKTOP_INPUT_SOURCES_DIR);
 
-  self->xkb_info = gnome_xkb_info_new ();
+  /* The same one the input chooser's layout ids belong to */
+  self->xkb_info = g_object_ref (cc_locale_catalogue_get_xkb_info ());
 
 #ifdef HAVE_IBUS
   ibus_init ();
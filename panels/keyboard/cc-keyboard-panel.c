@@ -30,6 +30,7 @@
 #include "cc-keyboard-resources.h"
 #include "cc-keyboard-shortcut-dialog.h"
 #include "cc-input-list-box.h"
+#include "cc-locale-catalogue.h"
 #include "cc-xkb-modifier-dialog.h"
 
 #include "keyboard-shortcuts.h"
@@ -231,6 +232,9 @@ cc_keyboard_panel_init (CcKeyboardPanel *self)
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
+  /* Have the input source chooser data ready by the time it is opened */
+  cc_locale_catalogue_preload ();
+
   self->input_source_settings = g_settings_new ("org.gnome.desktop.input-sources");
 
   /* "Input Source Switching" section */
@@ -36,8 +36,16 @@ struct _CcWifiConnectionList
 
   NMConnection  *last_active;
 
+  /* Rows waiting for the next frame to reflect AP property changes */
+  GHashTable    *pending_updates;
+  guint          update_tick_id;
+
   GPtrArray     *connections;
   GPtrArray     *connections_row;
+  GHashTable    *connection_to_index;
+
+  /* Maps each AP to the rows it has been added to (usually just one) */
+  GHashTable    *ap_to_rows;
 
   /* AP SSID cache stores the APs SSID used for assigning it to a row.
    * This is necessary to efficiently remove it when its SSID changes.
@@ -111,6 +119,79 @@ connection_ignored (NMConnection *connection)
   return FALSE;
 }
 
+static NMConnection*
+get_active_connection (CcWifiConnectionList *self)
+{
+  NMActiveConnection *ac;
+
+  ac = nm_device_get_active_connection (NM_DEVICE (self->device));
+  if (!ac)
+    return NULL;
+
+  return NM_CONNECTION (nm_active_connection_get_connection (ac));
+}
+
+static gboolean
+find_connection (CcWifiConnectionList *self,
+                 NMConnection         *connection,
+                 guint                *index)
+{
+  gpointer value;
+
+  if (!g_hash_table_lookup_extended (self->connection_to_index, connection, NULL, &value))
+    return FALSE;
+
+  if (index)
+    *index = GPOINTER_TO_UINT (value);
+
+  return TRUE;
+}
+
+static void
+append_connection (CcWifiConnectionList *self,
+                   NMConnection         *connection,
+                   CcWifiConnectionRow  *row)
+{
+  g_hash_table_insert (self->connection_to_index, connection,
+                       GUINT_TO_POINTER (self->connections->len));
+  g_ptr_array_add (self->connections, g_object_ref (connection));
+  g_ptr_array_add (self->connections_row, row);
+}
+
+static void
+remove_connection_index (CcWifiConnectionList *self,
+                         guint                 index)
+{
+  guint i;
+
+  g_hash_table_remove (self->connection_to_index,
+                       g_ptr_array_index (self->connections, index));
+  g_ptr_array_remove_index (self->connections_row, index);
+  g_ptr_array_remove_index (self->connections, index);
+
+  for (i = index; i < self->connections->len; i++)
+    g_hash_table_insert (self->connection_to_index,
+                         g_ptr_array_index (self->connections, i),
+                         GUINT_TO_POINTER (i));
+}
+
+static void
+track_access_point (CcWifiConnectionList *self,
+                    NMAccessPoint        *ap,
+                    CcWifiConnectionRow  *row)
+{
+  GPtrArray *rows;
+
+  rows = g_hash_table_lookup (self->ap_to_rows, ap);
+  if (!rows)
+    {
+      rows = g_ptr_array_new ();
+      g_hash_table_insert (self->ap_to_rows, ap, rows);
+    }
+
+  g_ptr_array_add (rows, row);
+}
+
 static CcWifiConnectionRow*
 cc_wifi_connection_list_row_add (CcWifiConnectionList *self,
                                  NMConnection         *connection,
@@ -140,6 +221,52 @@ cc_wifi_connection_list_row_add (CcWifiConnectionList *self,
   return res;
 }
 
+static void
+cc_wifi_connection_list_row_remove (CcWifiConnectionList *self,
+                                    CcWifiConnectionRow  *row)
+{
+  g_hash_table_remove (self->pending_updates, row);
+
+  g_signal_emit_by_name (self, "remove-row", row);
+  gtk_list_box_remove (self->listbox, GTK_WIDGET (row));
+}
+
+static gboolean
+flush_row_updates_cb (GtkWidget     *widget,
+                      GdkFrameClock *frame_clock,
+                      gpointer       user_data)
+{
+  CcWifiConnectionList *self = CC_WIFI_CONNECTION_LIST (user_data);
+  g_autoptr(GHashTable) rows = NULL;
+  GHashTableIter iter;
+  CcWifiConnectionRow *row;
+
+  self->update_tick_id = 0;
+
+  rows = g_steal_pointer (&self->pending_updates);
+  self->pending_updates = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  g_hash_table_iter_init (&iter, rows);
+  while (g_hash_table_iter_next (&iter, (gpointer*) &row, NULL))
+    cc_wifi_connection_row_update (row);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Access points notify about strength changes all the time, so collect
+ * the affected rows and update each of them once before the next frame. */
+static void
+queue_row_update (CcWifiConnectionList *self,
+                  CcWifiConnectionRow  *row)
+{
+  g_hash_table_add (self->pending_updates, row);
+
+  if (self->update_tick_id == 0)
+    self->update_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self->listbox),
+                                                         flush_row_updates_cb,
+                                                         self, NULL);
+}
+
 static void
 clear_widget (CcWifiConnectionList *self)
 {
@@ -158,8 +285,7 @@ clear_widget (CcWifiConnectionList *self)
   while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &row))
     {
       g_hash_table_iter_remove (&iter);
-      g_signal_emit_by_name (self, "remove-row", row);
-      gtk_list_box_remove (self->listbox, GTK_WIDGET (row));
+      cc_wifi_connection_list_row_remove (self, row);
     }
 
   /* Remove all connection rows */
@@ -170,13 +296,14 @@ clear_widget (CcWifiConnectionList *self)
 
       row = g_ptr_array_index (self->connections_row, i);
       g_ptr_array_index (self->connections_row, i) = NULL;
-      g_signal_emit_by_name (self, "remove-row", row);
-      gtk_list_box_remove (self->listbox, GTK_WIDGET (row));
+      cc_wifi_connection_list_row_remove (self, row);
      }
 
   /* Reset the internal state */
   g_ptr_array_set_size (self->connections, 0);
   g_ptr_array_set_size (self->connections_row, 0);
+  g_hash_table_remove_all (self->connection_to_index);
+  g_hash_table_remove_all (self->ap_to_rows);
   g_hash_table_remove_all (self->ssid_to_row);
   g_hash_table_remove_all (self->ap_ssid_cache);
 }
@@ -187,8 +314,7 @@ update_connections (CcWifiConnectionList *self)
   const GPtrArray *aps;
   const GPtrArray *acs_client;
   g_autoptr(GPtrArray) acs = NULL;
-  NMActiveConnection *ac;
-  NMConnection *ac_con = NULL;
+  NMConnection *ac_con;
   gint i;
 
   /* We don't want full UI rebuilds during some UI interactions, so allow freezing the list. */
@@ -210,14 +336,13 @@ update_connections (CcWifiConnectionList *self)
   for (i = 0; i < acs_client->len; i++)
     g_ptr_array_add (acs, g_ptr_array_index (acs_client, i));
 
-  ac = nm_device_get_active_connection (NM_DEVICE (self->device));
-  if (ac)
-    ac_con = NM_CONNECTION (nm_active_connection_get_connection (ac));
+  ac_con = get_active_connection (self);
+  g_set_object (&self->last_active, ac_con);
 
   if (ac_con && !g_ptr_array_find (acs, ac_con, NULL))
     {
       g_debug ("Adding remote connection for active connection");
-      g_ptr_array_add (acs, g_object_ref (ac_con));
+      g_ptr_array_add (acs, ac_con);
     }
 
   for (i = 0; i < acs->len; i++)
@@ -228,13 +353,12 @@ update_connections (CcWifiConnectionList *self)
       if (connection_ignored (con))
         continue;
 
-      g_ptr_array_add (self->connections, g_object_ref (con));
       if (self->hide_unavailable && con != ac_con)
-        g_ptr_array_add (self->connections_row, NULL);
+        append_connection (self, con, NULL);
       else
-        g_ptr_array_add (self->connections_row,
-                         cc_wifi_connection_list_row_add (self, con,
-                         NULL, TRUE));
+        append_connection (self, con,
+                           cc_wifi_connection_list_row_add (self, con,
+                           NULL, TRUE));
     }
 
   /* Coldplug all known APs again */
@@ -251,57 +375,11 @@ on_row_configured_cb (CcWifiConnectionList *self, CcWifiConnectionRow *row)
   g_signal_emit_by_name (self, "configure", row);
 }
 
+/* Adds the AP to the rows of all connections it is compatible with, or to
+ * the row of its SSID if there are none. */
 static void
-on_access_point_property_changed (CcWifiConnectionList *self,
-                                  GParamSpec           *pspec,
-                                  NMAccessPoint        *ap)
-{
-  CcWifiConnectionRow *row;
-  GBytes *ssid;
-  gboolean has_connection = FALSE;
-  gint i;
-
-  /* If the SSID changed then the AP needs to be added/removed from rows.
-   * Do this by simulating an AP addition/removal.  */
-  if (g_str_equal (pspec->name, NM_ACCESS_POINT_SSID))
-    {
-      g_debug ("Simulating add/remove for SSID change");
-      on_device_ap_removed_cb (self, ap, self->device);
-      on_device_ap_added_cb (self, ap, self->device);
-      return;
-    }
-
-  /* Otherwise, find all rows that contain the AP and update it. Do this by
-   * first searching all rows with connections, and then looking it up in the
-   * SSID rows if not found. */
-  for (i = 0; i < self->connections_row->len; i++)
-    {
-      row = g_ptr_array_index (self->connections_row, i);
-      if (row && cc_wifi_connection_row_has_access_point (row, ap))
-        {
-          cc_wifi_connection_row_update (row);
-          has_connection = TRUE;
-        }
-    }
-
-  if (!self->show_aps || has_connection)
-    return;
-
-  ssid = g_hash_table_lookup (self->ap_ssid_cache, ap);
-  if (!ssid)
-    return;
-
-  row = g_hash_table_lookup (self->ssid_to_row, ssid);
-  if (!row)
-    g_assert_not_reached ();
-  else
-    cc_wifi_connection_row_update (row);
-}
-
-static void
-on_device_ap_added_cb (CcWifiConnectionList *self,
-                       NMAccessPoint        *ap,
-                       NMDeviceWifi         *device)
+place_access_point (CcWifiConnectionList *self,
+                    NMAccessPoint        *ap)
 {
   g_autoptr(GPtrArray) connections = NULL;
   NM80211ApSecurityFlags rsn_flags;
@@ -310,10 +388,6 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
   g_autoptr(GBytes) ssid = NULL;
   guint i, j;
 
-  g_signal_connect_object (ap, "notify",
-                           G_CALLBACK (on_access_point_property_changed),
-                           self, G_CONNECT_SWAPPED);
-
   connections = nm_access_point_filter_connections (ap, self->connections);
 
   /* If this is the active AP, then add the active connection to the list. This
@@ -322,21 +396,18 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
    * So it seems like the dummy AP entry that NM creates internally is not actually
    * compatible with the connection that is being activated.
    */
-  if (ap == nm_device_wifi_get_active_access_point (device))
+  if (ap == nm_device_wifi_get_active_access_point (self->device))
     {
-      NMActiveConnection *ac;
       NMConnection *ac_con;
 
-      ac = nm_device_get_active_connection (NM_DEVICE (self->device));
+      ac_con = get_active_connection (self);
 
-      if (ac)
+      if (ac_con)
         {
           guint idx;
 
-          ac_con = NM_CONNECTION (nm_active_connection_get_connection (ac));
-
           if (!g_ptr_array_find (connections, ac_con, NULL) &&
-              g_ptr_array_find (self->connections, ac_con, &idx))
+              find_connection (self, ac_con, &idx))
             {
               g_debug ("Adding active connection to list of valid connections for AP");
               g_ptr_array_add (connections, g_object_ref (ac_con));
@@ -347,7 +418,7 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
   /* Add the AP to all connection related rows, creating the row if neccessary. */
   for (i = 0; i < connections->len; i++)
     {
-      gboolean found = g_ptr_array_find (self->connections, g_ptr_array_index (connections, i), &j);
+      gboolean found = find_connection (self, g_ptr_array_index (connections, i), &j);
 
       g_assert (found);
 
@@ -355,6 +426,7 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
       if (!row)
         row = cc_wifi_connection_list_row_add (self, g_ptr_array_index (connections, i), NULL, TRUE);
       cc_wifi_connection_row_add_access_point (row, ap);
+      track_access_point (self, ap, row);
       g_ptr_array_index (self->connections_row, j) = row;
     }
 
@@ -392,59 +464,200 @@ on_device_ap_added_cb (CcWifiConnectionList *self,
     {
       cc_wifi_connection_row_add_access_point (row, ap);
     }
+
+  track_access_point (self, ap, row);
 }
 
+/* Removes the AP from every row it was placed in, removing rows that are
+ * left without a reason to be shown. */
 static void
-on_device_ap_removed_cb (CcWifiConnectionList *self,
-                         NMAccessPoint        *ap,
-                         NMDeviceWifi         *device)
+unplace_access_point (CcWifiConnectionList *self,
+                      NMAccessPoint        *ap)
 {
-  CcWifiConnectionRow *row;
+  g_autoptr(GPtrArray) rows = NULL;
   g_autoptr(GBytes) ssid = NULL;
-  gboolean found = FALSE;
-  gint i;
+  guint i;
 
-  g_signal_handlers_disconnect_by_data (ap, self);
+  /* If the AP was inserted into a row without a connection, then we will get an
+   * SSID for it here. */
+  g_hash_table_steal_extended (self->ap_ssid_cache, ap, NULL, (gpointer*) &ssid);
 
-  /* Find any connection related row with the AP and remove the AP from it. Remove the
-   * row if it was the last AP and we are hiding unavailable connections. */
-  for (i = 0; i < self->connections_row->len; i++)
+  g_hash_table_steal_extended (self->ap_to_rows, ap, NULL, (gpointer*) &rows);
+  if (!rows)
+    return;
+
+  for (i = 0; i < rows->len; i++)
     {
-      row = g_ptr_array_index (self->connections_row, i);
-      if (row && cc_wifi_connection_row_remove_access_point (row, ap))
-        {
-          found = TRUE;
+      CcWifiConnectionRow *row = g_ptr_array_index (rows, i);
+      NMConnection *connection;
+      guint idx;
+
+      connection = cc_wifi_connection_row_get_connection (row);
+
+      /* Keep the row while it still has other APs */
+      if (!cc_wifi_connection_row_remove_access_point (row, ap))
+        continue;
 
-          if (self->hide_unavailable)
+      if (connection)
+        {
+          /* Remove the row if it was the last AP and we are hiding unavailable
+           * connections. Rows of connections that are being removed are not
+           * indexed anymore and are taken care of by the caller. */
+          if (self->hide_unavailable &&
+              find_connection (self, connection, &idx) &&
+              g_ptr_array_index (self->connections_row, idx) == row)
             {
-              g_ptr_array_index (self->connections_row, i) = NULL;
-              g_signal_emit_by_name (self, "remove-row", row);
-              gtk_list_box_remove (self->listbox, GTK_WIDGET (row));
+              g_ptr_array_index (self->connections_row, idx) = NULL;
+              cc_wifi_connection_list_row_remove (self, row);
             }
         }
+      else
+        {
+          g_assert (ssid != NULL);
+          g_hash_table_remove (self->ssid_to_row, ssid);
+          cc_wifi_connection_list_row_remove (self, row);
+        }
+    }
+}
+
+static void
+on_access_point_property_changed (CcWifiConnectionList *self,
+                                  GParamSpec           *pspec,
+                                  NMAccessPoint        *ap)
+{
+  GPtrArray *rows;
+  guint i;
+
+  /* If the SSID changed then the AP needs to be moved to other rows. */
+  if (g_str_equal (pspec->name, NM_ACCESS_POINT_SSID))
+    {
+      g_debug ("Moving AP for SSID change");
+      unplace_access_point (self, ap);
+      place_access_point (self, ap);
+      return;
     }
 
-  if (found || !self->show_aps)
+  /* Otherwise, update all rows that contain the AP */
+  rows = g_hash_table_lookup (self->ap_to_rows, ap);
+  if (!rows)
     return;
 
-  /* If the AP was inserted into a row without a connection, then we will get an
-   * SSID for it here. */
-  g_hash_table_steal_extended (self->ap_ssid_cache, ap, NULL, (gpointer*) &ssid);
-  if (!ssid)
+  for (i = 0; i < rows->len; i++)
+    queue_row_update (self, g_ptr_array_index (rows, i));
+}
+
+static void
+on_device_ap_added_cb (CcWifiConnectionList *self,
+                       NMAccessPoint        *ap,
+                       NMDeviceWifi         *device)
+{
+  g_signal_connect_object (ap, "notify",
+                           G_CALLBACK (on_access_point_property_changed),
+                           self, G_CONNECT_SWAPPED);
+
+  place_access_point (self, ap);
+}
+
+static void
+on_device_ap_removed_cb (CcWifiConnectionList *self,
+                         NMAccessPoint        *ap,
+                         NMDeviceWifi         *device)
+{
+  g_signal_handlers_disconnect_by_data (ap, self);
+
+  unplace_access_point (self, ap);
+}
+
+static gboolean
+access_point_matches_connection (CcWifiConnectionList *self,
+                                 NMAccessPoint        *ap,
+                                 NMConnection         *connection)
+{
+  if (ap == nm_device_wifi_get_active_access_point (self->device) &&
+      connection == get_active_connection (self))
+    return TRUE;
+
+  return nm_access_point_connection_valid (ap, connection);
+}
+
+/* Moves the APs of @row that no longer belong to it (or all of them if
+ * @all is set) to where they belong now. */
+static void
+reseat_access_points (CcWifiConnectionList *self,
+                      CcWifiConnectionRow  *row,
+                      NMConnection         *connection,
+                      gboolean              all)
+{
+  g_autoptr(GPtrArray) aps = NULL;
+  guint i;
+
+  aps = g_ptr_array_copy ((GPtrArray*) cc_wifi_connection_row_get_access_points (row),
+                          (GCopyFunc) g_object_ref, NULL);
+  g_ptr_array_set_free_func (aps, g_object_unref);
+
+  for (i = 0; i < aps->len; i++)
+    {
+      NMAccessPoint *ap = g_ptr_array_index (aps, i);
+
+      if (!all && access_point_matches_connection (self, ap, connection))
+        continue;
+
+      unplace_access_point (self, ap);
+      place_access_point (self, ap);
+    }
+}
+
+static void
+add_connection (CcWifiConnectionList *self,
+                NMConnection         *connection)
+{
+  CcWifiConnectionRow *row = NULL;
+  const GPtrArray *aps;
+  guint i;
+
+  if (find_connection (self, connection, NULL))
     return;
 
-  /* And we can update the row (possibly removing it) */
-  row = g_hash_table_lookup (self->ssid_to_row, ssid);
-  g_assert (row != NULL);
+  if (!self->hide_unavailable || connection == get_active_connection (self))
+    row = cc_wifi_connection_list_row_add (self, connection, NULL, TRUE);
 
-  if (cc_wifi_connection_row_remove_access_point (row, ap))
+  append_connection (self, connection, row);
+
+  /* Move the APs of the new connection out of their current rows */
+  aps = nm_device_wifi_get_access_points (self->device);
+  for (i = 0; i < aps->len; i++)
     {
-      g_hash_table_remove (self->ssid_to_row, ssid);
-      g_signal_emit_by_name (self, "remove-row", row);
-      gtk_list_box_remove (self->listbox, GTK_WIDGET (row));
+      NMAccessPoint *ap = g_ptr_array_index (aps, i);
+
+      if (!access_point_matches_connection (self, ap, connection))
+        continue;
+
+      unplace_access_point (self, ap);
+      place_access_point (self, ap);
     }
 }
 
+static void
+remove_connection (CcWifiConnectionList *self,
+                   NMConnection         *connection)
+{
+  CcWifiConnectionRow *row;
+  guint idx;
+
+  if (!find_connection (self, connection, &idx))
+    return;
+
+  row = g_ptr_array_index (self->connections_row, idx);
+  remove_connection_index (self, idx);
+
+  if (!row)
+    return;
+
+  /* The APs of the connection may now belong to other rows */
+  reseat_access_points (self, row, NULL, TRUE);
+  cc_wifi_connection_list_row_remove (self, row);
+}
+
 static void
 on_client_connection_added_cb (CcWifiConnectionList *self,
                                NMConnection         *connection,
@@ -456,10 +669,11 @@ on_client_connection_added_cb (CcWifiConnectionList *self,
   if (connection_ignored (connection))
     return;
 
-  /* The approach we take to handle connection changes is to do a full rebuild.
-   * It happens seldom enough to make this feasible.
-   */
-  update_connections (self);
+  /* The list is rebuilt when it is thawed */
+  if (self->freeze_count > 0 || self->updating)
+    return;
+
+  add_connection (self, connection);
 }
 
 static void
@@ -467,13 +681,52 @@ on_client_connection_removed_cb (CcWifiConnectionList *self,
                                  NMConnection         *connection,
                                  NMClient             *client)
 {
-  if (!g_ptr_array_find (self->connections, connection, NULL))
+  if (!find_connection (self, connection, NULL))
     return;
 
-  /* The approach we take to handle connection changes is to do a full rebuild.
-   * It happens seldom enough to make this feasible.
-   */
-  update_connections (self);
+  if (self->freeze_count > 0 || self->updating)
+    return;
+
+  /* Keep a connection that is still active, like update_connections() does */
+  if (connection == get_active_connection (self))
+    return;
+
+  remove_connection (self, connection);
+}
+
+static void
+update_connection_row (CcWifiConnectionList *self,
+                       NMConnection         *connection)
+{
+  CcWifiConnectionRow *row;
+  guint idx;
+
+  if (!connection || !find_connection (self, connection, &idx))
+    return;
+
+  row = g_ptr_array_index (self->connections_row, idx);
+
+  /* Unavailable connections only have a row while they are active */
+  if (self->hide_unavailable)
+    {
+      gboolean active = connection == get_active_connection (self);
+
+      if (!row && active)
+        {
+          row = cc_wifi_connection_list_row_add (self, connection, NULL, TRUE);
+          g_ptr_array_index (self->connections_row, idx) = row;
+        }
+      else if (row && !active &&
+               cc_wifi_connection_row_get_access_points (row)->len == 0)
+        {
+          g_ptr_array_index (self->connections_row, idx) = NULL;
+          cc_wifi_connection_list_row_remove (self, row);
+          return;
+        }
+    }
+
+  if (row)
+    cc_wifi_connection_row_update (row);
 }
 
 static void
@@ -481,26 +734,50 @@ on_device_state_changed_cb (CcWifiConnectionList *self,
                             GParamSpec           *pspec,
                             NMDeviceWifi         *device)
 {
-  NMActiveConnection *ac;
-  NMConnection *connection = NULL;
-  guint idx;
+  NMConnection *previous;
+  NMConnection *connection;
 
-  ac = nm_device_get_active_connection (NM_DEVICE (self->device));
-  if (ac)
-    connection = NM_CONNECTION (nm_active_connection_get_connection (ac));
+  if (self->freeze_count > 0 || self->updating)
+    return;
+
+  connection = get_active_connection (self);
 
   /* Just update the corresponding row if the AC is still the same. */
-  if (self->last_active == connection &&
-      g_ptr_array_find (self->connections, connection, &idx) &&
-      g_ptr_array_index (self->connections_row, idx))
+  if (self->last_active == connection)
     {
-      cc_wifi_connection_row_update (g_ptr_array_index (self->connections_row, idx));
+      update_connection_row (self, connection);
       return;
     }
 
-  /* Give up and do a full update. */
-  update_connections (self);
-  self->last_active = connection;
+  previous = g_steal_pointer (&self->last_active);
+  g_set_object (&self->last_active, connection);
+
+  /* The active connection is listed even when it is not known to the client */
+  if (connection && !connection_ignored (connection))
+    add_connection (self, connection);
+  update_connection_row (self, connection);
+
+  if (previous)
+    {
+      const GPtrArray *acs_client = nm_client_get_connections (self->client);
+      guint idx;
+
+      if (!g_ptr_array_find (acs_client, previous, NULL))
+        {
+          remove_connection (self, previous);
+        }
+      else
+        {
+          /* The active AP may have been grouped with it only because it was active */
+          if (find_connection (self, previous, &idx) &&
+              g_ptr_array_index (self->connections_row, idx))
+            reseat_access_points (self, g_ptr_array_index (self->connections_row, idx), previous, FALSE);
+
+          update_connection_row (self, previous);
+        }
+
+      g_object_unref (previous);
+    }
 }
 
 static void
@@ -510,16 +787,16 @@ on_device_active_ap_changed_cb (CcWifiConnectionList *self,
 {
   NMAccessPoint *ap;
   /* We need to make sure the active AP is grouped with the active connection.
-   * Do so by simply removing and adding it.
+   * Do so by simply moving it.
    *
    * This is necessary because the AP is added before this property
    * is updated. */
   ap = nm_device_wifi_get_active_access_point (self->device);
   if (ap)
     {
-      g_debug ("Simulating add/remove for active AP change");
-      on_device_ap_removed_cb (self, ap, self->device);
-      on_device_ap_added_cb (self, ap, self->device);
+      g_debug ("Moving active AP");
+      unplace_access_point (self, ap);
+      place_access_point (self, ap);
     }
 }
 
@@ -532,6 +809,12 @@ cc_wifi_connection_list_dispose (GObject *object)
    * through updates_connections */
   self->updating = TRUE;
 
+  if (self->update_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self->listbox), self->update_tick_id);
+      self->update_tick_id = 0;
+    }
+
   /* Drop all external references */
   clear_widget (self);
 
@@ -545,11 +828,15 @@ cc_wifi_connection_list_finalize (GObject *object)
 
   g_clear_object (&self->client);
   g_clear_object (&self->device);
+  g_clear_object (&self->last_active);
 
   g_clear_pointer (&self->connections, g_ptr_array_unref);
   g_clear_pointer (&self->connections_row, g_ptr_array_unref);
+  g_clear_pointer (&self->connection_to_index, g_hash_table_unref);
+  g_clear_pointer (&self->ap_to_rows, g_hash_table_unref);
   g_clear_pointer (&self->ssid_to_row, g_hash_table_unref);
   g_clear_pointer (&self->ap_ssid_cache, g_hash_table_unref);
+  g_clear_pointer (&self->pending_updates, g_hash_table_unref);
 
   G_OBJECT_CLASS (cc_wifi_connection_list_parent_class)->finalize (object);
 }
@@ -587,11 +874,8 @@ cc_wifi_connection_list_constructed (GObject *object)
   g_signal_connect_object (self->device, "notify::active-access-point",
                            G_CALLBACK (on_device_active_ap_changed_cb),
                            self, G_CONNECT_SWAPPED);
-  on_device_state_changed_cb (self, NULL, self->device);
 
-  /* Simulate a change notification on the available connections.
-   * This uses the implementation detail that the list is rebuild
-   * completely in this case. */
+  /* Initial population; later changes are applied incrementally. */
   update_connections (self);
 }
 
@@ -741,10 +1025,14 @@ cc_wifi_connection_list_init (CcWifiConnectionList *self)
 
   self->connections = g_ptr_array_new_with_free_func (g_object_unref);
   self->connections_row = g_ptr_array_new ();
+  self->connection_to_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->ap_to_rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                            NULL, (GDestroyNotify) g_ptr_array_unref);
   self->ssid_to_row = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
                                              (GDestroyNotify) g_bytes_unref, NULL);
   self->ap_ssid_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
                                                NULL, (GDestroyNotify) g_bytes_unref);
+  self->pending_updates = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 CcWifiConnectionList *
@@ -33,6 +33,10 @@ struct _CcWifiConnectionRow
   NMConnection    *connection;
   gboolean         known_connection;
 
+  /* Cached result of the last update, used as a sort key */
+  NMAccessPoint   *best_ap;
+  guint8           best_strength;
+
   GtkLabel        *active_label;
   GtkCheckButton  *checkbutton;
   GtkSpinner      *connecting_spinner;
@@ -159,6 +163,45 @@ get_connection_security (NMConnection *con)
     return NM_AP_SEC_UNKNOWN;
 }
 
+static void
+update_best_access_point (CcWifiConnectionRow *self)
+{
+  NMAccessPoint *active_ap;
+  gint i;
+
+  self->best_ap = NULL;
+  self->best_strength = 0;
+
+  if (self->aps->len == 0)
+    return;
+
+  active_ap = nm_device_wifi_get_active_access_point (self->device);
+
+  for (i = 0; i < self->aps->len; i++)
+    {
+      NMAccessPoint *cur;
+      guint8 cur_strength;
+
+      cur = g_ptr_array_index (self->aps, i);
+      cur_strength = nm_access_point_get_strength (cur);
+
+      /* Prefer the active AP in all cases */
+      if (cur == active_ap)
+        {
+          self->best_ap = cur;
+          self->best_strength = cur_strength;
+          return;
+        }
+
+      /* Use if we don't have an AP, this is the current AP, or it is better */
+      if (!self->best_ap || cur_strength > self->best_strength)
+        {
+          self->best_ap = cur;
+          self->best_strength = cur_strength;
+        }
+    }
+}
+
 static void
 update_ui (CcWifiConnectionRow *self)
 {
@@ -175,7 +218,8 @@ update_ui (CcWifiConnectionRow *self)
   g_assert (self->device);
   g_assert (self->connection || self->aps->len > 0);
 
-  best_ap = cc_wifi_connection_row_best_access_point (self);
+  update_best_access_point (self);
+  best_ap = self->best_ap;
 
   if (self->connection)
     {
@@ -248,7 +292,7 @@ update_ui (CcWifiConnectionRow *self)
   if (best_ap != NULL)
     {
       security = get_access_point_security (best_ap);
-      strength = nm_access_point_get_strength (best_ap);
+      strength = self->best_strength;
     }
 
   gtk_widget_set_visible (GTK_WIDGET (self->connecting_spinner), connecting);
@@ -413,6 +457,8 @@ cc_wifi_connection_row_set_property (GObject      *object,
           for (i = 0; i < ptr_array->len; i++)
             g_ptr_array_add (self->aps, g_object_ref (g_ptr_array_index (ptr_array, i)));
         }
+      if (self->device)
+        update_best_access_point (self);
       if (self->constructed)
         update_ui (self);
       break;
@@ -594,39 +640,17 @@ cc_wifi_connection_row_set_checked (CcWifiConnectionRow *self,
 NMAccessPoint*
 cc_wifi_connection_row_best_access_point (CcWifiConnectionRow *self)
 {
-  NMAccessPoint *best_ap = NULL;
-  NMAccessPoint *active_ap = NULL;
-  guint8 strength = 0;
-  gint i;
-
   g_return_val_if_fail (CC_WIFI_CONNECTION_ROW (self), NULL);
 
-  if (self->aps->len == 0)
-    return NULL;
-
-  active_ap = nm_device_wifi_get_active_access_point (self->device);
-
-  for (i = 0; i < self->aps->len; i++)
-    {
-      NMAccessPoint *cur;
-      guint8 cur_strength;
-
-      cur = g_ptr_array_index (self->aps, i);
-
-      /* Prefer the active AP in all cases */
-      if (cur == active_ap)
-        return cur;
+  return self->best_ap;
+}
 
-      cur_strength = nm_access_point_get_strength (cur);
-      /* Use if we don't have an AP, this is the current AP, or it is better */
-      if (!best_ap || cur_strength > strength)
-        {
-          best_ap = cur;
-          strength = cur_strength;
-        }
-    }
+guint8
+cc_wifi_connection_row_get_strength (CcWifiConnectionRow *self)
+{
+  g_return_val_if_fail (CC_WIFI_CONNECTION_ROW (self), 0);
 
-  return best_ap;
+  return self->best_strength;
 }
 
 void
@@ -648,6 +672,8 @@ cc_wifi_connection_row_remove_access_point (CcWifiConnectionRow *self,
   if (!g_ptr_array_remove (self->aps, g_object_ref (ap)))
     return FALSE;
 
+  update_best_access_point (self);
+
   /* Object might be invalid; this is alright if it is deleted right away */
   if (self->aps->len > 0 || self->connection)
     {
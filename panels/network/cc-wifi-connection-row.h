@@ -43,6 +43,7 @@ void                 cc_wifi_connection_row_set_checked         (CcWifiConnectio
                                                                  gboolean               value);
 
 NMAccessPoint       *cc_wifi_connection_row_best_access_point   (CcWifiConnectionRow   *row);
+guint8               cc_wifi_connection_row_get_strength        (CcWifiConnectionRow   *row);
 void                 cc_wifi_connection_row_add_access_point    (CcWifiConnectionRow   *row,
                                                                  NMAccessPoint         *ap);
 gboolean             cc_wifi_connection_row_remove_access_point (CcWifiConnectionRow   *row,
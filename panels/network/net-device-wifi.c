@@ -41,7 +41,11 @@
 #include "cc-wifi-connection-list.h"
 #include "cc-wifi-connection-row.h"
 
+/* Scans are requested every PERIODIC_WIFI_SCAN_TIMEOUT seconds while the
+ * results keep changing, backing off up to PERIODIC_WIFI_SCAN_TIMEOUT_MAX
+ * seconds while they don't. */
 #define PERIODIC_WIFI_SCAN_TIMEOUT 15
+#define PERIODIC_WIFI_SCAN_TIMEOUT_MAX 120
 
 static void nm_device_wifi_refresh_ui (NetDeviceWifi *self);
 static void show_wifi_list (NetDeviceWifi *self);
@@ -79,9 +83,17 @@ struct _NetDeviceWifi
         gint64                   last_scan;
         gboolean                 scanning;
 
-        guint                    monitor_scanning_id;
+        gboolean                 periodic_scan;
+        guint                    scan_interval;
+        gboolean                 aps_changed;
         guint                    scan_id;
+        GdkSurface              *toplevel;
         GCancellable            *cancellable;
+
+        guint                    scans_requested;
+        guint                    scans_completed;
+        guint                    scans_unchanged;
+        guint                    scans_failed;
 };
 
 enum {
@@ -96,14 +108,8 @@ static void
 disable_scan_timeout (NetDeviceWifi *self)
 {
         g_debug ("Disabling periodic Wi-Fi scan");
-        if (self->monitor_scanning_id > 0) {
-                g_source_remove (self->monitor_scanning_id);
-                self->monitor_scanning_id = 0;
-        }
-        if (self->scan_id > 0) {
-                g_source_remove (self->scan_id);
-                self->scan_id = 0;
-        }
+        self->periodic_scan = FALSE;
+        g_clear_handle_id (&self->scan_id, g_source_remove);
 }
 
 static void
@@ -284,6 +290,8 @@ nm_device_wifi_refresh_hotspot (NetDeviceWifi *self)
         gtk_widget_set_visible (GTK_WIDGET (self->hotspot_security_row), hotspot_security != NULL);
 }
 
+static void schedule_scan (NetDeviceWifi *self, guint seconds);
+
 static void
 set_scanning (NetDeviceWifi *self,
               gboolean       scanning,
@@ -294,28 +302,65 @@ set_scanning (NetDeviceWifi *self,
         self->scanning = scanning;
         self->last_scan = last_scan;
 
-        if (scanning_changed)
-                g_object_notify (G_OBJECT (self), "scanning");
+        if (!scanning_changed)
+                return;
+
+        g_object_notify (G_OBJECT (self), "scanning");
+
+        /* Whatever ended the scan, including a failed request, the next
+         * one needs scheduling; the list may have been shown again while
+         * this one was running, which does not schedule anything */
+        if (!scanning)
+                schedule_scan (self, self->scan_interval);
 }
 
 static gboolean
-update_scanning (gpointer user_data)
+scan_visible (NetDeviceWifi *self)
 {
-        NetDeviceWifi *self = user_data;
-        gint64 last_scan;
+        if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+                return FALSE;
 
-        last_scan = nm_device_wifi_get_last_scan (NM_DEVICE_WIFI (self->device));
+        if (self->toplevel &&
+            (gdk_toplevel_get_state (GDK_TOPLEVEL (self->toplevel)) & GDK_TOPLEVEL_STATE_MINIMIZED))
+                return FALSE;
 
-        /* The last_scan property is updated after the device finished scanning,
-         * so notify about it and stop monitoring for changes.
-         */
-        if (self->last_scan != last_scan) {
-                set_scanning (self, FALSE, last_scan);
-                self->monitor_scanning_id = 0;
-                return G_SOURCE_REMOVE;
-        }
+        return TRUE;
+}
+
+static gboolean request_scan (gpointer user_data);
+
+static void
+schedule_scan (NetDeviceWifi *self,
+               guint          seconds)
+{
+        g_clear_handle_id (&self->scan_id, g_source_remove);
 
-        return G_SOURCE_CONTINUE;
+        if (!self->periodic_scan || !scan_visible (self))
+                return;
+
+        self->scan_id = g_timeout_add_seconds (seconds, request_scan, self);
+}
+
+static void
+request_scan_cb (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+        NetDeviceWifi *self;
+        g_autoptr(GError) error = NULL;
+
+        if (nm_device_wifi_request_scan_finish (NM_DEVICE_WIFI (source_object), res, &error))
+                return;
+
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                return;
+
+        /* NetworkManager refuses scans right after a previous one, for example */
+        self = NET_DEVICE_WIFI (user_data);
+        self->scans_failed++;
+        g_debug ("Wi-Fi scan request failed: %s", error->message);
+
+        set_scanning (self, FALSE, self->last_scan);
 }
 
 static gboolean
@@ -323,20 +368,98 @@ request_scan (gpointer user_data)
 {
         NetDeviceWifi *self = user_data;
 
+        self->scan_id = 0;
+        self->scans_requested++;
+
         g_debug ("Periodic Wi-Fi scan requested");
 
         set_scanning (self, TRUE,
                       nm_device_wifi_get_last_scan (NM_DEVICE_WIFI (self->device)));
 
-        if (self->monitor_scanning_id == 0) {
-                self->monitor_scanning_id = g_timeout_add (1500, update_scanning,
-                                                                  self);
+        nm_device_wifi_request_scan_async (NM_DEVICE_WIFI (self->device),
+                                           self->cancellable, request_scan_cb, self);
+
+        /* Rescheduled when the scan finishes; this only matters if it never does */
+        schedule_scan (self, self->scan_interval);
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+on_last_scan_changed_cb (NetDeviceWifi *self)
+{
+        gint64 last_scan;
+
+        last_scan = nm_device_wifi_get_last_scan (NM_DEVICE_WIFI (self->device));
+        if (last_scan == self->last_scan)
+                return;
+
+        /* This also catches scans requested by someone else, which saves us
+         * from scanning again right away. */
+        self->scans_completed++;
+        if (self->aps_changed) {
+                self->scan_interval = PERIODIC_WIFI_SCAN_TIMEOUT;
+        } else {
+                self->scans_unchanged++;
+                self->scan_interval = MIN (self->scan_interval * 2, PERIODIC_WIFI_SCAN_TIMEOUT_MAX);
         }
+        self->aps_changed = FALSE;
 
-        nm_device_wifi_request_scan_async (NM_DEVICE_WIFI (self->device),
-                                           self->cancellable, NULL, NULL);
+        set_scanning (self, FALSE, last_scan);
+
+        g_debug ("Wi-Fi scan finished: %u requested, %u completed, %u unchanged, %u failed; next in %us",
+                 self->scans_requested, self->scans_completed, self->scans_unchanged,
+                 self->scans_failed, self->scan_interval);
 
-        return G_SOURCE_CONTINUE;
+        schedule_scan (self, self->scan_interval);
+}
+
+static void
+on_access_points_changed_cb (NetDeviceWifi *self)
+{
+        self->aps_changed = TRUE;
+}
+
+/* Resumes periodic scanning when the list becomes visible again, scanning
+ * right away if the last results are older than the current interval. */
+static void
+update_scan_visibility (NetDeviceWifi *self)
+{
+        gint64 age;
+
+        if (!self->periodic_scan)
+                return;
+
+        if (!scan_visible (self)) {
+                if (self->scan_id != 0)
+                        g_debug ("Pausing periodic Wi-Fi scan");
+                g_clear_handle_id (&self->scan_id, g_source_remove);
+                return;
+        }
+
+        if (self->scan_id != 0 || self->scanning)
+                return;
+
+        age = self->last_scan > 0 ? (nm_utils_get_timestamp_msec () - self->last_scan) / 1000 : G_MAXINT64;
+        if (age >= self->scan_interval)
+                request_scan (self);
+        else
+                schedule_scan (self, self->scan_interval - age);
+}
+
+static void
+start_periodic_scan (NetDeviceWifi *self)
+{
+        if (self->periodic_scan)
+                return;
+
+        g_debug ("Enabling periodic Wi-Fi scan");
+
+        self->periodic_scan = TRUE;
+        self->scan_interval = PERIODIC_WIFI_SCAN_TIMEOUT;
+        self->last_scan = nm_device_wifi_get_last_scan (NM_DEVICE_WIFI (self->device));
+
+        update_scan_visibility (self);
 }
 
 static void
@@ -351,12 +474,8 @@ nm_device_wifi_refresh_ui (NetDeviceWifi *self)
                 return;
         }
 
-        if (self->scan_id == 0 &&
-            nm_client_wireless_get_enabled (self->client)) {
-                self->scan_id = g_timeout_add_seconds (PERIODIC_WIFI_SCAN_TIMEOUT,
-                                                       request_scan, self);
-                request_scan (self);
-        }
+        if (nm_client_wireless_get_enabled (self->client))
+                start_periodic_scan (self);
 
         /* keep this in sync with the signal handler setup in cc_network_panel_init */
         wireless_enabled_toggled (self);
@@ -769,6 +888,40 @@ show_wifi_list (NetDeviceWifi *self)
         gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->listbox_box));
 }
 
+static void
+net_device_wifi_map (GtkWidget *widget)
+{
+        NetDeviceWifi *self = NET_DEVICE_WIFI (widget);
+        GdkSurface *surface;
+
+        GTK_WIDGET_CLASS (net_device_wifi_parent_class)->map (widget);
+
+        surface = gtk_native_get_surface (gtk_widget_get_native (widget));
+        if (GDK_IS_TOPLEVEL (surface)) {
+                self->toplevel = surface;
+                g_signal_connect_object (surface, "notify::state",
+                                         G_CALLBACK (update_scan_visibility),
+                                         self, G_CONNECT_SWAPPED);
+        }
+
+        update_scan_visibility (self);
+}
+
+static void
+net_device_wifi_unmap (GtkWidget *widget)
+{
+        NetDeviceWifi *self = NET_DEVICE_WIFI (widget);
+
+        if (self->toplevel) {
+                g_signal_handlers_disconnect_by_data (self->toplevel, self);
+                self->toplevel = NULL;
+        }
+
+        GTK_WIDGET_CLASS (net_device_wifi_parent_class)->unmap (widget);
+
+        update_scan_visibility (self);
+}
+
 static void
 net_device_wifi_finalize (GObject *object)
 {
@@ -932,7 +1085,6 @@ ap_sort (gconstpointer a, gconstpointer b, gpointer data)
         CcWifiConnectionRow *b_row = CC_WIFI_CONNECTION_ROW ((gpointer) b);
         NMActiveConnection *active_connection;
         gboolean a_configured, b_configured;
-        NMAccessPoint *apa, *apb;
         guint sa, sb;
 
         /* Show the connected AP first */
@@ -953,20 +1105,10 @@ ap_sort (gconstpointer a, gconstpointer b, gpointer data)
                 if (b_configured) return 1;
         }
 
-        /* Show higher strength networks above lower strength ones */
-
-        apa = cc_wifi_connection_row_best_access_point (a_row);
-        apb = cc_wifi_connection_row_best_access_point (b_row);
-
-        if (apa)
-                sa = nm_access_point_get_strength (apa);
-        else
-                sa = 0;
-
-        if (apb)
-                sb = nm_access_point_get_strength (apb);
-        else
-                sb = 0;
+        /* Show higher strength networks above lower strength ones. The rows
+         * cache the strength of their best AP whenever they are updated. */
+        sa = cc_wifi_connection_row_get_strength (a_row);
+        sb = cc_wifi_connection_row_get_strength (b_row);
 
         if (sa > sb) return -1;
         if (sb > sa) return 1;
@@ -1165,6 +1307,9 @@ net_device_wifi_class_init (NetDeviceWifiClass *klass)
         object_class->finalize = net_device_wifi_finalize;
         object_class->get_property = net_device_wifi_get_property;
 
+        widget_class->map = net_device_wifi_map;
+        widget_class->unmap = net_device_wifi_unmap;
+
         g_object_class_install_property (object_class,
                                          PROP_SCANNING,
                                          g_param_spec_boolean ("scanning",
@@ -1245,6 +1390,13 @@ net_device_wifi_new (CcPanel *panel, NMClient *client, NMDevice *device)
 
         g_signal_connect_object (device, "state-changed", G_CALLBACK (nm_device_wifi_refresh_ui), self, G_CONNECT_SWAPPED);
 
+        g_signal_connect_object (device, "notify::" NM_DEVICE_WIFI_LAST_SCAN,
+                                 G_CALLBACK (on_last_scan_changed_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (device, "access-point-added",
+                                 G_CALLBACK (on_access_points_changed_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (device, "access-point-removed",
+                                 G_CALLBACK (on_access_points_changed_cb), self, G_CONNECT_SWAPPED);
+
         list = GTK_WIDGET (cc_wifi_connection_list_new (client, NM_DEVICE_WIFI (device), TRUE, TRUE, FALSE));
         gtk_box_append (self->listbox_box, list);
 
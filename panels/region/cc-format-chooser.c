@@ -31,10 +31,57 @@
 
 #include "cc-common-language.h"
 #include "cc-format-preview.h"
+#include "cc-locale-catalogue.h"
 #include "cc-util.h"
 
-#define GNOME_DESKTOP_USE_UNSTABLE_API
-#include <libgnome-desktop/gnome-languages.h>
+typedef enum
+{
+  FORMAT_ITEM_HEADER,
+  FORMAT_ITEM_LOCALE,
+} FormatItemKind;
+
+/* Items of the region list: section titles and locales. The common
+ * formats section is only shown while the search is empty. */
+#define CC_TYPE_FORMAT_ITEM (cc_format_item_get_type ())
+G_DECLARE_FINAL_TYPE (CcFormatItem, cc_format_item, CC, FORMAT_ITEM, GObject)
+
+struct _CcFormatItem
+{
+  GObject             parent_instance;
+
+  FormatItemKind      kind;
+  gboolean            is_common;
+  const gchar        *title;
+  const CcLocaleInfo *info;
+};
+
+G_DEFINE_TYPE (CcFormatItem, cc_format_item, G_TYPE_OBJECT)
+
+static void
+cc_format_item_class_init (CcFormatItemClass *klass)
+{
+}
+
+static void
+cc_format_item_init (CcFormatItem *self)
+{
+}
+
+static CcFormatItem *
+cc_format_item_new (FormatItemKind      kind,
+                    gboolean            is_common,
+                    const gchar        *title,
+                    const CcLocaleInfo *info)
+{
+  CcFormatItem *self = g_object_new (CC_TYPE_FORMAT_ITEM, NULL);
+
+  self->kind = kind;
+  self->is_common = is_common;
+  self->title = title;
+  self->info = info;
+
+  return self;
+}
 
 struct _CcFormatChooser {
   GtkDialog parent_instance;
@@ -49,46 +96,44 @@ struct _CcFormatChooser {
   GtkWidget *region_filter_entry;
   GtkWidget *region_list;
   GtkWidget *region_list_stack;
-  GtkWidget *common_region_title;
-  GtkWidget *common_region_listbox;
   GtkWidget *region_box;
-  GtkWidget *region_title;
-  GtkWidget *region_listbox;
+  GtkListView *region_listview;
   GtkWidget *preview_box;
   CcFormatPreview *format_preview;
-  gboolean adding;
-  gboolean showing_extra;
-  gboolean no_results;
+  GtkFilterListModel *filter_model;
+  GtkFilter *filter;
+  GHashTable *bound_rows;
+  gboolean folded;
   gchar *region;
-  gchar *preview_region;
+  gchar *filter_contents;
   gchar **filter_words;
 };
 
 G_DEFINE_TYPE (CcFormatChooser, cc_format_chooser, GTK_TYPE_DIALOG)
 
 static void
-update_check_button_for_list (GtkWidget   *list_box,
-                              const gchar *locale_id)
+update_row_state (CcFormatChooser *chooser,
+                  GtkWidget       *row)
 {
-  GtkWidget *child;
+  GtkWidget *check = g_object_get_data (G_OBJECT (row), "check");
+  GtkWidget *button = g_object_get_data (G_OBJECT (row), "preview-button");
+  const gchar *region = g_object_get_data (G_OBJECT (row), "locale-id");
 
-  for (child = gtk_widget_get_first_child (list_box);
-       child;
-       child = gtk_widget_get_next_sibling (child))
-    {
-      if (!GTK_IS_LIST_BOX_ROW (child))
-        continue;
+  gtk_widget_set_opacity (check, g_strcmp0 (chooser->region, region) == 0 ? 1.0 : 0.0);
+  gtk_widget_set_opacity (button, chooser->folded);
+  gtk_widget_set_sensitive (button, chooser->folded);
+}
 
-      GtkWidget *check = g_object_get_data (G_OBJECT (child), "check");
-      const gchar *region = g_object_get_data (G_OBJECT (child), "locale-id");
-      if (check == NULL || region == NULL)
-        continue;
+static void
+update_bound_rows (CcFormatChooser *chooser)
+{
+  GHashTableIter iter;
+  gpointer row;
 
-      if (g_strcmp0 (locale_id, region) == 0)
-        gtk_widget_set_opacity (check, 1.0);
-      else
-        gtk_widget_set_opacity (check, 0.0);
-    }
+  /* Rows outside of the view get updated when they are bound again */
+  g_hash_table_iter_init (&iter, chooser->bound_rows);
+  while (g_hash_table_iter_next (&iter, &row, NULL))
+    update_row_state (chooser, row);
 }
 
 static void
@@ -98,46 +143,18 @@ set_locale_id (CcFormatChooser *chooser,
         g_free (chooser->region);
         chooser->region = g_strdup (locale_id);
 
-        update_check_button_for_list (chooser->region_listbox, locale_id);
-        update_check_button_for_list (chooser->common_region_listbox, locale_id);
+        update_bound_rows (chooser);
         cc_format_preview_set_region (chooser->format_preview, locale_id);
 }
 
 static gint
 sort_regions (gconstpointer a,
-              gconstpointer b,
-              gpointer      data)
+              gconstpointer b)
 {
-        const gchar *la;
-        const gchar *lb;
-
-        if (g_object_get_data (G_OBJECT (a), "locale-id") == NULL)
-                return 1;
-        if (g_object_get_data (G_OBJECT (b), "locale-id") == NULL)
-                return -1;
-
-        la = g_object_get_data (G_OBJECT (a), "locale-name");
-        lb = g_object_get_data (G_OBJECT (b), "locale-name");
+        const CcLocaleInfo *la = *(const CcLocaleInfo **) a;
+        const CcLocaleInfo *lb = *(const CcLocaleInfo **) b;
 
-        return g_strcmp0 (la, lb);
-}
-
-static GtkWidget *
-padded_label_new (const char *text)
-{
-        GtkWidget *widget, *label;
-
-        widget = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 10);
-        g_object_set (widget, "margin-top", 4, NULL);
-        g_object_set (widget, "margin-bottom", 4, NULL);
-        g_object_set (widget, "margin-start", 10, NULL);
-        g_object_set (widget, "margin-end", 10, NULL);
-
-        label = gtk_label_new (text);
-        gtk_label_set_ellipsize (GTK_LABEL (label), PANGO_ELLIPSIZE_END);
-        gtk_box_append (GTK_BOX (widget), label);
-
-        return widget;
+        return g_strcmp0 (la->region, lb->region);
 }
 
 static void
@@ -151,46 +168,15 @@ format_chooser_back_button_clicked_cb (CcFormatChooser *self)
   gtk_widget_show (self->done_button);
 }
 
-static void
-set_preview_button_visible (GtkWidget *row,
-                            gboolean   visible)
-{
-  GtkWidget *button;
-
-  button = g_object_get_data (G_OBJECT (row), "preview-button");
-  g_assert (button);
-
-  gtk_widget_set_opacity (button, visible);
-  gtk_widget_set_sensitive (button, visible);
-}
-
 static void
 format_chooser_leaflet_fold_changed_cb (CcFormatChooser *self)
 {
-  GtkWidget *child;
-  gboolean folded;
-
   g_assert (CC_IS_FORMAT_CHOOSER (self));
 
-  folded = adw_leaflet_get_folded (ADW_LEAFLET (self->main_leaflet));
-
-  for (child = gtk_widget_get_first_child (self->common_region_listbox);
-       child;
-       child = gtk_widget_get_next_sibling (child))
-    {
-      if (GTK_IS_LIST_BOX_ROW (child))
-        set_preview_button_visible (child, folded);
-    }
-
-  for (child = gtk_widget_get_first_child (self->region_listbox);
-       child;
-       child = gtk_widget_get_next_sibling (child))
-    {
-      if (GTK_IS_LIST_BOX_ROW (child))
-        set_preview_button_visible (child, folded);
-    }
+  self->folded = adw_leaflet_get_folded (ADW_LEAFLET (self->main_leaflet));
+  update_bound_rows (self);
 
-  if (!folded)
+  if (!self->folded)
     {
       cc_format_preview_set_region (self->format_preview, self->region);
       gtk_window_set_title (GTK_WINDOW (self), _("Formats"));
@@ -210,7 +196,7 @@ preview_button_clicked_cb (CcFormatChooser *self,
   g_assert (CC_IS_FORMAT_CHOOSER (self));
   g_assert (GTK_IS_WIDGET (button));
 
-  row = gtk_widget_get_ancestor (button, GTK_TYPE_LIST_BOX_ROW);
+  row = g_object_get_data (G_OBJECT (button), "row");
   g_assert (row);
 
   region = g_object_get_data (G_OBJECT (row), "locale-id");
@@ -225,102 +211,165 @@ preview_button_clicked_cb (CcFormatChooser *self,
     gtk_window_set_title (GTK_WINDOW (self), locale_name);
 }
 
-static GtkWidget *
-region_widget_new (CcFormatChooser *self,
-                   const gchar     *locale_id)
+static void
+setup_row_cb (CcFormatChooser          *self,
+              GtkListItem              *list_item,
+              GtkSignalListItemFactory *factory)
 {
-        gchar *locale_name;
-        gchar *locale_current_name;
-        gchar *locale_untranslated_name;
-        GtkWidget *row, *box, *button;
-        GtkWidget *check;
-
-        locale_name = gnome_get_country_from_locale (locale_id, locale_id);
-        if (!locale_name)
-          return NULL;
-
-        locale_current_name = gnome_get_country_from_locale (locale_id, NULL);
-        locale_untranslated_name = gnome_get_country_from_locale (locale_id, "C");
-
-        row = gtk_list_box_row_new ();
-        box = padded_label_new (locale_name);
-        gtk_list_box_row_set_child (GTK_LIST_BOX_ROW (row), box);
+        GtkWidget *row, *title, *label, *check, *button;
+
+        row = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 10);
+        g_object_set (row, "margin-top", 4, NULL);
+        g_object_set (row, "margin-bottom", 4, NULL);
+        g_object_set (row, "margin-start", 28, NULL);
+        g_object_set (row, "margin-end", 28, NULL);
+
+        title = gtk_label_new (NULL);
+        gtk_widget_set_halign (title, GTK_ALIGN_START);
+        gtk_widget_set_margin_top (title, 18);
+        gtk_widget_add_css_class (title, "dim-label");
+        gtk_widget_add_css_class (title, "heading");
+        gtk_box_append (GTK_BOX (row), title);
+
+        label = gtk_label_new (NULL);
+        gtk_label_set_ellipsize (GTK_LABEL (label), PANGO_ELLIPSIZE_END);
+        gtk_box_append (GTK_BOX (row), label);
 
         check = gtk_image_new_from_icon_name ("object-select-symbolic");
         gtk_widget_set_halign (check, GTK_ALIGN_START);
         gtk_widget_set_hexpand (check, TRUE);
         gtk_widget_set_opacity (check, 0.0);
-        gtk_box_append (GTK_BOX (box), check);
+        gtk_box_append (GTK_BOX (row), check);
 
         button = gtk_button_new_from_icon_name ("view-layout-symbolic");
         g_signal_connect_object (button, "clicked", G_CALLBACK (preview_button_clicked_cb),
                                  self, G_CONNECT_SWAPPED);
-        gtk_widget_show (button);
-        gtk_box_append (GTK_BOX (box), button);
+        gtk_box_append (GTK_BOX (row), button);
 
+        g_object_set_data (G_OBJECT (row), "title", title);
+        g_object_set_data (G_OBJECT (row), "label", label);
         g_object_set_data (G_OBJECT (row), "check", check);
         g_object_set_data (G_OBJECT (row), "preview-button", button);
-        g_object_set_data_full (G_OBJECT (row), "locale-id", g_strdup (locale_id), g_free);
-        g_object_set_data_full (G_OBJECT (row), "locale-name", locale_name, g_free);
-        g_object_set_data_full (G_OBJECT (row), "locale-current-name", locale_current_name, g_free);
-        g_object_set_data_full (G_OBJECT (row), "locale-untranslated-name", locale_untranslated_name, g_free);
+        g_object_set_data (G_OBJECT (button), "row", row);
 
-        return row;
+        gtk_list_item_set_child (list_item, row);
 }
 
 static void
-add_regions (CcFormatChooser *chooser,
-             gchar          **locale_ids,
-             GHashTable      *initial)
+bind_row_cb (CcFormatChooser          *self,
+             GtkListItem              *list_item,
+             GtkSignalListItemFactory *factory)
 {
-        g_autoptr(GList) initial_locales = NULL;
-        GtkWidget *widget;
-        GList *l;
-
-        chooser->adding = TRUE;
-        initial_locales = g_hash_table_get_keys (initial);
+        CcFormatItem *item;
+        GtkWidget *row;
+        gboolean is_header;
+
+        item = gtk_list_item_get_item (list_item);
+        row = gtk_list_item_get_child (list_item);
+        is_header = item->kind == FORMAT_ITEM_HEADER;
+
+        gtk_list_item_set_activatable (list_item, !is_header);
+        gtk_widget_set_visible (g_object_get_data (G_OBJECT (row), "title"), is_header);
+        gtk_widget_set_visible (g_object_get_data (G_OBJECT (row), "label"), !is_header);
+        gtk_widget_set_visible (g_object_get_data (G_OBJECT (row), "check"), !is_header);
+        gtk_widget_set_visible (g_object_get_data (G_OBJECT (row), "preview-button"), !is_header);
+
+        if (is_header) {
+                gtk_label_set_label (g_object_get_data (G_OBJECT (row), "title"), item->title);
+                g_object_set_data (G_OBJECT (row), "locale-id", NULL);
+                g_object_set_data (G_OBJECT (row), "locale-name", NULL);
+                return;
+        }
 
-        /* Populate Common Locales */
-        for (l = initial_locales; l != NULL; l = l->next) {
-                if (!cc_common_language_has_font (l->data))
-                        continue;
+        /* The catalogue entries live as long as the process */
+        gtk_label_set_label (g_object_get_data (G_OBJECT (row), "label"), item->info->region);
+        g_object_set_data (G_OBJECT (row), "locale-id", item->info->id);
+        g_object_set_data (G_OBJECT (row), "locale-name", item->info->region);
 
-                widget = region_widget_new (chooser, l->data);
-                if (!widget)
-                        continue;
+        update_row_state (self, row);
+        g_hash_table_add (self->bound_rows, row);
+}
 
-                gtk_list_box_append (GTK_LIST_BOX (chooser->common_region_listbox), widget);
-          }
+static void
+unbind_row_cb (CcFormatChooser          *self,
+               GtkListItem              *list_item,
+               GtkSignalListItemFactory *factory)
+{
+        g_hash_table_remove (self->bound_rows, gtk_list_item_get_child (list_item));
+}
 
-        /* Populate All locales */
-        while (*locale_ids) {
-                gchar *locale_id;
+static GListModel *
+create_section (const gchar *title,
+                GPtrArray   *locales,
+                gboolean     is_common)
+{
+        g_autoptr(CcFormatItem) header = NULL;
+        GListStore *section;
 
-                locale_id = *locale_ids;
-                locale_ids ++;
+        section = g_list_store_new (CC_TYPE_FORMAT_ITEM);
 
-                if (!cc_common_language_has_font (locale_id))
-                        continue;
+        header = cc_format_item_new (FORMAT_ITEM_HEADER, is_common, title, NULL);
+        g_list_store_append (section, header);
 
-                widget = region_widget_new (chooser, locale_id);
-                if (!widget)
-                  continue;
+        g_ptr_array_sort (locales, sort_regions);
+        for (guint i = 0; i < locales->len; i++) {
+                g_autoptr(CcFormatItem) item = NULL;
 
-                gtk_list_box_append (GTK_LIST_BOX (chooser->region_listbox), widget);
+                item = cc_format_item_new (FORMAT_ITEM_LOCALE, is_common, NULL, g_ptr_array_index (locales, i));
+                g_list_store_append (section, item);
         }
 
-        chooser->adding = FALSE;
+        return G_LIST_MODEL (section);
 }
 
-static void
-add_all_regions (CcFormatChooser *chooser)
+static GListModel *
+create_region_model (void)
 {
-        g_auto(GStrv) locale_ids = NULL;
         g_autoptr(GHashTable) initial = NULL;
+        g_autoptr(GPtrArray) common = NULL;
+        g_autoptr(GPtrArray) all = NULL;
+        g_autoptr(GListModel) common_section = NULL;
+        g_autoptr(GListModel) all_section = NULL;
+        GListStore *sections;
+        GPtrArray *locales;
+        GHashTableIter iter;
+        const gchar *locale_id;
 
-        locale_ids = gnome_get_all_locales ();
+        locales = cc_locale_catalogue_get_locales ();
         initial = cc_common_language_get_initial_languages ();
-        add_regions (chooser, locale_ids, initial);
+        common = g_ptr_array_new ();
+        all = g_ptr_array_sized_new (locales->len);
+
+        /* Populate Common Locales */
+        g_hash_table_iter_init (&iter, initial);
+        while (g_hash_table_iter_next (&iter, (gpointer *) &locale_id, NULL)) {
+                const CcLocaleInfo *info;
+
+                info = cc_locale_catalogue_lookup_locale (locale_id);
+                if (!info || !info->region || !cc_common_language_has_font_for_language (info->language_code))
+                        continue;
+
+                g_ptr_array_add (common, (gpointer) info);
+        }
+
+        /* Populate All locales */
+        for (guint i = 0; i < locales->len; i++) {
+                const CcLocaleInfo *info = g_ptr_array_index (locales, i);
+
+                if (!info->region || !cc_common_language_has_font_for_language (info->language_code))
+                        continue;
+
+                g_ptr_array_add (all, (gpointer) info);
+        }
+
+        common_section = create_section (_("Common Formats"), common, TRUE);
+        all_section = create_section (_("All Formats"), all, FALSE);
+
+        sections = g_list_store_new (G_TYPE_LIST_MODEL);
+        g_list_store_append (sections, common_section);
+        g_list_store_append (sections, all_section);
+
+        return G_LIST_MODEL (gtk_flatten_list_model_new (G_LIST_MODEL (sections)));
 }
 
 static gboolean
@@ -329,6 +378,9 @@ match_all (gchar       **words,
 {
         gchar **w;
 
+        if (str == NULL)
+                return FALSE;
+
         for (w = words; *w; ++w)
                 if (!strstr (str, *w))
                         return FALSE;
@@ -337,85 +389,94 @@ match_all (gchar       **words,
 }
 
 static gboolean
-region_visible (GtkListBoxRow *row,
-                gpointer   user_data)
+region_visible (gpointer object,
+                gpointer user_data)
 {
         CcFormatChooser *chooser = user_data;
-        g_autofree gchar *locale_name = NULL;
-        g_autofree gchar *locale_current_name = NULL;
-        g_autofree gchar *locale_untranslated_name = NULL;
-        gboolean match = TRUE;
+        CcFormatItem *item = object;
 
+        /* The popular section and the titles are shown only if search is empty */
         if (!chooser->filter_words)
-          goto end;
+          return TRUE;
 
-        locale_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-name"));
-        if (match_all (chooser->filter_words, locale_name))
-          goto end;
+        if (item->kind == FORMAT_ITEM_HEADER || item->is_common)
+          return FALSE;
 
-        locale_current_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-current-name"));
-        if (match_all (chooser->filter_words, locale_current_name))
-          goto end;
+        return match_all (chooser->filter_words, item->info->region_key) ||
+               match_all (chooser->filter_words, item->info->region_local_key) ||
+               match_all (chooser->filter_words, item->info->region_untranslated_key);
+}
+
+static void
+update_empty_state (CcFormatChooser *chooser)
+{
+        guint n_items;
 
-        locale_untranslated_name =
-                cc_util_normalize_casefold_and_unaccent (g_object_get_data (G_OBJECT (row), "locale-untranslated-name"));
+        n_items = g_list_model_get_n_items (G_LIST_MODEL (chooser->filter_model));
 
-        match = match_all (chooser->filter_words, locale_untranslated_name);
+        /* Wait for an incremental filter run to finish before deciding */
+        if (n_items == 0 && gtk_filter_list_model_get_pending (chooser->filter_model) > 0)
+          return;
 
- end:
-        if (match)
-          chooser->no_results = FALSE;
-        return match;
+        if (n_items == 0)
+          gtk_stack_set_visible_child (GTK_STACK (chooser->region_list_stack),
+                                       GTK_WIDGET (chooser->empty_results_view));
+        else
+          gtk_stack_set_visible_child (GTK_STACK (chooser->region_list_stack),
+                                       GTK_WIDGET (chooser->region_list));
 }
 
 static void
 filter_changed (CcFormatChooser *chooser)
 {
         g_autofree gchar *filter_contents = NULL;
-        gboolean visible;
-
-        g_clear_pointer (&chooser->filter_words, g_strfreev);
+        GtkFilterChange change;
 
         filter_contents =
                 cc_util_normalize_casefold_and_unaccent (gtk_editable_get_text (GTK_EDITABLE (chooser->region_filter_entry)));
+        if (filter_contents)
+                g_strstrip (filter_contents);
+        if (filter_contents && *filter_contents == '\0')
+                g_clear_pointer (&filter_contents, g_free);
 
-        /* The popular listbox is shown only if search is empty */
-        visible = filter_contents == NULL || *filter_contents == '\0';
-        gtk_widget_set_visible (chooser->common_region_listbox, visible);
-        gtk_widget_set_visible (chooser->common_region_title, visible);
-        gtk_widget_set_visible (chooser->region_title, visible);
-
-        /* Reset cached search state */
-        chooser->no_results = TRUE;
-
-        if (!filter_contents) {
-                gtk_list_box_invalidate_filter (GTK_LIST_BOX (chooser->region_listbox));
-                gtk_list_box_set_placeholder (GTK_LIST_BOX (chooser->region_listbox), NULL);
+        if (g_strcmp0 (filter_contents, chooser->filter_contents) == 0)
                 return;
-        }
-        chooser->filter_words = g_strsplit_set (g_strstrip (filter_contents), " ", 0);
-        gtk_list_box_invalidate_filter (GTK_LIST_BOX (chooser->region_listbox));
 
-        if (chooser->no_results)
-          gtk_stack_set_visible_child (GTK_STACK (chooser->region_list_stack),
-                                       GTK_WIDGET (chooser->empty_results_view));
+        /* Typing more characters can only hide rows and deleting them can
+         * only reveal rows, which lets the filter model skip work */
+        if (!chooser->filter_contents)
+                change = GTK_FILTER_CHANGE_MORE_STRICT;
+        else if (!filter_contents)
+                change = GTK_FILTER_CHANGE_LESS_STRICT;
+        else if (g_str_has_prefix (filter_contents, chooser->filter_contents))
+                change = GTK_FILTER_CHANGE_MORE_STRICT;
+        else if (g_str_has_prefix (chooser->filter_contents, filter_contents))
+                change = GTK_FILTER_CHANGE_LESS_STRICT;
         else
-          gtk_stack_set_visible_child (GTK_STACK (chooser->region_list_stack),
-                                       GTK_WIDGET (chooser->region_list));
+                change = GTK_FILTER_CHANGE_DIFFERENT;
+
+        g_clear_pointer (&chooser->filter_words, g_strfreev);
+        g_free (chooser->filter_contents);
+        chooser->filter_contents = g_steal_pointer (&filter_contents);
+
+        if (chooser->filter_contents)
+                chooser->filter_words = g_strsplit_set (chooser->filter_contents, " ", 0);
+
+        gtk_filter_changed (chooser->filter, change);
 }
 
 static void
-row_activated (CcFormatChooser *chooser,
-               GtkListBoxRow   *row)
+region_listview_activate_cb (CcFormatChooser *chooser,
+                             guint            position)
 {
+        g_autoptr(CcFormatItem) item = NULL;
         const gchar *new_locale_id;
 
-        if (chooser->adding)
+        item = g_list_model_get_item (G_LIST_MODEL (chooser->filter_model), position);
+        if (!item || item->kind == FORMAT_ITEM_HEADER)
                 return;
 
-        new_locale_id = g_object_get_data (G_OBJECT (row), "locale-id");
+        new_locale_id = item->info->id;
         if (g_strcmp0 (new_locale_id, chooser->region) == 0) {
                 gtk_dialog_response (GTK_DIALOG (chooser),
                                      gtk_dialog_get_response_for_widget (GTK_DIALOG (chooser),
@@ -429,18 +490,24 @@ static void
 activate_default (CcFormatChooser *chooser)
 {
         GtkWidget *focus;
+        GtkWidget *row;
         const gchar *locale_id;
 
+        /* The focus lands on the list item widget holding our row */
         focus = gtk_window_get_focus (GTK_WINDOW (chooser));
-        if (!focus)
+        if (!focus || !gtk_widget_is_ancestor (focus, GTK_WIDGET (chooser->region_listview)))
+                return;
+
+        row = gtk_widget_get_first_child (focus);
+        if (!row)
                 return;
 
-        locale_id = g_object_get_data (G_OBJECT (focus), "locale-id");
-        if (g_strcmp0 (locale_id, chooser->region) == 0)
+        locale_id = g_object_get_data (G_OBJECT (row), "locale-id");
+        if (!locale_id || g_strcmp0 (locale_id, chooser->region) == 0)
                 return;
 
         g_signal_stop_emission_by_name (chooser, "activate-default");
-        gtk_widget_activate (focus);
+        set_locale_id (chooser, locale_id);
 }
 
 static void
@@ -448,7 +515,11 @@ cc_format_chooser_dispose (GObject *object)
 {
         CcFormatChooser *chooser = CC_FORMAT_CHOOSER (object);
 
+        g_clear_object (&chooser->filter_model);
+        g_clear_object (&chooser->filter);
+        g_clear_pointer (&chooser->bound_rows, g_hash_table_unref);
         g_clear_pointer (&chooser->filter_words, g_strfreev);
+        g_clear_pointer (&chooser->filter_contents, g_free);
         g_clear_pointer (&chooser->region, g_free);
 
         G_OBJECT_CLASS (cc_format_chooser_parent_class)->dispose (object);
@@ -473,11 +544,8 @@ cc_format_chooser_class_init (CcFormatChooserClass *klass)
         gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, done_button);
         gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, main_leaflet);
         gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, region_filter_entry);
-        gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, common_region_title);
-        gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, common_region_listbox);
         gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, region_box);
-        gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, region_title);
-        gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, region_listbox);
+        gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, region_listview);
         gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, region_list);
         gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, region_list_stack);
         gtk_widget_class_bind_template_child (widget_class, CcFormatChooser, preview_box);
@@ -487,23 +555,36 @@ cc_format_chooser_class_init (CcFormatChooserClass *klass)
         gtk_widget_class_bind_template_callback (widget_class, format_chooser_back_button_clicked_cb);
         gtk_widget_class_bind_template_callback (widget_class, format_chooser_leaflet_fold_changed_cb);
         gtk_widget_class_bind_template_callback (widget_class, filter_changed);
-        gtk_widget_class_bind_template_callback (widget_class, row_activated);
+        gtk_widget_class_bind_template_callback (widget_class, region_listview_activate_cb);
 }
 
 void
 cc_format_chooser_init (CcFormatChooser *chooser)
 {
+        g_autoptr(GtkListItemFactory) factory = NULL;
+        g_autoptr(GtkNoSelection) selection = NULL;
+
         gtk_widget_init_template (GTK_WIDGET (chooser));
 
-        gtk_list_box_set_sort_func (GTK_LIST_BOX (chooser->common_region_listbox),
-                                    (GtkListBoxSortFunc)sort_regions, chooser, NULL);
-        gtk_list_box_set_sort_func (GTK_LIST_BOX (chooser->region_listbox),
-                                    (GtkListBoxSortFunc)sort_regions, chooser, NULL);
-        gtk_list_box_set_filter_func (GTK_LIST_BOX (chooser->region_listbox),
-                                      region_visible, chooser, NULL);
+        chooser->bound_rows = g_hash_table_new (NULL, NULL);
+
+        chooser->filter = GTK_FILTER (gtk_custom_filter_new (region_visible, chooser, NULL));
+        chooser->filter_model = gtk_filter_list_model_new (create_region_model (), g_object_ref (chooser->filter));
+        gtk_filter_list_model_set_incremental (chooser->filter_model, TRUE);
+        g_signal_connect_object (chooser->filter_model, "items-changed",
+                                 G_CALLBACK (update_empty_state), chooser, G_CONNECT_SWAPPED);
+        g_signal_connect_object (chooser->filter_model, "notify::pending",
+                                 G_CALLBACK (update_empty_state), chooser, G_CONNECT_SWAPPED);
+
+        factory = gtk_signal_list_item_factory_new ();
+        g_signal_connect_object (factory, "setup", G_CALLBACK (setup_row_cb), chooser, G_CONNECT_SWAPPED);
+        g_signal_connect_object (factory, "bind", G_CALLBACK (bind_row_cb), chooser, G_CONNECT_SWAPPED);
+        g_signal_connect_object (factory, "unbind", G_CALLBACK (unbind_row_cb), chooser, G_CONNECT_SWAPPED);
+
+        selection = gtk_no_selection_new (g_object_ref (G_LIST_MODEL (chooser->filter_model)));
+        gtk_list_view_set_model (chooser->region_listview, GTK_SELECTION_MODEL (selection));
+        gtk_list_view_set_factory (chooser->region_listview, factory);
 
-        add_all_regions (chooser);
-        gtk_list_box_invalidate_filter (GTK_LIST_BOX (chooser->region_listbox));
         format_chooser_leaflet_fold_changed_cb (chooser);
 
         g_signal_connect_object (chooser, "activate-default",
@@ -33,6 +33,7 @@
 #include "cc-format-chooser.h"
 
 #include "cc-common-language.h"
+#include "cc-locale-catalogue.h"
 
 #define GNOME_DESKTOP_USE_UNSTABLE_API
 #include <libgnome-desktop/gnome-languages.h>
@@ -858,6 +859,9 @@ cc_region_panel_init (CcRegionPanel *self)
 
         gtk_widget_init_template (GTK_WIDGET (self));
 
+        /* Have the language and format chooser data ready by the time they are opened */
+        cc_locale_catalogue_preload ();
+
         self->user_manager = act_user_manager_get_default ();
 
         g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
@@ -17,16 +17,18 @@
  */
 
 #include "cc-level-bar.h"
+#include "cc-peak-monitor.h"
 #include "cc-sound-enums.h"
-#include "gvc-mixer-stream-private.h"
 
 struct _CcLevelBar
 {
   GtkWidget             parent_instance;
 
   CcStreamType          type;
-  pa_stream            *level_stream;
-  gdouble               last_input_peak;
+  GvcMixerStream       *stream;
+  CcPeakMonitor        *monitor;
+  guint                 tick_id;
+  gint64                last_frame_time;
 
   gdouble               value;
 };
@@ -37,69 +39,65 @@ G_DEFINE_TYPE (CcLevelBar, cc_level_bar, GTK_TYPE_WIDGET)
 #define LED_HEIGHT  3
 #define LED_SPACING 4
 
-#define DECAY_STEP .15
+/* How fast the meter falls back, in full scale per second */
+#define DECAY_RATE 3.75
 
 static void
-set_peak (CcLevelBar *self,
-          gdouble     value)
+set_value (CcLevelBar *self,
+           gdouble     value)
 {
-  if (value < 0)
-     value = 0;
-  if (value > 1)
-     value = 1;
-
-  if (self->last_input_peak >= DECAY_STEP &&
-      value < self->last_input_peak - DECAY_STEP)
-    value = self->last_input_peak - DECAY_STEP;
-  self->last_input_peak = value;
+  if (value == self->value)
+    return;
 
   self->value = value;
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
-static void
-read_cb (pa_stream *stream,
-         size_t     length,
-         void      *userdata)
+static gboolean
+tick_cb (GtkWidget     *widget,
+         GdkFrameClock *frame_clock,
+         gpointer       user_data)
 {
-  CcLevelBar *self = userdata;
-  const void *data;
-  gdouble value;
+  CcLevelBar *self = CC_LEVEL_BAR (widget);
+  gint64 frame_time;
+  gdouble value, decay = 0.0;
 
-  if (pa_stream_peek (stream, &data, &length) < 0)
-    {
-      g_warning ("Failed to read data from stream");
-      return;
-    }
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  if (self->last_frame_time != 0)
+    decay = DECAY_RATE * (frame_time - self->last_frame_time) / G_USEC_PER_SEC;
+  self->last_frame_time = frame_time;
 
-  if (!data)
-    {
-      pa_stream_drop (stream);
-      return;
-    }
+  value = cc_peak_monitor_get_peak (self->monitor);
+  if (value < self->value - decay)
+    value = MAX (self->value - decay, 0.0);
 
-  assert (length > 0);
-  assert (length % sizeof (float) == 0);
+  set_value (self, value);
 
-  value = ((const float *) data)[length / sizeof (float) -1];
+  return G_SOURCE_CONTINUE;
+}
 
-  pa_stream_drop (stream);
+/* Only watch the stream while the meter can be seen, so hidden pages and
+ * scrolled away rows do not keep PulseAudio streams open. */
+static void
+start_monitoring (CcLevelBar *self)
+{
+  if (self->stream == NULL || self->monitor != NULL)
+    return;
 
-  set_peak (self, value);
+  self->monitor = cc_peak_monitor_get_for_stream (self->stream);
+  self->last_frame_time = 0;
+  self->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), tick_cb, NULL, NULL);
 }
 
 static void
-suspended_cb (pa_stream *stream,
-              void      *userdata)
+stop_monitoring (CcLevelBar *self)
 {
-  CcLevelBar *self = userdata;
-
-  if (pa_stream_is_suspended (stream))
+  if (self->tick_id != 0)
     {
-      g_debug ("Stream suspended");
-      self->value = 0.0;
-      gtk_widget_queue_draw (GTK_WIDGET (self));
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->tick_id);
+      self->tick_id = 0;
     }
+  g_clear_object (&self->monitor);
 }
 
 static void
@@ -181,17 +179,24 @@ cc_level_bar_snapshot (GtkWidget   *widget,
 }
 
 static void
-close_stream (pa_stream *stream)
+cc_level_bar_map (GtkWidget *widget)
 {
-  if (stream == NULL)
-    return;
+  CcLevelBar *self = CC_LEVEL_BAR (widget);
+
+  GTK_WIDGET_CLASS (cc_level_bar_parent_class)->map (widget);
+
+  start_monitoring (self);
+}
+
+static void
+cc_level_bar_unmap (GtkWidget *widget)
+{
+  CcLevelBar *self = CC_LEVEL_BAR (widget);
 
-  /* Stop receiving data */
-  pa_stream_set_read_callback (stream, NULL, NULL);
-  pa_stream_set_suspended_callback (stream, NULL, NULL);
+  stop_monitoring (self);
+  set_value (self, 0.0);
 
-  /* Disconnect from the stream */
-  pa_stream_disconnect (stream);
+  GTK_WIDGET_CLASS (cc_level_bar_parent_class)->unmap (widget);
 }
 
 static void
@@ -199,8 +204,8 @@ cc_level_bar_dispose (GObject *object)
 {
   CcLevelBar *self = CC_LEVEL_BAR (object);
 
-  close_stream (self->level_stream);
-  g_clear_pointer (&self->level_stream, pa_stream_unref);
+  stop_monitoring (self);
+  g_clear_object (&self->stream);
 
   G_OBJECT_CLASS (cc_level_bar_parent_class)->dispose (object);
 }
@@ -213,6 +218,8 @@ cc_level_bar_class_init (CcLevelBarClass *klass)
 
   object_class->dispose = cc_level_bar_dispose;
 
+  widget_class->map = cc_level_bar_map;
+  widget_class->unmap = cc_level_bar_unmap;
   widget_class->measure = cc_level_bar_measure;
   widget_class->snapshot = cc_level_bar_snapshot;
 }
@@ -227,64 +234,16 @@ cc_level_bar_set_stream (CcLevelBar     *self,
                          GvcMixerStream *stream,
                          CcStreamType    type)
 {
-  pa_context *context;
-  pa_sample_spec sample_spec;
-  pa_proplist *proplist;
-  pa_buffer_attr  attr;
-  g_autofree gchar *device = NULL;
-
   g_return_if_fail (CC_IS_LEVEL_BAR (self));
 
-  close_stream (self->level_stream);
-  g_clear_pointer (&self->level_stream, pa_stream_unref);
+  stop_monitoring (self);
+  g_set_object (&self->stream, stream);
 
   self->type = type;
+  self->value = 0.0;
 
-  if (stream == NULL)
-   {
-     self->value = 0.0;
-     gtk_widget_queue_draw (GTK_WIDGET (self));
-     return;
-   }
-
-  context = gvc_mixer_stream_get_pa_context (stream);
-
-  if (pa_context_get_server_protocol_version (context) < 13)
-    {
-      g_warning ("Unsupported version of PulseAudio");
-      return;
-    }
-
-  sample_spec.channels = 1;
-  sample_spec.format = PA_SAMPLE_FLOAT32;
-  sample_spec.rate = 25;
-
-  proplist = pa_proplist_new ();
-  pa_proplist_sets (proplist, PA_PROP_APPLICATION_ID, "org.gnome.VolumeControl");
-  self->level_stream = pa_stream_new_with_proplist (context, "Peak detect", &sample_spec, NULL, proplist);
-  pa_proplist_free (proplist);
-  if (self->level_stream == NULL)
-    {
-      g_warning ("Failed to create monitoring stream");
-      return;
-    }
-
-  pa_stream_set_read_callback (self->level_stream, read_cb, self);
-  pa_stream_set_suspended_callback (self->level_stream, suspended_cb, self);
-
-  memset (&attr, 0, sizeof (attr));
-  attr.fragsize = sizeof (float);
-  attr.maxlength = (uint32_t) -1;
-  device = g_strdup_printf ("%u", gvc_mixer_stream_get_index (stream));
-  if (pa_stream_connect_record (self->level_stream,
-                                device,
-                                &attr,
-                                (pa_stream_flags_t) (PA_STREAM_DONT_MOVE |
-                                                     PA_STREAM_PEAK_DETECT |
-                                                     PA_STREAM_ADJUST_LATENCY)) < 0)
-    {
-      g_warning ("Failed to connect monitoring stream");
-    }
+  if (gtk_widget_get_mapped (GTK_WIDGET (self)))
+    start_monitoring (self);
 
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
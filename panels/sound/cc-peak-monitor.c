@@ -0,0 +1,338 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <pulse/pulseaudio.h>
+#include <gvc-mixer-sink-input.h>
+
+#include "cc-peak-monitor.h"
+#include "gvc-mixer-stream-private.h"
+
+/* A CcPeakMonitor owns a single PulseAudio peak detection stream. Monitors
+ * are shared: every level meter watching the same device or application
+ * stream gets the same object, and the PulseAudio stream is closed when
+ * the last meter drops its reference. Meters poll the latest peak from
+ * their frame clock instead of being notified for every sample.
+ *
+ * PulseAudio kills the monitoring stream of an application stream when
+ * that stream moves to another sink, so a monitor whose stream was
+ * working reconnects. If the new stream fails before it gets ready, the
+ * watched stream is gone and the monitor is dropped from the shared table
+ * so the next caller starts afresh.
+ */
+
+/* Roughly one peak per displayed frame */
+#define PEAK_RATE 60
+
+struct _CcPeakMonitor
+{
+  GObject         parent_instance;
+
+  gchar          *key;
+  GvcMixerStream *mixer_stream;
+  pa_stream      *stream;
+  gboolean        was_ready;
+  guint           reconnect_id;
+  gdouble         peak;
+};
+
+G_DEFINE_TYPE (CcPeakMonitor, cc_peak_monitor, G_TYPE_OBJECT)
+
+/* Key → CcPeakMonitor, not owned */
+static GHashTable *monitors = NULL;
+
+static gboolean connect_stream (CcPeakMonitor  *self,
+                                GvcMixerStream *stream);
+
+static void
+forget_monitor (CcPeakMonitor *self)
+{
+  if (monitors == NULL || g_hash_table_lookup (monitors, self->key) != self)
+    return;
+
+  g_hash_table_remove (monitors, self->key);
+  if (g_hash_table_size (monitors) == 0)
+    g_clear_pointer (&monitors, g_hash_table_unref);
+}
+
+static void
+disconnect_stream (CcPeakMonitor *self)
+{
+  if (self->stream == NULL)
+    return;
+
+  /* Stop receiving data */
+  pa_stream_set_read_callback (self->stream, NULL, NULL);
+  pa_stream_set_suspended_callback (self->stream, NULL, NULL);
+  pa_stream_set_state_callback (self->stream, NULL, NULL);
+
+  if (pa_stream_get_state (self->stream) != PA_STREAM_UNCONNECTED)
+    pa_stream_disconnect (self->stream);
+  g_clear_pointer (&self->stream, pa_stream_unref);
+}
+
+static gboolean
+reconnect_cb (gpointer user_data)
+{
+  CcPeakMonitor *self = user_data;
+
+  self->reconnect_id = 0;
+
+  disconnect_stream (self);
+  if (!connect_stream (self, self->mixer_stream))
+    forget_monitor (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+read_cb (pa_stream *stream,
+         size_t     length,
+         void      *userdata)
+{
+  CcPeakMonitor *self = userdata;
+  gboolean have_peak = FALSE;
+  gfloat peak = 0.0;
+
+  /* Drain everything that is readable, only the loudest sample matters */
+  while (pa_stream_readable_size (stream) > 0)
+    {
+      const void *data;
+      const gfloat *samples;
+      gsize i;
+
+      if (pa_stream_peek (stream, &data, &length) < 0)
+        {
+          g_warning ("Failed to read data from stream");
+          return;
+        }
+
+      if (length == 0)
+        break;
+
+      /* A hole in the stream, skip it */
+      if (data == NULL)
+        {
+          pa_stream_drop (stream);
+          continue;
+        }
+
+      samples = data;
+      for (i = 0; i < length / sizeof (gfloat); i++)
+        {
+          if (!have_peak || samples[i] > peak)
+            peak = samples[i];
+          have_peak = TRUE;
+        }
+
+      pa_stream_drop (stream);
+    }
+
+  if (have_peak)
+    self->peak = CLAMP (peak, 0.0, 1.0);
+}
+
+static void
+suspended_cb (pa_stream *stream,
+              void      *userdata)
+{
+  CcPeakMonitor *self = userdata;
+
+  if (pa_stream_is_suspended (stream))
+    {
+      g_debug ("Stream suspended");
+      self->peak = 0.0;
+    }
+}
+
+static void
+state_cb (pa_stream *stream,
+          void      *userdata)
+{
+  CcPeakMonitor *self = userdata;
+
+  switch (pa_stream_get_state (stream))
+    {
+    case PA_STREAM_READY:
+      self->was_ready = TRUE;
+      break;
+    case PA_STREAM_FAILED:
+    case PA_STREAM_TERMINATED:
+      /* e.g. the application stream went away or moved */
+      self->peak = 0.0;
+      if (self->was_ready && self->reconnect_id == 0)
+        {
+          self->was_ready = FALSE;
+          self->reconnect_id = g_idle_add (reconnect_cb, self);
+        }
+      else if (self->reconnect_id == 0)
+        {
+          forget_monitor (self);
+        }
+      break;
+    default:
+      break;
+    }
+}
+
+static gchar *
+get_key (GvcMixerStream *stream)
+{
+  return g_strdup_printf ("%p:%s:%u",
+                          gvc_mixer_stream_get_pa_context (stream),
+                          GVC_IS_MIXER_SINK_INPUT (stream) ? "sink-input" : "device",
+                          gvc_mixer_stream_get_index (stream));
+}
+
+static gboolean
+connect_stream (CcPeakMonitor  *self,
+                GvcMixerStream *stream)
+{
+  pa_context *context;
+  pa_sample_spec sample_spec;
+  pa_proplist *proplist;
+  pa_buffer_attr attr;
+  g_autofree gchar *device = NULL;
+
+  context = gvc_mixer_stream_get_pa_context (stream);
+
+  if (pa_context_get_server_protocol_version (context) < 13)
+    {
+      g_warning ("Unsupported version of PulseAudio");
+      return FALSE;
+    }
+
+  sample_spec.channels = 1;
+  sample_spec.format = PA_SAMPLE_FLOAT32;
+  sample_spec.rate = PEAK_RATE;
+
+  proplist = pa_proplist_new ();
+  pa_proplist_sets (proplist, PA_PROP_APPLICATION_ID, "org.gnome.VolumeControl");
+  self->stream = pa_stream_new_with_proplist (context, "Peak detect", &sample_spec, NULL, proplist);
+  pa_proplist_free (proplist);
+  if (self->stream == NULL)
+    {
+      g_warning ("Failed to create monitoring stream");
+      return FALSE;
+    }
+
+  pa_stream_set_read_callback (self->stream, read_cb, self);
+  pa_stream_set_suspended_callback (self->stream, suspended_cb, self);
+  pa_stream_set_state_callback (self->stream, state_cb, self);
+
+  /* Application streams are monitored on their own, on the monitor
+   * source of whatever sink they play to. */
+  if (GVC_IS_MIXER_SINK_INPUT (stream))
+    pa_stream_set_monitor_stream (self->stream, gvc_mixer_stream_get_index (stream));
+  else
+    device = g_strdup_printf ("%u", gvc_mixer_stream_get_index (stream));
+
+  memset (&attr, 0, sizeof (attr));
+  attr.fragsize = sizeof (gfloat);
+  attr.maxlength = (uint32_t) -1;
+  if (pa_stream_connect_record (self->stream,
+                                device,
+                                &attr,
+                                (pa_stream_flags_t) (PA_STREAM_DONT_MOVE |
+                                                     PA_STREAM_PEAK_DETECT |
+                                                     PA_STREAM_ADJUST_LATENCY)) < 0)
+    {
+      g_warning ("Failed to connect monitoring stream");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+cc_peak_monitor_finalize (GObject *object)
+{
+  CcPeakMonitor *self = CC_PEAK_MONITOR (object);
+
+  g_clear_handle_id (&self->reconnect_id, g_source_remove);
+  disconnect_stream (self);
+
+  forget_monitor (self);
+  g_clear_pointer (&self->key, g_free);
+  g_clear_object (&self->mixer_stream);
+
+  G_OBJECT_CLASS (cc_peak_monitor_parent_class)->finalize (object);
+}
+
+static void
+cc_peak_monitor_class_init (CcPeakMonitorClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = cc_peak_monitor_finalize;
+}
+
+static void
+cc_peak_monitor_init (CcPeakMonitor *self)
+{
+}
+
+/**
+ * cc_peak_monitor_get_for_stream:
+ * @stream: a device or application stream
+ *
+ * Returns: (transfer full): the peak monitor watching @stream, shared with
+ * every other caller watching the same stream.
+ */
+CcPeakMonitor *
+cc_peak_monitor_get_for_stream (GvcMixerStream *stream)
+{
+  CcPeakMonitor *self;
+  g_autofree gchar *key = NULL;
+
+  g_return_val_if_fail (GVC_IS_MIXER_STREAM (stream), NULL);
+
+  key = get_key (stream);
+
+  if (monitors != NULL)
+    {
+      self = g_hash_table_lookup (monitors, key);
+      if (self != NULL)
+        return g_object_ref (self);
+    }
+  else
+    {
+      monitors = g_hash_table_new (g_str_hash, g_str_equal);
+    }
+
+  self = g_object_new (CC_TYPE_PEAK_MONITOR, NULL);
+  self->key = g_steal_pointer (&key);
+  self->mixer_stream = g_object_ref (stream);
+  g_hash_table_insert (monitors, self->key, self);
+
+  if (!connect_stream (self, stream))
+    forget_monitor (self);
+
+  return self;
+}
+
+/**
+ * cc_peak_monitor_get_peak:
+ * @monitor: a #CcPeakMonitor
+ *
+ * Returns: the most recent peak, between 0.0 and 1.0
+ */
+gdouble
+cc_peak_monitor_get_peak (CcPeakMonitor *self)
+{
+  g_return_val_if_fail (CC_IS_PEAK_MONITOR (self), 0.0);
+  return self->peak;
+}
@@ -0,0 +1,31 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <gvc-mixer-stream.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_PEAK_MONITOR (cc_peak_monitor_get_type ())
+G_DECLARE_FINAL_TYPE (CcPeakMonitor, cc_peak_monitor, CC, PEAK_MONITOR, GObject)
+
+CcPeakMonitor *cc_peak_monitor_get_for_stream (GvcMixerStream *stream);
+
+gdouble        cc_peak_monitor_get_peak       (CcPeakMonitor  *monitor);
+
+G_END_DECLS
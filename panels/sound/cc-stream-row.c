@@ -16,6 +16,9 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <gvc-mixer-sink-input.h>
+
+#include "cc-level-bar.h"
 #include "cc-sound-resources.h"
 #include "cc-stream-row.h"
 #include "cc-volume-slider.h"
@@ -31,6 +34,7 @@ struct _CcStreamRow
   GtkLabel       *name_label;
   GtkImage       *icon_image;
   CcVolumeSlider *volume_slider;
+  CcLevelBar     *level_bar;
 
   GvcMixerStream *stream;
   guint           id;
@@ -62,6 +66,7 @@ cc_stream_row_class_init (CcStreamRowClass *klass)
   gtk_widget_class_bind_template_child (widget_class, CcStreamRow, icon_image);
   gtk_widget_class_bind_template_child (widget_class, CcStreamRow, name_label);
   gtk_widget_class_bind_template_child (widget_class, CcStreamRow, volume_slider);
+  gtk_widget_class_bind_template_child (widget_class, CcStreamRow, level_bar);
 }
 
 void
@@ -122,6 +127,13 @@ cc_stream_row_new (GtkSizeGroup    *size_group,
   cc_volume_slider_set_stream (self->volume_slider, stream, stream_type);
   cc_volume_slider_set_mixer_control (self->volume_slider, mixer_control);
 
+  /* Only playback streams can be monitored on their own */
+  if (GVC_IS_MIXER_SINK_INPUT (stream))
+    {
+      cc_level_bar_set_stream (self->level_bar, stream, stream_type);
+      gtk_widget_set_visible (GTK_WIDGET (self->level_bar), TRUE);
+    }
+
   gtk_size_group_add_widget (size_group, GTK_WIDGET (self->label_box));
 
   return self;
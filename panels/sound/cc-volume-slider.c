@@ -37,6 +37,13 @@ struct _CcVolumeSlider
   GvcMixerStream  *stream;
   guint            notify_volume_handler_id;
   guint            notify_is_muted_handler_id;
+
+  /* Volume changes are pushed at most once per frame, and only once the
+   * previous request has been handled; the latest value wins. */
+  guint            push_tick_id;
+  gboolean         push_pending;
+  pa_volume_t      pending_volume;
+  pa_volume_t      pushed_volume;
 };
 
 G_DEFINE_TYPE (CcVolumeSlider, cc_volume_slider, GTK_TYPE_BOX)
@@ -62,6 +69,57 @@ update_volume_icon (CcVolumeSlider *self)
   gtk_button_set_icon_name (GTK_BUTTON (self->mute_button), icon_name);
 }
 
+static void notify_volume_cb (CcVolumeSlider *self);
+
+static void
+push_volume (CcVolumeSlider *self)
+{
+  self->push_pending = FALSE;
+  self->pushed_volume = self->pending_volume;
+
+  if (gvc_mixer_stream_set_volume (self->stream, self->pending_volume))
+      gvc_mixer_stream_push_volume (self->stream);
+}
+
+static gboolean
+push_tick_cb (GtkWidget     *widget,
+              GdkFrameClock *frame_clock,
+              gpointer       user_data)
+{
+  CcVolumeSlider *self = CC_VOLUME_SLIDER (widget);
+
+  /* Wait for the server to catch up with the previous request */
+  if (gvc_mixer_stream_is_running (self->stream))
+    return G_SOURCE_CONTINUE;
+
+  if (self->push_pending)
+    {
+      push_volume (self);
+      return G_SOURCE_CONTINUE;
+    }
+
+  self->push_tick_id = 0;
+
+  /* Pick up changes made by others while ours were in flight */
+  if (gvc_mixer_stream_get_volume (self->stream) != self->pushed_volume)
+    notify_volume_cb (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+flush_volume (CcVolumeSlider *self)
+{
+  if (self->push_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->push_tick_id);
+      self->push_tick_id = 0;
+    }
+
+  if (self->push_pending)
+    push_volume (self);
+}
+
 static void
 volume_changed_cb (CcVolumeSlider *self)
 {
@@ -75,8 +133,13 @@ volume_changed_cb (CcVolumeSlider *self)
 
   gtk_toggle_button_set_active (self->mute_button, volume == 0.0);
 
-  if (gvc_mixer_stream_set_volume (self->stream, (pa_volume_t) rounded))
-      gvc_mixer_stream_push_volume (self->stream);
+  self->pending_volume = (pa_volume_t) rounded;
+  self->push_pending = TRUE;
+
+  if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+    push_volume (self);
+  else if (self->push_tick_id == 0)
+    self->push_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), push_tick_cb, NULL, NULL);
 
   update_volume_icon (self);
 }
@@ -84,6 +147,10 @@ volume_changed_cb (CcVolumeSlider *self)
 static void
 notify_volume_cb (CcVolumeSlider *self)
 {
+  /* Ignore the echoes of our own pushes while the slider is being moved */
+  if (self->push_tick_id != 0)
+    return;
+
   g_signal_handlers_block_by_func (self->volume_adjustment, volume_changed_cb, self);
 
   if (gtk_toggle_button_get_active (self->mute_button))
@@ -145,11 +212,24 @@ notify_is_muted_cb (CcVolumeSlider *self)
   notify_volume_cb (self);
 }
 
+static void
+cc_volume_slider_unmap (GtkWidget *widget)
+{
+  CcVolumeSlider *self = CC_VOLUME_SLIDER (widget);
+
+  flush_volume (self);
+
+  GTK_WIDGET_CLASS (cc_volume_slider_parent_class)->unmap (widget);
+}
+
 static void
 cc_volume_slider_dispose (GObject *object)
 {
   CcVolumeSlider *self = CC_VOLUME_SLIDER (object);
 
+  if (self->stream != NULL)
+    flush_volume (self);
+
   g_clear_object (&self->mixer_control);
   g_clear_object (&self->stream);
 
@@ -164,6 +244,8 @@ cc_volume_slider_class_init (CcVolumeSliderClass *klass)
 
   object_class->dispose = cc_volume_slider_dispose;
 
+  widget_class->unmap = cc_volume_slider_unmap;
+
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/control-center/sound/cc-volume-slider.ui");
 
   gtk_widget_class_bind_template_child (widget_class, CcVolumeSlider, mute_button);
@@ -202,6 +284,8 @@ cc_volume_slider_set_stream (CcVolumeSlider *self,
 
   if (self->stream != NULL)
     {
+      flush_volume (self);
+
       g_signal_handler_disconnect (self->stream, self->notify_volume_handler_id);
       self->notify_volume_handler_id = 0;
       g_signal_handler_disconnect (self->stream, self->notify_is_muted_handler_id);
@@ -333,6 +333,227 @@ bolt_client_list_devices (BoltClient   *client,
   return g_steal_pointer (&devices);
 }
 
+static void
+got_the_device_paths (GObject      *source,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+  GError *err = NULL;
+  GTask *task = user_data;
+  GVariant *val;
+  char **paths = NULL;
+
+  val = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), res, &err);
+
+  if (val == NULL)
+    {
+      g_task_return_error (task, err); /* takes ownership */
+      g_object_unref (task);
+      return;
+    }
+
+  g_variant_get (val, "(^ao)", &paths);
+  g_variant_unref (val);
+
+  g_task_return_pointer (task, paths, (GDestroyNotify) g_strfreev);
+  g_object_unref (task);
+}
+
+void
+bolt_client_list_device_paths_async (BoltClient         *client,
+                                     GCancellable       *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer            user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (BOLT_IS_CLIENT (client));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (client, cancellable, callback, user_data);
+
+  g_dbus_proxy_call (G_DBUS_PROXY (client),
+                     "ListDevices",
+                     NULL,
+                     G_DBUS_CALL_FLAGS_NONE,
+                     -1,
+                     cancellable,
+                     got_the_device_paths,
+                     task);
+}
+
+char **
+bolt_client_list_device_paths_finish (BoltClient   *client,
+                                      GAsyncResult *res,
+                                      GError      **error)
+{
+  g_autoptr(GError) err = NULL;
+  char **paths;
+
+  g_return_val_if_fail (BOLT_IS_CLIENT (client), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  paths = g_task_propagate_pointer (G_TASK (res), &err);
+
+  if (paths == NULL)
+    bolt_error_propagate_stripped (error, &err);
+
+  return paths;
+}
+
+typedef struct ListData
+{
+  BoltDevice **devices;
+  guint        n_devices;
+  guint        pending;
+  GError      *error;
+} ListData;
+
+typedef struct ListSlot
+{
+  GTask *task;
+  guint  index;
+} ListSlot;
+
+static void
+list_data_free (ListData *data)
+{
+  for (guint i = 0; i < data->n_devices; i++)
+    g_clear_object (&data->devices[i]);
+
+  g_free (data->devices);
+  g_clear_error (&data->error);
+  g_free (data);
+}
+
+static void
+list_return_devices (GTask    *task,
+                     ListData *data)
+{
+  GPtrArray *devices;
+
+  if (data->error != NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&data->error));
+      return;
+    }
+
+  /* in the order they were listed */
+  devices = g_ptr_array_new_full (data->n_devices, g_object_unref);
+  for (guint i = 0; i < data->n_devices; i++)
+    g_ptr_array_add (devices, g_steal_pointer (&data->devices[i]));
+
+  g_task_return_pointer (task, devices, (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+list_got_device (GObject      *source,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+  ListSlot *slot = user_data;
+  GTask *task = slot->task;
+  GError *err = NULL;
+  ListData *data;
+  BoltDevice *dev;
+
+  data = g_task_get_task_data (task);
+  dev = bolt_device_new_for_object_path_finish (res, &err);
+
+  if (dev == NULL && data->error == NULL)
+    data->error = err; /* takes ownership */
+  else if (dev == NULL)
+    g_error_free (err);
+
+  data->devices[slot->index] = dev;
+  g_free (slot);
+
+  data->pending--;
+  if (data->pending > 0)
+    return;
+
+  list_return_devices (task, data);
+  g_object_unref (task);
+}
+
+static void
+list_got_paths (GObject      *source,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+  g_auto(GStrv) paths = NULL;
+  GDBusConnection *bus;
+  GCancellable *cancel;
+  GError *err = NULL;
+  GTask *task = user_data;
+  ListData *data;
+
+  paths = bolt_client_list_device_paths_finish (BOLT_CLIENT (source), res, &err);
+
+  if (paths == NULL)
+    {
+      g_task_return_error (task, err); /* takes ownership */
+      g_object_unref (task);
+      return;
+    }
+
+  data = g_task_get_task_data (task);
+  data->n_devices = g_strv_length (paths);
+  data->devices = g_new0 (BoltDevice *, data->n_devices);
+
+  if (data->n_devices == 0)
+    {
+      list_return_devices (task, data);
+      g_object_unref (task);
+      return;
+    }
+
+  bus = g_dbus_proxy_get_connection (G_DBUS_PROXY (source));
+  cancel = g_task_get_cancellable (task);
+
+  /* every proxy needs a round trip to fetch its properties, so
+   * create all of them at once instead of one after the other */
+  data->pending = data->n_devices;
+  for (guint i = 0; i < data->n_devices; i++)
+    {
+      ListSlot *slot = g_new (ListSlot, 1);
+
+      slot->task = task;
+      slot->index = i;
+
+      bolt_device_new_for_object_path_async (bus, paths[i], cancel, list_got_device, slot);
+    }
+}
+
+void
+bolt_client_list_devices_async (BoltClient         *client,
+                                GCancellable       *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer            user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (BOLT_IS_CLIENT (client));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (client, cancellable, callback, user_data);
+  g_task_set_task_data (task, g_new0 (ListData, 1), (GDestroyNotify) list_data_free);
+
+  bolt_client_list_device_paths_async (client, cancellable, list_got_paths, task);
+}
+
+GPtrArray *
+bolt_client_list_devices_finish (BoltClient   *client,
+                                 GAsyncResult *res,
+                                 GError      **error)
+{
+  g_return_val_if_fail (BOLT_IS_CLIENT (client), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, client), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
 BoltDevice *
 bolt_client_get_device (BoltClient   *client,
                         const char   *uid,
@@ -494,6 +715,10 @@ typedef struct OpData
   const char *method; /* Enroll or Authorize */
   char       *path;   /* object path */
   GVariant   *params; /* parameters */
+  char       *uid;    /* device */
+  int         parent; /* op that has to be done first, or -1 */
+  gboolean    started;
+  gboolean    done;
 
 } OpData;
 
@@ -507,11 +732,13 @@ op_data_new_enroll (const char *uid,
 
   params = g_variant_new ("(sss)", uid, policy, flags);
 
-  op = g_slice_new (OpData);
+  op = g_slice_new0 (OpData);
   op->iface = BOLT_DBUS_INTERFACE;
   op->method = "EnrollDevice";
   op->params = g_variant_ref_sink (params);
   op->path = g_strdup (BOLT_DBUS_PATH);
+  op->uid = g_strdup (uid);
+  op->parent = -1;
 
   return op;
 }
@@ -528,12 +755,14 @@ op_data_new_authorize (const char *uid,
   path = bolt_gen_object_path (BOLT_DBUS_PATH_DEVICES, uid);
   params = g_variant_new ("(s)", flags);
 
-  op = g_slice_new (OpData);
+  op = g_slice_new0 (OpData);
 
   op->iface = BOLT_DBUS_DEVICE_INTERFACE;
   op->method = "Authorize";
   op->params = g_variant_ref_sink (params);
   op->path = path; /* takes ownership */
+  op->uid = g_strdup (uid);
+  op->parent = -1;
 
   return op;
 }
@@ -543,50 +772,149 @@ op_data_free (OpData *op)
 {
   g_clear_pointer (&op->params, g_variant_unref);
   g_clear_pointer (&op->path, g_free);
+  g_clear_pointer (&op->uid, g_free);
   g_slice_free (OpData, op);
 }
 
+/* All the operations of an enroll/authorize/connect-all call. An
+ * operation is started as soon as the one for its parent device is
+ * done, so siblings run concurrently while every device still comes
+ * after the one it is connected to. */
+typedef struct AllOpData
+{
+  GPtrArray             *ops;  /* OpData */
+  guint                  n_done;
+  gboolean               finished;
+
+  /* cancelled with the task's cancellable or on the first error */
+  GCancellable          *cancel;
+  GCancellable          *task_cancel;
+  gulong                 cancel_id;
+
+  BoltDeviceProgressFunc progress;
+  gpointer               progress_data;
+  GDestroyNotify         progress_notify;
+} AllOpData;
+
+typedef struct AllOpCall
+{
+  GTask *task;
+  guint  index;
+} AllOpCall;
+
 static void
-op_queue_free (GQueue *queue)
+allop_data_free (AllOpData *data)
 {
-  g_queue_free_full (queue, (GDestroyNotify) op_data_free);
+  if (data->task_cancel != NULL)
+    g_cancellable_disconnect (data->task_cancel, data->cancel_id);
+
+  g_clear_object (&data->task_cancel);
+  g_clear_object (&data->cancel);
+  g_ptr_array_unref (data->ops);
+
+  if (data->progress_notify)
+    data->progress_notify (data->progress_data);
+
+  g_slice_free (AllOpData, data);
+}
+
+static void
+allop_cancelled (GCancellable *task_cancel,
+                 GCancellable *cancel)
+{
+  g_cancellable_cancel (cancel);
+}
+
+static GTask *
+allop_task_new (BoltClient            *client,
+                BoltDeviceProgressFunc progress,
+                gpointer               progress_data,
+                GDestroyNotify         progress_notify,
+                GCancellable          *cancellable,
+                GAsyncReadyCallback    callback,
+                gpointer               user_data)
+{
+  AllOpData *data;
+  GTask *task;
+
+  task = g_task_new (client, cancellable, callback, user_data);
+  g_task_set_return_on_cancel (task, TRUE);
+
+  data = g_slice_new0 (AllOpData);
+  data->ops = g_ptr_array_new_with_free_func ((GDestroyNotify) op_data_free);
+  data->cancel = g_cancellable_new ();
+  data->progress = progress;
+  data->progress_data = progress_data;
+  data->progress_notify = progress_notify;
+
+  if (cancellable != NULL)
+    {
+      data->task_cancel = g_object_ref (cancellable);
+      data->cancel_id = g_cancellable_connect (cancellable,
+                                               G_CALLBACK (allop_cancelled),
+                                               data->cancel,
+                                               NULL);
+    }
+
+  g_task_set_task_data (task, data, (GDestroyNotify) allop_data_free);
+
+  return task;
 }
 
 static void    allop_one_done (GObject      *source_object,
                                GAsyncResult *res,
                                gpointer      user_data);
 
-static gboolean
-allop_continue (BoltClient *client, GTask *task, GQueue *ops)
+static void
+allop_continue (BoltClient *client, GTask *task, AllOpData *data)
 {
   GDBusConnection *bus;
-  GCancellable *cancel;
-  OpData *op;
 
-  cancel = g_task_get_cancellable (task);
   bus = g_dbus_proxy_get_connection (G_DBUS_PROXY (client));
 
-  op = g_queue_pop_head (ops);
-
-  if (op == NULL)
-    return TRUE;
-
-  g_dbus_connection_call (bus,
-                          BOLT_DBUS_NAME,
-                          op->path,
-                          op->iface,
-                          op->method,
-                          op->params,
-                          NULL,
-                          G_DBUS_CALL_FLAGS_NONE,
-                          -1,
-                          cancel,
-                          allop_one_done,
-                          task);
-
-  op_data_free (op);
+  if (data->ops->len == 0)
+    {
+      /* nothing to do, so we are done */
+      data->finished = TRUE;
+      g_task_return_boolean (task, TRUE);
+      return;
+    }
 
-  return FALSE;
+  for (guint i = 0; i < data->ops->len; i++)
+    {
+      OpData *op = g_ptr_array_index (data->ops, i);
+      AllOpCall *call;
+
+      if (op->started)
+        continue;
+
+      if (op->parent >= 0)
+        {
+          OpData *parent = g_ptr_array_index (data->ops, op->parent);
+
+          if (!parent->done)
+            continue;
+        }
+
+      op->started = TRUE;
+
+      call = g_slice_new (AllOpCall);
+      call->task = g_object_ref (task);
+      call->index = i;
+
+      g_dbus_connection_call (bus,
+                              BOLT_DBUS_NAME,
+                              op->path,
+                              op->iface,
+                              op->method,
+                              op->params,
+                              NULL,
+                              G_DBUS_CALL_FLAGS_NONE,
+                              -1,
+                              data->cancel,
+                              allop_one_done,
+                              call);
+    }
 }
 
 static void
@@ -595,36 +923,72 @@ allop_one_done (GObject      *source_object,
                 gpointer      user_data)
 {
   g_autoptr(GVariant) val = NULL;
+  g_autoptr(GTask) task = NULL;
+  AllOpCall *call = user_data;
   BoltClient *client;
-  GDBusConnection *bus;
-  gboolean done;
+  AllOpData *data;
   GError *err = NULL;
-  GQueue *ops;
-  GTask *task;
+  OpData *op;
 
-  task = G_TASK (user_data);
+  task = call->task;
+  data = g_task_get_task_data (task);
+  op = g_ptr_array_index (data->ops, call->index);
+  g_slice_free (AllOpCall, call);
 
-  ops = g_task_get_task_data (task);
-  client = g_task_get_source_object (task);
-  bus = g_dbus_proxy_get_connection (G_DBUS_PROXY (client));
+  val = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &err);
 
-  val = g_dbus_connection_call_finish (bus, res, &err);
+  /* an earlier error ended it already */
+  if (data->finished)
+    {
+      g_clear_error (&err);
+      return;
+    }
 
   if (val == NULL)
     {
+      /* we are done (albeit with an error), stop what is in flight */
+      data->finished = TRUE;
+      g_cancellable_cancel (data->cancel);
       g_task_return_error (task, err); /* takes ownership */
-      g_object_unref (task);
-      /* we are done (albeit with an error) */
       return;
     }
 
-  done = allop_continue (client, task, ops);
+  op->done = TRUE;
+  data->n_done++;
 
-  if (done)
+  if (data->progress)
+    data->progress (op->uid, data->n_done, data->ops->len, data->progress_data);
+
+  if (data->n_done == data->ops->len)
     {
       /* we are done */
+      data->finished = TRUE;
       g_task_return_boolean (task, TRUE);
-      g_object_unref (task);
+      return;
+    }
+
+  /* do not start anything new once cancelled */
+  if (g_cancellable_set_error_if_cancelled (data->cancel, &err))
+    {
+      data->finished = TRUE;
+      g_task_return_error (task, err);
+      return;
+    }
+
+  client = g_task_get_source_object (task);
+  allop_continue (client, task, data);
+}
+
+static void
+allop_chain (AllOpData *data)
+{
+  /* nothing is known about how the devices are connected,
+   * so keep the order they were given in */
+  for (guint i = 1; i < data->ops->len; i++)
+    {
+      OpData *op = g_ptr_array_index (data->ops, i);
+
+      op->parent = i - 1;
     }
 }
 
@@ -640,7 +1004,7 @@ bolt_client_enroll_all_async (BoltClient         *client,
   g_autofree char *fstr = NULL;
   GError *err = NULL;
   const char *pstr;
-  GQueue *ops;
+  AllOpData *data;
   GTask *task;
 
   g_return_if_fail (BOLT_IS_CLIENT (client));
@@ -662,11 +1026,8 @@ bolt_client_enroll_all_async (BoltClient         *client,
       return;
     }
 
-  task = g_task_new (client, cancellable, callback, user_data);
-  g_task_set_return_on_cancel (task, TRUE);
-
-  ops = g_queue_new ();
-  g_task_set_task_data (task, ops, (GDestroyNotify) op_queue_free);
+  task = allop_task_new (client, NULL, NULL, NULL, cancellable, callback, user_data);
+  data = g_task_get_task_data (task);
 
   for (guint i = 0; i < uuids->len; i++)
     {
@@ -675,10 +1036,12 @@ bolt_client_enroll_all_async (BoltClient         *client,
 
       op = op_data_new_enroll (uid, pstr, fstr);
 
-      g_queue_push_tail (ops, op);
+      g_ptr_array_add (data->ops, op);
     }
 
-  allop_continue (client, task, ops);
+  allop_chain (data);
+  allop_continue (client, task, data);
+  g_object_unref (task);
 }
 
 gboolean
@@ -711,7 +1074,7 @@ bolt_client_authorize_all_async (BoltClient         *client,
 {
   g_autofree char *fstr = NULL;
   GError *err = NULL;
-  GQueue *ops;
+  AllOpData *data;
   GTask *task;
 
   g_return_if_fail (BOLT_IS_CLIENT (client));
@@ -726,11 +1089,8 @@ bolt_client_authorize_all_async (BoltClient         *client,
       return;
     }
 
-  task = g_task_new (client, cancellable, callback, user_data);
-  g_task_set_return_on_cancel (task, TRUE);
-
-  ops = g_queue_new ();
-  g_task_set_task_data (task, ops, (GDestroyNotify) op_queue_free);
+  task = allop_task_new (client, NULL, NULL, NULL, cancellable, callback, user_data);
+  data = g_task_get_task_data (task);
 
   for (guint i = 0; i < uuids->len; i++)
     {
@@ -739,10 +1099,12 @@ bolt_client_authorize_all_async (BoltClient         *client,
 
       op = op_data_new_authorize (uid, fstr);
 
-      g_queue_push_tail (ops, op);
+      g_ptr_array_add (data->ops, op);
     }
 
-  allop_continue (client, task, ops);
+  allop_chain (data);
+  allop_continue (client, task, data);
+  g_object_unref (task);
 }
 
 gboolean
@@ -774,10 +1136,35 @@ bolt_client_connect_all_async (BoltClient         *client,
                                GAsyncReadyCallback callback,
                                gpointer            user_data)
 {
+  bolt_client_connect_all_full_async (client,
+                                      devices,
+                                      policy,
+                                      flags,
+                                      NULL,
+                                      NULL,
+                                      NULL,
+                                      cancellable,
+                                      callback,
+                                      user_data);
+}
+
+void
+bolt_client_connect_all_full_async (BoltClient            *client,
+                                    GPtrArray             *devices,
+                                    BoltPolicy             policy,
+                                    BoltAuthCtrl           flags,
+                                    BoltDeviceProgressFunc progress,
+                                    gpointer               progress_data,
+                                    GDestroyNotify         progress_notify,
+                                    GCancellable          *cancellable,
+                                    GAsyncReadyCallback    callback,
+                                    gpointer               user_data)
+{
+  g_autoptr(GHashTable) index = NULL;
   g_autofree char *fstr = NULL;
   GError *err = NULL;
   const char *pstr;
-  GQueue *ops;
+  AllOpData *data;
   GTask *task;
 
   g_return_if_fail (BOLT_IS_CLIENT (client));
@@ -799,11 +1186,12 @@ bolt_client_connect_all_async (BoltClient         *client,
       return;
     }
 
-  task = g_task_new (client, cancellable, callback, user_data);
-  g_task_set_return_on_cancel (task, TRUE);
+  task = allop_task_new (client, progress, progress_data, progress_notify,
+                         cancellable, callback, user_data);
+  data = g_task_get_task_data (task);
 
-  ops = g_queue_new ();
-  g_task_set_task_data (task, ops, (GDestroyNotify) op_queue_free);
+  /* uid → op index */
+  index = g_hash_table_new (g_str_hash, g_str_equal);
 
   for (guint i = 0; i < devices->len; i++)
     {
@@ -816,10 +1204,27 @@ bolt_client_connect_all_async (BoltClient         *client,
       else
         op = op_data_new_enroll (uid, pstr, fstr);
 
-      g_queue_push_tail (ops, op);
+      g_ptr_array_add (data->ops, op);
+      g_hash_table_insert (index, op->uid, GUINT_TO_POINTER (i + 1));
     }
 
-  allop_continue (client, task, ops);
+  /* a device has to wait for its parent, if that is part of the
+   * operation too; devices on different branches do not wait for
+   * each other */
+  for (guint i = 0; i < devices->len; i++)
+    {
+      BoltDevice *dev = g_ptr_array_index (devices, i);
+      OpData *op = g_ptr_array_index (data->ops, i);
+      const char *parent = bolt_device_get_parent (dev);
+      guint n;
+
+      n = GPOINTER_TO_UINT (g_hash_table_lookup (index, parent ? parent : ""));
+      if (n > 0 && n - 1 != i)
+        op->parent = n - 1;
+    }
+
+  allop_continue (client, task, data);
+  g_object_unref (task);
 }
 
 gboolean
@@ -29,6 +29,18 @@ G_BEGIN_DECLS
 #define BOLT_TYPE_CLIENT bolt_client_get_type ()
 G_DECLARE_FINAL_TYPE (BoltClient, bolt_client, BOLT, CLIENT, BoltProxy);
 
+/**
+ * BoltDeviceProgressFunc:
+ * @uid: the device that was just enrolled or authorized
+ * @done: the number of devices done so far
+ * @total: the number of devices in the operation
+ * @user_data: user data
+ */
+typedef void (*BoltDeviceProgressFunc) (const char *uid,
+                                        guint       done,
+                                        guint       total,
+                                        gpointer    user_data);
+
 BoltClient *    bolt_client_new (GError **error);
 
 void            bolt_client_new_async (GCancellable       *cancellable,
@@ -41,6 +53,24 @@ GPtrArray *     bolt_client_list_devices (BoltClient   *client,
                                           GCancellable *cancellable,
                                           GError      **error);
 
+void            bolt_client_list_devices_async (BoltClient         *client,
+                                                GCancellable       *cancellable,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+
+GPtrArray *     bolt_client_list_devices_finish (BoltClient   *client,
+                                                 GAsyncResult *res,
+                                                 GError      **error);
+
+void            bolt_client_list_device_paths_async (BoltClient         *client,
+                                                     GCancellable       *cancellable,
+                                                     GAsyncReadyCallback callback,
+                                                     gpointer            user_data);
+
+char **         bolt_client_list_device_paths_finish (BoltClient   *client,
+                                                      GAsyncResult *res,
+                                                      GError      **error);
+
 BoltDevice *    bolt_client_get_device (BoltClient   *client,
                                         const char   *uid,
                                         GCancellable *cancellable,
@@ -96,6 +126,17 @@ void            bolt_client_connect_all_async (BoltClient         *client,
                                                GAsyncReadyCallback callback,
                                                gpointer            user_data);
 
+void            bolt_client_connect_all_full_async (BoltClient            *client,
+                                                    GPtrArray             *devices,
+                                                    BoltPolicy             policy,
+                                                    BoltAuthCtrl           flags,
+                                                    BoltDeviceProgressFunc progress,
+                                                    gpointer               progress_data,
+                                                    GDestroyNotify         progress_notify,
+                                                    GCancellable          *cancellable,
+                                                    GAsyncReadyCallback    callback,
+                                                    gpointer               user_data);
+
 gboolean        bolt_client_connect_all_finish (BoltClient   *client,
                                                 GAsyncResult *res,
                                                 GError      **error);
@@ -225,6 +225,45 @@ bolt_device_new_for_object_path (GDBusConnection *bus,
   return dev;
 }
 
+void
+bolt_device_new_for_object_path_async (GDBusConnection    *bus,
+                                       const char         *path,
+                                       GCancellable       *cancel,
+                                       GAsyncReadyCallback callback,
+                                       gpointer            user_data)
+{
+  g_return_if_fail (G_IS_DBUS_CONNECTION (bus));
+  g_return_if_fail (path != NULL);
+
+  g_async_initable_new_async (BOLT_TYPE_DEVICE,
+                              G_PRIORITY_DEFAULT,
+                              cancel,
+                              callback,
+                              user_data,
+                              "g-flags", G_DBUS_PROXY_FLAGS_NONE,
+                              "g-connection", bus,
+                              "g-name", BOLT_DBUS_NAME,
+                              "g-object-path", path,
+                              "g-interface-name", BOLT_DBUS_DEVICE_INTERFACE,
+                              NULL);
+}
+
+BoltDevice *
+bolt_device_new_for_object_path_finish (GAsyncResult *res,
+                                        GError      **error)
+{
+  g_autoptr(GObject) source = NULL;
+  GObject *obj;
+
+  source = g_async_result_get_source_object (res);
+  obj = g_async_initable_new_finish (G_ASYNC_INITABLE (source), res, error);
+
+  if (obj == NULL)
+    return NULL;
+
+  return BOLT_DEVICE (obj);
+}
+
 gboolean
 bolt_device_authorize (BoltDevice   *dev,
                        BoltAuthCtrl  flags,
@@ -33,6 +33,15 @@ BoltDevice *  bolt_device_new_for_object_path (GDBusConnection *bus,
                                                GCancellable    *cancellable,
                                                GError         **error);
 
+void          bolt_device_new_for_object_path_async (GDBusConnection    *bus,
+                                                     const char         *path,
+                                                     GCancellable       *cancellable,
+                                                     GAsyncReadyCallback callback,
+                                                     gpointer            user_data);
+
+BoltDevice *  bolt_device_new_for_object_path_finish (GAsyncResult *res,
+                                                      GError      **error);
+
 gboolean      bolt_device_authorize (BoltDevice   *dev,
                                      BoltAuthCtrl  flags,
                                      GCancellable *cancellable,
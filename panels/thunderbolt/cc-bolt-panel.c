@@ -59,8 +59,11 @@ struct _CcBoltPanel
   GtkSpinner         *authmode_spinner;
   GtkStack           *direct_access_row;
 
-  /* device list */
+  /* device list, keyed by object path */
   GHashTable         *devices;
+  /* object paths of devices whose proxies are being created */
+  GHashTable         *pending_devices;
+  GCancellable       *sync_cancel;
 
   GtkStack           *devices_stack;
   GtkBox             *devices_box;
@@ -90,6 +93,9 @@ static void                cc_bolt_panel_name_owner_changed (CcBoltPanel *panel)
 static CcBoltDeviceEntry * cc_bolt_panel_add_device (CcBoltPanel *panel,
                                                      BoltDevice  *dev);
 
+static void                cc_bolt_panel_load_device (CcBoltPanel *panel,
+                                                      const char  *path);
+
 static void                cc_bolt_panel_del_device_entry (CcBoltPanel       *panel,
                                                            CcBoltDeviceEntry *entry);
 
@@ -266,43 +272,76 @@ devices_table_clear_entries (GHashTable  *table,
 }
 
 static void
-devices_table_synchronize (CcBoltPanel *panel)
+on_device_paths_ready (GObject      *source_object,
+                       GAsyncResult *res,
+                       gpointer      user_data)
 {
   g_autoptr(GHashTable) old = NULL;
-  g_autoptr(GPtrArray) devices = NULL;
+  g_autoptr(GHashTable) old_pending = NULL;
   g_autoptr(GError) err = NULL;
+  g_auto(GStrv) paths = NULL;
+  CcBoltPanel *panel;
   guint i;
 
-  devices = bolt_client_list_devices (panel->client, cc_panel_get_cancellable (CC_PANEL (panel)), &err);
+  paths = bolt_client_list_device_paths_finish (BOLT_CLIENT (source_object), res, &err);
 
-  if (!devices)
+  if (paths == NULL)
     {
+      /* superseded, or the panel got destroyed */
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+
       g_warning ("Could not list devices: %s", err->message);
-      devices = g_ptr_array_new_with_free_func (g_object_unref);
+      paths = g_new0 (char *, 1);
     }
 
+  panel = CC_BOLT_PANEL (user_data);
+
   old = panel->devices;
   panel->devices = g_hash_table_new (g_str_hash, g_str_equal);
 
-  for (i = 0; i < devices->len; i++)
+  old_pending = panel->pending_devices;
+  panel->pending_devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (i = 0; paths[i] != NULL; i++)
     {
-      BoltDevice *dev = g_ptr_array_index (devices, i);
-      const char *path;
+      const char *path = paths[i];
+      gpointer key;
       gboolean found;
 
-      path = g_dbus_proxy_get_object_path (G_DBUS_PROXY (dev));
+      /* known devices keep their entries, which follow the property
+       * changes of their proxies on their own */
       found = devices_table_transfer_entry (old, panel->devices, path);
 
       if (found)
         continue;
 
-      cc_bolt_panel_add_device (panel, dev);
+      if (g_hash_table_steal_extended (old_pending, path, &key, NULL))
+        {
+          g_hash_table_add (panel->pending_devices, key);
+          continue;
+        }
+
+      cc_bolt_panel_load_device (panel, path);
     }
 
   devices_table_clear_entries (old, panel);
   gtk_stack_set_visible_child_name (panel->container, "devices-listing");
 }
 
+static void
+devices_table_synchronize (CcBoltPanel *panel)
+{
+  g_cancellable_cancel (panel->sync_cancel);
+  g_clear_object (&panel->sync_cancel);
+  panel->sync_cancel = g_cancellable_new ();
+
+  bolt_client_list_device_paths_async (panel->client,
+                                       panel->sync_cancel,
+                                       on_device_paths_ready,
+                                       panel);
+}
+
 static gboolean
 list_box_sync_visible (GtkListBox *listbox)
 {
@@ -374,6 +413,57 @@ cc_bolt_panel_add_device (CcBoltPanel *panel,
   return entry;
 }
 
+static void
+on_device_ready (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+  g_autoptr(BoltDevice) dev = NULL;
+  g_autoptr(GError) err = NULL;
+  CcBoltPanel *panel;
+  const char *path;
+
+  dev = bolt_device_new_for_object_path_finish (res, &err);
+
+  /* operation got cancelled because the panel got destroyed */
+  if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  panel = CC_BOLT_PANEL (user_data);
+  path = g_dbus_proxy_get_object_path (G_DBUS_PROXY (source_object));
+
+  /* the device went away in the meantime */
+  if (!g_hash_table_remove (panel->pending_devices, path))
+    return;
+
+  if (!dev)
+    {
+      g_warning ("Could not create proxy for %s: %s", path, err->message);
+      return;
+    }
+
+  if (g_hash_table_contains (panel->devices, path))
+    return;
+
+  cc_bolt_panel_add_device (panel, dev);
+}
+
+static void
+cc_bolt_panel_load_device (CcBoltPanel *panel,
+                           const char  *path)
+{
+  GDBusConnection *bus;
+
+  g_hash_table_add (panel->pending_devices, g_strdup (path));
+
+  bus = g_dbus_proxy_get_connection (G_DBUS_PROXY (panel->client));
+  bolt_device_new_for_object_path_async (bus,
+                                         path,
+                                         cc_panel_get_cancellable (CC_PANEL (panel)),
+                                         on_device_ready,
+                                         panel);
+}
+
 static void
 cc_bolt_panel_del_device_entry (CcBoltPanel       *panel,
                                 CcBoltDeviceEntry *entry)
@@ -482,6 +572,8 @@ cc_bolt_panel_name_owner_changed (CcBoltPanel *panel)
   if (name_owner == NULL)
     {
       cc_bolt_panel_set_no_thunderbolt (panel, NULL);
+      g_cancellable_cancel (panel->sync_cancel);
+      g_hash_table_remove_all (panel->pending_devices);
       devices_table_clear_entries (panel->devices, panel);
       gtk_widget_hide (GTK_WIDGET (panel->headerbar_box));
       return;
@@ -547,26 +639,15 @@ on_bolt_device_added_cb (BoltClient  *cli,
                          const char  *path,
                          CcBoltPanel *panel)
 {
-  g_autoptr(GError) err = NULL;
-  GDBusConnection *bus;
-  BoltDevice *dev;
   gboolean found;
 
-  found = g_hash_table_contains (panel->devices, path);
+  found = g_hash_table_contains (panel->devices, path) ||
+          g_hash_table_contains (panel->pending_devices, path);
 
   if (found)
     return;
 
-  bus = g_dbus_proxy_get_connection (G_DBUS_PROXY (panel->client));
-  dev = bolt_device_new_for_object_path (bus, path, cc_panel_get_cancellable (CC_PANEL (panel)), &err);
-
-  if (!dev)
-    {
-      g_warning ("Could not create proxy for %s", path);
-      return;
-    }
-
-  cc_bolt_panel_add_device (panel, dev);
+  cc_bolt_panel_load_device (panel, path);
 }
 
 static void
@@ -576,6 +657,8 @@ on_bolt_device_removed_cb (BoltClient  *cli,
 {
   CcBoltDeviceEntry *entry;
 
+  g_hash_table_remove (panel->pending_devices, path);
+
   entry = g_hash_table_lookup (panel->devices, path);
 
   if (!entry)
@@ -865,6 +948,7 @@ cc_bolt_panel_finalize (GObject *object)
 
   g_clear_object (&panel->client);
   g_clear_pointer (&panel->devices, g_hash_table_unref);
+  g_clear_pointer (&panel->pending_devices, g_hash_table_unref);
   g_clear_object (&panel->permission);
 
   G_OBJECT_CLASS (cc_bolt_panel_parent_class)->finalize (object);
@@ -875,6 +959,9 @@ cc_bolt_panel_dispose (GObject *object)
 {
   CcBoltPanel *panel = CC_BOLT_PANEL (object);
 
+  g_cancellable_cancel (panel->sync_cancel);
+  g_clear_object (&panel->sync_cancel);
+
   /* Must be destroyed in dispose, not finalize. */
   cc_bolt_device_dialog_set_device (panel->device_dialog, NULL, NULL);
   g_clear_pointer ((GtkWindow **) &panel->device_dialog, gtk_window_destroy);
@@ -948,6 +1035,7 @@ cc_bolt_panel_init (CcBoltPanel *panel)
                               NULL);
 
   panel->devices = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, NULL);
+  panel->pending_devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
   panel->device_dialog = cc_bolt_device_dialog_new ();
 
@@ -103,9 +103,13 @@ struct _CcAddUserDialog {
 
         gboolean            has_custom_username;
         gint                local_name_timeout_id;
+        GCancellable       *local_choices_cancellable;
         gint                local_username_timeout_id;
+        GCancellable       *local_username_cancellable;
         ActUserPasswordMode local_password_mode;
         gint                local_password_timeout_id;
+        GCancellable       *local_strength_cancellable;
+        gint                local_strength_level;
         gboolean            local_valid_username;
 
         guint               realmd_watch;
@@ -252,19 +256,25 @@ local_create_user (CcAddUserDialog *self)
                                             self);
 }
 
-static gint
-update_password_strength (CcAddUserDialog *self)
+static void
+password_strength_cb (GObject      *source_object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
 {
+        g_autoptr(CcAddUserDialog) self = CC_ADD_USER_DIALOG (user_data);
+        g_autoptr(GError) error = NULL;
         const gchar *password;
-        const gchar *username;
         const gchar *hint;
         const gchar *verify;
         gint strength_level;
 
-        password = gtk_editable_get_text (GTK_EDITABLE (self->local_password_entry));
-        username = gtk_combo_box_text_get_active_text (self->local_username_combo);
+        pw_strength_finish (result, &hint, &strength_level, &error);
+        if (error != NULL)
+                return;
 
-        pw_strength (password, NULL, username, &hint, &strength_level);
+        self->local_strength_level = strength_level;
+
+        password = gtk_editable_get_text (GTK_EDITABLE (self->local_password_entry));
 
         gtk_level_bar_set_value (self->local_strength_indicator, strength_level);
         gtk_label_set_label (self->local_password_hint, hint);
@@ -282,7 +292,28 @@ update_password_strength (CcAddUserDialog *self)
                 gtk_widget_set_sensitive (GTK_WIDGET (self->local_verify_entry), strength_level > 1);
         }
 
-        return strength_level;
+        dialog_validate (self);
+}
+
+/* Evaluates the password in the background, superseding any evaluation
+ * still in progress. The dialog is validated again once it is done. */
+static void
+update_password_strength (CcAddUserDialog *self)
+{
+        g_autofree gchar *username = NULL;
+        const gchar *password;
+
+        g_cancellable_cancel (self->local_strength_cancellable);
+        g_clear_object (&self->local_strength_cancellable);
+        self->local_strength_cancellable = g_cancellable_new ();
+
+        password = gtk_editable_get_text (GTK_EDITABLE (self->local_password_entry));
+        username = gtk_combo_box_text_get_active_text (self->local_username_combo);
+
+        pw_strength_async (password, NULL, username,
+                           self->local_strength_cancellable,
+                           password_strength_cb,
+                           g_object_ref (self));
 }
 
 static gboolean
@@ -293,7 +324,6 @@ local_validate (CcAddUserDialog *self)
         const gchar *name;
         const gchar *password;
         const gchar *verify;
-        gint strength;
 
         if (self->local_valid_username) {
                 gtk_image_set_from_icon_name (self->local_username_status_icon, "emblem-ok-symbolic");
@@ -308,8 +338,7 @@ local_validate (CcAddUserDialog *self)
         password = gtk_editable_get_text (GTK_EDITABLE (self->local_password_entry));
         verify = gtk_editable_get_text (GTK_EDITABLE (self->local_verify_entry));
         if (self->local_password_mode == ACT_USER_PASSWORD_MODE_REGULAR) {
-                strength = update_password_strength (self);
-                valid_password = strength > 1 && strcmp (password, verify) == 0;
+                valid_password = self->local_strength_level > 1 && strcmp (password, verify) == 0;
         } else {
                 valid_password = TRUE;
         }
@@ -329,8 +358,10 @@ static void local_username_is_valid_cb (GObject *source_object,
         gboolean valid;
 
         valid = is_valid_username_finish (result, &tip, &username, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                return;
         if (error != NULL) {
-                g_warning ("Could not check username by usermod: %s", error->message);
+                g_warning ("Could not check username: %s", error->message);
                 valid = TRUE;
         }
 
@@ -349,8 +380,17 @@ local_username_timeout (CcAddUserDialog *self)
 
         self->local_username_timeout_id = 0;
 
+        /* The user name is part of the password checks */
+        update_password_strength (self);
+
+        /* Only the result for the latest name matters */
+        g_cancellable_cancel (self->local_username_cancellable);
+        g_clear_object (&self->local_username_cancellable);
+        self->local_username_cancellable = g_cancellable_new ();
+
         name = gtk_combo_box_text_get_active_text (self->local_username_combo);
-        is_valid_username_async (name, NULL, local_username_is_valid_cb, g_object_ref (self));
+        is_valid_username_async (name, self->local_username_cancellable,
+                                 local_username_is_valid_cb, g_object_ref (self));
 
         return FALSE;
 }
@@ -416,10 +456,20 @@ local_name_entry_focus_out_event_cb (CcAddUserDialog *self)
 }
 
 static void
-generate_username_choices (const gchar  *name,
-                           GtkListStore *store)
+add_username_choice (GPtrArray   *items,
+                     const gchar *username)
+{
+        if (!g_ptr_array_find_with_equal_func (items, username, g_str_equal, NULL))
+                g_ptr_array_add (items, g_strdup (username));
+}
+
+/* Returns the usernames to suggest for @name, most likely first, without
+ * checking whether they are taken.
+ */
+static GStrv
+generate_username_choices (const gchar *name)
 {
-        gboolean in_use, same_as_initial;
+        gboolean same_as_initial;
         g_autofree gchar *lc_name = NULL;
         g_autofree gchar *ascii_name = NULL;
         g_autofree gchar *stripped_name = NULL;
@@ -436,12 +486,9 @@ generate_username_choices (const gchar  *name,
         g_autoptr(GString) item4 = NULL;
         int len;
         int nwords1, nwords2, i;
-        g_autoptr(GHashTable) items = NULL;
-        GtkTreeIter iter;
+        g_autoptr(GPtrArray) items = NULL;
         gsize max_name_length;
 
-        gtk_list_store_clear (store);
-
         ascii_name = g_convert_with_fallback (name, -1, "ASCII//TRANSLIT", "UTF-8",
                                               unicode_fallback, NULL, NULL, NULL);
         /* Re-try without TRANSLIT. musl does not implement it */
@@ -449,7 +496,7 @@ generate_username_choices (const gchar  *name,
                 ascii_name = g_convert_with_fallback (name, -1, "ASCII", "UTF-8",
                                                       unicode_fallback, NULL, NULL, NULL);
         if (ascii_name == NULL)
-                return;
+                return NULL;
 
         lc_name = g_ascii_strdown (ascii_name, -1);
 
@@ -474,7 +521,7 @@ generate_username_choices (const gchar  *name,
         }
 
         if (strlen (stripped_name) == 0) {
-                return;
+                return NULL;
         }
 
         /* we split name on spaces, and then on dashes, so that we can treat
@@ -574,68 +621,65 @@ generate_username_choices (const gchar  *name,
         g_string_truncate (item3, max_name_length);
         g_string_truncate (item4, max_name_length);
 
-        items = g_hash_table_new (g_str_hash, g_str_equal);
+        items = g_ptr_array_new_with_free_func (g_free);
 
-        in_use = is_username_used (item0->str);
-        if (!in_use && !g_ascii_isdigit (item0->str[0])) {
-                gtk_list_store_append (store, &iter);
-                gtk_list_store_set (store, &iter, 0, item0->str, -1);
-                g_hash_table_insert (items, item0->str, item0->str);
-        }
+        if (!g_ascii_isdigit (item0->str[0]))
+                add_username_choice (items, item0->str);
 
-        in_use = is_username_used (item1->str);
         same_as_initial = (g_strcmp0 (item0->str, item1->str) == 0);
-        if (!same_as_initial && nwords2 > 0 && !in_use && !g_ascii_isdigit (item1->str[0])) {
-                gtk_list_store_append (store, &iter);
-                gtk_list_store_set (store, &iter, 0, item1->str, -1);
-                g_hash_table_insert (items, item1->str, item1->str);
-        }
+        if (!same_as_initial && nwords2 > 0 && !g_ascii_isdigit (item1->str[0]))
+                add_username_choice (items, item1->str);
 
         /* if there's only one word, would be the same as item1 */
         if (nwords2 > 1) {
                 /* add other items */
-                in_use = is_username_used (item2->str);
-                if (!in_use && !g_ascii_isdigit (item2->str[0]) &&
-                    !g_hash_table_lookup (items, item2->str)) {
-                        gtk_list_store_append (store, &iter);
-                        gtk_list_store_set (store, &iter, 0, item2->str, -1);
-                        g_hash_table_insert (items, item2->str, item2->str);
-                }
-
-                in_use = is_username_used (item3->str);
-                if (!in_use && !g_ascii_isdigit (item3->str[0]) &&
-                    !g_hash_table_lookup (items, item3->str)) {
-                        gtk_list_store_append (store, &iter);
-                        gtk_list_store_set (store, &iter, 0, item3->str, -1);
-                        g_hash_table_insert (items, item3->str, item3->str);
-                }
-
-                in_use = is_username_used (item4->str);
-                if (!in_use && !g_ascii_isdigit (item4->str[0]) &&
-                    !g_hash_table_lookup (items, item4->str)) {
-                        gtk_list_store_append (store, &iter);
-                        gtk_list_store_set (store, &iter, 0, item4->str, -1);
-                        g_hash_table_insert (items, item4->str, item4->str);
-                }
+                if (!g_ascii_isdigit (item2->str[0]))
+                        add_username_choice (items, item2->str);
+                if (!g_ascii_isdigit (item3->str[0]))
+                        add_username_choice (items, item3->str);
+                if (!g_ascii_isdigit (item4->str[0]))
+                        add_username_choice (items, item4->str);
 
                 /* add the last word */
-                in_use = is_username_used (last_word->str);
-                if (!in_use && !g_ascii_isdigit (last_word->str[0]) &&
-                    !g_hash_table_lookup (items, last_word->str)) {
-                        gtk_list_store_append (store, &iter);
-                        gtk_list_store_set (store, &iter, 0, last_word->str, -1);
-                        g_hash_table_insert (items, last_word->str, last_word->str);
-                }
+                if (!g_ascii_isdigit (last_word->str[0]))
+                        add_username_choice (items, last_word->str);
 
                 /* ...and the first one */
-                in_use = is_username_used (first_word->str);
-                if (!in_use && !g_ascii_isdigit (first_word->str[0]) &&
-                    !g_hash_table_lookup (items, first_word->str)) {
-                        gtk_list_store_append (store, &iter);
-                        gtk_list_store_set (store, &iter, 0, first_word->str, -1);
-                        g_hash_table_insert (items, first_word->str, first_word->str);
-                }
+                if (!g_ascii_isdigit (first_word->str[0]))
+                        add_username_choice (items, first_word->str);
+        }
+
+        g_ptr_array_add (items, NULL);
+
+        return (GStrv) g_ptr_array_free (g_steal_pointer (&items), FALSE);
+}
+
+static void
+username_choices_cb (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+        g_autoptr(CcAddUserDialog) self = CC_ADD_USER_DIALOG (user_data);
+        g_autoptr(GError) error = NULL;
+        g_auto(GStrv) choices = NULL;
+        GtkTreeIter iter;
+        guint i;
+
+        choices = filter_used_usernames_finish (result, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                return;
+        if (error != NULL) {
+                g_warning ("Could not check usernames: %s", error->message);
+                return;
         }
+
+        for (i = 0; choices[i] != NULL; i++) {
+                gtk_list_store_append (self->local_username_model, &iter);
+                gtk_list_store_set (self->local_username_model, &iter, 0, choices[i], -1);
+        }
+
+        if (!self->has_custom_username)
+                gtk_combo_box_set_active (GTK_COMBO_BOX (self->local_username_combo), 0);
 }
 
 static void
@@ -645,13 +689,22 @@ local_name_entry_changed_cb (CcAddUserDialog *self)
 
         gtk_list_store_clear (self->local_username_model);
 
+        /* Only the choices for the latest name matter */
+        g_cancellable_cancel (self->local_choices_cancellable);
+        g_clear_object (&self->local_choices_cancellable);
+
         name = gtk_editable_get_text (GTK_EDITABLE (self->local_name_entry));
         if ((name == NULL || strlen (name) == 0) && !self->has_custom_username) {
                 gtk_editable_set_text (GTK_EDITABLE (self->local_username_entry), "");
         } else if (name != NULL && strlen (name) != 0) {
-                generate_username_choices (name, self->local_username_model);
-                if (!self->has_custom_username)
-                        gtk_combo_box_set_active (GTK_COMBO_BOX (self->local_username_combo), 0);
+                g_auto(GStrv) choices = generate_username_choices (name);
+
+                if (choices != NULL) {
+                        self->local_choices_cancellable = g_cancellable_new ();
+                        filter_used_usernames_async ((const gchar * const *) choices,
+                                                     self->local_choices_cancellable,
+                                                     username_choices_cb, g_object_ref (self));
+                }
         }
 
         if (self->local_name_timeout_id != 0) {
@@ -703,6 +756,7 @@ local_password_timeout (CcAddUserDialog *self)
 {
         self->local_password_timeout_id = 0;
 
+        update_password_strength (self);
         dialog_validate (self);
         update_password_match (self);
 
@@ -753,6 +807,10 @@ local_password_entry_changed_cb (CcAddUserDialog *self)
 {
         gtk_image_set_from_icon_name (self->local_password_status_icon, "dialog-warning-symbolic");
         gtk_image_set_from_icon_name (self->local_verify_status_icon, "dialog-warning-symbolic");
+
+        /* Not known until the new password has been evaluated */
+        self->local_strength_level = 0;
+
         recheck_password_match (self);
 }
 
@@ -1509,7 +1567,6 @@ cc_add_user_dialog_init (CcAddUserDialog *self)
 
         self->local_password_mode = ACT_USER_PASSWORD_MODE_SET_AT_LOGIN;
         dialog_validate (self);
-        update_password_strength (self);
         local_username_timeout (self);
 
         enterprise_check_domain (self);
@@ -1605,6 +1662,15 @@ cc_add_user_dialog_dispose (GObject *obj)
                 self->local_username_timeout_id = 0;
         }
 
+        g_cancellable_cancel (self->local_choices_cancellable);
+        g_clear_object (&self->local_choices_cancellable);
+
+        g_cancellable_cancel (self->local_username_cancellable);
+        g_clear_object (&self->local_username_cancellable);
+
+        g_cancellable_cancel (self->local_strength_cancellable);
+        g_clear_object (&self->local_strength_cancellable);
+
         if (self->enterprise_domain_timeout_id != 0) {
                 g_source_remove (self->enterprise_domain_timeout_id);
                 self->enterprise_domain_timeout_id = 0;
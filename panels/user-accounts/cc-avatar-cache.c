@@ -0,0 +1,363 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "cc-avatar-cache.h"
+
+/* Decodes avatar images in worker threads and keeps the results, keyed on
+ * the file and the size it is displayed at. Entries remember the
+ * modification time and size of the file they were decoded from, so a
+ * reload of an unchanged file only costs a stat. Concurrent loads of the
+ * same image share a single decode, and the least recently used entries
+ * are dropped once the cache is full.
+ */
+
+#define MAX_ENTRIES 256
+
+typedef struct {
+        gchar      *key;
+        guint64     mtime;
+        goffset     file_size;
+        GdkTexture *texture;
+        GList      *lru_link;
+} CacheEntry;
+
+typedef struct {
+        gchar      *filename;
+        gint        size;
+        guint64     mtime;
+        goffset     file_size;
+        GdkTexture *texture;
+        GdkPixbuf  *pixbuf;
+} DecodeData;
+
+struct _CcAvatarCache {
+        GObject     parent_instance;
+
+        /* key → CacheEntry */
+        GHashTable *entries;
+        /* Most recently used first, the links are owned by the entries */
+        GQueue      lru;
+        /* key → GPtrArray of GTasks waiting for a decode in progress */
+        GHashTable *pending;
+};
+
+G_DEFINE_TYPE (CcAvatarCache, cc_avatar_cache, G_TYPE_OBJECT)
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+        g_free (entry->key);
+        g_clear_object (&entry->texture);
+        g_list_free_1 (entry->lru_link);
+        g_free (entry);
+}
+
+static void
+decode_data_free (DecodeData *data)
+{
+        g_free (data->filename);
+        g_clear_object (&data->texture);
+        g_clear_object (&data->pixbuf);
+        g_free (data);
+}
+
+static gchar *
+get_key (const gchar *filename,
+         gint         size)
+{
+        return g_strdup_printf ("%d:%s", size, filename);
+}
+
+static void
+touch_entry (CcAvatarCache *self,
+             CacheEntry    *entry)
+{
+        g_queue_unlink (&self->lru, entry->lru_link);
+        g_queue_push_head_link (&self->lru, entry->lru_link);
+}
+
+static void
+remove_entry (CcAvatarCache *self,
+              CacheEntry    *entry)
+{
+        g_queue_unlink (&self->lru, entry->lru_link);
+        g_hash_table_remove (self->entries, entry->key);
+}
+
+static CacheEntry *
+store_entry (CcAvatarCache *self,
+             const gchar   *key,
+             DecodeData    *data)
+{
+        CacheEntry *entry;
+
+        entry = g_hash_table_lookup (self->entries, key);
+        if (entry == NULL) {
+                entry = g_new0 (CacheEntry, 1);
+                entry->key = g_strdup (key);
+                entry->lru_link = g_list_alloc ();
+                entry->lru_link->data = entry;
+                g_queue_push_head_link (&self->lru, entry->lru_link);
+                g_hash_table_insert (self->entries, entry->key, entry);
+        } else {
+                touch_entry (self, entry);
+        }
+
+        entry->mtime = data->mtime;
+        entry->file_size = data->file_size;
+
+        g_clear_object (&entry->texture);
+        if (data->pixbuf != NULL)
+                entry->texture = gdk_texture_new_for_pixbuf (data->pixbuf);
+        else
+                entry->texture = g_object_ref (data->texture);
+
+        while (self->lru.length > MAX_ENTRIES)
+                remove_entry (self, g_queue_peek_tail (&self->lru));
+
+        return entry;
+}
+
+static void
+decode_thread (GTask        *task,
+               gpointer      source_object,
+               gpointer      task_data,
+               GCancellable *cancellable)
+{
+        DecodeData *data = task_data;
+        g_autoptr(GFile) file = NULL;
+        g_autoptr(GFileInfo) info = NULL;
+        g_autoptr(GError) error = NULL;
+        guint64 mtime;
+
+        file = g_file_new_for_path (data->filename);
+        info = g_file_query_info (file,
+                                  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                                  G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                  G_FILE_QUERY_INFO_NONE,
+                                  NULL,
+                                  &error);
+        if (info == NULL) {
+                g_task_return_error (task, g_steal_pointer (&error));
+                return;
+        }
+
+        mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+                g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+        /* Keep the texture we already have */
+        if (data->texture != NULL &&
+            mtime == data->mtime &&
+            g_file_info_get_size (info) == data->file_size) {
+                g_task_return_boolean (task, TRUE);
+                return;
+        }
+
+        data->mtime = mtime;
+        data->file_size = g_file_info_get_size (info);
+        data->pixbuf = gdk_pixbuf_new_from_file_at_size (data->filename,
+                                                         data->size,
+                                                         data->size,
+                                                         &error);
+        if (data->pixbuf == NULL) {
+                g_task_return_error (task, g_steal_pointer (&error));
+                return;
+        }
+
+        g_task_return_boolean (task, TRUE);
+}
+
+static void
+decode_done_cb (GObject      *source,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+        CcAvatarCache *self = CC_AVATAR_CACHE (source);
+        g_autofree gchar *key = user_data;
+        g_autofree gchar *pending_key = NULL;
+        g_autoptr(GPtrArray) waiting = NULL;
+        g_autoptr(GError) error = NULL;
+        DecodeData *data;
+        CacheEntry *entry = NULL;
+        guint i;
+
+        g_hash_table_steal_extended (self->pending, key, (gpointer *) &pending_key, (gpointer *) &waiting);
+
+        data = g_task_get_task_data (G_TASK (result));
+        if (g_task_propagate_boolean (G_TASK (result), &error)) {
+                entry = store_entry (self, key, data);
+        } else {
+                entry = g_hash_table_lookup (self->entries, key);
+                if (entry != NULL)
+                        remove_entry (self, entry);
+                entry = NULL;
+        }
+
+        for (i = 0; waiting != NULL && i < waiting->len; i++) {
+                GTask *task = g_ptr_array_index (waiting, i);
+
+                if (entry != NULL)
+                        g_task_return_pointer (task, g_object_ref (entry->texture), g_object_unref);
+                else
+                        g_task_return_error (task, g_error_copy (error));
+        }
+}
+
+static void
+cc_avatar_cache_finalize (GObject *object)
+{
+        CcAvatarCache *self = CC_AVATAR_CACHE (object);
+
+        /* The links are freed along with the entries */
+        g_queue_init (&self->lru);
+        g_clear_pointer (&self->entries, g_hash_table_unref);
+        g_clear_pointer (&self->pending, g_hash_table_unref);
+
+        G_OBJECT_CLASS (cc_avatar_cache_parent_class)->finalize (object);
+}
+
+static void
+cc_avatar_cache_class_init (CcAvatarCacheClass *klass)
+{
+        GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+        object_class->finalize = cc_avatar_cache_finalize;
+}
+
+static void
+cc_avatar_cache_init (CcAvatarCache *self)
+{
+        self->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) cache_entry_free);
+        self->pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+        g_queue_init (&self->lru);
+}
+
+CcAvatarCache *
+cc_avatar_cache_get_default (void)
+{
+        static CcAvatarCache *cache = NULL;
+
+        if (cache == NULL)
+                cache = g_object_new (CC_TYPE_AVATAR_CACHE, NULL);
+
+        return cache;
+}
+
+/**
+ * cc_avatar_cache_lookup:
+ * @cache: a #CcAvatarCache
+ * @filename: the image file
+ * @size: the size the image is displayed at
+ *
+ * Returns: (transfer none) (nullable): the last texture decoded from
+ * @filename at @size, without checking whether the file changed since.
+ */
+GdkTexture *
+cc_avatar_cache_lookup (CcAvatarCache *self,
+                        const gchar   *filename,
+                        gint           size)
+{
+        g_autofree gchar *key = NULL;
+        CacheEntry *entry;
+
+        g_return_val_if_fail (CC_IS_AVATAR_CACHE (self), NULL);
+        g_return_val_if_fail (filename != NULL, NULL);
+
+        key = get_key (filename, size);
+        entry = g_hash_table_lookup (self->entries, key);
+        if (entry == NULL)
+                return NULL;
+
+        touch_entry (self, entry);
+
+        return entry->texture;
+}
+
+void
+cc_avatar_cache_load_async (CcAvatarCache       *self,
+                            const gchar         *filename,
+                            gint                 size,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+        g_autoptr(GTask) task = NULL;
+        g_autoptr(GTask) decode_task = NULL;
+        g_autofree gchar *key = NULL;
+        GPtrArray *waiting;
+        DecodeData *data;
+        CacheEntry *entry;
+
+        g_return_if_fail (CC_IS_AVATAR_CACHE (self));
+        g_return_if_fail (filename != NULL);
+
+        task = g_task_new (self, cancellable, callback, user_data);
+        g_task_set_source_tag (task, cc_avatar_cache_load_async);
+
+        key = get_key (filename, size);
+
+        waiting = g_hash_table_lookup (self->pending, key);
+        if (waiting != NULL) {
+                g_ptr_array_add (waiting, g_steal_pointer (&task));
+                return;
+        }
+
+        waiting = g_ptr_array_new_with_free_func (g_object_unref);
+        g_ptr_array_add (waiting, g_steal_pointer (&task));
+        g_hash_table_insert (self->pending, g_strdup (key), waiting);
+
+        data = g_new0 (DecodeData, 1);
+        data->filename = g_strdup (filename);
+        data->size = size;
+
+        entry = g_hash_table_lookup (self->entries, key);
+        if (entry != NULL) {
+                data->texture = g_object_ref (entry->texture);
+                data->mtime = entry->mtime;
+                data->file_size = entry->file_size;
+        }
+
+        /* The decode is shared between all the callers, it is not
+         * tied to any of their cancellables */
+        decode_task = g_task_new (self, NULL, decode_done_cb, g_steal_pointer (&key));
+        g_task_set_source_tag (decode_task, decode_thread);
+        g_task_set_task_data (decode_task, data, (GDestroyNotify) decode_data_free);
+        g_task_run_in_thread (decode_task, decode_thread);
+}
+
+/**
+ * cc_avatar_cache_load_finish:
+ * @cache: a #CcAvatarCache
+ * @result: the #GAsyncResult
+ * @error: return location for a #GError
+ *
+ * Returns: (transfer full): the texture for the image
+ */
+GdkTexture *
+cc_avatar_cache_load_finish (CcAvatarCache  *self,
+                             GAsyncResult   *result,
+                             GError        **error)
+{
+        g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+
+        return g_task_propagate_pointer (G_TASK (result), error);
+}
@@ -0,0 +1,42 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_AVATAR_CACHE (cc_avatar_cache_get_type())
+
+G_DECLARE_FINAL_TYPE (CcAvatarCache, cc_avatar_cache, CC, AVATAR_CACHE, GObject)
+
+CcAvatarCache *cc_avatar_cache_get_default (void);
+
+GdkTexture    *cc_avatar_cache_lookup      (CcAvatarCache        *cache,
+                                            const gchar          *filename,
+                                            gint                  size);
+void           cc_avatar_cache_load_async  (CcAvatarCache        *cache,
+                                            const gchar          *filename,
+                                            gint                  size,
+                                            GCancellable         *cancellable,
+                                            GAsyncReadyCallback   callback,
+                                            gpointer              user_data);
+GdkTexture    *cc_avatar_cache_load_finish (CcAvatarCache        *cache,
+                                            GAsyncResult         *result,
+                                            GError              **error);
+
+G_END_DECLS
@@ -32,6 +32,7 @@
 #define GNOME_DESKTOP_USE_UNSTABLE_API
 #include <libgnome-desktop/gnome-desktop-thumbnail.h>
 
+#include "cc-avatar-cache.h"
 #include "cc-avatar-chooser.h"
 #include "cc-crop-area.h"
 #include "user-utils.h"
@@ -39,6 +40,7 @@
 #define ROW_SPAN 5
 #define AVATAR_CHOOSER_PIXEL_SIZE 80
 #define PIXEL_SIZE 512
+#define FACES_BATCH_SIZE 32
 
 struct _CcAvatarChooser {
         GtkPopover parent;
@@ -48,10 +50,20 @@ struct _CcAvatarChooser {
         GtkWidget *crop_area;
         GtkWidget *user_flowbox;
         GtkWidget *flowbox;
+        GtkWidget *faces_scrolled_window;
 
         GnomeDesktopThumbnailFactory *thumb_factory;
         GListStore *faces;
 
+        /* Faces directories being enumerated */
+        GCancellable *cancellable;
+        GStrv facesdirs;
+        guint facesdir_index;
+        gboolean using_system_facesdirs;
+        gboolean added_faces;
+
+        guint load_visible_id;
+
         ActUser *user;
 };
 
@@ -201,33 +213,137 @@ face_widget_activated (CcAvatarChooser *self,
         gtk_popover_popdown (GTK_POPOVER (self));
 }
 
-static GtkWidget *
-create_face_widget (gpointer item,
-                    gpointer user_data)
+static void
+face_loaded_cb (GObject      *source,
+                GAsyncResult *result,
+                gpointer      user_data)
 {
-        g_autofree gchar *image_path = NULL;
-        g_autoptr(GdkPixbuf) source_pixbuf = NULL;
-        g_autoptr(GdkPixbuf) pixbuf = NULL;
-        GtkWidget *image;
+        g_autoptr(GtkWidget) avatar = user_data;
+        g_autoptr(GdkTexture) texture = NULL;
+        g_autoptr(GError) error = NULL;
+
+        texture = cc_avatar_cache_load_finish (CC_AVATAR_CACHE (source), result, &error);
+        if (texture == NULL) {
+                if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        return;
+
+                /* Not an image we can show */
+                g_debug ("Failed to load %s: %s",
+                         (const gchar *) g_object_get_data (G_OBJECT (avatar), "filename"),
+                         error->message);
+                if (gtk_widget_get_parent (avatar) != NULL)
+                        gtk_widget_hide (gtk_widget_get_parent (avatar));
+                return;
+        }
+
+        adw_avatar_set_custom_image (ADW_AVATAR (avatar), GDK_PAINTABLE (texture));
+}
 
-        image_path = g_file_get_path (G_FILE (item));
+static void
+load_face (CcAvatarChooser *self,
+           GtkWidget       *avatar)
+{
+        CcAvatarCache *cache;
+        const gchar *filename;
+        GdkTexture *texture;
 
-        source_pixbuf = gdk_pixbuf_new_from_file_at_size (image_path,
-                                                          AVATAR_CHOOSER_PIXEL_SIZE,
-                                                          AVATAR_CHOOSER_PIXEL_SIZE,
-                                                          NULL);
-        if (source_pixbuf == NULL)
-                return NULL;
+        if (g_object_get_data (G_OBJECT (avatar), "loaded") != NULL)
+                return;
+        g_object_set_data (G_OBJECT (avatar), "loaded", GINT_TO_POINTER (TRUE));
 
-        pixbuf = round_image (source_pixbuf);
-        image = gtk_image_new_from_pixbuf (pixbuf);
-        gtk_image_set_pixel_size (GTK_IMAGE (image), AVATAR_CHOOSER_PIXEL_SIZE);
-        gtk_widget_show (image);
+        filename = g_object_get_data (G_OBJECT (avatar), "filename");
+        cache = cc_avatar_cache_get_default ();
 
-        g_object_set_data_full (G_OBJECT (image),
-                                "filename", g_steal_pointer (&image_path), g_free);
+        /* Stock faces hardly ever change, so don't touch the disk again
+         * for the ones decoded already */
+        texture = cc_avatar_cache_lookup (cache, filename, AVATAR_CHOOSER_PIXEL_SIZE);
+        if (texture != NULL) {
+                adw_avatar_set_custom_image (ADW_AVATAR (avatar), GDK_PAINTABLE (texture));
+                return;
+        }
 
-        return image;
+        cc_avatar_cache_load_async (cache,
+                                    filename,
+                                    AVATAR_CHOOSER_PIXEL_SIZE,
+                                    self->cancellable,
+                                    face_loaded_cb,
+                                    g_object_ref (avatar));
+}
+
+static gboolean
+load_visible_faces (GtkWidget     *widget,
+                    GdkFrameClock *frame_clock,
+                    gpointer       user_data)
+{
+        CcAvatarChooser *self = CC_AVATAR_CHOOSER (user_data);
+        GtkAdjustment *adjustment;
+        GtkWidget *child;
+        gdouble top, bottom;
+        gboolean unallocated = FALSE;
+
+        if (!gtk_widget_get_mapped (self->flowbox)) {
+                self->load_visible_id = 0;
+                return G_SOURCE_REMOVE;
+        }
+
+        /* Decode the faces in view, and a row beyond it either way */
+        adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (self->faces_scrolled_window));
+        top = gtk_adjustment_get_value (adjustment) - AVATAR_CHOOSER_PIXEL_SIZE;
+        bottom = gtk_adjustment_get_value (adjustment) + gtk_adjustment_get_page_size (adjustment) + AVATAR_CHOOSER_PIXEL_SIZE;
+
+        for (child = gtk_widget_get_first_child (self->flowbox);
+             child != NULL;
+             child = gtk_widget_get_next_sibling (child)) {
+                graphene_rect_t bounds;
+
+                if (!GTK_IS_FLOW_BOX_CHILD (child) || !gtk_widget_get_visible (child))
+                        continue;
+
+                /* Children added since the last layout have no position yet */
+                if (!gtk_widget_compute_bounds (child, self->flowbox, &bounds) ||
+                    bounds.size.height <= 0) {
+                        unallocated = TRUE;
+                        continue;
+                }
+
+                if (bounds.origin.y + bounds.size.height < top || bounds.origin.y > bottom)
+                        continue;
+
+                load_face (self, gtk_flow_box_child_get_child (GTK_FLOW_BOX_CHILD (child)));
+        }
+
+        /* Tick callbacks run before the layout of their frame, so look at
+         * those again in the next one */
+        if (unallocated)
+                return G_SOURCE_CONTINUE;
+
+        self->load_visible_id = 0;
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+queue_load_visible_faces (CcAvatarChooser *self)
+{
+        if (self->load_visible_id == 0)
+                self->load_visible_id = gtk_widget_add_tick_callback (self->flowbox,
+                                                                      load_visible_faces,
+                                                                      self,
+                                                                      NULL);
+}
+
+static GtkWidget *
+create_face_widget (gpointer item,
+                    gpointer user_data)
+{
+        GtkWidget *avatar;
+
+        /* The image is decoded once the face scrolls into view */
+        avatar = adw_avatar_new (AVATAR_CHOOSER_PIXEL_SIZE, NULL, FALSE);
+        g_object_set_data_full (G_OBJECT (avatar),
+                                "filename", g_file_get_path (G_FILE (item)), g_free);
+
+        return avatar;
 }
 
 static GStrv
@@ -268,68 +384,143 @@ get_system_facesdirs (void)
         return (GStrv) g_ptr_array_steal (facesdirs, NULL);
 }
 
-static gboolean
-add_faces_from_dirs (GListStore *faces, GStrv facesdirs, gboolean add_all)
+static void enumerate_next_facesdir (CcAvatarChooser *self);
+
+static void
+faces_enumerated_cb (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      user_data)
 {
-        GFile *file;
-        GFileType type;
-        const gchar *target;
-        guint i;
-        gboolean added_faces = FALSE;
-
-        for (i = 0; facesdirs[i] != NULL; i++) {
-                g_autoptr(GFile) dir = NULL;
-                g_autoptr(GFileEnumerator) enumerator = NULL;
-
-                dir = g_file_new_for_path (facesdirs[i]);
-
-                enumerator = g_file_enumerate_children (dir,
-                                                        G_FILE_ATTRIBUTE_STANDARD_NAME ","
-                                                        G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                                        G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK ","
-                                                        G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET,
-                                                        G_FILE_QUERY_INFO_NONE,
-                                                        NULL, NULL);
-                if (enumerator == NULL) {
+        GFileEnumerator *enumerator = G_FILE_ENUMERATOR (source);
+        CcAvatarChooser *self;
+        g_autolist(GFileInfo) infos = NULL;
+        g_autoptr(GPtrArray) files = NULL;
+        g_autoptr(GError) error = NULL;
+        GFile *dir;
+        GList *l;
+
+        infos = g_file_enumerator_next_files_finish (enumerator, result, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                return;
+
+        self = CC_AVATAR_CHOOSER (user_data);
+
+        if (infos == NULL) {
+                g_file_enumerator_close_async (enumerator, G_PRIORITY_LOW, NULL, NULL, NULL);
+
+                /* Only the first system directory with faces is used */
+                if (self->added_faces && self->using_system_facesdirs)
+                        return;
+
+                self->facesdir_index++;
+                enumerate_next_facesdir (self);
+                return;
+        }
+
+        dir = g_file_enumerator_get_container (enumerator);
+        files = g_ptr_array_new_with_free_func (g_object_unref);
+
+        for (l = infos; l != NULL; l = l->next) {
+                GFileInfo *info = l->data;
+                GFileType type;
+                const gchar *target;
+
+                type = g_file_info_get_file_type (info);
+                if (type != G_FILE_TYPE_REGULAR &&
+                    type != G_FILE_TYPE_SYMBOLIC_LINK) {
+                        continue;
+                }
+
+                target = g_file_info_get_symlink_target (info);
+                if (target != NULL && g_str_has_prefix (target , "legacy/")) {
                         continue;
                 }
 
-                while (TRUE) {
-                        g_autoptr(GFileInfo) info = g_file_enumerator_next_file (enumerator, NULL, NULL);
-                        if (info == NULL) {
-                                break;
-                        }
+                g_ptr_array_add (files, g_file_get_child (dir, g_file_info_get_name (info)));
+        }
 
-                        type = g_file_info_get_file_type (info);
-                        if (type != G_FILE_TYPE_REGULAR &&
-                            type != G_FILE_TYPE_SYMBOLIC_LINK) {
-                                continue;
-                        }
+        if (files->len > 0) {
+                g_list_store_splice (self->faces,
+                                     g_list_model_get_n_items (G_LIST_MODEL (self->faces)),
+                                     0,
+                                     files->pdata,
+                                     files->len);
+                self->added_faces = TRUE;
+        }
 
-                        target = g_file_info_get_symlink_target (info);
-                        if (target != NULL && g_str_has_prefix (target , "legacy/")) {
-                                continue;
-                        }
+        g_file_enumerator_next_files_async (enumerator,
+                                            FACES_BATCH_SIZE,
+                                            G_PRIORITY_LOW,
+                                            self->cancellable,
+                                            faces_enumerated_cb,
+                                            self);
+}
 
-                        file = g_file_get_child (dir, g_file_info_get_name (info));
-                        g_list_store_append (faces, file);
+static void
+facesdir_opened_cb (GObject      *source,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+        CcAvatarChooser *self;
+        g_autoptr(GFileEnumerator) enumerator = NULL;
+        g_autoptr(GError) error = NULL;
 
-                        added_faces = TRUE;
-                }
+        enumerator = g_file_enumerate_children_finish (G_FILE (source), result, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                return;
 
-                g_file_enumerator_close (enumerator, NULL, NULL);
+        self = CC_AVATAR_CHOOSER (user_data);
 
-                if (added_faces && !add_all)
-                        break;
+        if (enumerator == NULL) {
+                self->facesdir_index++;
+                enumerate_next_facesdir (self);
+                return;
         }
-        return added_faces;
+
+        g_file_enumerator_next_files_async (enumerator,
+                                            FACES_BATCH_SIZE,
+                                            G_PRIORITY_LOW,
+                                            self->cancellable,
+                                            faces_enumerated_cb,
+                                            self);
 }
 
+static void
+enumerate_next_facesdir (CcAvatarChooser *self)
+{
+        g_autoptr(GFile) dir = NULL;
+
+        if (self->facesdirs[self->facesdir_index] == NULL) {
+                if (self->added_faces || self->using_system_facesdirs)
+                        return;
+
+                /* None of the configured directories has faces */
+                g_strfreev (self->facesdirs);
+                self->facesdirs = get_system_facesdirs ();
+                self->facesdir_index = 0;
+                self->using_system_facesdirs = TRUE;
+
+                enumerate_next_facesdir (self);
+                return;
+        }
+
+        dir = g_file_new_for_path (self->facesdirs[self->facesdir_index]);
+        g_file_enumerate_children_async (dir,
+                                         G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                         G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                         G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK ","
+                                         G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET,
+                                         G_FILE_QUERY_INFO_NONE,
+                                         G_PRIORITY_LOW,
+                                         self->cancellable,
+                                         facesdir_opened_cb,
+                                         self);
+}
 
 static void
 setup_photo_popup (CcAvatarChooser *self)
 {
-        g_auto(GStrv) settings_facesdirs = NULL;
+        GtkAdjustment *adjustment;
 
         self->faces = g_list_store_new (G_TYPE_FILE);
         gtk_flow_box_bind_model (GTK_FLOW_BOX (self->flowbox),
@@ -341,12 +532,22 @@ setup_photo_popup (CcAvatarChooser *self)
         g_signal_connect_object (self->flowbox, "child-activated",
                                  G_CALLBACK (face_widget_activated), self, G_CONNECT_SWAPPED);
 
-        settings_facesdirs = get_settings_facesdirs ();
-
-        if (!add_faces_from_dirs (self->faces, settings_facesdirs, TRUE)) {
-                g_auto(GStrv) system_facesdirs = get_system_facesdirs ();
-                add_faces_from_dirs (self->faces, system_facesdirs, FALSE);
-        }
+        /* Faces are decoded as they come into view */
+        adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (self->faces_scrolled_window));
+        g_signal_connect_object (adjustment, "value-changed",
+                                 G_CALLBACK (queue_load_visible_faces), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (adjustment, "changed",
+                                 G_CALLBACK (queue_load_visible_faces), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (self->faces, "items-changed",
+                                 G_CALLBACK (queue_load_visible_faces), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (self->flowbox, "map",
+                                 G_CALLBACK (queue_load_visible_faces), self, G_CONNECT_SWAPPED);
+
+        /* The directories may be slow network mounts, list them in
+         * batches without blocking */
+        self->cancellable = g_cancellable_new ();
+        self->facesdirs = get_settings_facesdirs ();
+        enumerate_next_facesdir (self);
 }
 
 CcAvatarChooser *
@@ -369,6 +570,14 @@ cc_avatar_chooser_dispose (GObject *object)
 {
         CcAvatarChooser *self = CC_AVATAR_CHOOSER (object);
 
+        g_cancellable_cancel (self->cancellable);
+        g_clear_object (&self->cancellable);
+        if (self->load_visible_id != 0) {
+                gtk_widget_remove_tick_callback (self->flowbox, self->load_visible_id);
+                self->load_visible_id = 0;
+        }
+        g_clear_pointer (&self->facesdirs, g_strfreev);
+        g_clear_object (&self->faces);
         g_clear_object (&self->thumb_factory);
         g_clear_object (&self->user);
 
@@ -391,6 +600,7 @@ cc_avatar_chooser_class_init (CcAvatarChooserClass *klass)
 
         gtk_widget_class_bind_template_child (wclass, CcAvatarChooser, user_flowbox);
         gtk_widget_class_bind_template_child (wclass, CcAvatarChooser, flowbox);
+        gtk_widget_class_bind_template_child (wclass, CcAvatarChooser, faces_scrolled_window);
 
         gtk_widget_class_bind_template_callback (wclass, cc_avatar_chooser_select_file);
 
@@ -50,6 +50,15 @@ struct _CcLoginHistoryDialog
         GDateTime    *current_week;
 
         ActUser      *user;
+
+        /* Session records sorted by login time, and the login time of the
+         * oldest record of any kind */
+        GArray       *login_history;
+        gint64        first_login_time;
+        gboolean      has_history;
+
+        /* Records of the week being shown */
+        GListStore   *records;
 };
 
 G_DEFINE_TYPE (CcLoginHistoryDialog, cc_login_history_dialog, GTK_TYPE_DIALOG)
@@ -60,6 +69,42 @@ typedef struct {
 	const gchar *type;
 } CcLoginHistory;
 
+#define CC_TYPE_LOGIN_HISTORY_RECORD (cc_login_history_record_get_type ())
+G_DECLARE_FINAL_TYPE (CcLoginHistoryRecord, cc_login_history_record, CC, LOGIN_HISTORY_RECORD, GObject)
+
+struct _CcLoginHistoryRecord
+{
+        GObject   parent_instance;
+
+        gint64    time;
+        gboolean  ended;
+};
+
+G_DEFINE_TYPE (CcLoginHistoryRecord, cc_login_history_record, G_TYPE_OBJECT)
+
+static void
+cc_login_history_record_class_init (CcLoginHistoryRecordClass *klass)
+{
+}
+
+static void
+cc_login_history_record_init (CcLoginHistoryRecord *self)
+{
+}
+
+static CcLoginHistoryRecord *
+cc_login_history_record_new (gint64   time,
+                             gboolean ended)
+{
+        CcLoginHistoryRecord *self;
+
+        self = g_object_new (CC_TYPE_LOGIN_HISTORY_RECORD, NULL);
+        self->time = time;
+        self->ended = ended;
+
+        return self;
+}
+
 static void
 show_week_label (CcLoginHistoryDialog *self)
 {
@@ -101,78 +146,109 @@ show_week_label (CcLoginHistoryDialog *self)
         gtk_label_set_label (self->title_label, label);
 }
 
-static void
-clear_history (CcLoginHistoryDialog *self)
+static gint
+compare_login_time (gconstpointer a,
+                    gconstpointer b)
 {
-        GtkWidget *child;
-
-        child = gtk_widget_get_first_child (GTK_WIDGET (self->history_box));
-        while (child) {
-                GtkWidget *next = gtk_widget_get_next_sibling (child);
-
-                if (ADW_ACTION_ROW (child))
-                    gtk_list_box_remove (self->history_box, GTK_WIDGET (child));
-
-                child = next;
-        }
+        const CcLoginHistory *history1 = a;
+        const CcLoginHistory *history2 = b;
+
+        if (history1->login_time < history2->login_time)
+                return -1;
+        if (history1->login_time > history2->login_time)
+                return 1;
+        return 0;
 }
 
-static GArray *
-get_login_history (ActUser *user)
+/* Decodes the history once, keeping only the x-session and tty records
+ * that are displayed. Session types are interned. */
+static void
+load_login_history (CcLoginHistoryDialog *self)
 {
-	GArray *login_history;
-	GVariantIter *iter, *iter2;
+	g_autoptr(GVariantIter) iter = NULL;
+	GVariantIter *iter2;
 	GVariant *variant;
 	const GVariant *value;
 	const gchar *key;
 	CcLoginHistory history;
 
-	login_history = NULL;
-	value = act_user_get_login_history (user);
+	g_array_set_size (self->login_history, 0);
+	self->has_history = FALSE;
+	self->first_login_time = G_MAXINT64;
+
+	value = act_user_get_login_history (self->user);
+	if (value == NULL)
+		return;
+
 	g_variant_get ((GVariant *) value, "a(xxa{sv})", &iter);
 	while (g_variant_iter_loop (iter, "(xxa{sv})", &history.login_time, &history.logout_time, &iter2)) {
+		history.type = NULL;
 		while (g_variant_iter_loop (iter2, "{&sv}", &key, &variant)) {
 			if (g_strcmp0 (key, "type") == 0) {
-				history.type = g_variant_get_string (variant, NULL);
+				history.type = g_intern_string (g_variant_get_string (variant, NULL));
 			}
 		}
 
-		if (login_history == NULL) {
-			login_history = g_array_new (FALSE, TRUE, sizeof (CcLoginHistory));
+		self->has_history = TRUE;
+		self->first_login_time = MIN (self->first_login_time, history.login_time);
+
+		/* Display only x-session and tty records */
+		if (history.type == NULL ||
+		    (!g_str_has_prefix (history.type, ":") &&
+		     !g_str_has_prefix (history.type, "tty"))) {
+			continue;
 		}
 
-		g_array_append_val (login_history, history);
+		g_array_append_val (self->login_history, history);
 	}
 
-	return login_history;
+	g_array_sort (self->login_history, compare_login_time);
+}
+
+/* Returns the number of records that started before @time */
+static guint
+count_logins_before (CcLoginHistoryDialog *self,
+                     gint64                time)
+{
+        guint low = 0, high = self->login_history->len;
+
+        while (low < high) {
+                guint middle = low + (high - low) / 2;
+
+                if (g_array_index (self->login_history, CcLoginHistory, middle).login_time < time)
+                        low = middle + 1;
+                else
+                        high = middle;
+        }
+
+        return low;
 }
 
 static void
 set_sensitivity (CcLoginHistoryDialog *self)
 {
-        g_autoptr(GArray) login_history = NULL;
-        CcLoginHistory history;
         gboolean sensitive = FALSE;
 
-        login_history = get_login_history (self->user);
-        if (login_history != NULL) {
-                history = g_array_index (login_history, CcLoginHistory, 0);
-                sensitive = g_date_time_to_unix (self->week) > history.login_time;
-        }
+        if (self->has_history)
+                sensitive = g_date_time_to_unix (self->week) > self->first_login_time;
         gtk_widget_set_sensitive (GTK_WIDGET (self->previous_button), sensitive);
 
         sensitive = (g_date_time_compare (self->current_week, self->week) == 1);
         gtk_widget_set_sensitive (GTK_WIDGET (self->next_button), sensitive);
 }
 
-static void
-add_record (CcLoginHistoryDialog *self, GDateTime *datetime, gchar *record_string, gint line)
+static GtkWidget *
+create_record_row (gpointer item,
+                   gpointer user_data)
 {
+        CcLoginHistoryRecord *record = item;
+        g_autoptr(GDateTime) datetime = NULL;
         g_autofree gchar *date = NULL;
         g_autofree gchar *time = NULL;
         g_autofree gchar *str = NULL;
         GtkWidget *row;
 
+        datetime = g_date_time_new_from_unix_local (record->time);
         date = cc_util_get_smart_date (datetime);
         /* Translators: This is a time format string in the style of "22:58".
            It indicates a login time which follows a date. */
@@ -182,69 +258,60 @@ add_record (CcLoginHistoryDialog *self, GDateTime *datetime, gchar *record_strin
         str = g_strdup_printf(C_("login date-time", "%s, %s"), date, time);
 
         row = adw_action_row_new ();
-        adw_preferences_row_set_title (ADW_PREFERENCES_ROW (row), record_string);
+        adw_preferences_row_set_title (ADW_PREFERENCES_ROW (row),
+                                       record->ended ? _("Session Ended") : _("Session Started"));
         adw_action_row_set_subtitle (ADW_ACTION_ROW (row), str);
 
-        gtk_list_box_insert (self->history_box, row, line);
+        return row;
 }
 
 static void
 show_week (CcLoginHistoryDialog *self)
 {
-        g_autoptr(GArray) login_history = NULL;
-        g_autoptr(GDateTime) datetime = NULL;
+        g_autoptr(GPtrArray) records = NULL;
         g_autoptr(GDateTime) temp = NULL;
         gint64 from, to;
-        gint i, line;
-        CcLoginHistory history;
+        guint i;
 
         show_week_label (self);
-        clear_history (self);
         set_sensitivity (self);
 
-        login_history = get_login_history (self->user);
-        if (login_history == NULL) {
-                return;
-        }
+        records = g_ptr_array_new_with_free_func (g_object_unref);
 
-        /* Find first record for week */
         from = g_date_time_to_unix (self->week);
         temp = g_date_time_add_weeks (self->week, 1);
         to = g_date_time_to_unix (temp);
-        for (i = login_history->len - 1; i >= 0; i--) {
-                history = g_array_index (login_history, CcLoginHistory, i);
-                if (history.login_time < to) {
-                        break;
-                }
-        }
 
-        /* Add new session records */
-        line = 0;
-        for (;i >= 0; i--) {
-                history = g_array_index (login_history, CcLoginHistory, i);
+        /* Add the session records, newest first, starting from the last
+         * session that started before the end of the week */
+        for (i = count_logins_before (self, to); i > 0; i--) {
+                CcLoginHistory *history = &g_array_index (self->login_history, CcLoginHistory, i - 1);
 
-                /* Display only x-session and tty records */
-                if (!g_str_has_prefix (history.type, ":") &&
-                    !g_str_has_prefix (history.type, "tty")) {
-                        continue;
-                }
-
-                if (history.logout_time > 0 && history.logout_time < from) {
+                if (history->logout_time > 0 && history->logout_time < from) {
                         break;
                 }
 
-                if (history.logout_time > 0 && history.logout_time < to) {
-                        datetime = g_date_time_new_from_unix_local (history.logout_time);
-                        add_record (self, datetime, _("Session Ended"), line);
-                        line++;
+                if (history->logout_time > 0 && history->logout_time < to) {
+                        g_ptr_array_add (records, cc_login_history_record_new (history->logout_time, TRUE));
                 }
 
-                if (history.login_time >= from) {
-                        datetime = g_date_time_new_from_unix_local (history.login_time);
-                        add_record (self, datetime, _("Session Started"), line);
-                        line++;
+                if (history->login_time >= from) {
+                        g_ptr_array_add (records, cc_login_history_record_new (history->login_time, FALSE));
                 }
         }
+
+        g_list_store_splice (self->records,
+                             0,
+                             g_list_model_get_n_items (G_LIST_MODEL (self->records)),
+                             records->pdata,
+                             records->len);
+}
+
+static void
+user_changed_cb (CcLoginHistoryDialog *self)
+{
+        load_login_history (self);
+        show_week (self);
 }
 
 static void
@@ -275,6 +342,8 @@ cc_login_history_dialog_dispose (GObject *object)
         CcLoginHistoryDialog *self = CC_LOGIN_HISTORY_DIALOG (object);
 
         g_clear_object (&self->user);
+        g_clear_object (&self->records);
+        g_clear_pointer (&self->login_history, g_array_unref);
         g_clear_pointer (&self->week, g_date_time_unref);
         g_clear_pointer (&self->current_week, g_date_time_unref);
 
@@ -307,6 +376,14 @@ cc_login_history_dialog_init (CcLoginHistoryDialog *self)
         g_resources_register (cc_user_accounts_get_resource ());
 
         gtk_widget_init_template (GTK_WIDGET (self));
+
+        self->login_history = g_array_new (FALSE, FALSE, sizeof (CcLoginHistory));
+        self->records = g_list_store_new (CC_TYPE_LOGIN_HISTORY_RECORD);
+        gtk_list_box_bind_model (self->history_box,
+                                 G_LIST_MODEL (self->records),
+                                 create_record_row,
+                                 self,
+                                 NULL);
 }
 
 CcLoginHistoryDialog *
@@ -324,6 +401,9 @@ cc_login_history_dialog_new (ActUser *user)
                              NULL);
 
         self->user = g_object_ref (user);
+        g_signal_connect_object (self->user, "changed",
+                                 G_CALLBACK (user_changed_cb), self, G_CONNECT_SWAPPED);
+        load_login_history (self);
 
         /* Set the first day of this week */
         local = g_date_time_new_now_local ();
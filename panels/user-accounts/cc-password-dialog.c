@@ -64,27 +64,35 @@ struct _CcPasswordDialog
         gboolean            old_password_ok;
         gint                old_password_entry_timeout_id;
 
+        GCancellable       *strength_cancellable;
+        gint                strength_level;
+
         PasswdHandler      *passwd_handler;
 };
 
 G_DEFINE_TYPE (CcPasswordDialog, cc_password_dialog, ADW_TYPE_WINDOW)
 
-static gint
-update_password_strength (CcPasswordDialog *self)
+static void update_sensitivity (CcPasswordDialog *self);
+
+static void
+password_strength_cb (GObject      *source_object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
 {
+        g_autoptr(CcPasswordDialog) self = CC_PASSWORD_DIALOG (user_data);
+        g_autoptr(GError) error = NULL;
         const gchar *password;
-        const gchar *old_password;
-        const gchar *username;
-        gint strength_level;
         const gchar *hint;
         const gchar *verify;
+        gint strength_level;
 
-        password = gtk_editable_get_text (GTK_EDITABLE (self->password_entry));
-        old_password = gtk_editable_get_text (GTK_EDITABLE (self->old_password_entry));
-        username = act_user_get_user_name (self->user);
+        pw_strength_finish (result, &hint, &strength_level, &error);
+        if (error != NULL)
+                return;
+
+        self->strength_level = strength_level;
 
-        pw_strength (password, old_password, username,
-                     &hint, &strength_level);
+        password = gtk_editable_get_text (GTK_EDITABLE (self->password_entry));
 
         gtk_level_bar_set_value (self->strength_indicator, strength_level);
         gtk_label_set_label (self->password_hint_label, hint);
@@ -103,7 +111,30 @@ update_password_strength (CcPasswordDialog *self)
                 gtk_widget_set_sensitive (GTK_WIDGET (self->verify_entry), strength_level > 1);
         }
 
-        return strength_level;
+        update_sensitivity (self);
+}
+
+/* Evaluates the password in the background, superseding any evaluation
+ * still in progress */
+static void
+update_password_strength (CcPasswordDialog *self)
+{
+        const gchar *password;
+        const gchar *old_password;
+        const gchar *username;
+
+        g_cancellable_cancel (self->strength_cancellable);
+        g_clear_object (&self->strength_cancellable);
+        self->strength_cancellable = g_cancellable_new ();
+
+        password = gtk_editable_get_text (GTK_EDITABLE (self->password_entry));
+        old_password = gtk_editable_get_text (GTK_EDITABLE (self->old_password_entry));
+        username = act_user_get_user_name (self->user);
+
+        pw_strength_async (password, old_password, username,
+                           self->strength_cancellable,
+                           password_strength_cb,
+                           g_object_ref (self));
 }
 
 static void
@@ -194,14 +225,12 @@ update_sensitivity (CcPasswordDialog *self)
 {
         const gchar *password, *verify;
         gboolean can_change;
-        int strength;
 
         password = gtk_editable_get_text (GTK_EDITABLE (self->password_entry));
         verify = gtk_editable_get_text (GTK_EDITABLE (self->verify_entry));
 
         if (self->password_mode == ACT_USER_PASSWORD_MODE_REGULAR) {
-                strength = update_password_strength (self);
-                can_change = strength > 1 && strcmp (password, verify) == 0 &&
+                can_change = self->strength_level > 1 && strcmp (password, verify) == 0 &&
                              (self->old_password_ok || !gtk_widget_get_visible (GTK_WIDGET (self->old_password_entry)));
         }
         else {
@@ -291,6 +320,9 @@ recheck_password_match (CcPasswordDialog *self)
 static void
 password_entry_changed (CcPasswordDialog *self)
 {
+        /* Not known until the new password has been evaluated */
+        self->strength_level = 0;
+
         gtk_widget_add_css_class (GTK_WIDGET (self->password_entry), "error");
         gtk_widget_add_css_class (GTK_WIDGET (self->verify_entry), "error");
         recheck_password_match (self);
@@ -357,6 +389,8 @@ old_password_entry_timeout (CcPasswordDialog *self)
 {
         const gchar *text;
 
+        /* The old password is part of the password checks */
+        update_password_strength (self);
         update_sensitivity (self);
 
         text = gtk_editable_get_text (GTK_EDITABLE (self->old_password_entry));
@@ -386,6 +420,9 @@ old_password_entry_focus_out_cb (CcPasswordDialog *self)
 static void
 old_password_entry_changed (CcPasswordDialog *self)
 {
+        /* Not known until the new password has been evaluated */
+        self->strength_level = 0;
+
         if (self->old_password_entry_timeout_id != 0) {
                 g_source_remove (self->old_password_entry_timeout_id);
                 self->old_password_entry_timeout_id = 0;
@@ -438,6 +475,9 @@ cc_password_dialog_dispose (GObject *object)
                 self->password_entry_timeout_id = 0;
         }
 
+        g_cancellable_cancel (self->strength_cancellable);
+        g_clear_object (&self->strength_cancellable);
+
         G_OBJECT_CLASS (cc_password_dialog_parent_class)->dispose (object);
 }
 
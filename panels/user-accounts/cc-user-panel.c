@@ -44,6 +44,7 @@
 #endif
 
 #include "cc-add-user-dialog.h"
+#include "cc-avatar-cache.h"
 #include "cc-avatar-chooser.h"
 #include "cc-language-chooser.h"
 #include "cc-login-history-dialog.h"
@@ -60,6 +61,12 @@
 
 #define USER_ACCOUNTS_PERMISSION "org.gnome.controlcenter.user-accounts.administration"
 
+/* Offer to search the list once it gets longer than this */
+#define USERS_SEARCH_THRESHOLD 10
+
+#define USER_COLLATION_KEY "cc-user-panel-collation-key"
+#define USER_SEARCH_KEY "cc-user-panel-search-key"
+
 struct _CcUserPanel {
         CcPanel parent_instance;
 
@@ -86,7 +93,7 @@ struct _CcUserPanel {
         GtkWidget       *no_users_box;
         GtkRevealer     *notification_revealer;
         AdwPreferencesGroup *other_users;
-        GtkListBox      *other_users_listbox;
+        GtkListView     *other_users_listview;
         AdwPreferencesRow *other_users_row;
         GtkLabel        *password_button_label;
 #ifdef HAVE_MALCONTENT
@@ -100,11 +107,14 @@ struct _CcUserPanel {
         AdwAvatar       *user_avatar;
         GtkMenuButton   *user_avatar_edit_button;
         GtkOverlay      *users_overlay;
+        GtkSearchEntry  *users_search_entry;
 
         ActUser *selected_user;
         GPermission *permission;
         CcLanguageChooser *language_chooser;
         GListStore *other_users_model;
+        GtkCustomFilter *users_filter;
+        gchar *users_search_text;
 
         CcAvatarChooser *avatar_chooser;
 
@@ -164,14 +174,13 @@ get_selected_user (CcUserPanel *self)
 }
 
 static void
-set_selected_user (CcUserPanel  *self,
-                   AdwActionRow *row)
-{
-        uid_t uid;
- 
-        uid = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (row), "uid"));
-        g_set_object (&self->selected_user,
-                      act_user_manager_get_user_by_id (self->um, uid));
+user_activated_cb (CcUserPanel *self,
+                   guint        position)
+{
+        g_autoptr(ActUser) user = NULL;
+
+        user = g_list_model_get_item (G_LIST_MODEL (gtk_list_view_get_model (self->other_users_listview)), position);
+        g_set_object (&self->selected_user, user);
         show_user (self->selected_user, self);
 }
 
@@ -212,104 +221,260 @@ get_real_or_user_name (ActUser *user)
   return name;
 }
 
+static void
+avatar_loaded_cb (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+        g_autoptr(AdwAvatar) avatar = user_data;
+        g_autoptr(GdkTexture) texture = NULL;
+        g_autoptr(GError) error = NULL;
+
+        texture = cc_avatar_cache_load_finish (CC_AVATAR_CACHE (source), result, &error);
+        if (texture == NULL) {
+                if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        return;
+
+                /* Fall back to the initials */
+                g_debug ("Failed to load avatar: %s", error->message);
+                adw_avatar_set_custom_image (avatar, NULL);
+                return;
+        }
+
+        adw_avatar_set_custom_image (avatar, GDK_PAINTABLE (texture));
+}
+
+static void
+cancel_avatar_load (gpointer data)
+{
+        GCancellable *cancellable = data;
+
+        g_cancellable_cancel (cancellable);
+        g_object_unref (cancellable);
+}
+
+/* The initials are shown right away, the picture is decoded in the
+ * background and swapped in once it is ready. */
 static void
 setup_avatar_for_user (AdwAvatar *avatar, ActUser *user)
 {
+        CcAvatarCache *cache = cc_avatar_cache_get_default ();
+        GCancellable *cancellable;
+        GdkTexture *texture = NULL;
         const gchar *avatar_file;
+        gint size;
 
-        adw_avatar_set_custom_image (avatar, NULL);
         adw_avatar_set_text (avatar, get_real_or_user_name (user));
 
         avatar_file = act_user_get_icon_file (user);
-        if (avatar_file) {
-                g_autoptr(GdkPixbuf) pixbuf = NULL;
-
-                pixbuf = gdk_pixbuf_new_from_file_at_size (avatar_file,
-                                                           adw_avatar_get_size (avatar),
-                                                           adw_avatar_get_size (avatar),
-                                                           NULL);
-                if (pixbuf) {
-                        adw_avatar_set_custom_image (avatar,
-                                                     GDK_PAINTABLE (gdk_texture_new_for_pixbuf (pixbuf)));
-                }
-        }
+        size = adw_avatar_get_size (avatar);
+
+        /* Show what we decoded last time, if anything, until we know whether
+         * the file changed */
+        if (avatar_file != NULL)
+                texture = cc_avatar_cache_lookup (cache, avatar_file, size);
+        adw_avatar_set_custom_image (avatar, GDK_PAINTABLE (texture));
+
+        /* This cancels any load still in progress for the avatar */
+        cancellable = g_cancellable_new ();
+        g_object_set_data_full (G_OBJECT (avatar), "avatar-cancellable",
+                                cancellable, cancel_avatar_load);
+
+        if (avatar_file != NULL)
+                cc_avatar_cache_load_async (cache, avatar_file, size, cancellable,
+                                            avatar_loaded_cb, g_object_ref (avatar));
 }
 
-static GtkWidget *
-create_user_row (gpointer item,
-                 gpointer user_data)
+static void
+user_row_setup_cb (CcUserPanel *self,
+                   GtkListItem *item)
 {
-        ActUser *user = ACT_USER (item);
-        GtkWidget *row, *user_image;
+        GtkWidget *box, *avatar, *label;
+
+        box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
+        gtk_widget_set_margin_top (box, 6);
+        gtk_widget_set_margin_bottom (box, 6);
+        gtk_widget_set_margin_start (box, 12);
+        gtk_widget_set_margin_end (box, 12);
 
-        row = adw_action_row_new ();
-        g_object_set_data (G_OBJECT (row), "uid", GINT_TO_POINTER (act_user_get_uid (user)));
-        gtk_list_box_row_set_activatable (GTK_LIST_BOX_ROW (row), TRUE); 
-        adw_preferences_row_set_title (ADW_PREFERENCES_ROW (row),
-                                       get_real_or_user_name (user));
-        user_image = adw_avatar_new (48, NULL, TRUE);
-        setup_avatar_for_user (ADW_AVATAR (user_image), user);
-        adw_action_row_add_prefix (ADW_ACTION_ROW (row), user_image);
+        avatar = adw_avatar_new (48, NULL, TRUE);
+        gtk_box_append (GTK_BOX (box), avatar);
 
-        return row;
+        label = gtk_label_new (NULL);
+        gtk_label_set_xalign (GTK_LABEL (label), 0.0);
+        gtk_label_set_ellipsize (GTK_LABEL (label), PANGO_ELLIPSIZE_END);
+        gtk_box_append (GTK_BOX (box), label);
+
+        gtk_list_item_set_child (item, box);
+}
+
+static void
+user_row_bind_cb (CcUserPanel *self,
+                  GtkListItem *item)
+{
+        ActUser *user = gtk_list_item_get_item (item);
+        GtkWidget *box, *avatar, *label;
+
+        box = gtk_list_item_get_child (item);
+        avatar = gtk_widget_get_first_child (box);
+        label = gtk_widget_get_next_sibling (avatar);
+
+        gtk_label_set_label (GTK_LABEL (label), get_real_or_user_name (user));
+        setup_avatar_for_user (ADW_AVATAR (avatar), user);
+}
+
+/* Names are compared and searched much more often than they change, so
+ * the keys are computed when a user is added or changed and kept on it. */
+static void
+update_user_keys (ActUser *user)
+{
+        g_autofree gchar *real_name = NULL;
+        g_autofree gchar *user_name = NULL;
+
+        g_object_set_data_full (G_OBJECT (user), USER_COLLATION_KEY,
+                                g_utf8_collate_key (get_real_or_user_name (user), -1),
+                                g_free);
+
+        real_name = cc_util_normalize_casefold_and_unaccent (act_user_get_real_name (user));
+        user_name = cc_util_normalize_casefold_and_unaccent (act_user_get_user_name (user));
+        g_object_set_data_full (G_OBJECT (user), USER_SEARCH_KEY,
+                                g_strjoin ("\n", real_name ? real_name : "", user_name ? user_name : "", NULL),
+                                g_free);
 }
 
 static gint
 sort_users (gconstpointer a, gconstpointer b, gpointer user_data)
 {
-        ActUser *ua, *ub;
+        return g_strcmp0 (g_object_get_data (G_OBJECT (a), USER_COLLATION_KEY),
+                          g_object_get_data (G_OBJECT (b), USER_COLLATION_KEY));
+}
 
-        ua = ACT_USER (a);
-        ub = ACT_USER (b);
+static gboolean
+filter_users (gpointer item, gpointer user_data)
+{
+        CcUserPanel *self = user_data;
+        const gchar *search_key;
 
-        /* Make sure the current user is shown first */
-        if (act_user_get_uid (ua) == getuid ()) {
-                return -G_MAXINT32;
-        }
-        else if (act_user_get_uid (ub) == getuid ()) {
-                return G_MAXINT32;
-        }
-        else {
-                g_autofree gchar *name1 = NULL;
-                g_autofree gchar *name2 = NULL;
+        if (self->users_search_text == NULL || *self->users_search_text == '\0')
+                return TRUE;
 
-                name1 = g_utf8_collate_key (get_real_or_user_name (ua), -1);
-                name2 = g_utf8_collate_key (get_real_or_user_name (ub), -1);
+        search_key = g_object_get_data (G_OBJECT (item), USER_SEARCH_KEY);
 
-                return strcmp (name1, name2);
-        }
+        return search_key != NULL && strstr (search_key, self->users_search_text) != NULL;
 }
 
 static void
-user_changed (CcUserPanel *self, ActUser *user)
+users_search_changed_cb (CcUserPanel *self)
+{
+        g_autofree gchar *old_text = g_steal_pointer (&self->users_search_text);
+        GtkFilterChange change = GTK_FILTER_CHANGE_DIFFERENT;
+
+        self->users_search_text = cc_util_normalize_casefold_and_unaccent (gtk_editable_get_text (GTK_EDITABLE (self->users_search_entry)));
+
+        if (old_text != NULL && strstr (self->users_search_text, old_text) != NULL)
+                change = GTK_FILTER_CHANGE_MORE_STRICT;
+        else if (old_text != NULL && strstr (old_text, self->users_search_text) != NULL)
+                change = GTK_FILTER_CHANGE_LESS_STRICT;
+
+        gtk_filter_changed (GTK_FILTER (self->users_filter), change);
+}
+
+static void
+update_other_users_visibility (CcUserPanel *self)
 {
+        guint n_users;
+
+        n_users = g_list_model_get_n_items (G_LIST_MODEL (self->other_users_model));
+        gtk_widget_set_visible (GTK_WIDGET (self->other_users_row), n_users > 0);
+        gtk_widget_set_visible (GTK_WIDGET (self->users_search_entry), n_users > USERS_SEARCH_THRESHOLD);
+}
+
+static gboolean
+should_list_user (ActUser *user)
+{
+        return !act_user_is_system_account (user) && act_user_get_uid (user) != getuid ();
+}
+
+static void
+reload_users (CcUserPanel *self)
+{
+        g_autoptr(GPtrArray) users = NULL;
         GSList *user_list, *l;
-        gboolean show;
 
-        g_list_store_remove_all (self->other_users_model);
+        users = g_ptr_array_new ();
         user_list = act_user_manager_list_users (self->um);
         for (l = user_list; l; l = l->next) {
-                ActUser *other_user = ACT_USER (l->data);
+                ActUser *user = ACT_USER (l->data);
 
-                if (act_user_is_system_account (other_user)) {
+                if (!should_list_user (user))
                         continue;
-                }
 
-                if (act_user_get_uid (other_user) == getuid ()) {
-                        continue;
-                }
+                update_user_keys (user);
+                g_ptr_array_add (users, user);
+        }
+        g_slist_free (user_list);
 
-                g_list_store_insert_sorted (self->other_users_model,
-                                            other_user,
-                                            sort_users,
-                                            self);
+        g_list_store_splice (self->other_users_model,
+                             0,
+                             g_list_model_get_n_items (G_LIST_MODEL (self->other_users_model)),
+                             users->pdata,
+                             users->len);
+
+        update_other_users_visibility (self);
+}
+
+static void
+user_added (CcUserPanel *self, ActUser *user)
+{
+        if (!should_list_user (user) ||
+            g_list_store_find (self->other_users_model, user, NULL))
+                return;
+
+        update_user_keys (user);
+        g_list_store_append (self->other_users_model, user);
+
+        update_other_users_visibility (self);
+}
+
+static void
+user_removed (CcUserPanel *self, ActUser *user)
+{
+        guint position;
+
+        if (!g_list_store_find (self->other_users_model, user, &position))
+                return;
+
+        g_list_store_remove (self->other_users_model, position);
+
+        update_other_users_visibility (self);
+}
+
+static void
+user_changed (CcUserPanel *self, ActUser *user)
+{
+        g_autoptr(ActUser) item = g_object_ref (user);
+        guint position;
+
+        if (!g_list_store_find (self->other_users_model, user, &position)) {
+                user_added (self, user);
+        } else if (!should_list_user (user)) {
+                user_removed (self, user);
+        } else {
+                /* Replacing the item re-sorts, re-filters and rebinds
+                 * only the row of this user */
+                update_user_keys (user);
+                g_list_store_splice (self->other_users_model, position, 1, (gpointer *) &item, 1);
         }
 
         if (self->selected_user == user)
                 show_user (user, self);
+}
 
-        show = g_list_model_get_n_items (G_LIST_MODEL (self->other_users_model)) > 0;
-        gtk_widget_set_visible (GTK_WIDGET (self->other_users_row), show);
+static void
+user_is_logged_in_changed (CcUserPanel *self, ActUser *user)
+{
+        if (self->selected_user == user)
+                show_user (user, self);
 }
 
 static void
@@ -1213,10 +1378,12 @@ users_loaded (CcUserPanel *self)
                 show_current_user (self);
         }
 
+        reload_users (self);
+
         g_signal_connect_object (self->um, "user-changed", G_CALLBACK (user_changed), self, G_CONNECT_SWAPPED);
-        g_signal_connect_object (self->um, "user-is-logged-in-changed", G_CALLBACK (user_changed), self, G_CONNECT_SWAPPED);
-        g_signal_connect_object (self->um, "user-added", G_CALLBACK (user_changed), self, G_CONNECT_SWAPPED);
-        g_signal_connect_object (self->um, "user-removed", G_CALLBACK (user_changed), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (self->um, "user-is-logged-in-changed", G_CALLBACK (user_is_logged_in_changed), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (self->um, "user-added", G_CALLBACK (user_added), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (self->um, "user-removed", G_CALLBACK (user_removed), self, G_CONNECT_SWAPPED);
 }
 
 static void
@@ -1381,14 +1548,29 @@ static void
 setup_main_window (CcUserPanel *self)
 {
         g_autoptr(GError) error = NULL;
+        g_autoptr(GtkListItemFactory) factory = NULL;
+        g_autoptr(GtkNoSelection) selection = NULL;
+        GtkSortListModel *sort_model;
+        GtkFilterListModel *filter_model;
+        GtkCustomSorter *sorter;
         gboolean loaded;
 
+        /* Sort below the filter, so that searching does not re-sort */
         self->other_users_model = g_list_store_new (ACT_TYPE_USER);
-        gtk_list_box_bind_model (self->other_users_listbox,
-                                 G_LIST_MODEL (self->other_users_model),
-                                 (GtkListBoxCreateWidgetFunc)create_user_row,
-                                 self,
-                                 NULL);
+        sorter = gtk_custom_sorter_new (sort_users, self, NULL);
+        sort_model = gtk_sort_list_model_new (G_LIST_MODEL (g_object_ref (self->other_users_model)),
+                                              GTK_SORTER (sorter));
+        self->users_filter = gtk_custom_filter_new (filter_users, self, NULL);
+        filter_model = gtk_filter_list_model_new (G_LIST_MODEL (sort_model),
+                                                  GTK_FILTER (g_object_ref (self->users_filter)));
+
+        factory = gtk_signal_list_item_factory_new ();
+        g_signal_connect_object (factory, "setup", G_CALLBACK (user_row_setup_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (factory, "bind", G_CALLBACK (user_row_bind_cb), self, G_CONNECT_SWAPPED);
+
+        selection = gtk_no_selection_new (G_LIST_MODEL (filter_model));
+        gtk_list_view_set_factory (self->other_users_listview, factory);
+        gtk_list_view_set_model (self->other_users_listview, GTK_SELECTION_MODEL (selection));
 
         add_unlock_tooltip (GTK_WIDGET (self->user_avatar));
 
@@ -1411,7 +1593,6 @@ setup_main_window (CcUserPanel *self)
         g_object_get (self->um, "is-loaded", &loaded, NULL);
         if (loaded) {
                 users_loaded (self);
-                user_changed (self, NULL);
         } else {
                 g_signal_connect_object (self->um, "notify::is-loaded", G_CALLBACK (users_loaded), self, G_CONNECT_SWAPPED);
         }
@@ -1492,6 +1673,9 @@ cc_user_panel_dispose (GObject *object)
         CcUserPanel *self = CC_USER_PANEL (object);
 
         g_clear_object (&self->selected_user);
+        g_clear_object (&self->users_filter);
+        g_clear_object (&self->other_users_model);
+        g_clear_pointer (&self->users_search_text, g_free);
         g_clear_object (&self->login_screen_settings);
         g_clear_pointer ((GtkWindow **)&self->language_chooser, gtk_window_destroy);
         g_clear_object (&self->permission);
@@ -1540,7 +1724,7 @@ cc_user_panel_class_init (CcUserPanelClass *klass)
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, notification_revealer);
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, other_users);
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, other_users_row);
-        gtk_widget_class_bind_template_child (widget_class, CcUserPanel, other_users_listbox);
+        gtk_widget_class_bind_template_child (widget_class, CcUserPanel, other_users_listview);
 #ifdef HAVE_MALCONTENT
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, parental_controls_button_label);
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, parental_controls_row);
@@ -1553,6 +1737,7 @@ cc_user_panel_class_init (CcUserPanelClass *klass)
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, user_avatar);
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, user_avatar_edit_button);
         gtk_widget_class_bind_template_child (widget_class, CcUserPanel, users_overlay);
+        gtk_widget_class_bind_template_child (widget_class, CcUserPanel, users_search_entry);
 
         gtk_widget_class_bind_template_callback (widget_class, account_type_changed);
         gtk_widget_class_bind_template_callback (widget_class, add_user);
@@ -1566,7 +1751,8 @@ cc_user_panel_class_init (CcUserPanelClass *klass)
         gtk_widget_class_bind_template_callback (widget_class, delete_user);
         gtk_widget_class_bind_template_callback (widget_class, dismiss_notification);
         gtk_widget_class_bind_template_callback (widget_class, restart_now);
-        gtk_widget_class_bind_template_callback (widget_class, set_selected_user);
+        gtk_widget_class_bind_template_callback (widget_class, user_activated_cb);
+        gtk_widget_class_bind_template_callback (widget_class, users_search_changed_cb);
         gtk_widget_class_bind_template_callback (widget_class, on_back_button_clicked_cb);
         gtk_widget_class_bind_template_callback (widget_class, show_history);
 }
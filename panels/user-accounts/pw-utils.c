@@ -22,33 +22,41 @@
 
 #include "pw-utils.h"
 
+#include <string.h>
+
+#include <gio/gio.h>
 #include <glib.h>
 #include <glib/gi18n.h>
 
 #include <pwquality.h>
 
+/* The settings are loaded once and shared by all the dialogs and by the
+ * worker threads evaluating passwords, which only ever read them. */
 static pwquality_settings_t *
 get_pwq (void)
 {
         static pwquality_settings_t *settings;
 
-        if (settings == NULL) {
+        if (g_once_init_enter (&settings)) {
+                pwquality_settings_t *new_settings;
                 gchar *err = NULL;
                 gint rv = 0;
 
-                settings = pwquality_default_settings ();
-                pwquality_set_int_value (settings, PWQ_SETTING_MAX_SEQUENCE, 4);
+                new_settings = pwquality_default_settings ();
+                pwquality_set_int_value (new_settings, PWQ_SETTING_MAX_SEQUENCE, 4);
 
-                rv = pwquality_read_config (settings, NULL, (gpointer)&err);
+                rv = pwquality_read_config (new_settings, NULL, (gpointer)&err);
                 if (rv < 0) {
                         g_warning ("failed to read pwquality configuration: %s\n",
                                    pwquality_strerror (NULL, 0, rv, err));
-                        pwquality_free_settings (settings);
+                        pwquality_free_settings (new_settings);
 
                         /* Load just default settings in case of failure. */
-                        settings = pwquality_default_settings ();
-                        pwquality_set_int_value (settings, PWQ_SETTING_MAX_SEQUENCE, 4);
+                        new_settings = pwquality_default_settings ();
+                        pwquality_set_int_value (new_settings, PWQ_SETTING_MAX_SEQUENCE, 4);
                 }
+
+                g_once_init_leave (&settings, new_settings);
         }
 
         return settings;
@@ -133,12 +141,13 @@ pw_error_hint (gint error)
         }
 }
 
-gdouble
-pw_strength (const gchar  *password,
-             const gchar  *old_password,
-             const gchar  *username,
-             const gchar **hint,
-             gint         *strength_level)
+static gdouble
+evaluate_strength (const gchar  *password,
+                   const gchar  *old_password,
+                   const gchar  *username,
+                   gint          min_length,
+                   const gchar **hint,
+                   gint         *strength_level)
 {
         gint rv, level, length = 0;
         gdouble strength = 0.0;
@@ -165,7 +174,7 @@ pw_strength (const gchar  *password,
                 level = 5;
         }
 
-        if (length && length < pw_min_length())
+        if (length && length < min_length)
                 *hint = pw_error_hint (PWQ_ERROR_MIN_LENGTH);
         else
                 *hint = pw_error_hint (rv);
@@ -175,3 +184,105 @@ pw_strength (const gchar  *password,
 
         return strength;
 }
+
+typedef struct {
+        gchar       *password;
+        gchar       *old_password;
+        gchar       *username;
+        gint         min_length;
+        gdouble      strength;
+        const gchar *hint;
+        gint         level;
+} PwStrengthData;
+
+static void
+pw_strength_data_free (PwStrengthData *data)
+{
+        if (data->password != NULL)
+                memset (data->password, 0, strlen (data->password));
+        if (data->old_password != NULL)
+                memset (data->old_password, 0, strlen (data->old_password));
+
+        g_free (data->password);
+        g_free (data->old_password);
+        g_free (data->username);
+        g_free (data);
+}
+
+/* cracklib keeps the dictionary it checks against in static variables,
+ * so only one password is ever evaluated at a time. */
+static GMutex check_lock;
+
+static void
+pw_strength_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+        g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&check_lock);
+        PwStrengthData *data = task_data;
+
+        /* Passwords which got replaced by a newer one while waiting for
+         * their turn are not worth evaluating anymore. */
+        if (g_task_return_error_if_cancelled (task))
+                return;
+
+        data->strength = evaluate_strength (data->password,
+                                            data->old_password,
+                                            data->username,
+                                            data->min_length,
+                                            &data->hint,
+                                            &data->level);
+
+        g_task_return_boolean (task, TRUE);
+}
+
+/* pwquality_check() can take a while when it goes through the cracklib
+ * dictionaries, so do it in a thread. Cancelling the evaluation, for
+ * instance because the password changed again, skips it if it has not
+ * started yet. */
+void
+pw_strength_async (const gchar         *password,
+                   const gchar         *old_password,
+                   const gchar         *username,
+                   GCancellable        *cancellable,
+                   GAsyncReadyCallback  callback,
+                   gpointer             user_data)
+{
+        g_autoptr(GTask) task = NULL;
+        PwStrengthData *data;
+
+        data = g_new0 (PwStrengthData, 1);
+        data->password = g_strdup (password);
+        data->old_password = g_strdup (old_password);
+        data->username = g_strdup (username);
+        data->min_length = pw_min_length ();
+
+        task = g_task_new (NULL, cancellable, callback, user_data);
+        g_task_set_source_tag (task, pw_strength_async);
+        g_task_set_task_data (task, data, (GDestroyNotify) pw_strength_data_free);
+        g_task_run_in_thread (task, pw_strength_thread);
+}
+
+gdouble
+pw_strength_finish (GAsyncResult  *result,
+                    const gchar  **hint,
+                    gint          *strength_level,
+                    GError       **error)
+{
+        PwStrengthData *data;
+
+        g_return_val_if_fail (g_task_is_valid (result, NULL), 0.0);
+
+        if (!g_task_propagate_boolean (G_TASK (result), error))
+                return 0.0;
+
+        data = g_task_get_task_data (G_TASK (result));
+
+        if (hint != NULL)
+                *hint = data->hint;
+        if (strength_level != NULL)
+                *strength_level = data->level;
+
+        return data->strength;
+}
@@ -20,12 +20,17 @@
 
 #pragma once
 
-#include <glib.h>
+#include <gio/gio.h>
 
-gint     pw_min_length (void);
-gchar   *pw_generate   (void);
-gdouble  pw_strength   (const gchar  *password,
-                        const gchar  *old_password,
-                        const gchar  *username,
-                        const gchar **hint,
-                        gint         *strength_level);
+gint     pw_min_length      (void);
+gchar   *pw_generate        (void);
+void     pw_strength_async  (const gchar          *password,
+                             const gchar          *old_password,
+                             const gchar          *username,
+                             GCancellable         *cancellable,
+                             GAsyncReadyCallback   callback,
+                             gpointer              user_data);
+gdouble  pw_strength_finish (GAsyncResult         *result,
+                             const gchar         **hint,
+                             gint                 *strength_level,
+                             GError              **error);
@@ -20,19 +20,15 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <math.h>
 #include <stdlib.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <limits.h>
 #include <unistd.h>
 #include <utmpx.h>
 #include <pwd.h>
 
-#ifdef __FreeBSD__
-#include <sysexits.h>
-#endif
-
 #include <gio/gio.h>
 #include <gio/gunixoutputstream.h>
 #include <glib/gi18n.h>
@@ -53,18 +49,78 @@ get_username_max_length (void)
         return sizeof (((struct utmpx *)NULL)->ut_user);
 }
 
-gboolean
-is_username_used (const gchar *username)
+/* Existence checks can hit NSS and, from there, a remote directory, so
+ * their results are kept for a little while and lookups for a name that
+ * is already being looked up are shared.
+ */
+#define USERNAME_CACHE_TIMEOUT (30 * G_USEC_PER_SEC)
+
+typedef struct {
+        gboolean used;
+        gint64   timestamp;
+} UsernameCacheEntry;
+
+/* username → UsernameCacheEntry */
+static GHashTable *username_cache = NULL;
+/* username → GPtrArray of the GTasks waiting for the lookup */
+static GHashTable *username_lookups = NULL;
+
+static gboolean
+lookup_username (const gchar *username)
 {
-        struct passwd *pwent;
+        struct passwd pwent, *result = NULL;
+        g_autofree gchar *buffer = NULL;
+        glong buffer_size;
+
+        buffer_size = sysconf (_SC_GETPW_R_SIZE_MAX);
+        if (buffer_size <= 0)
+                buffer_size = 16384;
+
+        buffer = g_malloc (buffer_size);
+        while (getpwnam_r (username, &pwent, buffer, buffer_size, &result) == ERANGE) {
+                buffer_size *= 2;
+                buffer = g_realloc (buffer, buffer_size);
+        }
 
-        if (username == NULL || username[0] == '\0') {
+        return result != NULL;
+}
+
+static gboolean
+get_cached_username (const gchar *username,
+                     gboolean    *used)
+{
+        UsernameCacheEntry *entry;
+
+        if (username_cache == NULL)
+                return FALSE;
+
+        entry = g_hash_table_lookup (username_cache, username);
+        if (entry == NULL)
+                return FALSE;
+
+        if (g_get_monotonic_time () - entry->timestamp > USERNAME_CACHE_TIMEOUT) {
+                g_hash_table_remove (username_cache, username);
                 return FALSE;
         }
 
-        pwent = getpwnam (username);
+        *used = entry->used;
+
+        return TRUE;
+}
+
+static void
+cache_username (const gchar *username,
+                gboolean     used)
+{
+        UsernameCacheEntry *entry;
+
+        if (username_cache == NULL)
+                username_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 
-        return pwent != NULL;
+        entry = g_new (UsernameCacheEntry, 1);
+        entry->used = used;
+        entry->timestamp = g_get_monotonic_time ();
+        g_hash_table_replace (username_cache, g_strdup (username), entry);
 }
 
 gboolean
@@ -112,55 +168,79 @@ is_valid_username_data_free (isValidUsernameData *data)
         g_free (data);
 }
 
-#ifdef __FreeBSD__
-/* Taken from pw(8) man page. */
-#define E_SUCCESS EX_OK
-#define E_BAD_ARG EX_DATAERR
-#define E_NOTFOUND EX_NOUSER
-#else
-/* Taken from usermod.c in shadow-utils. */
-#define E_SUCCESS 0
-#define E_BAD_ARG 3
-#define E_NOTFOUND 6
-#endif
+/* The naming rules of shadow-utils (is_valid_name() in chkname.c), which
+ * is what useradd and usermod check names against:
+ *
+ *   [a-zA-Z0-9_.][a-zA-Z0-9_.-]*$?
+ *
+ * except for fully numeric names, "." and "..".
+ */
+static gboolean
+is_valid_username_syntax (const gchar *username)
+{
+        gboolean numeric;
+        const gchar *c;
+
+        if (g_str_equal (username, ".") || g_str_equal (username, ".."))
+                return FALSE;
+
+        if (!g_ascii_isalnum (username[0]) && username[0] != '_' && username[0] != '.')
+                return FALSE;
+
+        numeric = g_ascii_isdigit (username[0]);
+
+        for (c = username + 1; *c != '\0'; c++) {
+                if (!g_ascii_isalnum (*c) &&
+                    *c != '_' && *c != '.' && *c != '-' &&
+                    !(*c == '$' && c[1] == '\0'))
+                        return FALSE;
+
+                numeric &= g_ascii_isdigit (*c) != 0;
+        }
+
+        return !numeric;
+}
 
 static void
-is_valid_username_child_watch_cb (GPid pid,
-                                  gint status,
-                                  gpointer user_data)
+complete_username_check (GTask    *task,
+                         gboolean  used)
 {
-        g_autoptr(GTask) task = G_TASK (user_data);
         isValidUsernameData *data = g_task_get_task_data (task);
-        GError *error = NULL;
-        gboolean valid = FALSE;
-        const gchar *tip = NULL;
-
-        if (WIFEXITED (status)) {
-                switch (WEXITSTATUS (status)) {
-                        case E_NOTFOUND:
-                                valid = TRUE;
-                                break;
-                        case E_BAD_ARG:
-                                tip = _("The username should usually only consist of lower case letters from a-z, digits and the following characters: - _");
-                                valid = FALSE;
-                                break;
-                        case E_SUCCESS:
-                                tip = _("Sorry, that user name isn’t available. Please try another.");
-                                valid = FALSE;
-                                break;
-                }
-        }
 
-        if (valid || tip != NULL) {
-                data->tip = g_strdup (tip);
-                g_task_return_boolean (task, valid);
-        }
-        else {
-                g_spawn_check_wait_status (status, &error);
-                g_task_return_error (task, error);
-        }
+        if (used)
+                data->tip = g_strdup (_("Sorry, that user name isn’t available. Please try another."));
+
+        g_task_return_boolean (task, !used);
+}
+
+static void
+lookup_username_thread (GTask        *task,
+                        gpointer      source_object,
+                        gpointer      task_data,
+                        GCancellable *cancellable)
+{
+        g_task_return_boolean (task, lookup_username (task_data));
+}
+
+static void
+lookup_username_done_cb (GObject      *source_object,
+                         GAsyncResult *result,
+                         gpointer      user_data)
+{
+        const gchar *username = g_task_get_task_data (G_TASK (result));
+        g_autofree gchar *key = NULL;
+        g_autoptr(GPtrArray) waiting = NULL;
+        gboolean used;
+        guint i;
+
+        used = g_task_propagate_boolean (G_TASK (result), NULL);
+        cache_username (username, used);
+
+        g_hash_table_steal_extended (username_lookups, username,
+                                     (gpointer *) &key, (gpointer *) &waiting);
 
-        g_spawn_close_pid (pid);
+        for (i = 0; i < waiting->len; i++)
+                complete_username_check (g_ptr_array_index (waiting, i), used);
 }
 
 void
@@ -170,10 +250,10 @@ is_valid_username_async (const gchar *username,
                          gpointer callback_data)
 {
         g_autoptr(GTask) task = NULL;
+        g_autoptr(GTask) lookup_task = NULL;
         isValidUsernameData *data;
-        gchar *argv[6];
-        GPid pid;
-        GError *error = NULL;
+        GPtrArray *waiting;
+        gboolean used;
 
         task = g_task_new (NULL, cancellable, callback, callback_data);
         g_task_set_source_tag (task, is_valid_username_async);
@@ -191,42 +271,36 @@ is_valid_username_async (const gchar *username,
                 g_task_return_boolean (task, FALSE);
                 return;
         }
+        else if (!is_valid_username_syntax (username)) {
+                data->tip = g_strdup (_("The username should usually only consist of lower case letters from a-z, digits and the following characters: - _"));
+                g_task_return_boolean (task, FALSE);
+                return;
+        }
 
-#ifdef __FreeBSD__
-        /* Abuse "pw usershow -n <name>" in the same way as the code below. We
-         * don't use "pw usermod -n <name> -N -l <newname>" here because it has
-         * a special case for "root" to reject changes to the root user.
-         */
-        argv[0] = "pw";
-        argv[1] = "usershow";
-        argv[2] = "-n";
-        argv[3] = data->username;
-        argv[4] = NULL;
-#else
-        /* "usermod --login" is meant to be used to change a username, but the
-         * exit codes can be safely abused to check the validity of username.
-         * However, the current "usermod" implementation may change in the
-         * future, so it would be nice to have some official way for this
-         * instead of relying on the current "--login" implementation.
-         */
-        argv[0] = "/usr/sbin/usermod";
-        argv[1] = "--login";
-        argv[2] = data->username;
-        argv[3] = "--";
-        argv[4] = data->username;
-        argv[5] = NULL;
-#endif
-
-        if (!g_spawn_async (NULL, argv, NULL,
-                            G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD |
-                            G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
-                            NULL, NULL, &pid, &error)) {
-                g_task_return_error (task, error);
+        if (get_cached_username (username, &used)) {
+                complete_username_check (task, used);
+                return;
+        }
+
+        if (username_lookups == NULL)
+                username_lookups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+
+        /* Join the lookup already in progress for this name, if any. A
+         * cancelled caller just stops waiting for it. */
+        waiting = g_hash_table_lookup (username_lookups, username);
+        if (waiting != NULL) {
+                g_ptr_array_add (waiting, g_steal_pointer (&task));
                 return;
         }
 
-        g_child_watch_add (pid, (GChildWatchFunc) is_valid_username_child_watch_cb, task);
-        g_steal_pointer (&task);
+        waiting = g_ptr_array_new_with_free_func (g_object_unref);
+        g_ptr_array_add (waiting, g_steal_pointer (&task));
+        g_hash_table_insert (username_lookups, g_strdup (username), waiting);
+
+        lookup_task = g_task_new (NULL, NULL, lookup_username_done_cb, NULL);
+        g_task_set_source_tag (lookup_task, lookup_username_thread);
+        g_task_set_task_data (lookup_task, g_strdup (username), g_free);
+        g_task_run_in_thread (lookup_task, lookup_username_thread);
 }
 
 gboolean
@@ -253,31 +327,112 @@ is_valid_username_finish (GAsyncResult *result,
         return g_task_propagate_boolean (task, error);
 }
 
-GdkPixbuf *
-round_image (GdkPixbuf *pixbuf)
+static GStrv
+get_unused_usernames (GStrv usernames)
 {
-        GdkPixbuf *dest = NULL;
-        cairo_surface_t *surface;
-        cairo_t *cr;
-        gint size;
+        g_autoptr(GStrvBuilder) builder = g_strv_builder_new ();
+        gboolean used;
+        guint i;
+
+        /* Anything the cache has lost track of meanwhile is offered anyway,
+         * the final check on the chosen name still catches it. */
+        for (i = 0; usernames[i] != NULL; i++) {
+                if (!get_cached_username (usernames[i], &used) || !used)
+                        g_strv_builder_add (builder, usernames[i]);
+        }
 
-        size = gdk_pixbuf_get_width (pixbuf);
-        surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, size, size);
-        cr = cairo_create (surface);
+        return g_strv_builder_end (builder);
+}
+
+static void
+lookup_usernames_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+        GStrv usernames = task_data;
+        g_autoptr(GArray) used = NULL;
+        guint i;
+
+        used = g_array_sized_new (FALSE, FALSE, sizeof (gboolean), g_strv_length (usernames));
+        for (i = 0; usernames[i] != NULL; i++) {
+                gboolean found = lookup_username (usernames[i]);
+                g_array_append_val (used, found);
+        }
 
-        /* Clip a circle */
-        cairo_arc (cr, size/2, size/2, size/2, 0, 2 * G_PI);
-        cairo_clip (cr);
-        cairo_new_path (cr);
+        g_task_return_pointer (task, g_steal_pointer (&used), (GDestroyNotify) g_array_unref);
+}
 
-        gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
-        cairo_paint (cr);
+static void
+lookup_usernames_done_cb (GObject      *source_object,
+                          GAsyncResult *result,
+                          gpointer      user_data)
+{
+        g_autoptr(GTask) task = G_TASK (user_data);
+        GStrv looked_up = g_task_get_task_data (G_TASK (result));
+        g_autoptr(GArray) used = NULL;
+        guint i;
 
-        dest = gdk_pixbuf_get_from_surface (surface, 0, 0, size, size);
-        cairo_surface_destroy (surface);
-        cairo_destroy (cr);
+        /* The results are worth keeping even if nobody waits for them */
+        used = g_task_propagate_pointer (G_TASK (result), NULL);
+        for (i = 0; i < used->len; i++)
+                cache_username (looked_up[i], g_array_index (used, gboolean, i));
+
+        if (g_task_return_error_if_cancelled (task))
+                return;
+
+        g_task_return_pointer (task,
+                               get_unused_usernames (g_task_get_task_data (task)),
+                               (GDestroyNotify) g_strfreev);
+}
+
+/* Drops the names that are already taken from @usernames, looking the
+ * ones not in the cache up in a single thread.
+ */
+void
+filter_used_usernames_async (const gchar * const *usernames,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             callback_data)
+{
+        g_autoptr(GTask) task = NULL;
+        g_autoptr(GTask) lookup_task = NULL;
+        g_autoptr(GStrvBuilder) builder = NULL;
+        g_auto(GStrv) uncached = NULL;
+        gboolean used;
+        guint i;
+
+        task = g_task_new (NULL, cancellable, callback, callback_data);
+        g_task_set_source_tag (task, filter_used_usernames_async);
+        g_task_set_task_data (task, g_strdupv ((GStrv) usernames), (GDestroyNotify) g_strfreev);
+
+        builder = g_strv_builder_new ();
+        for (i = 0; usernames[i] != NULL; i++) {
+                if (!get_cached_username (usernames[i], &used))
+                        g_strv_builder_add (builder, usernames[i]);
+        }
+        uncached = g_strv_builder_end (builder);
+
+        if (uncached[0] == NULL) {
+                g_task_return_pointer (task,
+                                       get_unused_usernames (g_task_get_task_data (task)),
+                                       (GDestroyNotify) g_strfreev);
+                return;
+        }
+
+        lookup_task = g_task_new (NULL, NULL, lookup_usernames_done_cb, g_steal_pointer (&task));
+        g_task_set_source_tag (lookup_task, lookup_usernames_thread);
+        g_task_set_task_data (lookup_task, g_steal_pointer (&uncached), (GDestroyNotify) g_strfreev);
+        g_task_run_in_thread (lookup_task, lookup_usernames_thread);
+}
+
+GStrv
+filter_used_usernames_finish (GAsyncResult  *result,
+                              GError       **error)
+{
+        g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
 
-        return dest;
+        return g_task_propagate_pointer (G_TASK (result), error);
 }
 
 static gchar *
@@ -313,68 +468,122 @@ extract_initials_from_name (const gchar *name)
         return g_string_free (initials, FALSE);
 }
 
-static GdkRGBA
-get_color_for_name (const gchar *name)
+// https://gitlab.gnome.org/Community/Design/HIG-app-icons/blob/master/GNOME%20HIG.gpl
+static const gdouble gnome_color_palette[][3] = {
+        {  98, 160, 234 },
+        {  53, 132, 228 },
+        {  28, 113, 216 },
+        {  26,  95, 180 },
+        {  87, 227, 137 },
+        {  51, 209, 122 },
+        {  46, 194, 126 },
+        {  38, 162, 105 },
+        { 248, 228,  92 },
+        { 246, 211,  45 },
+        { 245, 194,  17 },
+        { 229, 165,  10 },
+        { 255, 163,  72 },
+        { 255, 120,   0 },
+        { 230,  97,   0 },
+        { 198,  70,   0 },
+        { 237,  51,  59 },
+        { 224,  27,  36 },
+        { 192,  28,  40 },
+        { 165,  29,  45 },
+        { 192,  97, 203 },
+        { 163,  71, 186 },
+        { 129,  61, 156 },
+        {  97,  53, 131 },
+        { 181, 131,  90 },
+        { 152, 106,  68 },
+        { 134,  94,  60 },
+        {  99,  69,  44 }
+};
+
+/* Returns the palette index for @name, or -1 for white */
+static gint
+get_color_index_for_name (const gchar *name)
 {
-        // https://gitlab.gnome.org/Community/Design/HIG-app-icons/blob/master/GNOME%20HIG.gpl
-        static gdouble gnome_color_palette[][3] = {
-                {  98, 160, 234 },
-                {  53, 132, 228 },
-                {  28, 113, 216 },
-                {  26,  95, 180 },
-                {  87, 227, 137 },
-                {  51, 209, 122 },
-                {  46, 194, 126 },
-                {  38, 162, 105 },
-                { 248, 228,  92 },
-                { 246, 211,  45 },
-                { 245, 194,  17 },
-                { 229, 165,  10 },
-                { 255, 163,  72 },
-                { 255, 120,   0 },
-                { 230,  97,   0 },
-                { 198,  70,   0 },
-                { 237,  51,  59 },
-                { 224,  27,  36 },
-                { 192,  28,  40 },
-                { 165,  29,  45 },
-                { 192,  97, 203 },
-                { 163,  71, 186 },
-                { 129,  61, 156 },
-                {  97,  53, 131 },
-                { 181, 131,  90 },
-                { 152, 106,  68 },
-                { 134,  94,  60 },
-                {  99,  69,  44 }
-        };
-
-        GdkRGBA color = { 255, 255, 255, 1.0 };
-        guint hash;
-        gint number_of_colors;
-        gint idx;
-
         if (name == NULL || strlen (name) == 0)
-                return color;
+                return -1;
+
+        return g_str_hash (name) % G_N_ELEMENTS (gnome_color_palette);
+}
+
+/* Rendered initials avatars are kept, keyed on what they are drawn from,
+ * up to a total size in bytes; the least recently used ones go first.
+ * The font description and layout are made once per size. Everything
+ * here is only used from the main thread.
+ */
+#define AVATAR_RENDER_CACHE_SIZE (8 * 1024 * 1024)
+
+typedef struct {
+        gchar           *key;
+        cairo_surface_t *surface;
+        gsize            bytes;
+        GList           *lru_link;
+} RenderedAvatar;
 
-        hash = g_str_hash (name);
-        number_of_colors = G_N_ELEMENTS (gnome_color_palette);
-        idx = hash % number_of_colors;
+typedef struct {
+        PangoFontDescription *font_desc;
+        PangoLayout          *layout;
+} AvatarFont;
+
+static GHashTable *rendered_avatars = NULL;
+static GQueue rendered_avatars_lru = G_QUEUE_INIT;
+static gsize rendered_avatars_bytes = 0;
+static GHashTable *avatar_fonts = NULL;
+
+static void
+rendered_avatar_free (RenderedAvatar *avatar)
+{
+        g_free (avatar->key);
+        cairo_surface_destroy (avatar->surface);
+        g_list_free_1 (avatar->lru_link);
+        g_free (avatar);
+}
+
+static void
+avatar_font_free (AvatarFont *font)
+{
+        pango_font_description_free (font->font_desc);
+        g_object_unref (font->layout);
+        g_free (font);
+}
+
+static AvatarFont *
+get_avatar_font (gint size)
+{
+        AvatarFont *font;
+
+        if (avatar_fonts == NULL)
+                avatar_fonts = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) avatar_font_free);
 
-        color.red   = gnome_color_palette[idx][0];
-        color.green = gnome_color_palette[idx][1];
-        color.blue  = gnome_color_palette[idx][2];
+        font = g_hash_table_lookup (avatar_fonts, GINT_TO_POINTER (size));
+        if (font == NULL) {
+                g_autoptr(PangoContext) context = NULL;
+
+                font = g_new0 (AvatarFont, 1);
+                font->font_desc = pango_font_description_new ();
+                pango_font_description_set_family_static (font->font_desc, "Sans");
+                pango_font_description_set_size (font->font_desc, (gint) ceil (size / 2.5) * PANGO_SCALE);
+
+                context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+                font->layout = pango_layout_new (context);
+                pango_layout_set_font_description (font->layout, font->font_desc);
+
+                g_hash_table_insert (avatar_fonts, GINT_TO_POINTER (size), font);
+        }
 
-        return color;
+        return font;
 }
 
 static cairo_surface_t *
-generate_user_picture (const gchar *name, gint size)
+draw_user_picture (const gchar *initials,
+                   gint         color_index,
+                   gint         size)
 {
-        PangoFontDescription *font_desc;
-        g_autofree gchar *initials = extract_initials_from_name (name);
-        g_autofree gchar *font = g_strdup_printf ("Sans %d", (int)ceil (size / 2.5));
-        PangoLayout *layout;
-        GdkRGBA color = get_color_for_name (name);
+        AvatarFont *font;
         cairo_surface_t *surface;
         gint width, height;
         cairo_t *cr;
@@ -384,26 +593,94 @@ generate_user_picture (const gchar *name, gint size)
                                               size);
         cr = cairo_create (surface);
         cairo_rectangle (cr, 0, 0, size, size);
-        cairo_set_source_rgb (cr, color.red/255.0, color.green/255.0, color.blue/255.0);
+        if (color_index < 0)
+                cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
+        else
+                cairo_set_source_rgb (cr,
+                                      gnome_color_palette[color_index][0] / 255.0,
+                                      gnome_color_palette[color_index][1] / 255.0,
+                                      gnome_color_palette[color_index][2] / 255.0);
         cairo_fill (cr);
 
         /* Draw the initials on top */
+        font = get_avatar_font (size);
         cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
-        layout = pango_cairo_create_layout (cr);
-        pango_layout_set_text (layout, initials, -1);
-        font_desc = pango_font_description_from_string (font);
-        pango_layout_set_font_description (layout, font_desc);
-        pango_font_description_free (font_desc);
+        pango_cairo_update_layout (cr, font->layout);
+        pango_layout_set_text (font->layout, initials, -1);
 
-        pango_layout_get_size (layout, &width, &height);
+        pango_layout_get_size (font->layout, &width, &height);
         cairo_translate (cr, size/2, size/2);
         cairo_move_to (cr, - ((double)width / PANGO_SCALE)/2, - ((double)height/PANGO_SCALE)/2);
-        pango_cairo_show_layout (cr, layout);
+        pango_cairo_show_layout (cr, font->layout);
         cairo_destroy (cr);
 
+        cairo_surface_flush (surface);
+
         return surface;
 }
 
+/**
+ * render_user_picture:
+ * @name: the name to take the initials and colour from
+ * @size: the size of the picture
+ *
+ * Draws the initials of @name on a coloured square, as used for the
+ * default avatar. The result may be shared with other callers and must
+ * not be drawn on.
+ *
+ * Returns: (transfer full): an image surface of @size × @size pixels
+ */
+cairo_surface_t *
+render_user_picture (const gchar *name,
+                     gint         size)
+{
+        g_autofree gchar *initials = NULL;
+        g_autofree gchar *key = NULL;
+        RenderedAvatar *avatar;
+        gint color_index;
+
+        g_return_val_if_fail (name != NULL, NULL);
+        g_return_val_if_fail (size > 0, NULL);
+
+        initials = extract_initials_from_name (name);
+        color_index = get_color_index_for_name (name);
+        key = g_strdup_printf ("%d:%d:%s", size, color_index, initials != NULL ? initials : "");
+
+        if (rendered_avatars == NULL)
+                rendered_avatars = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) rendered_avatar_free);
+
+        avatar = g_hash_table_lookup (rendered_avatars, key);
+        if (avatar != NULL) {
+                g_queue_unlink (&rendered_avatars_lru, avatar->lru_link);
+                g_queue_push_head_link (&rendered_avatars_lru, avatar->lru_link);
+
+                return cairo_surface_reference (avatar->surface);
+        }
+
+        avatar = g_new0 (RenderedAvatar, 1);
+        avatar->key = g_steal_pointer (&key);
+        avatar->surface = draw_user_picture (initials != NULL ? initials : "", color_index, size);
+        avatar->bytes = (gsize) cairo_image_surface_get_stride (avatar->surface) * size;
+        avatar->lru_link = g_list_alloc ();
+        avatar->lru_link->data = avatar;
+
+        g_queue_push_head_link (&rendered_avatars_lru, avatar->lru_link);
+        g_hash_table_insert (rendered_avatars, avatar->key, avatar);
+        rendered_avatars_bytes += avatar->bytes;
+
+        /* Always keep the one just drawn */
+        while (rendered_avatars_bytes > AVATAR_RENDER_CACHE_SIZE &&
+               rendered_avatars_lru.length > 1) {
+                RenderedAvatar *oldest = g_queue_peek_tail (&rendered_avatars_lru);
+
+                g_queue_unlink (&rendered_avatars_lru, oldest->lru_link);
+                rendered_avatars_bytes -= oldest->bytes;
+                g_hash_table_remove (rendered_avatars, oldest->key);
+        }
+
+        return cairo_surface_reference (avatar->surface);
+}
+
 void
 set_user_icon_data (ActUser   *user,
                     GdkPixbuf *pixbuf)
@@ -446,7 +723,7 @@ generate_default_avatar (ActUser *user, gint size)
         name = act_user_get_real_name (user);
         if (name == NULL)
                 name = "";
-        surface = generate_user_picture (name, size);
+        surface = render_user_picture (name, size);
 
         pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0, size, size);
         cairo_surface_destroy (surface);
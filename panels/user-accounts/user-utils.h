@@ -32,7 +32,6 @@ void     set_entry_validation_error       (GtkEntry    *entry,
 void     clear_entry_validation_error     (GtkEntry    *entry);
 
 gsize    get_username_max_length          (void);
-gboolean is_username_used                 (const gchar *username);
 gboolean is_valid_name                    (const gchar *name);
 void     is_valid_username_async          (const gchar *username,
                                            GCancellable *cancellable,
@@ -42,7 +41,14 @@ gboolean is_valid_username_finish         (GAsyncResult *result,
                                            gchar **tip,
                                            gchar **username,
                                            GError **error);
-GdkPixbuf *round_image                    (GdkPixbuf   *pixbuf);
+void     filter_used_usernames_async      (const gchar * const *usernames,
+                                           GCancellable *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer callback_data);
+GStrv    filter_used_usernames_finish     (GAsyncResult *result,
+                                           GError **error);
+cairo_surface_t *render_user_picture      (const gchar *name,
+                                           gint         size);
 GdkPixbuf *generate_default_avatar        (ActUser     *user,
                                            gint         size);
 void       set_default_avatar             (ActUser     *user);
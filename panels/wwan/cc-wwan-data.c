@@ -32,9 +32,9 @@
 #define _GNU_SOURCE
 #include <string.h>
 #include <glib/gi18n.h>
-#include <nma-mobile-providers.h>
 
 #include "cc-wwan-data.h"
+#include "cc-wwan-providers.h"
 
 /**
  * @short_description: Device Internet Data Object
@@ -80,8 +80,7 @@ struct _CcWwanData
 
   NMClient           *nm_client;
   NMDevice           *nm_device;
-  NMAMobileProvidersDatabase *apn_db;
-  NMAMobileProvider  *apn_provider;
+  GCancellable       *cancellable;
   CcWwanDataApn      *default_apn;
   CcWwanDataApn      *old_default_apn;
   GListStore         *apn_list;
@@ -134,7 +133,7 @@ struct _CcWwanDataApn {
   GObject parent_instance;
 
   /* Set if the APN is from the mobile-provider-info database */
-  NMAMobileAccessMethod *access_method;
+  const CcWwanProviderApn *access_method;
 
   /* Set if the APN is saved in NetworkManager */
   NMConnection *nm_connection;
@@ -202,8 +201,8 @@ wwan_data_get_nm_connection (CcWwanDataApn *apn)
 }
 
 static gboolean
-wwan_data_apn_are_same (CcWwanDataApn         *apn,
-                        NMAMobileAccessMethod *access_method)
+wwan_data_apn_are_same (CcWwanDataApn           *apn,
+                        const CcWwanProviderApn *access_method)
 {
   NMConnection *connection;
   NMSetting *setting;
@@ -214,110 +213,193 @@ wwan_data_apn_are_same (CcWwanDataApn         *apn,
   connection = NM_CONNECTION (apn->remote_connection);
   setting = NM_SETTING (nm_connection_get_setting_gsm (connection));
 
-  if (g_strcmp0 (nma_mobile_access_method_get_3gpp_apn (access_method),
+  if (g_strcmp0 (access_method->apn,
                  nm_setting_gsm_get_apn (NM_SETTING_GSM (setting))) != 0)
     return FALSE;
 
-  if (g_strcmp0 (nma_mobile_access_method_get_username (access_method),
+  if (g_strcmp0 (access_method->username,
                  nm_setting_gsm_get_username (NM_SETTING_GSM (setting))) != 0)
     return FALSE;
 
-  if (g_strcmp0 (nma_mobile_access_method_get_password (access_method),
+  /* The password getter never returns %NULL */
+  if (g_strcmp0 (access_method->password ? access_method->password : "",
                  cc_wwan_data_apn_get_password (apn)) != 0)
     return FALSE;
 
   return TRUE;
 }
 
-static CcWwanDataApn *
-wwan_data_find_matching_apn (CcWwanData            *self,
-                             NMAMobileAccessMethod *access_method)
+/*
+ * Looking up the password of a saved APN asks NetworkManager for its
+ * secrets, so saved APNs are hashed by APN and username, and only the
+ * few that match those are compared in full.
+ */
+typedef struct
+{
+  GHashTable *by_method;    /* CcWwanProviderApn → CcWwanDataApn */
+  GHashTable *by_settings;  /* APN and username → GPtrArray of CcWwanDataApn */
+} ApnIndex;
+
+static gchar *
+wwan_data_apn_key (const gchar *apn_name,
+                   const gchar *username)
+{
+  return g_strconcat (apn_name ? apn_name : "", "\n", username ? username : "", NULL);
+}
+
+static void
+wwan_data_apn_index_init (CcWwanData *self,
+                          ApnIndex   *index)
 {
-  CcWwanDataApn *apn;
   guint i, n_items;
 
+  index->by_method = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                            NULL, g_object_unref);
+  index->by_settings = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, (GDestroyNotify) g_ptr_array_unref);
+
   n_items = g_list_model_get_n_items (G_LIST_MODEL (self->apn_list));
 
   for (i = 0; i < n_items; i++)
     {
+      g_autoptr(CcWwanDataApn) apn = NULL;
+      g_autofree gchar *key = NULL;
+      NMSettingGsm *setting;
+      GPtrArray *apns;
+
       apn = g_list_model_get_item (G_LIST_MODEL (self->apn_list), i);
 
-      if (apn->access_method == access_method)
-        return apn;
+      if (apn->access_method && !g_hash_table_contains (index->by_method, apn->access_method))
+        g_hash_table_insert (index->by_method, (gpointer) apn->access_method, g_object_ref (apn));
 
-      if (wwan_data_apn_are_same (apn, access_method))
-        return apn;
+      if (!apn->remote_connection)
+        continue;
+
+      setting = nm_connection_get_setting_gsm (NM_CONNECTION (apn->remote_connection));
+      key = wwan_data_apn_key (nm_setting_gsm_get_apn (setting),
+                               nm_setting_gsm_get_username (setting));
+
+      apns = g_hash_table_lookup (index->by_settings, key);
+      if (!apns)
+        {
+          apns = g_ptr_array_new_with_free_func (g_object_unref);
+          g_hash_table_insert (index->by_settings, g_steal_pointer (&key), apns);
+        }
+
+      g_ptr_array_add (apns, g_object_ref (apn));
+    }
+}
+
+static void
+wwan_data_apn_index_clear (ApnIndex *index)
+{
+  g_clear_pointer (&index->by_method, g_hash_table_unref);
+  g_clear_pointer (&index->by_settings, g_hash_table_unref);
+}
+
+static CcWwanDataApn *
+wwan_data_find_matching_apn (ApnIndex                *index,
+                             const CcWwanProviderApn *access_method)
+{
+  g_autofree gchar *key = NULL;
+  CcWwanDataApn *apn;
+  GPtrArray *apns;
 
-      g_object_unref (apn);
+  apn = g_hash_table_lookup (index->by_method, access_method);
+  if (apn)
+    return g_object_ref (apn);
+
+  key = wwan_data_apn_key (access_method->apn, access_method->username);
+  apns = g_hash_table_lookup (index->by_settings, key);
+
+  for (guint i = 0; apns && i < apns->len; i++)
+    {
+      apn = g_ptr_array_index (apns, i);
+
+      if (wwan_data_apn_are_same (apn, access_method))
+        return g_object_ref (apn);
     }
 
   return NULL;
 }
 
 static gboolean
-wwan_data_nma_method_is_mms (NMAMobileAccessMethod *method)
+wwan_data_provider_apn_is_mms (const CcWwanProviderApn *method)
 {
-  const char *str;
-
-  str = nma_mobile_access_method_get_3gpp_apn (method);
-  if (str && strcasestr (str, "mms"))
+  if (method->apn && strcasestr (method->apn, "mms"))
     return TRUE;
 
-  str = nma_mobile_access_method_get_name (method);
-  if (str && strcasestr (str, "mms"))
+  if (method->name && strcasestr (method->name, "mms"))
     return TRUE;
 
   return FALSE;
 }
 
 static void
-wwan_data_update_apn_list_db (CcWwanData *self)
+wwan_data_provider_apns_ready_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
 {
-  GSList *apn_methods = NULL, *l;
+  g_autoptr(GPtrArray) new_apns = NULL;
   g_autoptr(GError) error = NULL;
-  guint i = 0;
-
-  if (!self->sim || !self->operator_code)
-    return;
+  const CcWwanProviderApn *methods;
+  CcWwanData *self;
+  ApnIndex index;
+  guint i, n_methods;
 
-  if (!self->apn_list)
-    self->apn_list = g_list_store_new (CC_TYPE_WWAN_DATA_APN);
+  methods = cc_wwan_providers_lookup_finish (result, &n_methods, &error);
 
-  if (!self->apn_db)
-    self->apn_db = nma_mobile_providers_database_new_sync (NULL, NULL, NULL, &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
 
-  if (error)
-    {
-      g_warning ("%s", error->message);
-      return;
-    }
+  self = CC_WWAN_DATA (user_data);
 
-  if (!self->apn_provider)
-    self->apn_provider = nma_mobile_providers_database_lookup_3gpp_mcc_mnc (self->apn_db,
-                                                                            self->operator_code);
+  if (error || n_methods == 0)
+    return;
 
-  if (self->apn_provider)
-    apn_methods = nma_mobile_provider_get_methods (self->apn_provider);
+  wwan_data_apn_index_init (self, &index);
+  new_apns = g_ptr_array_new_with_free_func (g_object_unref);
 
-  for (l = apn_methods; l; l = l->next, i++)
+  for (i = 0; i < n_methods; i++)
     {
       g_autoptr(CcWwanDataApn) apn = NULL;
 
       /* We don’t list MMS APNs */
-      if (wwan_data_nma_method_is_mms (l->data))
+      if (wwan_data_provider_apn_is_mms (&methods[i]))
         continue;
 
-      apn = wwan_data_find_matching_apn (self, l->data);
+      apn = wwan_data_find_matching_apn (&index, &methods[i]);
 
-      /* Prepend the item in order */
       if (!apn)
         {
           apn = cc_wwan_data_apn_new ();
-          g_list_store_insert (self->apn_list, i, apn);
+          g_ptr_array_add (new_apns, g_object_ref (apn));
         }
 
-      apn->access_method = l->data;
+      apn->access_method = &methods[i];
     }
+
+  wwan_data_apn_index_clear (&index);
+
+  /* Prepend the new items in order */
+  g_list_store_splice (self->apn_list, 0, 0, new_apns->pdata, new_apns->len);
+}
+
+static void
+wwan_data_update_apn_list_db (CcWwanData *self)
+{
+  if (!self->sim || !self->operator_code)
+    return;
+
+  if (!self->apn_list)
+    self->apn_list = g_list_store_new (CC_TYPE_WWAN_DATA_APN);
+
+  /* The provider database is shared by all modems, and loaded
+   * in a worker thread the first time */
+  cc_wwan_providers_lookup_async (self->operator_code,
+                                  self->cancellable,
+                                  wwan_data_provider_apns_ready_cb,
+                                  self);
 }
 
 static void
@@ -408,6 +490,8 @@ cc_wwan_data_dispose (GObject *object)
 {
   CcWwanData *self = (CcWwanData *)object;
 
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
   g_clear_pointer (&self->sim_id, g_free);
   g_clear_pointer (&self->operator_code, g_free);
   g_clear_error (&self->error);
@@ -416,7 +500,6 @@ cc_wwan_data_dispose (GObject *object)
   g_clear_object (&self->mm_object);
   g_clear_object (&self->nm_client);
   g_clear_object (&self->active_connection);
-  g_clear_object (&self->apn_db);
 
   G_OBJECT_CLASS (cc_wwan_data_parent_class)->dispose (object);
 }
@@ -451,6 +534,7 @@ cc_wwan_data_init (CcWwanData *self)
 {
   self->home_only = TRUE;
   self->priority = CC_WWAN_APN_PRIORITY_LOW;
+  self->cancellable = g_cancellable_new ();
 }
 
 /**
@@ -608,10 +692,10 @@ wwan_data_update_apn (CcWwanData    *self,
 
   if (apn->access_method && !apn->remote_connection)
     {
-      name = nma_mobile_access_method_get_name (apn->access_method);
-      username = nma_mobile_access_method_get_username (apn->access_method);
-      password = nma_mobile_access_method_get_password (apn->access_method);
-      apn_name = nma_mobile_access_method_get_3gpp_apn (apn->access_method);
+      name = apn->access_method->name;
+      username = apn->access_method->username;
+      password = apn->access_method->password;
+      apn_name = apn->access_method->apn;
     }
   else
     {
@@ -1142,8 +1226,6 @@ cc_wwan_data_apn_finalize (GObject *object)
   CcWwanDataApn *apn = CC_WWAN_DATA_APN (object);
 
   wwan_data_apn_reset (apn);
-  g_clear_pointer (&apn->access_method,
-                   nma_mobile_access_method_unref);
 
   G_OBJECT_CLASS (cc_wwan_data_parent_class)->finalize (object);
 }
@@ -1183,8 +1265,8 @@ cc_wwan_data_apn_get_name (CcWwanDataApn *apn)
   if (apn->remote_connection)
     return nm_connection_get_id (NM_CONNECTION (apn->remote_connection));
 
-  if (apn->access_method)
-    return nma_mobile_access_method_get_name (apn->access_method);
+  if (apn->access_method && apn->access_method->name)
+    return apn->access_method->name;
 
   return "";
 }
@@ -1246,7 +1328,7 @@ cc_wwan_data_apn_get_apn (CcWwanDataApn *apn)
     }
   else if (apn->access_method)
     {
-      apn_name = nma_mobile_access_method_get_3gpp_apn (apn->access_method);
+      apn_name = apn->access_method->apn;
     }
 
   return apn_name ? apn_name : "";
@@ -1311,7 +1393,7 @@ cc_wwan_data_apn_get_username (CcWwanDataApn *apn)
     }
   else if (apn->access_method)
     {
-      username = nma_mobile_access_method_get_username (apn->access_method);
+      username = apn->access_method->username;
     }
 
   return username ? username : "";
@@ -1393,7 +1475,7 @@ cc_wwan_data_apn_get_password (CcWwanDataApn *apn)
     }
   else if (apn->access_method)
     {
-      password = nma_mobile_access_method_get_password (apn->access_method);
+      password = apn->access_method->password;
     }
 
   return password ? password : "";
@@ -0,0 +1,673 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* cc-wwan-providers.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "cc-wwan-providers"
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "cc-wwan-providers.h"
+
+#ifndef MOBILE_BROADBAND_PROVIDER_INFO_DATABASE
+# define MOBILE_BROADBAND_PROVIDER_INFO_DATABASE "/usr/share/mobile-broadband-provider-info/serviceproviders.xml"
+#endif
+
+/*
+ * The mobile-broadband-provider-info database is a single XML file of
+ * a few megabytes, covering every provider in the world, while all we
+ * ever need from it are the access points of the one or two operators
+ * of the inserted SIMs.
+ *
+ * So it is loaded at most once per process, in a worker thread, and
+ * only the GSM access points are kept, grouped by provider and indexed
+ * by MCC/MNC. The result is also written to the user's cache directory
+ * in GVariant form, which can simply be mapped the next time, as long
+ * as the XML file has not changed since.
+ *
+ * Cache format: (version, XML path, XML mtime, XML size,
+ *                [(MCCMNC, first access point, number of access points)],
+ *                [(name, apn, username, password)])
+ */
+#define CACHE_VERSION 1
+#define CACHE_TYPE    "(ustta(suu)a(ssss))"
+
+typedef struct
+{
+  guint first;
+  guint n_apns;
+} ProviderRange;
+
+typedef struct
+{
+  GVariant          *data;    /* owns every string below */
+  CcWwanProviderApn *apns;
+  guint              n_apns;
+  ProviderRange     *ranges;
+  GHashTable        *index;   /* MCCMNC → ProviderRange */
+} CcWwanProviders;
+
+/* Only ever touched from the main thread */
+static CcWwanProviders *providers = NULL;
+static GPtrArray *waiting_tasks = NULL;
+
+static void
+providers_free (CcWwanProviders *self)
+{
+  g_clear_pointer (&self->index, g_hash_table_unref);
+  g_clear_pointer (&self->ranges, g_free);
+  g_clear_pointer (&self->apns, g_free);
+  g_clear_pointer (&self->data, g_variant_unref);
+  g_free (self);
+}
+
+static const gchar *
+nullable_string (const gchar *str)
+{
+  return (str && *str) ? str : NULL;
+}
+
+/* Takes ownership of @data, which must be in serialized form */
+static CcWwanProviders *
+providers_new (GVariant *data)
+{
+  g_autoptr(GVariant) codes = NULL;
+  g_autoptr(GVariant) apns = NULL;
+  CcWwanProviders *self;
+  GVariantIter iter;
+  const gchar *code;
+  guint first, n_apns;
+  guint i;
+
+  self = g_new0 (CcWwanProviders, 1);
+  self->data = data;
+
+  codes = g_variant_get_child_value (data, 4);
+  apns = g_variant_get_child_value (data, 5);
+
+  /* The strings point into the serialized data, which outlives the
+   * child values */
+  self->n_apns = g_variant_n_children (apns);
+  self->apns = g_new0 (CcWwanProviderApn, self->n_apns);
+
+  g_variant_iter_init (&iter, apns);
+  for (i = 0; i < self->n_apns; i++)
+    {
+      CcWwanProviderApn *apn = &self->apns[i];
+      const gchar *name, *apn_name, *username, *password;
+
+      g_variant_iter_next (&iter, "(&s&s&s&s)", &name, &apn_name, &username, &password);
+      apn->name = nullable_string (name);
+      apn->apn = nullable_string (apn_name);
+      apn->username = nullable_string (username);
+      apn->password = nullable_string (password);
+    }
+
+  self->ranges = g_new0 (ProviderRange, g_variant_n_children (codes));
+  self->index = g_hash_table_new (g_str_hash, g_str_equal);
+
+  g_variant_iter_init (&iter, codes);
+  for (i = 0; g_variant_iter_next (&iter, "(&suu)", &code, &first, &n_apns); i++)
+    {
+      /* The cache is not trusted to be sane */
+      if (first > self->n_apns || n_apns > self->n_apns - first)
+        continue;
+
+      self->ranges[i].first = first;
+      self->ranges[i].n_apns = n_apns;
+      g_hash_table_insert (self->index, (gpointer) code, &self->ranges[i]);
+    }
+
+  return self;
+}
+
+/* Parsing the XML database */
+
+typedef struct
+{
+  gchar *name;
+  gchar *apn;
+  gchar *username;
+  gchar *password;
+} ApnRecord;
+
+typedef struct
+{
+  GVariantBuilder  codes;
+  GVariantBuilder  apns;
+  guint            n_apns;
+  GHashTable      *seen_codes;
+
+  /* The current provider */
+  gboolean         in_provider;
+  gboolean         in_gsm;
+  gchar           *provider_name;
+  gboolean         provider_name_has_lang;
+  GPtrArray       *provider_codes;
+  guint            provider_first_apn;
+
+  /* The current access point */
+  gboolean         in_apn;
+  ApnRecord        apn;
+  gboolean         apn_name_has_lang;
+
+  GString         *text;
+  gboolean         text_has_lang;
+} ProvidersParser;
+
+static void
+apn_record_clear (ApnRecord *apn)
+{
+  g_clear_pointer (&apn->name, g_free);
+  g_clear_pointer (&apn->apn, g_free);
+  g_clear_pointer (&apn->username, g_free);
+  g_clear_pointer (&apn->password, g_free);
+}
+
+static const gchar *
+find_attribute (const gchar **names,
+                const gchar **values,
+                const gchar  *name)
+{
+  for (guint i = 0; names[i]; i++)
+    if (g_str_equal (names[i], name))
+      return values[i];
+
+  return NULL;
+}
+
+/* Names may come in several languages; keep the untranslated one,
+ * or else the first one */
+static void
+set_name (gchar           **name,
+          gboolean         *name_has_lang,
+          ProvidersParser  *parser)
+{
+  if (*name && (parser->text_has_lang || !*name_has_lang))
+    return;
+
+  g_free (*name);
+  *name = g_strstrip (g_strdup (parser->text->str));
+  *name_has_lang = parser->text_has_lang;
+}
+
+static void
+parser_start_element (GMarkupParseContext  *context,
+                      const gchar          *element_name,
+                      const gchar         **attribute_names,
+                      const gchar         **attribute_values,
+                      gpointer              user_data,
+                      GError              **error)
+{
+  ProvidersParser *parser = user_data;
+
+  g_string_truncate (parser->text, 0);
+  parser->text_has_lang = find_attribute (attribute_names, attribute_values, "xml:lang") != NULL;
+
+  if (g_str_equal (element_name, "provider"))
+    {
+      parser->in_provider = TRUE;
+      parser->provider_first_apn = parser->n_apns;
+      g_clear_pointer (&parser->provider_name, g_free);
+      g_ptr_array_set_size (parser->provider_codes, 0);
+    }
+  else if (parser->in_provider && g_str_equal (element_name, "gsm"))
+    {
+      parser->in_gsm = TRUE;
+    }
+  else if (parser->in_gsm && g_str_equal (element_name, "network-id"))
+    {
+      const gchar *mcc, *mnc;
+
+      mcc = find_attribute (attribute_names, attribute_values, "mcc");
+      mnc = find_attribute (attribute_names, attribute_values, "mnc");
+
+      if (mcc && mnc)
+        g_ptr_array_add (parser->provider_codes, g_strconcat (mcc, mnc, NULL));
+    }
+  else if (parser->in_gsm && g_str_equal (element_name, "apn"))
+    {
+      parser->in_apn = TRUE;
+      apn_record_clear (&parser->apn);
+      parser->apn.apn = g_strdup (find_attribute (attribute_names, attribute_values, "value"));
+    }
+}
+
+static void
+parser_end_element (GMarkupParseContext  *context,
+                    const gchar          *element_name,
+                    gpointer              user_data,
+                    GError              **error)
+{
+  ProvidersParser *parser = user_data;
+
+  if (parser->in_apn)
+    {
+      if (g_str_equal (element_name, "name"))
+        {
+          set_name (&parser->apn.name, &parser->apn_name_has_lang, parser);
+        }
+      else if (g_str_equal (element_name, "username"))
+        {
+          g_free (parser->apn.username);
+          parser->apn.username = g_strstrip (g_strdup (parser->text->str));
+        }
+      else if (g_str_equal (element_name, "password"))
+        {
+          g_free (parser->apn.password);
+          parser->apn.password = g_strstrip (g_strdup (parser->text->str));
+        }
+      else if (g_str_equal (element_name, "apn"))
+        {
+          const gchar *name;
+
+          /* Access points without a name go by their provider's */
+          name = parser->apn.name ? parser->apn.name : parser->provider_name;
+
+          g_variant_builder_add (&parser->apns, "(ssss)",
+                                 name ? name : "",
+                                 parser->apn.apn ? parser->apn.apn : "",
+                                 parser->apn.username ? parser->apn.username : "",
+                                 parser->apn.password ? parser->apn.password : "");
+          parser->n_apns++;
+
+          apn_record_clear (&parser->apn);
+          parser->in_apn = FALSE;
+        }
+    }
+  else if (parser->in_gsm)
+    {
+      if (g_str_equal (element_name, "gsm"))
+        parser->in_gsm = FALSE;
+    }
+  else if (parser->in_provider)
+    {
+      if (g_str_equal (element_name, "name"))
+        {
+          set_name (&parser->provider_name, &parser->provider_name_has_lang, parser);
+        }
+      else if (g_str_equal (element_name, "provider"))
+        {
+          /* Like NetworkManager, the first provider with a given
+           * MCC/MNC wins */
+          for (guint i = 0; i < parser->provider_codes->len; i++)
+            {
+              gchar *code = g_ptr_array_index (parser->provider_codes, i);
+
+              if (g_hash_table_contains (parser->seen_codes, code))
+                continue;
+
+              g_hash_table_add (parser->seen_codes, g_strdup (code));
+              g_variant_builder_add (&parser->codes, "(suu)",
+                                     code,
+                                     parser->provider_first_apn,
+                                     parser->n_apns - parser->provider_first_apn);
+            }
+
+          parser->in_provider = FALSE;
+        }
+    }
+
+  g_string_truncate (parser->text, 0);
+}
+
+static void
+parser_text (GMarkupParseContext  *context,
+             const gchar          *text,
+             gsize                 text_len,
+             gpointer              user_data,
+             GError              **error)
+{
+  ProvidersParser *parser = user_data;
+
+  g_string_append_len (parser->text, text, text_len);
+}
+
+static const GMarkupParser providers_markup_parser = {
+  parser_start_element,
+  parser_end_element,
+  parser_text,
+  NULL,
+  NULL,
+};
+
+static GVariant *
+providers_parse (const gchar  *path,
+                 guint64       mtime,
+                 guint64       size,
+                 GError      **error)
+{
+  g_autoptr(GMarkupParseContext) context = NULL;
+  g_autoptr(GVariant) data = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autofree gchar *contents = NULL;
+  ProvidersParser parser = { 0, };
+  gsize length;
+  gboolean success;
+
+  if (!g_file_get_contents (path, &contents, &length, error))
+    return NULL;
+
+  g_variant_builder_init (&parser.codes, G_VARIANT_TYPE ("a(suu)"));
+  g_variant_builder_init (&parser.apns, G_VARIANT_TYPE ("a(ssss)"));
+  parser.seen_codes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  parser.provider_codes = g_ptr_array_new_with_free_func (g_free);
+  parser.text = g_string_new (NULL);
+
+  context = g_markup_parse_context_new (&providers_markup_parser, 0, &parser, NULL);
+  success = g_markup_parse_context_parse (context, contents, length, error) &&
+            g_markup_parse_context_end_parse (context, error);
+
+  if (success)
+    {
+      data = g_variant_new (CACHE_TYPE,
+                            CACHE_VERSION,
+                            path,
+                            mtime,
+                            size,
+                            &parser.codes,
+                            &parser.apns);
+      g_variant_ref_sink (data);
+    }
+  else
+    {
+      g_variant_builder_clear (&parser.codes);
+      g_variant_builder_clear (&parser.apns);
+    }
+
+  apn_record_clear (&parser.apn);
+  g_free (parser.provider_name);
+  g_hash_table_unref (parser.seen_codes);
+  g_ptr_array_unref (parser.provider_codes);
+  g_string_free (parser.text, TRUE);
+
+  if (!success)
+    return NULL;
+
+  /* Make sure the strings handed out point into one serialized blob */
+  bytes = g_variant_get_data_as_bytes (data);
+
+  return g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, TRUE));
+}
+
+/* The on-disk cache */
+
+static gchar *
+get_cache_path (void)
+{
+  return g_build_filename (g_get_user_cache_dir (),
+                           "gnome-control-center",
+                           "wwan",
+                           "serviceproviders.cache",
+                           NULL);
+}
+
+static GVariant *
+cache_load (const gchar *cache_path,
+            const gchar *path,
+            guint64      mtime,
+            guint64      size)
+{
+  g_autoptr(GMappedFile) mapped = NULL;
+  g_autoptr(GVariant) data = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  const gchar *cached_path;
+  guint64 cached_mtime, cached_size;
+  guint32 version;
+
+  mapped = g_mapped_file_new (cache_path, FALSE, NULL);
+  if (!mapped)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  data = g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE);
+  g_variant_ref_sink (data);
+
+  g_variant_get (data, "(u&stt@a(suu)@a(ssss))",
+                 &version, &cached_path, &cached_mtime, &cached_size, NULL, NULL);
+
+  if (version != CACHE_VERSION ||
+      g_strcmp0 (cached_path, path) != 0 ||
+      cached_mtime != mtime ||
+      cached_size != size)
+    return NULL;
+
+  /* The access points point straight into the file, which is only
+   * guaranteed to be safe for data in normal form. Anything else gets
+   * reparsed and the cache rewritten. */
+  if (!g_variant_is_normal_form (data))
+    return NULL;
+
+  return g_steal_pointer (&data);
+}
+
+static void
+cache_save (const gchar *cache_path,
+            GVariant    *data)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *dir = NULL;
+
+  dir = g_path_get_dirname (cache_path);
+
+  /* The file is replaced atomically, so it is safe for others to have
+   * the old one mapped */
+  if (g_mkdir_with_parents (dir, 0700) != 0 ||
+      !g_file_set_contents (cache_path,
+                            g_variant_get_data (data),
+                            g_variant_get_size (data),
+                            &error))
+    g_debug ("Failed to write the provider cache %s: %s",
+             cache_path, error ? error->message : g_strerror (errno));
+}
+
+static CcWwanProviders *
+providers_load (GError **error)
+{
+  g_autoptr(GFileInfo) info = NULL;
+  g_autoptr(GFile) file = NULL;
+  g_autofree gchar *cache_path = NULL;
+  const gchar *path = MOBILE_BROADBAND_PROVIDER_INFO_DATABASE;
+  CcWwanProviders *self;
+  GVariant *data;
+  guint64 mtime, size;
+  gint64 start_time;
+
+  start_time = g_get_monotonic_time ();
+
+  file = g_file_new_for_path (path);
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL,
+                            error);
+  if (!info)
+    return NULL;
+
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+          g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  size = g_file_info_get_size (info);
+
+  cache_path = get_cache_path ();
+  data = cache_load (cache_path, path, mtime, size);
+
+  if (!data)
+    {
+      data = providers_parse (path, mtime, size, error);
+      if (!data)
+        return NULL;
+
+      cache_save (cache_path, data);
+    }
+
+  self = providers_new (data);
+
+  g_debug ("Loaded %u access points for %u operator codes in %" G_GINT64_FORMAT " ms",
+           self->n_apns,
+           g_hash_table_size (self->index),
+           (g_get_monotonic_time () - start_time) / 1000);
+
+  return self;
+}
+
+static void
+providers_load_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  CcWwanProviders *self;
+  GError *error = NULL;
+
+  self = providers_load (&error);
+
+  if (self)
+    g_task_return_pointer (task, self, (GDestroyNotify) providers_free);
+  else
+    g_task_return_error (task, error);
+}
+
+static void
+providers_loaded_cb (GObject      *object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  g_autoptr(GPtrArray) tasks = g_steal_pointer (&waiting_tasks);
+  g_autoptr(GError) error = NULL;
+
+  /* Kept for the lifetime of the process. On failure, the next
+   * lookup tries again */
+  providers = g_task_propagate_pointer (G_TASK (result), &error);
+
+  if (error)
+    g_warning ("Failed to load the mobile provider database: %s", error->message);
+
+  for (guint i = 0; i < tasks->len; i++)
+    {
+      GTask *task = g_ptr_array_index (tasks, i);
+
+      if (error)
+        g_task_return_error (task, g_error_copy (error));
+      else
+        g_task_return_pointer (task, providers, NULL);
+    }
+}
+
+/**
+ * cc_wwan_providers_lookup_async:
+ * @mccmnc: the operator code of a SIM
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: a #GAsyncReadyCallback
+ * @user_data: user data for @callback
+ *
+ * Looks up the access points known for @mccmnc. The provider database
+ * is loaded in a worker thread by the first lookup, which every other
+ * lookup made in the meantime waits for; afterwards, lookups complete
+ * right away.
+ */
+void
+cc_wwan_providers_lookup_async (const gchar         *mccmnc,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  g_autoptr(GTask) load_task = NULL;
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (mccmnc != NULL);
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_wwan_providers_lookup_async);
+  g_task_set_task_data (task, g_strdup (mccmnc), g_free);
+
+  if (providers)
+    {
+      g_task_return_pointer (task, providers, NULL);
+      return;
+    }
+
+  if (waiting_tasks)
+    {
+      g_ptr_array_add (waiting_tasks, g_steal_pointer (&task));
+      return;
+    }
+
+  waiting_tasks = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (waiting_tasks, g_steal_pointer (&task));
+
+  load_task = g_task_new (NULL, NULL, providers_loaded_cb, NULL);
+  g_task_set_source_tag (load_task, providers_load);
+  g_task_run_in_thread (load_task, providers_load_thread);
+}
+
+/**
+ * cc_wwan_providers_lookup_finish:
+ * @result: a #GAsyncResult
+ * @n_apns: (out): return location for the number of access points
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes a lookup started with cc_wwan_providers_lookup_async().
+ * An MCC/MNC with a three digit MNC also matches a provider listed
+ * with the first two digits only, like NetworkManager does.
+ *
+ * Returns: (transfer none) (array length=n_apns) (nullable): the
+ *   access points of the provider, in database order, or %NULL if
+ *   there are none or on error
+ */
+const CcWwanProviderApn *
+cc_wwan_providers_lookup_finish (GAsyncResult  *result,
+                                 guint         *n_apns,
+                                 GError       **error)
+{
+  CcWwanProviders *self;
+  ProviderRange *range;
+  const gchar *mccmnc;
+
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+  g_return_val_if_fail (n_apns != NULL, NULL);
+
+  *n_apns = 0;
+
+  self = g_task_propagate_pointer (G_TASK (result), error);
+  if (!self)
+    return NULL;
+
+  mccmnc = g_task_get_task_data (G_TASK (result));
+  range = g_hash_table_lookup (self->index, mccmnc);
+
+  if (!range && strlen (mccmnc) == 6)
+    {
+      g_autofree gchar *mccmnc_2 = g_strndup (mccmnc, 5);
+
+      range = g_hash_table_lookup (self->index, mccmnc_2);
+    }
+
+  if (!range || range->n_apns == 0)
+    return NULL;
+
+  *n_apns = range->n_apns;
+
+  return &self->apns[range->first];
+}
@@ -0,0 +1,47 @@
+/* -*- Mode: C; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* cc-wwan-providers.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * A GSM access point from the mobile-broadband-provider-info
+ * database. Unset fields are %NULL. Entries live as long as the
+ * process and must not be modified.
+ */
+typedef struct
+{
+  const gchar *name;
+  const gchar *apn;
+  const gchar *username;
+  const gchar *password;
+} CcWwanProviderApn;
+
+void                     cc_wwan_providers_lookup_async  (const gchar          *mccmnc,
+                                                          GCancellable         *cancellable,
+                                                          GAsyncReadyCallback   callback,
+                                                          gpointer              user_data);
+const CcWwanProviderApn *cc_wwan_providers_lookup_finish (GAsyncResult         *result,
+                                                          guint                *n_apns,
+                                                          GError              **error);
+
+G_END_DECLS
@@ -36,6 +36,14 @@ typedef struct
   gchar              *description;
   gchar             **keywords;
   CcPanelVisibility   visibility;
+
+  /* Normalized and stripped, for searching */
+  gchar              *search_name;
+  gchar              *search_description;
+
+  /* Result for the current search query */
+  gboolean            search_match;
+  gint                search_distance;
 } RowData;
 
 struct _CcPanelList
@@ -56,6 +64,7 @@ struct _CcPanelList
 
   gchar              *current_panel_id;
   gchar              *search_query;
+  gchar              *normalized_search_query;
 
   CcPanelListView     previous_view;
   CcPanelListView     view;
@@ -209,9 +218,53 @@ switch_to_view (CcPanelList     *self,
   CC_EXIT;
 }
 
+static void
+update_row_search (CcPanelList *self,
+                   RowData     *data)
+{
+  const gchar *search = self->normalized_search_query;
+  const gchar *match;
+  gint i;
+
+  data->search_match = TRUE;
+  data->search_distance = G_MAXINT;
+
+  if (!search)
+    return;
+
+  match = strstr (data->search_name, search);
+  if (match)
+    data->search_distance = match - data->search_name;
+
+  if (match || (data->search_description && strstr (data->search_description, search)))
+    return;
+
+  for (i = 0; data->keywords[i] != NULL; i++)
+    {
+      if (g_str_has_prefix (data->keywords[i], search))
+        return;
+    }
+
+  data->search_match = FALSE;
+}
+
 static void
 update_search (CcPanelList *self)
 {
+  GHashTableIter iter;
+  RowData *data;
+
+  g_clear_pointer (&self->normalized_search_query, g_free);
+  if (self->search_query)
+    {
+      self->normalized_search_query = cc_util_normalize_casefold_and_unaccent (self->search_query);
+      g_strstrip (self->normalized_search_query);
+    }
+
+  g_hash_table_iter_init (&iter, self->id_to_search_data);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &data))
+    update_row_search (self, data);
+
   /*
    * Only change to the search view is there's a
    * search query available.
@@ -265,6 +318,8 @@ static void
 row_data_free (RowData *data)
 {
   g_strfreev (data->keywords);
+  g_free (data->search_description);
+  g_free (data->search_name);
   g_free (data->description);
   g_free (data->name);
   g_free (data->id);
@@ -291,6 +346,9 @@ row_data_new (CcPanelCategory     category,
   data->name = g_strdup (name);
   data->description = g_strdup (description);
   data->keywords = g_strdupv (keywords);
+  data->search_name = g_strstrip (cc_util_normalize_casefold_and_unaccent (name));
+  if (description)
+    data->search_description = g_strstrip (cc_util_normalize_casefold_and_unaccent (description));
 
   /* Setup the row */
   grid = gtk_grid_new ();
@@ -349,11 +407,6 @@ filter_func (GtkListBoxRow *row,
 {
   CcPanelList *self;
   RowData *data;
-  g_autofree gchar *search_text = NULL;
-  g_autofree gchar *panel_text = NULL;
-  g_autofree gchar *panel_description = NULL;
-  gboolean retval = FALSE;
-  gint i;
 
   self = CC_PANEL_LIST (user_data);
   data = g_object_get_data (G_OBJECT (row), "data");
@@ -361,27 +414,14 @@ filter_func (GtkListBoxRow *row,
   if (!self->search_query)
     return TRUE;
 
-  panel_text = cc_util_normalize_casefold_and_unaccent (data->name);
-  search_text = cc_util_normalize_casefold_and_unaccent (self->search_query);
-  panel_description = cc_util_normalize_casefold_and_unaccent (data->description);
-
-  g_strstrip (panel_text);
-  g_strstrip (search_text);
-  g_strstrip (panel_description);
-
   /*
    * The description label is only visible when the search is
    * happening.
    */
   gtk_widget_set_visible (data->description_label, self->view == CC_PANEL_LIST_SEARCH);
 
-  for (i = 0; !retval && data->keywords[i] != NULL; i++)
-      retval = (strstr (data->keywords[i], search_text) == data->keywords[i]);
-
-  retval = retval || g_strstr_len (panel_text, -1, search_text) != NULL ||
-           g_strstr_len (panel_description, -1, search_text) != NULL;
-
-  return retval;
+  /* Computed once per query by update_search() */
+  return data->search_match;
 }
 
 static const gchar * const panel_order[] = {
@@ -466,44 +506,19 @@ search_sort_function (GtkListBoxRow *a,
 {
   CcPanelList *self;
   RowData *a_data, *b_data;
-  g_autofree gchar *a_name = NULL;
-  g_autofree gchar *b_name = NULL;
-  g_autofree gchar *search = NULL;
-  gchar *a_strstr, *b_strstr;
-  gint a_distance, b_distance;
+  const gchar *search;
 
   self = CC_PANEL_LIST (user_data);
-  search = NULL;
+  search = self->normalized_search_query;
   a_data = g_object_get_data (G_OBJECT (a), "data");
   b_data = g_object_get_data (G_OBJECT (b), "data");
 
-  a_distance = b_distance = G_MAXINT;
-
-  a_name = cc_util_normalize_casefold_and_unaccent (a_data->name);
-  b_name = cc_util_normalize_casefold_and_unaccent (b_data->name);
-  g_strstrip (a_name);
-  g_strstrip (b_name);
-
-  if (self->search_query)
-    {
-      search = cc_util_normalize_casefold_and_unaccent (self->search_query);
-      g_strstrip (search);
-    }
-
   /* Default result for empty search */
-  if (!search || g_utf8_strlen (search, -1) == 0)
-    return g_strcmp0 (a_name, b_name);
-
-  a_strstr = g_strstr_len (a_name, -1, search);
-  b_strstr = g_strstr_len (b_name, -1, search);
-
-  if (a_strstr)
-    a_distance = g_strstr_len (a_name, -1, search) - a_name;
-
-  if (b_strstr)
-    b_distance = g_strstr_len (b_name, -1, search) - b_name;
+  if (!search || *search == '\0')
+    return g_strcmp0 (a_data->search_name, b_data->search_name);
 
-  return a_distance - b_distance;
+  /* Distances are computed once per query by update_search() */
+  return a_data->search_distance - b_data->search_distance;
 }
 
 static void
@@ -660,6 +675,7 @@ cc_panel_list_finalize (GObject *object)
   CcPanelList *self = (CcPanelList *)object;
 
   g_clear_pointer (&self->search_query, g_free);
+  g_clear_pointer (&self->normalized_search_query, g_free);
   g_clear_pointer (&self->current_panel_id, g_free);
   g_clear_pointer (&self->id_to_data, g_hash_table_destroy);
   g_clear_pointer (&self->id_to_search_data, g_hash_table_destroy);
@@ -959,6 +975,7 @@ cc_panel_list_add_panel (CcPanelList        *self,
   /* And add to the search listbox too */
   search_data = row_data_new (category, id, title, description, keywords, icon, visibility, has_sidebar);
   gtk_widget_set_visible (search_data->row, visibility != CC_PANEL_HIDDEN);
+  update_row_search (self, search_data);
 
   gtk_list_box_append (GTK_LIST_BOX (self->search_listbox), search_data->row);
 
@@ -0,0 +1,201 @@
+#include "config.h"
+
+#include <glib.h>
+#include <locale.h>
+#include <string.h>
+
+#include "cc-util.h"
+
+#define IS_CDM_UCS4(c) (((c) >= 0x0300 && (c) <= 0x036F)  || \
+                        ((c) >= 0x1DC0 && (c) <= 0x1DFF)  || \
+                        ((c) >= 0x20D0 && (c) <= 0x20FF)  || \
+                        ((c) >= 0xFE20 && (c) <= 0xFE2F))
+
+#define IS_SOFT_HYPHEN(c) ((c) == 0x00AD)
+
+/* The implementation cc_util_normalize_casefold_and_unaccent() used to
+ * have, before it grew its fast paths. Results must stay identical. */
+static char *
+reference_normalize (const char *str)
+{
+  g_autofree gchar *normalized = NULL;
+  gchar *tmp;
+  int i = 0, j = 0, ilen;
+
+  normalized = g_utf8_normalize (str, -1, G_NORMALIZE_NFKD);
+  tmp = g_utf8_casefold (normalized, -1);
+
+  ilen = strlen (tmp);
+
+  while (i < ilen)
+    {
+      gunichar unichar;
+      gint utf8_len;
+
+      unichar = g_utf8_get_char_validated (&tmp[i], -1);
+      if (unichar == (gunichar) -1 ||
+          unichar == (gunichar) -2)
+        break;
+
+      utf8_len = g_utf8_next_char (&tmp[i]) - &tmp[i];
+
+      if (IS_CDM_UCS4 (unichar) || IS_SOFT_HYPHEN (unichar))
+        {
+          i += utf8_len;
+          continue;
+        }
+
+      if (i != j)
+        memmove (&tmp[j], &tmp[i], utf8_len);
+
+      i += utf8_len;
+      j += utf8_len;
+    }
+
+  tmp[j] = '\0';
+
+  return tmp;
+}
+
+static const char *samples[] = {
+  /* Panel names, keywords and descriptions */
+  "Wi-Fi", "Network", "Bluetooth", "Background", "Appearance",
+  "Notifications", "Search", "Multitasking", "Applications", "Privacy",
+  "Online Accounts", "Sharing", "Sound", "Power", "Displays",
+  "Mouse & Touchpad", "Keyboard Shortcuts", "Printers", "Removable Media",
+  "Color", "Region & Language", "Accessibility", "Users", "Default Applications",
+  "Date & Time", "About", "Thunderbolt", "Wacom Tablet", "Mobile Network",
+  "Hintergrund", "Benachrichtigungen", "Barrierefreiheit", "Energie",
+  "Réseau", "Arrière-plan", "Confidentialité", "Accessibilité",
+  "Área de trabajo", "Configuración regional", "Énergie", "Ñandú",
+  "Łączność", "Dźwięk", "Zasilanie", "Ekrany", "Użytkownicy",
+  "Tiếng Việt", "Ελληνικά", "Русский", "Українська", "日本語", "中文 (中国)",
+  "한국어", "العربية", "עברית", "हिन्दी", "ภาษาไทย",
+  /* Locale names */
+  "English (United States)", "Deutsch (Deutschland)", "Français (France)",
+  "Español (España)", "Português (Brasil)", "Norsk bokmål (Norge)",
+  "Türkçe (Türkiye)", "Čeština (Česko)", "Magyar (Magyarország)",
+  "Íslenska (Ísland)", "Føroyskt (Føroyar)", "Kalaallisut (Kalaallit Nunaat)",
+  "Straße", "ǅemal", "ǰ", "İstanbul", "ſtraße", "ŉ", "½ ¼ ¾", "ª º µ",
+  /* Characters that must go through the full normalization */
+  "e\xcc\x81", "ﬁle", "Ⅻ", "ｆｕｌｌｗｉｄｔｈ", "x\xc2\xad" "y", "\xe2\x84\xab",
+  "", " ", "ABC xyz 0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~",
+};
+
+static void
+check (const char *str,
+       GString    *buffer)
+{
+  g_autofree gchar *expected = reference_normalize (str);
+  g_autofree gchar *result = cc_util_normalize_casefold_and_unaccent (str);
+
+  g_assert_cmpstr (result, ==, expected);
+  g_assert_cmpstr (cc_util_normalize_casefold_and_unaccent_into (str, buffer), ==, expected);
+  g_assert_cmpuint (buffer->len, ==, strlen (expected));
+}
+
+static void
+test_normalize_samples (void)
+{
+  g_autoptr(GString) buffer = g_string_new (NULL);
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (samples); i++)
+    check (samples[i], buffer);
+
+  /* Concatenations mix the fast and slow paths within one string */
+  for (i = 0; i < G_N_ELEMENTS (samples); i++)
+    for (j = 0; j < G_N_ELEMENTS (samples); j++)
+      {
+        g_autofree gchar *str = g_strconcat (samples[i], samples[j], NULL);
+        check (str, buffer);
+      }
+}
+
+static void
+test_normalize_code_points (void)
+{
+  g_autoptr(GString) buffer = g_string_new (NULL);
+  gunichar c;
+
+  for (c = 1; c < 0x3000; c++)
+    {
+      gchar str[16];
+      gint len;
+
+      if (!g_unichar_validate (c))
+        continue;
+
+      /* On its own, and surrounded by ASCII and Latin characters */
+      len = g_unichar_to_utf8 (c, str);
+      str[len] = '\0';
+      check (str, buffer);
+
+      len = g_unichar_to_utf8 (c, str + 1);
+      str[0] = 'A';
+      memcpy (str + 1 + len, "\xc3\x89z", 4);
+      check (str, buffer);
+    }
+}
+
+static void
+test_normalize_null (void)
+{
+  g_autoptr(GString) buffer = g_string_new ("stale");
+
+  g_assert_null (cc_util_normalize_casefold_and_unaccent (NULL));
+  g_assert_null (cc_util_normalize_casefold_and_unaccent_into (NULL, buffer));
+  g_assert_cmpuint (buffer->len, ==, 0);
+}
+
+static void
+test_normalize_perf (void)
+{
+  g_autoptr(GString) buffer = g_string_new (NULL);
+  g_autoptr(GTimer) timer = g_timer_new ();
+  const guint iterations = 2000;
+  gdouble reference, allocating, into;
+  guint i, j;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Only run in performance mode");
+      return;
+    }
+
+  g_timer_start (timer);
+  for (i = 0; i < iterations; i++)
+    for (j = 0; j < G_N_ELEMENTS (samples); j++)
+      g_free (reference_normalize (samples[j]));
+  reference = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < iterations; i++)
+    for (j = 0; j < G_N_ELEMENTS (samples); j++)
+      g_free (cc_util_normalize_casefold_and_unaccent (samples[j]));
+  allocating = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < iterations; i++)
+    for (j = 0; j < G_N_ELEMENTS (samples); j++)
+      cc_util_normalize_casefold_and_unaccent_into (samples[j], buffer);
+  into = g_timer_elapsed (timer, NULL);
+
+  g_test_message ("%u strings: reference %.3fs, normalize %.3fs, normalize_into %.3fs",
+                  iterations * (guint) G_N_ELEMENTS (samples), reference, allocating, into);
+  g_test_minimized_result (allocating, "normalize %.3fs", allocating);
+  g_test_minimized_result (into, "normalize_into %.3fs", into);
+}
+
+int main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/common/util/normalize-samples", test_normalize_samples);
+  g_test_add_func ("/common/util/normalize-code-points", test_normalize_code_points);
+  g_test_add_func ("/common/util/normalize-null", test_normalize_null);
+  g_test_add_func ("/common/util/normalize-perf", test_normalize_perf);
+
+  return g_test_run ();
+}
@@ -0,0 +1,401 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Builds CcDisplayConfigDBus from GetCurrentState payloads stored in
+ * files, without a compositor, and checks what the panel derives from
+ * them. Run with -m perf to get timings.
+ */
+
+#include <config.h>
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "cc-display-config-dbus.h"
+
+#define CURRENT_STATE_TYPE "(ua((ssss)a(siiddada{sv})a{sv})a(iiduba(ssss)a{sv})a{sv})"
+
+#define MIN_WIDTH  800
+#define MIN_HEIGHT 600
+
+static const char *states[] = {
+  "single-laptop",
+  "laptop-dock",
+  "mirrored",
+  "quad-4k",
+  "video-wall",
+};
+
+static GVariant *
+load_state (const char *name)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *path = NULL;
+  g_autofree gchar *contents = NULL;
+  GVariant *state;
+
+  path = g_strdup_printf (TEST_SRCDIR "/%s.txt", name);
+  g_file_get_contents (path, &contents, NULL, &error);
+  g_assert_no_error (error);
+
+  state = g_variant_parse (G_VARIANT_TYPE (CURRENT_STATE_TYPE), contents, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  return g_variant_ref_sink (state);
+}
+
+static CcDisplayConfig *
+new_config (GVariant *state)
+{
+  return g_object_new (CC_TYPE_DISPLAY_CONFIG_DBUS, "state", state, NULL);
+}
+
+static gboolean
+monitor_has_resolution (CcDisplayMonitor *monitor,
+                        int               width,
+                        int               height,
+                        gboolean          interlaced,
+                        CcDisplayMode   **first_mode)
+{
+  GList *l;
+
+  for (l = cc_display_monitor_get_modes (monitor); l; l = l->next)
+    {
+      CcDisplayMode *mode = l->data;
+      int w, h;
+
+      cc_display_mode_get_resolution (mode, &w, &h);
+      if (w == width && h == height && cc_display_mode_is_interlaced (mode) == interlaced)
+        {
+          if (first_mode)
+            *first_mode = mode;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static gboolean
+mode_has_scale (CcDisplayMode *mode,
+                double         scale)
+{
+  g_autoptr(GArray) scales = cc_display_mode_get_supported_scales (mode);
+  guint i;
+
+  for (i = 0; i < scales->len; i++)
+    if (G_APPROX_VALUE (g_array_index (scales, double, i), scale, DBL_EPSILON))
+      return TRUE;
+
+  return FALSE;
+}
+
+static void
+check_construction (CcDisplayConfig *config,
+                    GVariant        *state)
+{
+  g_autoptr(GVariant) monitors = g_variant_get_child_value (state, 1);
+  GList *l;
+
+  g_assert_cmpuint (g_list_length (cc_display_config_get_monitors (config)), ==,
+                    g_variant_n_children (monitors));
+
+  for (l = cc_display_config_get_monitors (config); l; l = l->next)
+    {
+      CcDisplayMonitor *monitor = l->data;
+
+      g_assert_nonnull (cc_display_monitor_get_modes (monitor));
+      g_assert_nonnull (cc_display_monitor_get_connector_name (monitor));
+
+      if (cc_display_monitor_is_active (monitor))
+        g_assert_nonnull (cc_display_monitor_get_mode (monitor));
+    }
+}
+
+static void
+check_scaled_modes (CcDisplayConfig *config)
+{
+  GList *l, *ll;
+
+  cc_display_config_set_minimum_size (config, MIN_WIDTH, MIN_HEIGHT);
+
+  for (l = cc_display_config_get_monitors (config); l; l = l->next)
+    {
+      CcDisplayMonitor *monitor = l->data;
+
+      for (ll = cc_display_monitor_get_modes (monitor); ll; ll = ll->next)
+        {
+          CcDisplayMode *mode = ll->data;
+          int w, h;
+
+          if (mode == cc_display_monitor_get_mode (monitor) ||
+              mode == cc_display_monitor_get_preferred_mode (monitor))
+            continue;
+
+          cc_display_mode_get_resolution (mode, &w, &h);
+          g_assert_cmpint (MAX (w, h), >=, MIN_WIDTH);
+          g_assert_cmpint (MIN (w, h), >=, MIN_HEIGHT);
+        }
+    }
+}
+
+static void
+check_cloning_modes (CcDisplayConfig *config)
+{
+  g_autolist(CcDisplayMode) clone_modes = NULL;
+  CcDisplayMonitor *base_monitor = NULL;
+  guint n_expected = 0, n_preferred = 0;
+  GList *l, *ll;
+
+  for (l = cc_display_config_get_monitors (config); l; l = l->next)
+    if (cc_display_monitor_is_active (l->data))
+      {
+        base_monitor = l->data;
+        break;
+      }
+
+  clone_modes = cc_display_config_generate_cloning_modes (config);
+  if (!base_monitor)
+    {
+      g_assert_null (clone_modes);
+      return;
+    }
+
+  /* One clone mode per mode of the base monitor that all monitors have */
+  for (l = cc_display_monitor_get_modes (base_monitor); l; l = l->next)
+    {
+      CcDisplayMode *mode = l->data;
+      gboolean interlaced = cc_display_mode_is_interlaced (mode);
+      gboolean compatible = TRUE;
+      int w, h;
+
+      cc_display_mode_get_resolution (mode, &w, &h);
+
+      for (ll = cc_display_config_get_monitors (config); ll && compatible; ll = ll->next)
+        compatible = monitor_has_resolution (ll->data, w, h, interlaced, NULL);
+
+      if (compatible)
+        n_expected++;
+    }
+
+  g_assert_cmpuint (g_list_length (clone_modes), ==, n_expected);
+
+  for (l = clone_modes; l; l = l->next)
+    {
+      CcDisplayMode *clone_mode = l->data;
+      g_autoptr(GArray) scales = cc_display_mode_get_supported_scales (clone_mode);
+      int w, h;
+      guint i;
+
+      g_assert_true (cc_display_mode_is_clone_mode (clone_mode));
+      cc_display_mode_get_resolution (clone_mode, &w, &h);
+
+      if (cc_display_mode_is_preferred (clone_mode))
+        n_preferred++;
+
+      /* Every scale must work with the first such mode of every monitor */
+      for (ll = cc_display_config_get_monitors (config); ll; ll = ll->next)
+        {
+          CcDisplayMode *mode = NULL;
+
+          g_assert_true (monitor_has_resolution (ll->data, w, h, FALSE, &mode));
+
+          for (i = 0; i < scales->len; i++)
+            g_assert_true (mode_has_scale (mode, g_array_index (scales, double, i)));
+        }
+    }
+
+  g_assert_cmpuint (n_preferred, ==, clone_modes ? 1 : 0);
+}
+
+static void
+check_layout (CcDisplayConfig *config)
+{
+  int min_x = G_MAXINT, min_y = G_MAXINT;
+  GList *l;
+
+  if (g_list_length (cc_display_config_get_monitors (config)) < 2)
+    return;
+
+  /* Leaving mirror mode places all monitors next to each other */
+  cc_display_config_set_cloning (config, TRUE);
+  g_assert_true (cc_display_config_is_cloning (config));
+  cc_display_config_set_cloning (config, FALSE);
+  g_assert_false (cc_display_config_is_cloning (config));
+
+  for (l = cc_display_config_get_monitors (config); l; l = l->next)
+    {
+      GList *ll;
+      int x, y;
+
+      if (!cc_display_monitor_is_active (l->data))
+        continue;
+
+      cc_display_monitor_get_geometry (l->data, &x, &y, NULL, NULL);
+      g_assert_cmpint (y, ==, 0);
+      min_x = MIN (min_x, x);
+
+      /* Monitors that were disabled have no mode and take up no space */
+      if (!cc_display_monitor_get_mode (l->data))
+        continue;
+
+      for (ll = l->next; ll; ll = ll->next)
+        {
+          int other_x;
+
+          if (!cc_display_monitor_get_mode (ll->data))
+            continue;
+
+          cc_display_monitor_get_geometry (ll->data, &other_x, NULL, NULL, NULL);
+          g_assert_cmpint (x, !=, other_x);
+        }
+    }
+  g_assert_cmpint (min_x, ==, 0);
+
+  /* Comparing configs moves the layout back to the origin */
+  for (l = cc_display_config_get_monitors (config); l; l = l->next)
+    {
+      int x, y;
+
+      cc_display_monitor_get_geometry (l->data, &x, &y, NULL, NULL);
+      cc_display_monitor_set_position (l->data, x + 100, y + 50);
+    }
+
+  g_assert_true (cc_display_config_equal (config, config));
+
+  min_x = min_y = G_MAXINT;
+  for (l = cc_display_config_get_monitors (config); l; l = l->next)
+    {
+      int x, y;
+
+      if (!cc_display_monitor_is_active (l->data))
+        continue;
+
+      cc_display_monitor_get_geometry (l->data, &x, &y, NULL, NULL);
+      min_x = MIN (min_x, x);
+      min_y = MIN (min_y, y);
+    }
+  g_assert_cmpint (min_x, ==, 0);
+  g_assert_cmpint (min_y, ==, 0);
+}
+
+static void
+test_state (gconstpointer data)
+{
+  g_autoptr(GVariant) state = load_state (data);
+  g_autoptr(CcDisplayConfig) config = new_config (state);
+
+  check_construction (config, state);
+  check_scaled_modes (config);
+  check_cloning_modes (config);
+  check_layout (config);
+}
+
+static gsize
+get_allocated_bytes (void)
+{
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+  return mallinfo2 ().uordblks;
+#endif
+#endif
+  return 0;
+}
+
+static void
+test_state_perf (gconstpointer data)
+{
+  const guint iterations = 200;
+  g_autoptr(GVariant) state = NULL;
+  g_autoptr(GTimer) timer = NULL;
+  gdouble construct = 0, clone = 0, layout = 0;
+  gssize allocated;
+  guint i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Only run in performance mode");
+      return;
+    }
+
+  state = load_state (data);
+  timer = g_timer_new ();
+
+  for (i = 0; i < iterations; i++)
+    {
+      g_autoptr(CcDisplayConfig) config = NULL;
+      GList *clone_modes;
+
+      g_timer_start (timer);
+      config = new_config (state);
+      cc_display_config_set_minimum_size (config, MIN_WIDTH, MIN_HEIGHT);
+      construct += g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      clone_modes = cc_display_config_generate_cloning_modes (config);
+      clone += g_timer_elapsed (timer, NULL);
+      g_list_free_full (clone_modes, g_object_unref);
+
+      g_timer_start (timer);
+      cc_display_config_set_cloning (config, TRUE);
+      cc_display_config_set_cloning (config, FALSE);
+      cc_display_config_equal (config, config);
+      layout += g_timer_elapsed (timer, NULL);
+    }
+
+  /* Memory held by one config with its monitors and modes */
+  {
+    g_autoptr(CcDisplayConfig) config = NULL;
+    gsize before = get_allocated_bytes ();
+
+    config = new_config (state);
+    allocated = get_allocated_bytes () - before;
+  }
+
+  g_test_message ("%s: construct %.3fms, cloning modes %.3fms, layout %.3fms, %" G_GSSIZE_FORMAT " bytes",
+                  (const char *) data,
+                  construct * 1000 / iterations,
+                  clone * 1000 / iterations,
+                  layout * 1000 / iterations,
+                  allocated);
+  g_test_minimized_result (construct / iterations, "%s construct %.3fms",
+                           (const char *) data, construct * 1000 / iterations);
+  g_test_minimized_result (clone / iterations, "%s cloning modes %.3fms",
+                           (const char *) data, clone * 1000 / iterations);
+}
+
+int main (int argc, char **argv)
+{
+  guint i;
+
+  setlocale (LC_ALL, "");
+  g_test_init (&argc, &argv, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (states); i++)
+    {
+      g_autofree gchar *path = g_strdup_printf ("/display/config/%s", states[i]);
+      g_autofree gchar *perf_path = g_strdup_printf ("/display/config-perf/%s", states[i]);
+
+      g_test_add_data_func (path, states[i], test_state);
+      g_test_add_data_func (perf_path, states[i], test_state_perf);
+    }
+
+  return g_test_run ();
+}
@@ -0,0 +1,116 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "loop-stats.h"
+
+#define PROBE_INTERVAL_MS  5
+
+static gint64
+get_cpu_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+  return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+static gboolean
+probe_cb (gpointer user_data)
+{
+  LoopStats *stats = user_data;
+  gint64 now = g_get_monotonic_time ();
+  gint64 latency;
+
+  latency = MAX (0, now - stats->last_probe - PROBE_INTERVAL_MS * 1000);
+  stats->max_latency = MAX (stats->max_latency, latency);
+  stats->total_latency += latency;
+  stats->n_probes++;
+  stats->last_probe = now;
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+tick_cb (GtkWidget     *widget,
+         GdkFrameClock *frame_clock,
+         gpointer       user_data)
+{
+  LoopStats *stats = user_data;
+  gint64 frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  gint64 refresh_interval = 0;
+
+  gdk_frame_clock_get_refresh_info (frame_clock, frame_time, &refresh_interval, NULL);
+  if (refresh_interval <= 0)
+    refresh_interval = G_USEC_PER_SEC / 60;
+
+  /* Every refresh interval that passed without a frame is a dropped one */
+  if (stats->last_frame > 0 && frame_time - stats->last_frame > refresh_interval * 3 / 2)
+    stats->n_dropped += (frame_time - stats->last_frame) / refresh_interval - 1;
+
+  stats->last_frame = frame_time;
+  stats->n_frames++;
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Starts measuring, counting the frames of @widget */
+void
+loop_stats_start (LoopStats *stats,
+                  GtkWidget *widget)
+{
+  memset (stats, 0, sizeof (*stats));
+
+  stats->widget = widget;
+  stats->cpu_start = get_cpu_time ();
+  stats->wall_start = g_get_monotonic_time ();
+  stats->last_probe = stats->wall_start;
+
+  stats->probe_id = g_timeout_add (PROBE_INTERVAL_MS, probe_cb, stats);
+  stats->tick_id = gtk_widget_add_tick_callback (widget, tick_cb, stats, NULL);
+}
+
+/* Stops measuring and reports the results as @name. The wall time is
+ * reported per operation when @n_operations is not 0; leave it at 0 when
+ * the test sets the pace itself. */
+void
+loop_stats_stop (LoopStats   *stats,
+                 const gchar *name,
+                 guint        n_operations)
+{
+  gdouble wall, cpu, avg_latency, max_latency;
+
+  g_clear_handle_id (&stats->probe_id, g_source_remove);
+  gtk_widget_remove_tick_callback (stats->widget, stats->tick_id);
+
+  wall = (gdouble) (g_get_monotonic_time () - stats->wall_start) / 1000;
+  cpu = (gdouble) (get_cpu_time () - stats->cpu_start) / 1000;
+  avg_latency = stats->n_probes > 0 ? (gdouble) stats->total_latency / stats->n_probes / 1000 : 0;
+  max_latency = (gdouble) stats->max_latency / 1000;
+
+  g_test_message ("%s: %.1fms wall, %.1fms CPU, main loop latency %.2fms avg / %.2fms max, "
+                  "%u frames, %u dropped",
+                  name, wall, cpu, avg_latency, max_latency,
+                  stats->n_frames, stats->n_dropped);
+
+  if (n_operations > 0)
+    g_test_minimized_result (wall / n_operations, "%s wall time per operation: %.2fms", name, wall / n_operations);
+  g_test_minimized_result (cpu, "%s CPU time: %.1fms", name, cpu);
+  g_test_minimized_result (max_latency, "%s max main loop latency: %.2fms", name, max_latency);
+  g_test_minimized_result (stats->n_dropped, "%s dropped frames: %u", name, stats->n_dropped);
+}
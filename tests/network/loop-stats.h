@@ -0,0 +1,52 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/*
+ * What a stretch of a benchmark cost this process: wall and CPU time,
+ * main loop latency and the frames a window dropped meanwhile.
+ */
+typedef struct {
+  GtkWidget *widget;
+
+  gint64     cpu_start;
+  gint64     wall_start;
+
+  /* Main loop latency, sampled by a short timeout */
+  guint      probe_id;
+  gint64     last_probe;
+  gint64     max_latency;
+  gint64     total_latency;
+  guint      n_probes;
+
+  /* Frame clock ticks of the widget */
+  guint      tick_id;
+  gint64     last_frame;
+  guint      n_frames;
+  guint      n_dropped;
+} LoopStats;
+
+void loop_stats_start (LoopStats   *stats,
+                       GtkWidget   *widget);
+void loop_stats_stop  (LoopStats   *stats,
+                       const gchar *name,
+                       guint        n_operations);
+
+G_END_DECLS
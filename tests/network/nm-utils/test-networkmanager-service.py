@@ -423,6 +423,9 @@ class WifiAp(ExportedObj):
         ExportedObj.__init__(self, bus, path)
 
     def __del__(self):
+        self.stop()
+
+    def stop(self):
         if self.strength_id > 0:
             GLib.source_remove(self.strength_id)
         self.strength_id = 0
@@ -432,6 +435,10 @@ class WifiAp(ExportedObj):
         self.__notify(PP_STRENGTH)
         return True
 
+    def set_strength(self, strength):
+        self.strength = strength
+        self.__notify(PP_STRENGTH)
+
     # Properties interface
     def __get_props(self):
         props = {}
@@ -506,9 +513,17 @@ class WifiDevice(Device):
 
     def remove_ap(self, ap):
         self.aps.remove(ap)
+        ap.stop()
         self.__notify(PW_ACCESS_POINTS)
         self.AccessPointRemoved(to_path(ap))
 
+    def add_aps(self, aps):
+        # Notify the property once for the whole batch
+        self.aps.extend(aps)
+        self.__notify(PW_ACCESS_POINTS)
+        for ap in aps:
+            self.AccessPointAdded(to_path(ap))
+
     # Properties interface
     def __get_props(self):
         props = {}
@@ -541,6 +556,26 @@ class WifiDevice(Device):
                 return
         raise ApNotFoundException("AP %s not found" % path)
 
+    def add_test_aps(self, ssid_prefix, count, n_ssids):
+        aps = [WifiAp(self._bus, '%s-%03d' % (ssid_prefix, i % n_ssids), None, 0x1, 0x1cc, 0x1cc, 2412)
+               for i in range(count)]
+        self.add_aps(aps)
+        return aps
+
+    def ap_burst(self, seed, n_add, n_remove, n_strength):
+        # Roughly what a scan in a crowded place looks like: some APs go out
+        # of range, others (mostly of already known SSIDs) appear and many
+        # report a new signal strength.
+        rand = random.Random(seed)
+        candidates = [ap for ap in self.aps if ap != self.active_ap]
+        for ap in rand.sample(candidates, min(n_remove, len(candidates))):
+            self.remove_ap(ap)
+        ssids = [ap.ssid for ap in self.aps] or ['burst']
+        for i in range(n_add):
+            self.add_test_ap(rand.choice(ssids), None)
+        for ap in rand.sample(self.aps, min(n_strength, len(self.aps))):
+            ap.set_strength(rand.randint(0, 100))
+
 
 ###################################################################
 IFACE_WIMAX_NSP = 'org.freedesktop.NetworkManager.WiMax.Nsp'
@@ -1018,6 +1053,21 @@ class NetworkManager(ExportedObj):
                 return
         raise UnknownDeviceException("Device not found")
 
+    @dbus.service.method(IFACE_TEST, in_signature='ssuu', out_signature='ao')
+    def AddWifiAps(self, ifname, ssid_prefix, count, n_ssids):
+        for d in self.devices:
+            if d.iface == ifname:
+                return to_path_array(d.add_test_aps(ssid_prefix, count, max(n_ssids, 1)))
+        raise UnknownDeviceException("Device not found")
+
+    @dbus.service.method(IFACE_TEST, in_signature='suuuu', out_signature='')
+    def WifiApBurst(self, ifname, seed, n_add, n_remove, n_strength):
+        for d in self.devices:
+            if d.iface == ifname:
+                d.ap_burst(seed, n_add, n_remove, n_strength)
+                return
+        raise UnknownDeviceException("Device not found")
+
     @dbus.service.method(IFACE_TEST, in_signature='ss', out_signature='o')
     def AddWimaxNsp(self, ifname, name):
         for d in self.devices:
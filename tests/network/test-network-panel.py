@@ -33,10 +33,12 @@ from gtest import GTest
 from x11session import X11SessionTestCase
 
 BUILDDIR = os.environ.get('BUILDDIR', os.path.join(os.path.dirname(__file__)))
+# meson.build also runs test-wifi-benchmark through this harness
+TEST_EXE = os.environ.get('TEST_EXE', 'test-network-panel')
 
 
 class PanelTestCase(X11SessionTestCase, GTest):
-    g_test_exe = os.path.join(BUILDDIR, 'test-network-panel')
+    g_test_exe = os.path.join(BUILDDIR, TEST_EXE)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,282 @@
+/*
+ * The Control Center is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * The Control Center is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with the Control Center; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Runs the Wi-Fi panel against the mock NetworkManager service with
+ * hundreds of access points and measures how the client side copes:
+ * main loop latency, dropped frames and CPU time of this process (the
+ * mock service runs in its own process and is not accounted for).
+ */
+
+#define G_LOG_DOMAIN "test-wifi-benchmark"
+
+#include "nm-macros-internal.h"
+
+#include <NetworkManager.h>
+#include <nm-client.h>
+#include <nm-utils.h>
+
+#include "nm-test-libnm-utils.h"
+
+#include <string.h>
+#include <gtk/gtk.h>
+
+#include "cc-test-window.h"
+#include "loop-stats.h"
+#include "shell/cc-object-storage.h"
+
+#include "nmtst-helpers.h"
+
+#define WIFI_IFACE         "wlan1000"
+
+#define N_ACCESS_POINTS    400
+#define N_SSIDS            150
+#define N_CONNECTIONS      60
+
+#define N_BURSTS           40
+#define BURST_ADD          12
+#define BURST_REMOVE       12
+#define BURST_STRENGTH     120
+#define BURST_INTERVAL_MS  250
+
+#define TIMEOUT_SECONDS    60
+
+typedef struct {
+  NMTstcServiceInfo *sinfo;
+  NMClient *client;
+
+  NMDevice *wifi;
+
+  GtkWindow *shell;
+  CcPanel *panel;
+} WifiBenchmarkFixture;
+
+extern GType cc_wifi_panel_get_type (void);
+
+static gboolean
+quit_loop_cb (gpointer user_data)
+{
+  g_main_loop_quit (user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+run_main_loop (guint ms)
+{
+  g_autoptr(GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+
+  g_timeout_add (ms, quit_loop_cb, loop);
+  g_main_loop_run (loop);
+}
+
+static void
+wait_for_access_points (WifiBenchmarkFixture *fixture,
+                        guint                 n_aps)
+{
+  gint64 deadline = g_get_monotonic_time () + TIMEOUT_SECONDS * G_USEC_PER_SEC;
+
+  while (nm_device_wifi_get_access_points (NM_DEVICE_WIFI (fixture->wifi))->len < n_aps)
+    {
+      g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+      g_main_context_iteration (NULL, TRUE);
+    }
+
+  /* Let the panel process everything that is queued up */
+  while (g_main_context_iteration (NULL, FALSE));
+}
+
+static void
+add_access_points (WifiBenchmarkFixture *fixture)
+{
+  g_dbus_proxy_call (fixture->sinfo->proxy,
+                     "AddWifiAps",
+                     g_variant_new ("(ssuu)", WIFI_IFACE, "bench", N_ACCESS_POINTS, N_SSIDS),
+                     G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                     -1, NULL, NULL, NULL);
+
+  wait_for_access_points (fixture, N_ACCESS_POINTS);
+}
+
+static void
+add_connections (WifiBenchmarkFixture *fixture)
+{
+  gint64 deadline = g_get_monotonic_time () + TIMEOUT_SECONDS * G_USEC_PER_SEC;
+  guint i;
+
+  /* Saved networks for some of the SSIDs the access points use */
+  for (i = 0; i < N_CONNECTIONS; i++)
+    {
+      g_autofree gchar *id = g_strdup_printf ("bench-%03u", i * (N_SSIDS / N_CONNECTIONS));
+      g_autoptr(GBytes) ssid = g_bytes_new (id, strlen (id));
+      NMConnection *connection;
+
+      connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRELESS_SETTING_NAME, NULL);
+      g_object_set (nm_connection_get_setting_wireless (connection),
+                    NM_SETTING_WIRELESS_SSID, ssid,
+                    NULL);
+
+      nmtstc_service_add_connection (fixture->sinfo, connection, FALSE, NULL);
+      g_object_unref (connection);
+    }
+
+  while (nm_client_get_connections (fixture->client)->len < N_CONNECTIONS)
+    {
+      g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+      g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+static void
+fixture_set_up (WifiBenchmarkFixture *fixture,
+                gconstpointer         user_data)
+{
+  g_autoptr(GError) error = NULL;
+
+  cc_object_storage_initialize ();
+
+  /* Bring up the libnm service. */
+  fixture->sinfo = nmtstc_service_init ();
+
+  fixture->client = nm_client_new (NULL, &error);
+  g_assert_no_error (error);
+
+  /* Insert into object storage so that we see the same events as the panel. */
+  cc_object_storage_add_object (CC_OBJECT_NMCLIENT, fixture->client);
+
+  fixture->wifi = nmtstc_service_add_device (fixture->sinfo,
+                                             fixture->client,
+                                             "AddWifiDevice",
+                                             WIFI_IFACE);
+
+  fixture->shell = GTK_WINDOW (cc_test_window_new ());
+
+  fixture->panel = g_object_new (cc_wifi_panel_get_type (),
+                                 "shell", CC_SHELL (fixture->shell),
+                                 NULL);
+
+  g_object_ref (fixture->panel);
+  cc_shell_set_active_panel (CC_SHELL (fixture->shell), fixture->panel);
+
+  gtk_window_present (fixture->shell);
+
+  add_connections (fixture);
+  run_main_loop (100);
+}
+
+static void
+fixture_tear_down (WifiBenchmarkFixture *fixture,
+                   gconstpointer         user_data)
+{
+  g_clear_object (&fixture->panel);
+  g_clear_object (&fixture->client);
+  g_clear_pointer (&fixture->shell, gtk_window_destroy);
+
+  cc_object_storage_destroy ();
+
+  g_clear_pointer (&fixture->sinfo, nmtstc_service_cleanup);
+}
+
+/*****************************************************************************/
+
+static void
+test_populate (WifiBenchmarkFixture *fixture,
+               gconstpointer         user_data)
+{
+  LoopStats stats;
+
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+  add_access_points (fixture);
+  loop_stats_stop (&stats, "populate", 0);
+}
+
+static void
+test_bursts (WifiBenchmarkFixture *fixture,
+             gconstpointer         user_data)
+{
+  LoopStats stats;
+  guint i;
+
+  add_access_points (fixture);
+  run_main_loop (500);
+
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+
+  for (i = 0; i < N_BURSTS; i++)
+    {
+      /* Asynchronous, so that the measured main loop keeps running */
+      g_dbus_proxy_call (fixture->sinfo->proxy,
+                         "WifiApBurst",
+                         g_variant_new ("(suuuu)", WIFI_IFACE, i, BURST_ADD, BURST_REMOVE, BURST_STRENGTH),
+                         G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                         -1, NULL, NULL, NULL);
+
+      run_main_loop (BURST_INTERVAL_MS);
+    }
+
+  loop_stats_stop (&stats, "bursts", 0);
+
+  g_assert_cmpuint (nm_device_wifi_get_access_points (NM_DEVICE_WIFI (fixture->wifi))->len, >, 0);
+}
+
+static void
+test_idle (WifiBenchmarkFixture *fixture,
+           gconstpointer         user_data)
+{
+  LoopStats stats;
+
+  add_access_points (fixture);
+  run_main_loop (500);
+
+  /* Only the periodic strength changes of the mock APs and scanning */
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+  run_main_loop (10 * 1000);
+  loop_stats_stop (&stats, "idle", 0);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+  g_setenv ("LIBNM_USE_SESSION_BUS", "1", TRUE);
+  g_setenv ("LC_ALL", "C", TRUE);
+
+  gtk_test_init (&argc, &argv, NULL);
+  adw_init ();
+
+  g_test_add ("/wifi-benchmark/populate",
+              WifiBenchmarkFixture,
+              NULL,
+              fixture_set_up,
+              test_populate,
+              fixture_tear_down);
+
+  g_test_add ("/wifi-benchmark/bursts",
+              WifiBenchmarkFixture,
+              NULL,
+              fixture_set_up,
+              test_bursts,
+              fixture_tear_down);
+
+  g_test_add ("/wifi-benchmark/idle",
+              WifiBenchmarkFixture,
+              NULL,
+              fixture_set_up,
+              test_idle,
+              fixture_tear_down);
+
+  return g_test_run ();
+}
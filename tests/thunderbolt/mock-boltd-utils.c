@@ -0,0 +1,129 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+
+#include "bolt-names.h"
+#include "mock-boltd-utils.h"
+
+static gboolean
+name_has_owner (GDBusConnection *bus,
+                const gchar     *name)
+{
+  g_autoptr(GVariant) ret = NULL;
+  gboolean has_owner = FALSE;
+
+  ret = g_dbus_connection_call_sync (bus,
+                                     "org.freedesktop.DBus",
+                                     "/org/freedesktop/DBus",
+                                     "org.freedesktop.DBus",
+                                     "NameHasOwner",
+                                     g_variant_new ("(s)", name),
+                                     G_VARIANT_TYPE ("(b)"),
+                                     G_DBUS_CALL_FLAGS_NONE,
+                                     -1,
+                                     NULL,
+                                     NULL);
+  if (ret != NULL)
+    g_variant_get (ret, "(b)", &has_owner);
+
+  return has_owner;
+}
+
+/* Starts the mock with @n_devices plain devices and waits until it is on
+ * the bus */
+void
+mock_boltd_start (MockBoltd *mock,
+                  guint      n_devices)
+{
+  g_autofree gchar *n = g_strdup_printf ("%u", n_devices);
+  const gchar *args[] = { "python3", TEST_BOLT_SERVICE, n, NULL };
+  g_autoptr(GError) error = NULL;
+  gint i;
+
+  mock->bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+  g_assert_no_error (error);
+
+  /* The service exits once its stdin, the keepalive pipe, is closed */
+  g_spawn_async_with_pipes (NULL, (gchar **) args, NULL,
+                            G_SPAWN_SEARCH_PATH,
+                            NULL, NULL,
+                            &mock->pid, &mock->keepalive_fd, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  for (i = 1000; i > 0; i--)
+    {
+      if (name_has_owner (mock->bus, BOLT_DBUS_NAME))
+        break;
+      g_usleep (G_USEC_PER_SEC / 50);
+    }
+  g_assert_cmpint (i, >, 0);
+
+  mock->proxy = g_dbus_proxy_new_sync (mock->bus,
+                                       G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                                       G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS |
+                                       G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+                                       NULL,
+                                       BOLT_DBUS_NAME,
+                                       BOLT_DBUS_PATH,
+                                       "org.freedesktop.bolt1.Mock",
+                                       NULL,
+                                       &error);
+  g_assert_no_error (error);
+}
+
+/* Stops the mock and waits until the bus notices it is gone */
+void
+mock_boltd_stop (MockBoltd *mock)
+{
+  gint i;
+
+  g_clear_object (&mock->proxy);
+
+  kill (mock->pid, SIGTERM);
+  close (mock->keepalive_fd);
+  g_spawn_close_pid (mock->pid);
+
+  for (i = 100; i > 0; i--)
+    {
+      if (!name_has_owner (mock->bus, BOLT_DBUS_NAME))
+        break;
+      g_usleep (G_USEC_PER_SEC / 50);
+    }
+  g_assert_cmpint (i, >, 0);
+
+  g_clear_object (&mock->bus);
+}
+
+GVariant *
+mock_boltd_call (MockBoltd   *mock,
+                 const gchar *method,
+                 GVariant    *parameters)
+{
+  g_autoptr(GVariant) ret = NULL;
+  g_autoptr(GError) error = NULL;
+
+  ret = g_dbus_proxy_call_sync (mock->proxy,
+                                method,
+                                parameters,
+                                G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                -1,
+                                NULL,
+                                &error);
+  g_assert_no_error (error);
+
+  return g_steal_pointer (&ret);
+}
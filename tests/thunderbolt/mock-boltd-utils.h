@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * A running mock-boltd.py on the system bus, and a proxy for its
+ * org.freedesktop.bolt1.Mock interface.
+ */
+typedef struct {
+  GPid             pid;
+  gint             keepalive_fd;
+  GDBusConnection *bus;
+  GDBusProxy      *proxy;
+} MockBoltd;
+
+void      mock_boltd_start (MockBoltd   *mock,
+                            guint        n_devices);
+void      mock_boltd_stop  (MockBoltd   *mock);
+GVariant *mock_boltd_call  (MockBoltd   *mock,
+                            const gchar *method,
+                            GVariant    *parameters);
+
+G_END_DECLS
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# -*- Mode: python; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+#
+# A minimal stand-in for boltd on the system bus: the manager with its
+# device list and signals, and plain devices that can be enrolled and
+# authorized. The extra Mock interface on the manager lets tests add,
+# remove and change devices, delay the replies to enroll and authorize
+# calls and look at when those calls came in.
+#
+# Usage: mock-boltd.py [N_DEVICES]
+
+from gi.repository import GLib
+import sys
+import uuid
+import dbus
+import dbus.service
+import dbus.mainloop.glib
+
+mainloop = GLib.MainLoop()
+
+BUS_NAME = 'org.freedesktop.bolt'
+MANAGER_PATH = '/org/freedesktop/bolt'
+DEVICES_PATH = '/org/freedesktop/bolt/devices'
+
+IFACE_MANAGER = 'org.freedesktop.bolt1.Manager'
+IFACE_DEVICE = 'org.freedesktop.bolt1.Device'
+IFACE_MOCK = 'org.freedesktop.bolt1.Mock'
+
+
+class UnknownInterfaceException(dbus.DBusException):
+    _dbus_error_name = dbus.PROPERTIES_IFACE + '.UnknownInterface'
+
+
+class UnknownPropertyException(dbus.DBusException):
+    _dbus_error_name = dbus.PROPERTIES_IFACE + '.UnknownProperty'
+
+
+class NotFoundException(dbus.DBusException):
+    _dbus_error_name = 'org.freedesktop.bolt.Error.NotFound'
+
+
+class PropertiesObject(dbus.service.Object):
+    def __init__(self, bus, path, iface, props):
+        dbus.service.Object.__init__(self, bus, path)
+        self.path = path
+        self.iface = iface
+        self.props = props
+
+    @dbus.service.method(dbus_interface=dbus.PROPERTIES_IFACE, in_signature='s', out_signature='a{sv}')
+    def GetAll(self, iface):
+        if iface != self.iface:
+            raise UnknownInterfaceException()
+        return self.props
+
+    @dbus.service.method(dbus_interface=dbus.PROPERTIES_IFACE, in_signature='ss', out_signature='v')
+    def Get(self, iface, name):
+        if iface != self.iface:
+            raise UnknownInterfaceException()
+        if name not in self.props:
+            raise UnknownPropertyException()
+        return self.props[name]
+
+    @dbus.service.signal(dbus.PROPERTIES_IFACE, signature='sa{sv}as')
+    def PropertiesChanged(self, iface, changed, invalidated):
+        pass
+
+    def set_props(self, changed):
+        self.props.update(changed)
+        self.PropertiesChanged(self.iface, changed, [])
+
+
+class Device(PropertiesObject):
+    def __init__(self, manager, bus, index, parent=None, stored=None):
+        uid = str(uuid.UUID(int=index + 1))
+        path = DEVICES_PATH + '/' + uid.replace('-', '_')
+        if parent is not None:
+            syspath = parent.props['SysfsPath'] + '/%d' % index
+        else:
+            syspath = '/sys/devices/bench/%d' % index
+        if stored is None:
+            stored = index % 2 == 0
+        props = {
+            'Uid': dbus.String(uid),
+            'Name': dbus.String('Bench Device %d' % index),
+            'Vendor': dbus.String('GNOME'),
+            'Type': dbus.String('peripheral'),
+            'Status': dbus.String('authorized'),
+            'AuthFlags': dbus.String('none'),
+            'Parent': dbus.String(parent.props['Uid'] if parent is not None else ''),
+            'SysfsPath': dbus.String(syspath),
+            'ConnectTime': dbus.UInt64(1500000000 + index),
+            'AuthorizeTime': dbus.UInt64(1500000000 + index),
+            'Stored': dbus.Boolean(stored),
+            'Policy': dbus.String('auto'),
+            'Key': dbus.String('missing'),
+            'StoreTime': dbus.UInt64(0),
+            'Label': dbus.String(''),
+        }
+        PropertiesObject.__init__(self, bus, path, IFACE_DEVICE, props)
+        self.manager = manager
+
+    @dbus.service.method(dbus_interface=IFACE_DEVICE, in_signature='s', out_signature='',
+                         async_callbacks=('ok_cb', 'err_cb'))
+    def Authorize(self, flags, ok_cb, err_cb):
+        def done():
+            self.set_props({'Status': dbus.String('authorized')})
+            ok_cb()
+
+        self.manager.handle_call(self, done)
+
+
+class Manager(PropertiesObject):
+    def __init__(self, bus):
+        props = {
+            'Version': dbus.UInt32(1),
+            'Probing': dbus.Boolean(False),
+            'DefaultPolicy': dbus.String('auto'),
+            'SecurityLevel': dbus.String('user'),
+            'AuthMode': dbus.String('enabled'),
+        }
+        PropertiesObject.__init__(self, bus, MANAGER_PATH, IFACE_MANAGER, props)
+        self.bus = bus
+        self.devices = []
+        self.next_index = 0
+        self.latency = 0
+        self.calls = []
+
+    def add_device(self, parent=None, stored=None):
+        device = Device(self, self.bus, self.next_index, parent, stored)
+        self.next_index += 1
+        self.devices.append(device)
+        return device
+
+    def find_device(self, uid):
+        for d in self.devices:
+            if d.props['Uid'] == uid:
+                return d
+        raise NotFoundException('device with id \'%s\' could not be found' % uid)
+
+    def handle_call(self, device, done):
+        call = [device.props['Uid'], GLib.get_monotonic_time(), 0]
+        self.calls.append(call)
+
+        def reply():
+            call[2] = GLib.get_monotonic_time()
+            done()
+            return False
+
+        GLib.timeout_add(self.latency, reply)
+
+    @dbus.service.method(dbus_interface=IFACE_MANAGER, in_signature='', out_signature='ao')
+    def ListDevices(self):
+        return dbus.Array([d.path for d in self.devices], signature='o')
+
+    @dbus.service.method(dbus_interface=IFACE_MANAGER, in_signature='s', out_signature='o')
+    def DeviceByUid(self, uid):
+        return self.find_device(uid).path
+
+    @dbus.service.method(dbus_interface=IFACE_MANAGER, in_signature='sss', out_signature='o',
+                         async_callbacks=('ok_cb', 'err_cb'))
+    def EnrollDevice(self, uid, policy, flags, ok_cb, err_cb):
+        try:
+            device = self.find_device(uid)
+        except NotFoundException as e:
+            err_cb(e)
+            return
+
+        def done():
+            device.set_props({'Status': dbus.String('authorized'),
+                              'Stored': dbus.Boolean(True)})
+            ok_cb(device.path)
+
+        self.handle_call(device, done)
+
+    @dbus.service.signal(IFACE_MANAGER, signature='o')
+    def DeviceAdded(self, path):
+        pass
+
+    @dbus.service.signal(IFACE_MANAGER, signature='o')
+    def DeviceRemoved(self, path):
+        pass
+
+    @dbus.service.method(dbus_interface=IFACE_MOCK, in_signature='u', out_signature='')
+    def AddDevices(self, count):
+        for i in range(count):
+            self.DeviceAdded(self.add_device().path)
+
+    @dbus.service.method(dbus_interface=IFACE_MOCK, in_signature='u', out_signature='')
+    def RemoveDevices(self, count):
+        for i in range(min(count, len(self.devices))):
+            device = self.devices.pop()
+            device.remove_from_connection()
+            self.DeviceRemoved(device.path)
+
+    @dbus.service.method(dbus_interface=IFACE_MOCK, in_signature='sb', out_signature='s')
+    def AddDevice(self, parent_uid, stored):
+        parent = self.find_device(parent_uid) if parent_uid else None
+        device = self.add_device(parent, stored)
+        device.set_props({'Status': dbus.String('connected')})
+        self.DeviceAdded(device.path)
+        return device.props['Uid']
+
+    @dbus.service.method(dbus_interface=IFACE_MOCK, in_signature='u', out_signature='')
+    def SetLatency(self, ms):
+        self.latency = ms
+
+    @dbus.service.method(dbus_interface=IFACE_MOCK, in_signature='', out_signature='a(sxx)')
+    def GetCalls(self):
+        """Enroll and authorize calls in the order they came in, with the
+        monotonic times they came in and got their reply (0 if pending)"""
+        return dbus.Array([(c[0], c[1], c[2]) for c in self.calls], signature='(sxx)')
+
+    @dbus.service.method(dbus_interface=IFACE_MOCK, in_signature='us', out_signature='')
+    def SetStatus(self, index, status):
+        self.devices[index].set_props({'Status': dbus.String(status)})
+
+    @dbus.service.method(dbus_interface=IFACE_MOCK, in_signature='s', out_signature='')
+    def SetSecurityLevel(self, level):
+        self.set_props({'SecurityLevel': dbus.String(level)})
+
+
+def stdin_cb(io, condition):
+    mainloop.quit()
+
+
+def main():
+    dbus.mainloop.glib.DBusGMainLoop(set_as_default=True)
+
+    n_devices = int(sys.argv[1]) if len(sys.argv) > 1 else 0
+
+    bus = dbus.SystemBus()
+    manager = Manager(bus)
+    for i in range(n_devices):
+        manager.add_device()
+
+    if not bus.request_name(BUS_NAME):
+        sys.exit(1)
+
+    # Watch stdin; if it closes, assume our parent has crashed, and exit
+    io = GLib.IOChannel(0)
+    GLib.io_add_watch(io, GLib.PRIORITY_LOW, GLib.IOCondition.HUP, stdin_cb)
+
+    try:
+        mainloop.run()
+    except Exception:
+        pass
+
+    sys.exit(0)
+
+
+if __name__ == '__main__':
+    main()
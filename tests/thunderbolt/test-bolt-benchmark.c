@@ -0,0 +1,252 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs the Thunderbolt panel against a mock boltd with hundreds of
+ * devices and measures how long the panel takes to list them, what a
+ * single device being added or removed costs afterwards, and how a
+ * full listing through the client library compares when done
+ * synchronously and asynchronously. Only this process is accounted for,
+ * the mock service runs in its own.
+ */
+
+#define G_LOG_DOMAIN "test-bolt-benchmark"
+
+#include <adwaita.h>
+#include <gtk/gtk.h>
+
+#include "bolt-client.h"
+#include "cc-bolt-device-entry.h"
+#include "cc-test-window.h"
+#include "loop-stats.h"
+#include "mock-boltd-utils.h"
+
+#define N_DEVICES          300
+#define N_UPDATES          40
+
+#define TIMEOUT_SECONDS    60
+
+typedef struct {
+  MockBoltd        boltd;
+
+  GtkWindow       *shell;
+  CcPanel         *panel;
+} BoltBenchmarkFixture;
+
+extern GType cc_bolt_panel_get_type (void);
+
+static guint
+count_device_entries (GtkWidget *widget)
+{
+  GtkWidget *child;
+  guint n = 0;
+
+  if (CC_IS_BOLT_DEVICE_ENTRY (widget))
+    return 1;
+
+  for (child = gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    n += count_device_entries (child);
+
+  return n;
+}
+
+static void
+wait_for_device_entries (BoltBenchmarkFixture *fixture,
+                         guint                 n_entries)
+{
+  gint64 deadline = g_get_monotonic_time () + TIMEOUT_SECONDS * G_USEC_PER_SEC;
+
+  while (count_device_entries (GTK_WIDGET (fixture->panel)) != n_entries)
+    {
+      g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+      g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+static void
+create_panel (BoltBenchmarkFixture *fixture)
+{
+  fixture->panel = g_object_new (cc_bolt_panel_get_type (),
+                                 "shell", CC_SHELL (fixture->shell),
+                                 NULL);
+
+  g_object_ref (fixture->panel);
+  cc_shell_set_active_panel (CC_SHELL (fixture->shell), fixture->panel);
+}
+
+static void
+fixture_set_up (BoltBenchmarkFixture *fixture,
+                gconstpointer         user_data)
+{
+  mock_boltd_start (&fixture->boltd, N_DEVICES);
+
+  fixture->shell = GTK_WINDOW (cc_test_window_new ());
+  gtk_window_present (fixture->shell);
+}
+
+static void
+fixture_tear_down (BoltBenchmarkFixture *fixture,
+                   gconstpointer         user_data)
+{
+  g_clear_object (&fixture->panel);
+  g_clear_pointer (&fixture->shell, gtk_window_destroy);
+
+  mock_boltd_stop (&fixture->boltd);
+}
+
+/*****************************************************************************/
+
+static void
+test_activation (BoltBenchmarkFixture *fixture,
+                 gconstpointer         user_data)
+{
+  LoopStats stats;
+
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+  create_panel (fixture);
+  wait_for_device_entries (fixture, N_DEVICES);
+  loop_stats_stop (&stats, "activation", 1);
+}
+
+static void
+test_updates (BoltBenchmarkFixture *fixture,
+              gconstpointer         user_data)
+{
+  LoopStats stats;
+  guint i;
+
+  create_panel (fixture);
+  wait_for_device_entries (fixture, N_DEVICES);
+
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+
+  for (i = 0; i < N_UPDATES; i++)
+    {
+      g_variant_unref (mock_boltd_call (&fixture->boltd, "AddDevices", g_variant_new ("(u)", 1)));
+      wait_for_device_entries (fixture, N_DEVICES + 1);
+
+      g_variant_unref (mock_boltd_call (&fixture->boltd, "RemoveDevices", g_variant_new ("(u)", 1)));
+      wait_for_device_entries (fixture, N_DEVICES);
+    }
+
+  loop_stats_stop (&stats, "updates", 2 * N_UPDATES);
+}
+
+static void
+test_resync (BoltBenchmarkFixture *fixture,
+             gconstpointer         user_data)
+{
+  LoopStats stats;
+  guint i;
+
+  create_panel (fixture);
+  wait_for_device_entries (fixture, N_DEVICES);
+
+  /* A security level change makes the panel list the devices again,
+   * as if boltd got restarted; one device goes away every time */
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+
+  for (i = 0; i < N_UPDATES; i++)
+    {
+      g_variant_unref (mock_boltd_call (&fixture->boltd, "RemoveDevices", g_variant_new ("(u)", 1)));
+      g_variant_unref (mock_boltd_call (&fixture->boltd, "SetSecurityLevel", g_variant_new ("(s)", i % 2 ? "user" : "secure")));
+      wait_for_device_entries (fixture, N_DEVICES - i - 1);
+    }
+
+  loop_stats_stop (&stats, "resync", N_UPDATES);
+}
+
+static void
+list_devices_cb (GObject      *source,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+  GPtrArray **devices = user_data;
+  g_autoptr(GError) error = NULL;
+
+  *devices = bolt_client_list_devices_finish (BOLT_CLIENT (source), res, &error);
+  g_assert_no_error (error);
+}
+
+static void
+test_list_devices (BoltBenchmarkFixture *fixture,
+                   gconstpointer         user_data)
+{
+  g_autoptr(BoltClient) client = NULL;
+  g_autoptr(GPtrArray) devices = NULL;
+  g_autoptr(GError) error = NULL;
+  LoopStats stats;
+
+  client = bolt_client_new (&error);
+  g_assert_no_error (error);
+
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+  devices = bolt_client_list_devices (client, NULL, &error);
+  g_assert_no_error (error);
+  loop_stats_stop (&stats, "list-devices-sync", 1);
+
+  g_assert_cmpuint (devices->len, ==, N_DEVICES);
+  g_clear_pointer (&devices, g_ptr_array_unref);
+
+  loop_stats_start (&stats, GTK_WIDGET (fixture->shell));
+  bolt_client_list_devices_async (client, NULL, list_devices_cb, &devices);
+  while (devices == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  loop_stats_stop (&stats, "list-devices-async", 1);
+
+  g_assert_cmpuint (devices->len, ==, N_DEVICES);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+  g_setenv ("LC_ALL", "C", TRUE);
+
+  gtk_test_init (&argc, &argv, NULL);
+  adw_init ();
+
+  g_test_add ("/bolt-benchmark/activation",
+              BoltBenchmarkFixture,
+              NULL,
+              fixture_set_up,
+              test_activation,
+              fixture_tear_down);
+
+  g_test_add ("/bolt-benchmark/updates",
+              BoltBenchmarkFixture,
+              NULL,
+              fixture_set_up,
+              test_updates,
+              fixture_tear_down);
+
+  g_test_add ("/bolt-benchmark/resync",
+              BoltBenchmarkFixture,
+              NULL,
+              fixture_set_up,
+              test_resync,
+              fixture_tear_down);
+
+  g_test_add ("/bolt-benchmark/list-devices",
+              BoltBenchmarkFixture,
+              NULL,
+              fixture_set_up,
+              test_list_devices,
+              fixture_tear_down);
+
+  return g_test_run ();
+}
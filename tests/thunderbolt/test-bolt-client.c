@@ -0,0 +1,440 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks how the client library enrolls and authorizes a whole tree of
+ * devices against a mock boltd that takes a while to answer: a device
+ * must only be touched once its parent is done, devices on different
+ * branches should not wait for each other, and the whole operation can
+ * be cancelled half way through.
+ */
+
+#define G_LOG_DOMAIN "test-bolt-client"
+
+#include <gio/gio.h>
+
+#include "bolt-client.h"
+#include "bolt-device.h"
+#include "mock-boltd-utils.h"
+
+/* How long the mock takes to answer every enroll or authorize call */
+#define LATENCY_MS         200
+#define TIMEOUT_SECONDS    30
+
+/*
+ *   root ─┬─ a ─┬─ a1
+ *         │     └─ a2
+ *         ├─ b
+ *         └─ c
+ */
+enum {
+  ROOT,
+  A,
+  A1,
+  A2,
+  B,
+  C,
+  N_DEVICES
+};
+
+static const struct {
+  gint     parent;
+  gboolean stored;
+} topology[N_DEVICES] = {
+  [ROOT] = { -1,   FALSE },
+  [A]    = { ROOT, TRUE  },
+  [A1]   = { A,    FALSE },
+  [A2]   = { A,    TRUE  },
+  [B]    = { ROOT, FALSE },
+  [C]    = { ROOT, TRUE  },
+};
+
+/* Depth of the tree above, i.e. the calls that cannot overlap */
+#define N_LEVELS           3
+
+typedef struct {
+  MockBoltd        boltd;
+
+  BoltClient      *client;
+  gchar           *uids[N_DEVICES];
+  GPtrArray       *devices;
+
+  /* The result of the operation under test */
+  gboolean         finished;
+  GError          *error;
+
+  /* Progress reports, in order */
+  GPtrArray       *progress;
+  GCancellable    *cancellable;
+  gboolean         cancel_on_progress;
+} BoltClientFixture;
+
+typedef struct {
+  gint64 start;
+  gint64 end;
+} Call;
+
+/* uid → when the mock got the call for it and when it answered */
+static GHashTable *
+get_calls (BoltClientFixture *fixture,
+           guint             *n_calls)
+{
+  g_autoptr(GVariant) ret = NULL;
+  g_autoptr(GVariantIter) iter = NULL;
+  GHashTable *calls;
+  const gchar *uid;
+  gint64 start, end;
+
+  calls = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  ret = mock_boltd_call (&fixture->boltd, "GetCalls", NULL);
+  g_variant_get (ret, "(a(sxx))", &iter);
+
+  *n_calls = 0;
+  while (g_variant_iter_next (iter, "(&sxx)", &uid, &start, &end))
+    {
+      Call *call = g_new0 (Call, 1);
+
+      call->start = start;
+      call->end = end;
+
+      /* every device is only ever touched once */
+      g_assert_false (g_hash_table_contains (calls, uid));
+      g_hash_table_insert (calls, g_strdup (uid), call);
+      (*n_calls)++;
+    }
+
+  return calls;
+}
+
+static void
+fixture_set_up (BoltClientFixture *fixture,
+                gconstpointer      user_data)
+{
+  g_autoptr(GError) error = NULL;
+  gint i;
+
+  mock_boltd_start (&fixture->boltd, 0);
+
+  fixture->client = bolt_client_new (&error);
+  g_assert_no_error (error);
+
+  fixture->devices = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      g_autoptr(GVariant) ret = NULL;
+      const gchar *parent = NULL;
+      BoltDevice *dev;
+
+      if (topology[i].parent >= 0)
+        parent = fixture->uids[topology[i].parent];
+
+      ret = mock_boltd_call (&fixture->boltd, "AddDevice", g_variant_new ("(sb)", parent ? parent : "", topology[i].stored));
+      g_variant_get (ret, "(s)", &fixture->uids[i]);
+
+      dev = bolt_client_get_device (fixture->client, fixture->uids[i], NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpstr (bolt_device_get_parent (dev), ==, parent);
+
+      g_ptr_array_add (fixture->devices, dev);
+    }
+
+  g_variant_unref (mock_boltd_call (&fixture->boltd, "SetLatency", g_variant_new ("(u)", LATENCY_MS)));
+
+  fixture->progress = g_ptr_array_new_with_free_func (g_free);
+  fixture->cancellable = g_cancellable_new ();
+}
+
+static void
+fixture_tear_down (BoltClientFixture *fixture,
+                   gconstpointer      user_data)
+{
+  gint i;
+
+  g_clear_object (&fixture->cancellable);
+  g_clear_pointer (&fixture->progress, g_ptr_array_unref);
+  g_clear_error (&fixture->error);
+  g_clear_pointer (&fixture->devices, g_ptr_array_unref);
+  for (i = 0; i < N_DEVICES; i++)
+    g_clear_pointer (&fixture->uids[i], g_free);
+  g_clear_object (&fixture->client);
+
+  mock_boltd_stop (&fixture->boltd);
+}
+
+static void
+wait_until_finished (BoltClientFixture *fixture)
+{
+  gint64 deadline = g_get_monotonic_time () + TIMEOUT_SECONDS * G_USEC_PER_SEC;
+
+  while (!fixture->finished)
+    {
+      g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+      g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+static gboolean
+quit_cb (gpointer user_data)
+{
+  gboolean *done = user_data;
+
+  *done = TRUE;
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Lets the mock answer whatever might still be in flight */
+static void
+wait_for_latency (guint n)
+{
+  gboolean done = FALSE;
+
+  g_timeout_add (n * LATENCY_MS, quit_cb, &done);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+progress_cb (const char *uid,
+             guint       done,
+             guint       total,
+             gpointer    user_data)
+{
+  BoltClientFixture *fixture = user_data;
+
+  g_assert_cmpuint (done, ==, fixture->progress->len + 1);
+  g_assert_cmpuint (total, ==, N_DEVICES);
+
+  g_ptr_array_add (fixture->progress, g_strdup (uid));
+
+  if (fixture->cancel_on_progress)
+    g_cancellable_cancel (fixture->cancellable);
+}
+
+static void
+connect_all_cb (GObject      *source_object,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+  BoltClientFixture *fixture = user_data;
+
+  bolt_client_connect_all_finish (BOLT_CLIENT (source_object), res, &fixture->error);
+  fixture->finished = TRUE;
+}
+
+static void
+authorize_all_cb (GObject      *source_object,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+  BoltClientFixture *fixture = user_data;
+
+  bolt_client_authorize_all_finish (BOLT_CLIENT (source_object), res, &fixture->error);
+  fixture->finished = TRUE;
+}
+
+static guint
+progress_index (BoltClientFixture *fixture,
+                gint               device)
+{
+  guint i;
+
+  for (i = 0; i < fixture->progress->len; i++)
+    if (g_str_equal (g_ptr_array_index (fixture->progress, i), fixture->uids[device]))
+      return i;
+
+  g_assert_not_reached ();
+}
+
+/*****************************************************************************/
+
+static void
+test_connect_all_order (BoltClientFixture *fixture,
+                        gconstpointer      user_data)
+{
+  g_autoptr(GHashTable) calls = NULL;
+  Call *call, *parent;
+  gint64 start, elapsed;
+  guint n_calls;
+  gint i;
+
+  /* The panel hands the devices over sorted like this, which already
+   * puts every device after its parent; the order should not matter
+   * beyond that though, so make it the opposite */
+  bolt_devices_sort_by_syspath (fixture->devices, TRUE);
+
+  start = g_get_monotonic_time ();
+
+  bolt_client_connect_all_full_async (fixture->client,
+                                      fixture->devices,
+                                      BOLT_POLICY_DEFAULT,
+                                      BOLT_AUTHCTRL_NONE,
+                                      progress_cb,
+                                      fixture,
+                                      NULL,
+                                      fixture->cancellable,
+                                      connect_all_cb,
+                                      fixture);
+  wait_until_finished (fixture);
+  g_assert_no_error (fixture->error);
+
+  elapsed = (g_get_monotonic_time () - start) / 1000;
+  g_test_message ("connect all: %" G_GINT64_FORMAT "ms for %u devices on %u levels, %ums latency",
+                  elapsed, N_DEVICES, N_LEVELS, LATENCY_MS);
+
+  calls = get_calls (fixture, &n_calls);
+  g_assert_cmpuint (n_calls, ==, N_DEVICES);
+  g_assert_cmpuint (fixture->progress->len, ==, N_DEVICES);
+
+  /* Every device was only touched after its parent was done */
+  for (i = 0; i < N_DEVICES; i++)
+    {
+      call = g_hash_table_lookup (calls, fixture->uids[i]);
+      g_assert_nonnull (call);
+      g_assert_cmpint (call->end, >, 0);
+
+      if (topology[i].parent < 0)
+        continue;
+
+      parent = g_hash_table_lookup (calls, fixture->uids[topology[i].parent]);
+      g_assert_cmpint (call->start, >=, parent->end);
+      g_assert_cmpuint (progress_index (fixture, i), >, progress_index (fixture, topology[i].parent));
+    }
+
+  /* Siblings were in flight at the same time */
+  call = g_hash_table_lookup (calls, fixture->uids[A]);
+  g_assert_cmpint (((Call *) g_hash_table_lookup (calls, fixture->uids[B]))->start, <, call->end);
+  g_assert_cmpint (((Call *) g_hash_table_lookup (calls, fixture->uids[C]))->start, <, call->end);
+
+  call = g_hash_table_lookup (calls, fixture->uids[A1]);
+  g_assert_cmpint (((Call *) g_hash_table_lookup (calls, fixture->uids[A2]))->start, <, call->end);
+
+  /* The overlapping calls above are what proves that; how close the
+   * whole run gets to one round trip per level depends on the machine,
+   * so it is only reported */
+  g_assert_cmpint (elapsed, >=, N_LEVELS * LATENCY_MS);
+  g_test_minimized_result ((gdouble) elapsed / (N_LEVELS * LATENCY_MS),
+                           "connect all: %.2fx the time of one round trip per level",
+                           (gdouble) elapsed / (N_LEVELS * LATENCY_MS));
+}
+
+static void
+test_authorize_all_order (BoltClientFixture *fixture,
+                          gconstpointer      user_data)
+{
+  g_autoptr(GPtrArray) uuids = NULL;
+  g_autoptr(GHashTable) calls = NULL;
+  Call *call, *prev = NULL;
+  guint n_calls, i;
+
+  /* Without the devices the client knows nothing about how they are
+   * connected, so it has to stick to the order it is given */
+  uuids = g_ptr_array_new ();
+  g_ptr_array_add (uuids, fixture->uids[ROOT]);
+  g_ptr_array_add (uuids, fixture->uids[A]);
+  g_ptr_array_add (uuids, fixture->uids[B]);
+
+  bolt_client_authorize_all_async (fixture->client,
+                                   uuids,
+                                   BOLT_AUTHCTRL_NONE,
+                                   fixture->cancellable,
+                                   authorize_all_cb,
+                                   fixture);
+  wait_until_finished (fixture);
+  g_assert_no_error (fixture->error);
+
+  calls = get_calls (fixture, &n_calls);
+  g_assert_cmpuint (n_calls, ==, uuids->len);
+
+  for (i = 0; i < uuids->len; i++)
+    {
+      call = g_hash_table_lookup (calls, g_ptr_array_index (uuids, i));
+      g_assert_nonnull (call);
+
+      if (prev != NULL)
+        g_assert_cmpint (call->start, >=, prev->end);
+
+      prev = call;
+    }
+}
+
+static void
+test_connect_all_cancel (BoltClientFixture *fixture,
+                         gconstpointer      user_data)
+{
+  g_autoptr(GHashTable) calls = NULL;
+  guint n_calls;
+
+  /* Cancel as soon as the root is done, before its children start */
+  fixture->cancel_on_progress = TRUE;
+
+  bolt_client_connect_all_full_async (fixture->client,
+                                      fixture->devices,
+                                      BOLT_POLICY_DEFAULT,
+                                      BOLT_AUTHCTRL_NONE,
+                                      progress_cb,
+                                      fixture,
+                                      NULL,
+                                      fixture->cancellable,
+                                      connect_all_cb,
+                                      fixture);
+  wait_until_finished (fixture);
+  g_assert_error (fixture->error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+
+  g_assert_cmpuint (fixture->progress->len, ==, 1);
+  g_assert_cmpstr (g_ptr_array_index (fixture->progress, 0), ==, fixture->uids[ROOT]);
+
+  /* Nothing else reached the service */
+  wait_for_latency (2);
+
+  calls = get_calls (fixture, &n_calls);
+  g_assert_cmpuint (n_calls, ==, 1);
+  g_assert_true (g_hash_table_contains (calls, fixture->uids[ROOT]));
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/bolt-client/connect-all-order",
+              BoltClientFixture,
+              NULL,
+              fixture_set_up,
+              test_connect_all_order,
+              fixture_tear_down);
+
+  g_test_add ("/bolt-client/authorize-all-order",
+              BoltClientFixture,
+              NULL,
+              fixture_set_up,
+              test_authorize_all_order,
+              fixture_tear_down);
+
+  g_test_add ("/bolt-client/connect-all-cancel",
+              BoltClientFixture,
+              NULL,
+              fixture_set_up,
+              test_connect_all_cancel,
+              fixture_tear_down);
+
+  return g_test_run ();
+}
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+#
+# Runs one of the thunderbolt test programs, named by TEST_EXE, in an X11
+# session with the system bus, where the tests start mock-boltd.py, and a
+# mock polkitd for the panel's manage permission.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+import os
+import subprocess
+import sys
+import unittest
+
+try:
+    import dbusmock
+except ImportError:
+    sys.stderr.write('You need python-dbusmock (http://pypi.python.org/pypi/python-dbusmock) for this test suite.\n')
+    sys.exit(1)
+
+# Add the shared directory to the search path
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', 'shared'))
+
+from gtest import GTest
+from x11session import X11SessionTestCase
+
+BUILDDIR = os.environ.get('BUILDDIR', os.path.join(os.path.dirname(__file__)))
+TEST_EXE = os.environ.get('TEST_EXE', 'test-bolt-benchmark')
+
+
+class BoltTestCase(X11SessionTestCase, GTest):
+    g_test_exe = os.path.join(BUILDDIR, TEST_EXE)
+
+    @classmethod
+    def setUpClass(klass):
+        X11SessionTestCase.setUpClass()
+
+        klass.polkitd, klass.polkitd_obj = klass.spawn_server_template(
+            'polkitd', {}, stdout=subprocess.DEVNULL)
+
+    @classmethod
+    def tearDownClass(klass):
+        klass.polkitd.terminate()
+        klass.polkitd.wait()
+
+        X11SessionTestCase.tearDownClass()
+
+
+if __name__ == '__main__':
+    # avoid writing to stderr
+    unittest.main(testRunner=unittest.TextTestRunner(stream=sys.stdout, verbosity=2))